@@ -12,6 +12,7 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <optional>
 #include <algorithm>
 #include <iostream>
 #include <cstdint>
@@ -28,6 +29,7 @@ class AST;
 class ASTUMinus;
 class ASTPlus;
 class ASTMult;
+class ASTElemMult;
 class ASTMod;
 class ASTPow;
 class ASTTransp;
@@ -41,13 +43,16 @@ class ASTTypeDecl;
 class ASTFunc;
 class ASTReturn;
 class ASTCall;
+class ASTMap;
 class ASTAssign;
+class ASTCompoundAssign;
 class ASTArrayAssign;
 class ASTArrayAccess;
 class ASTComp;
 class ASTBool;
 class ASTCond;
 class ASTLoop;
+class ASTParLoop;
 class ASTLoopBreak;
 class ASTLoopNext;
 class ASTExprList;
@@ -59,6 +64,7 @@ enum class ASTType
 	UMinus,
 	Plus,
 	Mult,
+	ElemMult,
 	Mod,
 	Pow,
 	Transp,
@@ -72,13 +78,16 @@ enum class ASTType
 	Func,
 	Return,
 	Call,
+	Map,
 	Assign,
+	CompoundAssign,
 	ArrayAssign,
 	ArrayAccess,
 	Comp,
 	Bool,
 	Cond,
 	Loop,
+	ParLoop,
 	LoopBreak,
 	LoopNext,
 	ExprList,
@@ -101,6 +110,7 @@ public:
 	virtual t_astret visit(const ASTUMinus* ast) = 0;
 	virtual t_astret visit(const ASTPlus* ast) = 0;
 	virtual t_astret visit(const ASTMult* ast) = 0;
+	virtual t_astret visit(const ASTElemMult* ast) = 0;
 	virtual t_astret visit(const ASTMod* ast) = 0;
 	virtual t_astret visit(const ASTPow* ast) = 0;
 	virtual t_astret visit(const ASTTransp* ast) = 0;
@@ -109,6 +119,7 @@ public:
 	virtual t_astret visit(const ASTVarDecl* ast) = 0;
 	virtual t_astret visit(const ASTVar* ast) = 0;
 	virtual t_astret visit(const ASTAssign* ast) = 0;
+	virtual t_astret visit(const ASTCompoundAssign* ast) = 0;
 
 	virtual t_astret visit(const ASTArrayAssign* ast) = 0;
 	virtual t_astret visit(const ASTArrayAccess* ast) = 0;
@@ -119,11 +130,13 @@ public:
 
 	virtual t_astret visit(const ASTFunc* ast) = 0;
 	virtual t_astret visit(const ASTCall* ast) = 0;
+	virtual t_astret visit(const ASTMap* ast) = 0;
 	virtual t_astret visit(const ASTReturn* ast) = 0;
 	virtual t_astret visit(const ASTStmts* ast) = 0;
 
 	virtual t_astret visit(const ASTCond* ast) = 0;
 	virtual t_astret visit(const ASTLoop* ast) = 0;
+	virtual t_astret visit(const ASTParLoop* ast) = 0;
 	virtual t_astret visit(const ASTLoopBreak* ast) = 0;
 	virtual t_astret visit(const ASTLoopNext* ast) = 0;
 
@@ -150,8 +163,15 @@ public:
 	virtual t_astret accept(ASTVisitor* visitor) const = 0;
 	virtual ASTType type() = 0;
 
+	// source line of a statement
+	void SetLine(std::size_t line) { m_line = line; }
+	const std::optional<std::size_t>& GetLine() const { return m_line; }
+
 	// TODO: either add this to all derived ast classes or use terminal override value in lexer
 	//virtual bool IsTerminal() const override { return false; }
+
+private:
+	std::optional<std::size_t> m_line{};
 };
 
 
@@ -215,6 +235,13 @@ public:
 	const ASTPtr GetTerm2() const { return term2; }
 	bool IsInverted() const { return inverted; }
 
+	// re-associates a chain of products, see MultChain
+	void SetTerms(ASTPtr term1, ASTPtr term2)
+	{
+		this->term1 = term1;
+		this->term2 = term2;
+	}
+
 	virtual ASTType type() override { return ASTType::Mult; }
 
 private:
@@ -223,6 +250,28 @@ private:
 };
 
 
+/**
+ * element-wise (hadamard) product or division, .* and ./
+ */
+class ASTElemMult : public ASTAcceptor<ASTElemMult>
+{
+public:
+	ASTElemMult(ASTPtr term1, ASTPtr term2, bool invert = false)
+		: term1{term1}, term2{term2}, inverted{invert}
+	{}
+
+	const ASTPtr GetTerm1() const { return term1; }
+	const ASTPtr GetTerm2() const { return term2; }
+	bool IsInverted() const { return inverted; }
+
+	virtual ASTType type() override { return ASTType::ElemMult; }
+
+private:
+	ASTPtr term1{}, term2{};
+	bool inverted = false;
+};
+
+
 class ASTMod : public ASTAcceptor<ASTMod>
 {
 public:
@@ -536,6 +585,27 @@ private:
 };
 
 
+/**
+ * applies a function to each element of an array
+ */
+class ASTMap : public ASTAcceptor<ASTMap>
+{
+public:
+	ASTMap(const t_str& ident, ASTPtr term)
+		: ident{ident}, term{term}
+	{}
+
+	const t_str& GetIdent() const { return ident; }
+	const ASTPtr GetTerm() const { return term; }
+
+	virtual ASTType type() override { return ASTType::Map; }
+
+private:
+	t_str ident{};
+	ASTPtr term{};
+};
+
+
 class ASTAssign : public ASTAcceptor<ASTAssign>
 {
 public:
@@ -565,6 +635,45 @@ private:
 };
 
 
+class ASTCompoundAssign : public ASTAcceptor<ASTCompoundAssign>
+{
+public:
+	enum CompoundOp
+	{
+		ADD, SUB,
+		MUL, DIV
+	};
+
+public:
+	ASTCompoundAssign(const t_str& ident, ASTPtr expr, CompoundOp op)
+		: ident{ident}, expr{expr}, op{op}
+	{
+		// equivalent plain assignment "ident = ident op expr"
+		ASTPtr var = std::make_shared<ASTVar>(ident);
+		ASTPtr rhs;
+		if(op == ADD || op == SUB)
+			rhs = std::make_shared<ASTPlus>(var, expr, op == SUB);
+		else
+			rhs = std::make_shared<ASTMult>(var, expr, op == DIV);
+		assign = std::make_shared<ASTAssign>(ident, rhs);
+	}
+
+	const t_str& GetIdent() const { return ident; }
+	const ASTPtr GetExpr() const { return expr; }
+	CompoundOp GetOp() const { return op; }
+	const std::shared_ptr<ASTAssign> GetAssignment() const { return assign; }
+
+	virtual ASTType type() override { return ASTType::CompoundAssign; }
+
+private:
+	t_str ident{};
+	ASTPtr expr{};
+	CompoundOp op{};
+
+	std::shared_ptr<ASTAssign> assign{};
+};
+
+
 class ASTComp : public ASTAcceptor<ASTComp>
 {
 public:
@@ -665,6 +774,34 @@ private:
 };
 
 
+/**
+ * parallel loop over the integer range [begin, end] whose iterations
+ * may run concurrently, they may only write disjoint array elements or
+ * add to the given accumulator variables
+ */
+class ASTParLoop : public ASTAcceptor<ASTParLoop>
+{
+public:
+	ASTParLoop(const t_str& ident, ASTPtr begin, ASTPtr end,
+		ASTPtr stmt, const std::vector<t_str>& accs = {})
+		: ident{ident}, begin{begin}, end{end}, stmt{stmt}, accs{accs}
+	{}
+
+	const t_str& GetIdent() const { return ident; }
+	const ASTPtr GetBegin() const { return begin; }
+	const ASTPtr GetEnd() const { return end; }
+	const ASTPtr GetLoopStmt() const { return stmt; }
+	const std::vector<t_str>& GetAccumulators() const { return accs; }
+
+	virtual ASTType type() override { return ASTType::ParLoop; }
+
+private:
+	t_str ident{};
+	ASTPtr begin{}, end{}, stmt{};
+	std::vector<t_str> accs{};
+};
+
+
 class ASTLoopBreak : public ASTAcceptor<ASTLoopBreak>
 {
 public:
@@ -797,4 +934,32 @@ private:
 };
 
 
+/**
+ * checks if a node is an inversion, i.e. a power with the constant exponent -1
+ */
+inline const ASTPow* get_inversion(const ASTPtr& ast)
+{
+	if(!ast || ast->type() != ASTType::Pow)
+		return nullptr;
+
+	const ASTPow* pow = static_cast<const ASTPow*>(ast.get());
+	ASTPtr exp = pow->GetTerm2();
+
+	// the exponent is either a negative constant or a negated positive one
+	t_real sign = 1.;
+	if(exp->type() == ASTType::UMinus)
+	{
+		exp = static_cast<const ASTUMinus*>(exp.get())->GetTerm();
+		sign = -1.;
+	}
+
+	if(auto num = std::dynamic_pointer_cast<ASTNumConst<t_int>>(exp))
+		return sign*t_real(num->GetVal()) == -1. ? pow : nullptr;
+	if(auto num = std::dynamic_pointer_cast<ASTNumConst<t_real>>(exp))
+		return sign*num->GetVal() == -1. ? pow : nullptr;
+
+	return nullptr;
+}
+
+
 #endif
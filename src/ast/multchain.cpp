@@ -0,0 +1,421 @@
+/**
+ * re-associates chains of matrix products in the syntax tree
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license: see 'LICENSE.GPL' file
+ */
+
+#include "multchain.h"
+
+#include <functional>
+#include <limits>
+
+
+MultChain::MultChain(SymTab* syms) : m_syms{syms}
+{
+}
+
+
+/**
+ * finds the symbol with a specific name in the symbol table
+ */
+const Symbol* MultChain::GetSym(const t_str& name) const
+{
+	if(!m_syms)
+		return nullptr;
+
+	t_str scoped_name;
+	for(const t_str& scope : m_curscope)
+		scoped_name += scope + Symbol::get_scopenameseparator();
+	scoped_name += name;
+
+	const Symbol* sym = m_syms->FindSymbol(scoped_name);
+
+	// try global scope instead
+	if(!sym)
+		sym = m_syms->FindSymbol(name);
+
+	return sym;
+}
+
+
+/**
+ * collects the factors of a chain of products from left to right
+ */
+void MultChain::GetFactors(const ASTPtr& ast, std::vector<ASTPtr>& factors) const
+{
+	if(ast->type() == ASTType::Mult)
+	{
+		const ASTMult* mult = static_cast<const ASTMult*>(ast.get());
+		if(!mult->IsInverted())
+		{
+			GetFactors(mult->GetTerm1(), factors);
+			GetFactors(mult->GetTerm2(), factors);
+			return;
+		}
+	}
+
+	factors.push_back(ast);
+}
+
+
+/**
+ * re-associates the chain of products starting at the given node
+ * if another order needs fewer multiplications
+ */
+void MultChain::Reorder(const ASTPtr& ast)
+{
+	if(ast->type() != ASTType::Mult)
+		return;
+	std::shared_ptr<ASTMult> root = std::static_pointer_cast<ASTMult>(ast);
+	if(root->IsInverted())
+		return;
+
+	std::vector<ASTPtr> factors;
+	GetFactors(ast, factors);
+	const std::size_t num_factors = factors.size();
+	if(num_factors < 3)
+		return;
+
+	// factor i is a dims[i] x dims[i+1] matrix, only the last one may be a vector
+	std::vector<std::size_t> dims(num_factors + 1);
+	for(std::size_t i=0; i<num_factors; ++i)
+	{
+		if(factors[i]->type() != ASTType::Var)
+			return;
+
+		const Symbol* sym = GetSym(static_cast<const ASTVar*>(factors[i].get())->GetIdent());
+		if(!sym)
+			return;
+
+		std::size_t rows = 0, cols = 0;
+		if(sym->ty == SymbolType::MATRIX)
+		{
+			rows = std::get<0>(sym->dims);
+			cols = std::get<1>(sym->dims);
+		}
+		else if(sym->ty == SymbolType::VECTOR && i == num_factors - 1)
+		{
+			rows = std::get<0>(sym->dims);
+			cols = 1;
+		}
+		else
+		{
+			return;
+		}
+
+		// dimension mismatches are reported by the code generators
+		if(i > 0 && dims[i] != rows)
+			return;
+
+		dims[i] = rows;
+		dims[i + 1] = cols;
+	}
+
+	// number of multiplications of the product as written
+	std::size_t factor_idx = 0;
+	std::function<t_real(const ASTPtr&)> get_cost;
+	get_cost = [&factor_idx, &dims, &get_cost](const ASTPtr& node) -> t_real
+	{
+		const ASTMult* mult = node->type() == ASTType::Mult
+			? static_cast<const ASTMult*>(node.get()) : nullptr;
+		if(!mult || mult->IsInverted())
+		{
+			++factor_idx;
+			return 0.;
+		}
+
+		const std::size_t first = factor_idx;
+		t_real cost = get_cost(mult->GetTerm1());
+		const std::size_t mid = factor_idx;
+		cost += get_cost(mult->GetTerm2());
+
+		return cost + t_real(dims[first]) * t_real(dims[mid]) * t_real(dims[factor_idx]);
+	};
+	const t_real written_cost = get_cost(ast);
+
+	// minimum number of multiplications of the factors i to j and the best split after factor k
+	std::vector<std::vector<t_real>> cost(num_factors, std::vector<t_real>(num_factors, 0.));
+	std::vector<std::vector<std::size_t>> split(num_factors, std::vector<std::size_t>(num_factors, 0));
+
+	for(std::size_t len=2; len<=num_factors; ++len)
+	{
+		for(std::size_t i=0; i+len<=num_factors; ++i)
+		{
+			const std::size_t j = i + len - 1;
+			cost[i][j] = std::numeric_limits<t_real>::max();
+
+			for(std::size_t k=i; k<j; ++k)
+			{
+				t_real c = cost[i][k] + cost[k + 1][j] +
+					t_real(dims[i]) * t_real(dims[k + 1]) * t_real(dims[j + 1]);
+				if(c < cost[i][j])
+				{
+					cost[i][j] = c;
+					split[i][j] = k;
+				}
+			}
+		}
+	}
+
+	if(cost[0][num_factors - 1] >= written_cost)
+		return;
+
+	// build the products in the optimal order, re-using the factors and the root node
+	std::function<ASTPtr(std::size_t, std::size_t)> build;
+	build = [&factors, &split, &build](std::size_t i, std::size_t j) -> ASTPtr
+	{
+		if(i == j)
+			return factors[i];
+
+		const std::size_t k = split[i][j];
+		return std::make_shared<ASTMult>(build(i, k), build(k + 1, j));
+	};
+
+	const std::size_t k = split[0][num_factors - 1];
+	root->SetTerms(build(0, k), build(k + 1, num_factors - 1));
+}
+
+
+/**
+ * re-associates the products in a statement or an expression and its sub-expressions
+ */
+void MultChain::Optimise(const ASTPtr& ast)
+{
+	if(!ast)
+		return;
+
+	Reorder(ast);
+	ast->accept(this);
+}
+
+
+t_astret MultChain::visit(const ASTUMinus* ast)
+{
+	Optimise(ast->GetTerm());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTPlus* ast)
+{
+	Optimise(ast->GetTerm1());
+	Optimise(ast->GetTerm2());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTMult* ast)
+{
+	Optimise(ast->GetTerm1());
+	Optimise(ast->GetTerm2());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTElemMult* ast)
+{
+	Optimise(ast->GetTerm1());
+	Optimise(ast->GetTerm2());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTMod* ast)
+{
+	Optimise(ast->GetTerm1());
+	Optimise(ast->GetTerm2());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTPow* ast)
+{
+	Optimise(ast->GetTerm1());
+	Optimise(ast->GetTerm2());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTTransp* ast)
+{
+	Optimise(ast->GetTerm());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTNorm* ast)
+{
+	Optimise(ast->GetTerm());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTVarDecl* ast)
+{
+	Optimise(ast->GetAssignment());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit([[maybe_unused]] const ASTVar* ast)
+{
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTAssign* ast)
+{
+	Optimise(ast->GetExpr());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTCompoundAssign* ast)
+{
+	// the plain assignment "var = var op expr" shares the expression
+	Optimise(ast->GetExpr());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTArrayAccess* ast)
+{
+	Optimise(ast->GetTerm());
+	Optimise(ast->GetNum1());
+	Optimise(ast->GetNum2());
+	Optimise(ast->GetNum3());
+	Optimise(ast->GetNum4());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTArrayAssign* ast)
+{
+	Optimise(ast->GetExpr());
+	Optimise(ast->GetNum1());
+	Optimise(ast->GetNum2());
+	Optimise(ast->GetNum3());
+	Optimise(ast->GetNum4());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit([[maybe_unused]] const ASTNumConst<t_real>* ast)
+{
+	return nullptr;
+}
+
+
+t_astret MultChain::visit([[maybe_unused]] const ASTNumConst<t_int>* ast)
+{
+	return nullptr;
+}
+
+
+t_astret MultChain::visit([[maybe_unused]] const ASTStrConst* ast)
+{
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTFunc* ast)
+{
+	m_curscope.push_back(ast->GetIdent());
+	Optimise(ast->GetStatements());
+	m_curscope.pop_back();
+
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTCall* ast)
+{
+	for(const auto& arg : ast->GetArgumentList())
+		Optimise(arg);
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTMap* ast)
+{
+	Optimise(ast->GetTerm());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTReturn* ast)
+{
+	Optimise(ast->GetRets());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTStmts* ast)
+{
+	for(const auto& stmt : ast->GetStatementList())
+		Optimise(stmt);
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTCond* ast)
+{
+	Optimise(ast->GetCond());
+	Optimise(ast->GetIf());
+	Optimise(ast->GetElse());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTLoop* ast)
+{
+	Optimise(ast->GetCond());
+	Optimise(ast->GetLoopStmt());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTParLoop* ast)
+{
+	Optimise(ast->GetBegin());
+	Optimise(ast->GetEnd());
+	Optimise(ast->GetLoopStmt());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit([[maybe_unused]] const ASTLoopBreak* ast)
+{
+	return nullptr;
+}
+
+
+t_astret MultChain::visit([[maybe_unused]] const ASTLoopNext* ast)
+{
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTComp* ast)
+{
+	Optimise(ast->GetTerm1());
+	Optimise(ast->GetTerm2());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTBool* ast)
+{
+	Optimise(ast->GetTerm1());
+	Optimise(ast->GetTerm2());
+	return nullptr;
+}
+
+
+t_astret MultChain::visit(const ASTExprList* ast)
+{
+	for(const auto& expr : ast->GetList())
+		Optimise(expr);
+	return nullptr;
+}
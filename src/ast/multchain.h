@@ -0,0 +1,101 @@
+/**
+ * re-associates chains of matrix products in the syntax tree
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license: see 'LICENSE.GPL' file
+ *
+ * Products like A*B*v are parsed left to right, i.e. as (A*B)*v, which needs
+ * a matrix-matrix product. Using the static dimensions of the variables, the
+ * chain is re-associated to the order with the fewest multiplications,
+ * here A*(B*v), see e.g. Cormen et al., "Introduction to Algorithms", ch. 15.2.
+ * Only chains of matrix variables, optionally ending in a vector variable,
+ * are changed, products involving scalars, strings or other expressions are
+ * kept as written.
+ */
+
+#ifndef __MULT_CHAIN_H__
+#define __MULT_CHAIN_H__
+
+#include "ast.h"
+
+#include <vector>
+
+
+class MultChain : public ASTVisitor
+{
+public:
+	MultChain(SymTab* syms);
+	virtual ~MultChain() = default;
+
+	MultChain(const MultChain&) = delete;
+	const MultChain& operator=(const MultChain&) = delete;
+
+	// re-associates the products in a statement or an expression
+	void Optimise(const ASTPtr& ast);
+
+	virtual t_astret visit(const ASTUMinus* ast) override;
+	virtual t_astret visit(const ASTPlus* ast) override;
+	virtual t_astret visit(const ASTMult* ast) override;
+	virtual t_astret visit(const ASTElemMult* ast) override;
+	virtual t_astret visit(const ASTMod* ast) override;
+	virtual t_astret visit(const ASTPow* ast) override;
+	virtual t_astret visit(const ASTTransp* ast) override;
+	virtual t_astret visit(const ASTNorm* ast) override;
+
+	virtual t_astret visit(const ASTVarDecl* ast) override;
+	virtual t_astret visit(const ASTVar* ast) override;
+	virtual t_astret visit(const ASTAssign* ast) override;
+	virtual t_astret visit(const ASTCompoundAssign* ast) override;
+
+	virtual t_astret visit(const ASTArrayAccess* ast) override;
+	virtual t_astret visit(const ASTArrayAssign* ast) override;
+
+	virtual t_astret visit(const ASTNumConst<t_real>* ast) override;
+	virtual t_astret visit(const ASTNumConst<t_int>* ast) override;
+	virtual t_astret visit(const ASTStrConst* ast) override;
+
+	virtual t_astret visit(const ASTFunc* ast) override;
+	virtual t_astret visit(const ASTCall* ast) override;
+	virtual t_astret visit(const ASTMap* ast) override;
+	virtual t_astret visit(const ASTReturn* ast) override;
+	virtual t_astret visit(const ASTStmts* ast) override;
+
+	virtual t_astret visit(const ASTCond* ast) override;
+	virtual t_astret visit(const ASTLoop* ast) override;
+	virtual t_astret visit(const ASTParLoop* ast) override;
+	virtual t_astret visit(const ASTLoopBreak* ast) override;
+	virtual t_astret visit(const ASTLoopNext* ast) override;
+
+	virtual t_astret visit(const ASTComp* ast) override;
+	virtual t_astret visit(const ASTBool* ast) override;
+	virtual t_astret visit(const ASTExprList* ast) override;
+
+	// ------------------------------------------------------------------------
+	// internally handled dummy nodes
+	// ------------------------------------------------------------------------
+	virtual t_astret visit(const ASTArgNames*) override { return nullptr; }
+	virtual t_astret visit(const ASTTypeDecl*) override { return nullptr; }
+	// ------------------------------------------------------------------------
+
+
+protected:
+	// finds the symbol with a specific name in the symbol table
+	const Symbol* GetSym(const t_str& name) const;
+
+	// collects the factors of a chain of products
+	void GetFactors(const ASTPtr& ast, std::vector<ASTPtr>& factors) const;
+
+	// re-associates the chain of products starting at the given node
+	void Reorder(const ASTPtr& ast);
+
+
+private:
+	// symbol table
+	SymTab* m_syms{nullptr};
+
+	// currently active function scope
+	std::vector<t_str> m_curscope{};
+};
+
+
+#endif
@@ -46,6 +46,17 @@ t_astret ASTPrinter::visit(const ASTMult* ast)
 }
 
 
+t_astret ASTPrinter::visit(const ASTElemMult* ast)
+{
+	(*m_ostr) << "<ElemMult>\n";
+	ast->GetTerm1()->accept(this);
+	ast->GetTerm2()->accept(this);
+	(*m_ostr) << "</ElemMult>\n";
+
+	return nullptr;
+}
+
+
 t_astret ASTPrinter::visit(const ASTMod* ast)
 {
 	(*m_ostr) << "<Mod>\n";
@@ -115,6 +126,16 @@ t_astret ASTPrinter::visit(const ASTCall* ast)
 }
 
 
+t_astret ASTPrinter::visit(const ASTMap* ast)
+{
+	(*m_ostr) << "<Map ident=\"" << ast->GetIdent() << "\">\n";
+	ast->GetTerm()->accept(this);
+	(*m_ostr) << "</Map>\n";
+
+	return nullptr;
+}
+
+
 t_astret ASTPrinter::visit(const ASTStmts* ast)
 {
 	(*m_ostr) << "<Stmts>\n";
@@ -255,6 +276,26 @@ t_astret ASTPrinter::visit(const ASTAssign* ast)
 }
 
 
+t_astret ASTPrinter::visit(const ASTCompoundAssign* ast)
+{
+	(*m_ostr) << "<CompoundAssign ident=\"" << ast->GetIdent() << "\" op=\"";
+	switch(ast->GetOp())
+	{
+		case ASTCompoundAssign::ADD: (*m_ostr) << "add"; break;
+		case ASTCompoundAssign::SUB: (*m_ostr) << "sub"; break;
+		case ASTCompoundAssign::MUL: (*m_ostr) << "mul"; break;
+		case ASTCompoundAssign::DIV: (*m_ostr) << "div"; break;
+		default: (*m_ostr) << "unknown"; break;
+	}
+	(*m_ostr) << "\">\n";
+
+	ast->GetExpr()->accept(this);
+	(*m_ostr) << "</CompoundAssign>\n";
+
+	return nullptr;
+}
+
+
 t_astret ASTPrinter::visit(const ASTArrayAccess* ast)
 {
 	(*m_ostr) << "<ArrayAccess"
@@ -428,6 +469,31 @@ t_astret ASTPrinter::visit(const ASTLoop* ast)
 }
 
 
+t_astret ASTPrinter::visit(const ASTParLoop* ast)
+{
+	(*m_ostr) << "<ParLoop ident=\"" << ast->GetIdent() << "\">\n";
+
+	(*m_ostr) << "<begin>\n";
+	ast->GetBegin()->accept(this);
+	(*m_ostr) << "</begin>\n";
+
+	(*m_ostr) << "<end>\n";
+	ast->GetEnd()->accept(this);
+	(*m_ostr) << "</end>\n";
+
+	for(const t_str& acc : ast->GetAccumulators())
+		(*m_ostr) << "<reduce ident=\"" << acc << "\" />\n";
+
+	(*m_ostr) << "<stmt>\n";
+	ast->GetLoopStmt()->accept(this);
+	(*m_ostr) << "</stmt>\n";
+
+	(*m_ostr) << "</ParLoop>\n";
+
+	return nullptr;
+}
+
+
 t_astret ASTPrinter::visit(const ASTLoopBreak* ast)
 {
 	(*m_ostr) << "<Break num=\"" << ast->GetNumLoops() << "\" />\n";
@@ -23,6 +23,7 @@ public:
 	virtual t_astret visit(const ASTUMinus* ast) override;
 	virtual t_astret visit(const ASTPlus* ast) override;
 	virtual t_astret visit(const ASTMult* ast) override;
+	virtual t_astret visit(const ASTElemMult* ast) override;
 	virtual t_astret visit(const ASTMod* ast) override;
 	virtual t_astret visit(const ASTPow* ast) override;
 	virtual t_astret visit(const ASTTransp* ast) override;
@@ -31,6 +32,7 @@ public:
 	virtual t_astret visit(const ASTVarDecl* ast) override;
 	virtual t_astret visit(const ASTVar* ast) override;
 	virtual t_astret visit(const ASTAssign* ast) override;
+	virtual t_astret visit(const ASTCompoundAssign* ast) override;
 
 	virtual t_astret visit(const ASTArrayAccess* ast) override;
 	virtual t_astret visit(const ASTArrayAssign* ast) override;
@@ -41,11 +43,13 @@ public:
 
 	virtual t_astret visit(const ASTFunc* ast) override;
 	virtual t_astret visit(const ASTCall* ast) override;
+	virtual t_astret visit(const ASTMap* ast) override;
 	virtual t_astret visit(const ASTReturn* ast) override;
 	virtual t_astret visit(const ASTStmts* ast) override;
 
 	virtual t_astret visit(const ASTCond* ast) override;
 	virtual t_astret visit(const ASTLoop* ast) override;
+	virtual t_astret visit(const ASTParLoop* ast) override;
 	virtual t_astret visit(const ASTLoopBreak* ast) override;
 	virtual t_astret visit(const ASTLoopNext* ast) override;
 
@@ -39,6 +39,15 @@ t_astret Semantics::visit(const ASTMult* ast)
 }
 
 
+t_astret Semantics::visit(const ASTElemMult* ast)
+{
+	ast->GetTerm1()->accept(this);
+	ast->GetTerm2()->accept(this);
+
+	return nullptr;
+}
+
+
 t_astret Semantics::visit(const ASTMod* ast)
 {
 	ast->GetTerm1()->accept(this);
@@ -88,6 +97,14 @@ t_astret Semantics::visit(const ASTCall* ast)
 }
 
 
+t_astret Semantics::visit(const ASTMap* ast)
+{
+	ast->GetTerm()->accept(this);
+
+	return nullptr;
+}
+
+
 t_astret Semantics::visit(const ASTStmts* ast)
 {
 	for(const auto& stmt : ast->GetStatementList())
@@ -150,6 +167,13 @@ t_astret Semantics::visit(const ASTAssign* ast)
 }
 
 
+t_astret Semantics::visit(const ASTCompoundAssign* ast)
+{
+	ast->GetExpr()->accept(this);
+	return nullptr;
+}
+
+
 t_astret Semantics::visit(const ASTArrayAccess* ast)
 {
 	ast->GetNum1()->accept(this);
@@ -216,6 +240,16 @@ t_astret Semantics::visit(const ASTLoop* ast)
 }
 
 
+t_astret Semantics::visit(const ASTParLoop* ast)
+{
+	ast->GetBegin()->accept(this);
+	ast->GetEnd()->accept(this);
+	ast->GetLoopStmt()->accept(this);
+
+	return nullptr;
+}
+
+
 t_astret Semantics::visit([[maybe_unused]] const ASTStrConst* ast)
 {
 	return nullptr;
@@ -120,6 +120,7 @@ t_astret ZeroACAsm::visit(const ASTArrayAssign* ast)
 
 	// evaluate the rhs expression
 	t_astret expr = ast->GetExpr()->accept(this);
+	std::size_t loopvar_reads = m_parloop_var_reads;
 
 	bool ranged12 = ast->IsRanged12();
 	bool ranged34 = ast->IsRanged34();
@@ -190,6 +191,7 @@ t_astret ZeroACAsm::visit(const ASTArrayAssign* ast)
 		m_ostr->put(static_cast<t_vm_byte>(OpCode::WRARR2DR));
 	}
 
+	CheckParLoopWrite(sym, true, m_parloop_var_reads != loopvar_reads);
 	return expr;
 }
 
@@ -6,13 +6,15 @@
  */
 
 #include "asm.h"
+#include "common/ext_funcs.h"
 
 #include <sstream>
+#include <iostream>
 
 
 
 ZeroACAsm::ZeroACAsm(SymTab* syms, std::ostream* ostr)
-	: m_syms{syms}, m_ostr{ostr}
+	: m_syms{syms}, m_ostr_bin{ostr}
 {
 	// dummy symbol for scalar constants
 	m_scalar_const = new Symbol();
@@ -107,12 +109,9 @@ void ZeroACAsm::Finish()
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::HALT));
 
 
-	// write constants block
+	// the constants block directly follows the code
 	std::streampos consttab_pos = m_ostr->tellp();
-	if(auto [constsize, constbytes] = m_consttab.GetBytes(); constsize && constbytes)
-	{
-		m_ostr->write((char*)constbytes.get(), constsize);
-	}
+	auto [constsize, constbytes] = m_consttab.GetBytes();
 
 	// patch in the addresses of the constants
 	for(auto [addr_pos, const_addr] : m_const_addrs)
@@ -155,8 +154,168 @@ void ZeroACAsm::Finish()
 	}
 
 
-	// seek to end of stream
-	m_ostr->seekp(0, std::ios_base::end);
+	// ------------------------------------------------------------------------
+	// write the binary file
+	// ------------------------------------------------------------------------
+	const std::string code = m_code.str();
+
+	std::ostringstream ostr_syms, ostr_lines, ostr_pure;
+	WriteSymbolSection(ostr_syms);
+	WriteLineSection(ostr_lines);
+	WritePureSection(ostr_pure);
+	const std::string syms = ostr_syms.str();
+	const std::string lines = ostr_lines.str();
+	const std::string pure = ostr_pure.str();
+
+	constexpr const std::uint16_t num_sections = 5;
+	BinHeader hdr = make_bin_header(num_sections, 0);
+
+	// the loadable sections start at an aligned file offset
+	std::uint64_t code_offs = sizeof(BinHeader) + num_sections*sizeof(BinSection);
+	code_offs = (code_offs + g_bin_align - 1) / g_bin_align * g_bin_align;
+
+	std::array<BinSection, num_sections> sections{};
+	sections[0].type = BinSectionType::CODE;
+	sections[0].flags = BIN_SECT_LOAD | BIN_SECT_EXEC;
+	sections[0].offset = code_offs;
+	sections[0].size = code.size();
+	sections[0].addr = 0;
+
+	// keep the constants at their ip-relative distance from the code
+	sections[1].type = BinSectionType::CONSTS;
+	sections[1].flags = BIN_SECT_LOAD;
+	sections[1].offset = sections[0].offset + sections[0].size;
+	sections[1].size = constbytes ? static_cast<std::uint64_t>(constsize) : 0;
+	sections[1].addr = static_cast<std::uint64_t>(consttab_pos);
+
+	sections[2].type = BinSectionType::SYMBOLS;
+	sections[2].offset = sections[1].offset + sections[1].size;
+	sections[2].size = syms.size();
+
+	sections[3].type = BinSectionType::LINES;
+	sections[3].offset = sections[2].offset + sections[2].size;
+	sections[3].size = lines.size();
+
+	sections[4].type = BinSectionType::PURE;
+	sections[4].offset = sections[3].offset + sections[3].size;
+	sections[4].size = pure.size();
+
+	m_ostr_bin->write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+	m_ostr_bin->write(reinterpret_cast<const char*>(sections.data()),
+		sections.size()*sizeof(BinSection));
+
+	// padding up to the code section
+	std::uint64_t hdr_size = sizeof(BinHeader) + num_sections*sizeof(BinSection);
+	for(std::uint64_t pad = hdr_size; pad < code_offs; ++pad)
+		m_ostr_bin->put(static_cast<t_vm_byte>(OpCode::HALT));
+
+	m_ostr_bin->write(code.data(), code.size());
+	if(sections[1].size)
+		m_ostr_bin->write(reinterpret_cast<const char*>(constbytes.get()), sections[1].size);
+	m_ostr_bin->write(syms.data(), syms.size());
+	m_ostr_bin->write(lines.data(), lines.size());
+	m_ostr_bin->write(pure.data(), pure.size());
+	m_ostr_bin->flush();
+	// ------------------------------------------------------------------------
+}
+
+
+/**
+ * writes the function names and addresses
+ */
+void ZeroACAsm::WriteSymbolSection(std::ostream& ostr) const
+{
+	for(const auto& [name, sym] : m_syms->GetSymbols())
+	{
+		if(sym.ty != SymbolType::FUNC || sym.is_external || !sym.addr)
+			continue;
+
+		t_vm_addr addr = static_cast<t_vm_addr>(*sym.addr);
+		t_vm_addr num_args = static_cast<t_vm_addr>(sym.argty.size());
+		t_vm_addr len = static_cast<t_vm_addr>(sym.name.length());
+
+		ostr.write(reinterpret_cast<const char*>(&addr), sizeof(addr));
+		ostr.write(reinterpret_cast<const char*>(&num_args), sizeof(num_args));
+		ostr.write(reinterpret_cast<const char*>(&len), sizeof(len));
+		ostr.write(sym.name.data(), len);
+	}
+}
+
+
+/**
+ * finds the functions that neither directly nor indirectly
+ * call an external function with side effects
+ */
+std::unordered_set<t_str> ZeroACAsm::GetPureFunctions() const
+{
+	std::unordered_set<t_str> impure;
+
+	// propagate impurity from the callees to the callers
+	bool changed = true;
+	while(changed)
+	{
+		changed = false;
+
+		for(const auto& [func, callees] : m_func_callees)
+		{
+			if(impure.contains(func))
+				continue;
+
+			for(const t_str& callee : callees)
+			{
+				bool is_internal = m_func_callees.contains(callee);
+				if((is_internal && impure.contains(callee)) ||
+					(!is_internal && !is_pure_ext_func(callee)))
+				{
+					impure.insert(func);
+					changed = true;
+					break;
+				}
+			}
+		}
+	}
+
+	std::unordered_set<t_str> pure;
+	for(const auto& [func, callees] : m_func_callees)
+	{
+		if(!impure.contains(func))
+			pure.insert(func);
+	}
+
+	return pure;
+}
+
+
+/**
+ * writes the addresses and argument counts of the functions without side effects
+ */
+void ZeroACAsm::WritePureSection(std::ostream& ostr) const
+{
+	for(const t_str& name : GetPureFunctions())
+	{
+		const Symbol* sym = m_syms->FindSymbol(name);
+		if(!sym || sym->ty != SymbolType::FUNC || sym->is_external || !sym->addr)
+			continue;
+
+		t_vm_addr addr = static_cast<t_vm_addr>(*sym->addr);
+		t_vm_addr num_args = static_cast<t_vm_addr>(sym->argty.size());
+
+		ostr.write(reinterpret_cast<const char*>(&addr), sizeof(addr));
+		ostr.write(reinterpret_cast<const char*>(&num_args), sizeof(num_args));
+	}
+}
+
+
+/**
+ * writes the code addresses of the source lines
+ */
+void ZeroACAsm::WriteLineSection(std::ostream& ostr) const
+{
+	for(const auto& [addr, line] : m_lines)
+	{
+		ostr.write(reinterpret_cast<const char*>(&addr), sizeof(addr));
+		ostr.write(reinterpret_cast<const char*>(&line), sizeof(line));
+	}
 }
 
 
@@ -187,7 +346,7 @@ t_astret ZeroACAsm::visit(const ASTCond* ast)
 
 	// if block
 	std::streampos before_if_block = m_ostr->tellp();
-	ast->GetIf()->accept(this);
+	EmitStatement(ast->GetIf());
 	if(ast->HasElse())
 	{
 		// skip to end of if statement if there's an else block
@@ -212,7 +371,7 @@ t_astret ZeroACAsm::visit(const ASTCond* ast)
 	if(ast->HasElse())
 	{
 		std::streampos before_else_block = m_ostr->tellp();
-		ast->GetElse()->accept(this);
+		EmitStatement(ast->GetElse());
 		std::streampos after_else_block = m_ostr->tellp();
 
 		// go back and fill in missing number of bytes to skip
@@ -231,8 +390,7 @@ t_astret ZeroACAsm::visit(const ASTCond* ast)
 
 t_astret ZeroACAsm::visit(const ASTLoop* ast)
 {
-	static std::size_t loop_ident = 0;
-	++loop_ident;
+	std::size_t loop_ident = ++m_loop_ident;
 	m_cur_loop.push_back(loop_ident);
 
 	std::streampos loop_begin = m_ostr->tellp();
@@ -255,7 +413,7 @@ t_astret ZeroACAsm::visit(const ASTLoop* ast)
 
 	std::streampos before_block = m_ostr->tellp();
 	// loop statements
-	ast->GetLoopStmt()->accept(this);
+	EmitStatement(ast->GetLoopStmt());
 
 	// loop back
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));      // push jump address
@@ -319,6 +477,189 @@ t_astret ZeroACAsm::visit(const ASTLoop* ast)
 }
 
 
+/**
+ * parallel loop, the vm runs the loop body following the PARLOOP instruction
+ * for every index, the loop variable, the variables declared in the body and
+ * the accumulators are private to each thread
+ */
+t_astret ZeroACAsm::visit(const ASTParLoop* ast)
+{
+	if(!m_curscope.size())
+		throw std::runtime_error("ASTParLoop: Not in a function.");
+	const t_str& cur_func = *m_curscope.rbegin();
+
+	// loop variable
+	const t_str& varname = ast->GetIdent();
+	t_astret loopvar = GetSym(varname);
+	if(!loopvar->addr)
+		throw std::runtime_error("ASTParLoop: Variable \"" + varname + "\" has not been declared.");
+	if(loopvar->ty != SymbolType::INT)
+		throw std::runtime_error("ASTParLoop: Loop variable \"" + varname + "\" has to be an integer.");
+
+	// iteration range
+	ast->GetBegin()->accept(this);
+	CastTo(m_int_const);
+	ast->GetEnd()->accept(this);
+	CastTo(m_int_const);
+
+	// block of the variables declared in the loop body, filled in later
+	t_vm_addr block_addr = 0;
+	t_vm_int block_size = 0;
+
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
+	std::streampos block_addr_pos = m_ostr->tellp();
+	m_ostr->write(reinterpret_cast<const char*>(&block_addr),
+		vm_type_size<VMType::ADDR_BP, false>);
+
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+	m_ostr->put(static_cast<t_vm_byte>(VMType::INT));
+	std::streampos block_size_pos = m_ostr->tellp();
+	m_ostr->write(reinterpret_cast<const char*>(&block_size),
+		vm_type_size<VMType::INT, false>);
+
+	// accumulators
+	for(const t_str& accname : ast->GetAccumulators())
+	{
+		t_astret acc = GetSym(accname);
+		if(!acc->addr)
+			throw std::runtime_error("ASTParLoop: Variable \"" + accname + "\" has not been declared.");
+		if(acc->ty != SymbolType::SCALAR && acc->ty != SymbolType::INT &&
+			acc->ty != SymbolType::VECTOR && acc->ty != SymbolType::MATRIX)
+			throw std::runtime_error("ASTParLoop: Accumulator \"" + accname + "\" has to be numeric.");
+
+		m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+		m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
+		t_vm_addr addr = static_cast<t_vm_addr>(*acc->addr);
+		m_ostr->write(reinterpret_cast<const char*>(&addr),
+			vm_type_size<VMType::ADDR_BP, false>);
+	}
+	PushIntConst(static_cast<t_vm_int>(ast->GetAccumulators().size()));
+
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
+	t_vm_addr loopvar_addr = static_cast<t_vm_addr>(*loopvar->addr);
+	m_ostr->write(reinterpret_cast<const char*>(&loopvar_addr),
+		vm_type_size<VMType::ADDR_BP, false>);
+
+	// end of the loop body, filled in later
+	t_vm_addr skip = 0;
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_IP));
+	std::streampos skip_addr = m_ostr->tellp();
+	m_ostr->write(reinterpret_cast<const char*>(&skip),
+		vm_type_size<VMType::ADDR_IP, false>);
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PARLOOP));
+
+	// loop body
+	std::size_t loop_ident = ++m_loop_ident;
+	m_cur_loop.push_back(loop_ident);
+	m_parloops.insert(loop_ident);
+
+	std::streampos before_block = m_ostr->tellp();
+	t_vm_addr frame_before = m_local_stack[cur_func];
+
+	// the variables declared in the body of the outermost loop, its accumulators
+	// and the loop variables are private to the iterations, the vm also gives
+	// nested loops a private loop variable
+	bool outermost = !m_parloop_frame;
+	if(outermost)
+	{
+		m_parloop_frame = frame_before;
+		for(const t_str& accname : ast->GetAccumulators())
+			m_parloop_privs.insert(GetSym(accname));
+	}
+	bool new_priv = m_parloop_privs.insert(loopvar).second;
+	bool new_var = m_parloop_vars.insert(loopvar).second;
+
+	EmitStatement(ast->GetLoopStmt());
+
+	if(outermost)
+	{
+		m_parloop_frame.reset();
+		m_parloop_privs.clear();
+		m_parloop_vars.clear();
+	}
+	else
+	{
+		if(new_priv)
+			m_parloop_privs.erase(loopvar);
+		if(new_var)
+			m_parloop_vars.erase(loopvar);
+	}
+
+	t_vm_addr frame_after = m_local_stack[cur_func];
+	std::streampos after_block = m_ostr->tellp();
+
+	// go back and fill in the end of the loop body and its variables
+	skip = after_block - before_block;
+	m_ostr->seekp(skip_addr);
+	m_ostr->write(reinterpret_cast<const char*>(&skip),
+		vm_type_size<VMType::ADDR_IP, false>);
+
+	block_addr = -frame_after;
+	block_size = frame_after - frame_before;
+	m_ostr->seekp(block_addr_pos);
+	m_ostr->write(reinterpret_cast<const char*>(&block_addr),
+		vm_type_size<VMType::ADDR_BP, false>);
+	m_ostr->seekp(block_size_pos);
+	m_ostr->write(reinterpret_cast<const char*>(&block_size),
+		vm_type_size<VMType::INT, false>);
+
+	// fill in any saved, unset end-of-iteration jump addresses (continues)
+	while(true)
+	{
+		auto iter = m_loop_end_comefroms.find(loop_ident);
+		if(iter == m_loop_end_comefroms.end())
+			break;
+
+		std::streampos pos = iter->second;
+		m_loop_end_comefroms.erase(iter);
+
+		t_vm_addr to_skip = after_block - pos;
+		// already skipped over address and jmp instruction
+		to_skip -= vm_type_size<VMType::ADDR_IP, true>;
+		m_ostr->seekp(pos);
+		m_ostr->write(reinterpret_cast<const char*>(&to_skip),
+			vm_type_size<VMType::ADDR_IP, false>);
+	}
+
+	// go to end of stream
+	m_ostr->seekp(0, std::ios_base::end);
+	m_cur_loop.pop_back();
+
+	return nullptr;
+}
+
+
+/**
+ * the iterations of a parallel loop may only assign their private variables
+ * and the accumulators, shared arrays are only written element-wise, and the
+ * elements should be indexed by a loop variable to keep them disjoint
+ */
+void ZeroACAsm::CheckParLoopWrite(const Symbol* sym, bool elem, bool indexed) const
+{
+	if(!m_parloop_frame || !sym || m_parloop_privs.contains(sym))
+		return;
+
+	// variable declared in the loop body
+	if(sym->addr && -*sym->addr > static_cast<t_int>(*m_parloop_frame))
+		return;
+
+	if(!elem)
+	{
+		throw std::runtime_error("Variable \"" + sym->name + "\" is shared by the iterations"
+			" of a parallel loop, declare it in the loop body or as an accumulator.");
+	}
+
+	if(!indexed)
+	{
+		std::cerr << "Warning: Array \"" << sym->name << "\" is written in a parallel loop"
+			<< " at an index not depending on a loop variable." << std::endl;
+	}
+}
+
+
 t_astret ZeroACAsm::visit(const ASTLoopBreak* ast)
 {
 	//if(!m_curscope.size())
@@ -332,6 +673,13 @@ t_astret ZeroACAsm::visit(const ASTLoopBreak* ast)
 	if(static_cast<std::size_t>(loop_depth) >= m_cur_loop.size() || loop_depth < 0)
 		loop_depth = static_cast<t_int>(m_cur_loop.size()-1);
 
+	// the iterations of a parallel loop cannot be cancelled
+	for(t_int depth=0; depth<=loop_depth; ++depth)
+	{
+		if(m_parloops.contains(m_cur_loop[m_cur_loop.size()-depth-1]))
+			throw std::runtime_error("ASTLoopBreak: Cannot break out of a parallel loop.");
+	}
+
 	// jump to the end of the loop
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));  // push jump address
 	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_IP));
@@ -359,11 +707,21 @@ t_astret ZeroACAsm::visit(const ASTLoopNext* ast)
 	if(static_cast<std::size_t>(loop_depth) >= m_cur_loop.size() || loop_depth < 0)
 		loop_depth = static_cast<t_int>(m_cur_loop.size()-1);
 
-	// jump to the beginning of the loop
+	for(t_int depth=0; depth<loop_depth; ++depth)
+	{
+		if(m_parloops.contains(m_cur_loop[m_cur_loop.size()-depth-1]))
+			throw std::runtime_error("ASTLoopNext: Cannot leave a parallel loop.");
+	}
+
+	// jump to the beginning of the loop,
+	// or to the end of the body for parallel loops
+	std::size_t loop_ident = m_cur_loop[m_cur_loop.size()-loop_depth-1];
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));  // push jump address
 	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_IP));
-	m_loop_begin_comefroms.insert(std::make_pair(
-		m_cur_loop[m_cur_loop.size()-loop_depth-1], m_ostr->tellp()));
+	if(m_parloops.contains(loop_ident))
+		m_loop_end_comefroms.insert(std::make_pair(loop_ident, m_ostr->tellp()));
+	else
+		m_loop_begin_comefroms.insert(std::make_pair(loop_ident, m_ostr->tellp()));
 	t_vm_addr dummy_addr = 0;
 	m_ostr->write(reinterpret_cast<const char*>(&dummy_addr),
 		vm_type_size<VMType::ADDR_IP, false>);
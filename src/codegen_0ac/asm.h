@@ -11,9 +11,13 @@
 #include "ast/ast.h"
 #include "codegen_0ac/consttab.h"
 #include "vm_0ac/opcodes.h"
+#include "vm_0ac/binfile.h"
 
 #include <stack>
+#include <sstream>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 
 /**
@@ -32,6 +36,7 @@ public:
 	virtual t_astret visit(const ASTUMinus* ast) override;
 	virtual t_astret visit(const ASTPlus* ast) override;
 	virtual t_astret visit(const ASTMult* ast) override;
+	virtual t_astret visit(const ASTElemMult* ast) override;
 	virtual t_astret visit(const ASTMod* ast) override;
 	virtual t_astret visit(const ASTPow* ast) override;
 	virtual t_astret visit(const ASTTransp* ast) override;
@@ -40,6 +45,7 @@ public:
 	virtual t_astret visit(const ASTVarDecl* ast) override;
 	virtual t_astret visit(const ASTVar* ast) override;
 	virtual t_astret visit(const ASTAssign* ast) override;
+	virtual t_astret visit(const ASTCompoundAssign* ast) override;
 
 	virtual t_astret visit(const ASTArrayAccess* ast) override;
 	virtual t_astret visit(const ASTArrayAssign* ast) override;
@@ -50,11 +56,13 @@ public:
 
 	virtual t_astret visit(const ASTFunc* ast) override;
 	virtual t_astret visit(const ASTCall* ast) override;
+	virtual t_astret visit(const ASTMap* ast) override;
 	virtual t_astret visit(const ASTReturn* ast) override;
 	virtual t_astret visit(const ASTStmts* ast) override;
 
 	virtual t_astret visit(const ASTCond* ast) override;
 	virtual t_astret visit(const ASTLoop* ast) override;
+	virtual t_astret visit(const ASTParLoop* ast) override;
 	virtual t_astret visit(const ASTLoopBreak* ast) override;
 	virtual t_astret visit(const ASTLoopNext* ast) override;
 
@@ -92,6 +100,11 @@ protected:
 		const std::optional<std::streampos>& pos = std::nullopt,
 		bool allow_array_cast = false);
 
+	// fused element-wise array expressions
+	t_astret GetFusedType(ASTType ty, const AST* ast, std::size_t& num_ops) const;
+	void EmitFused(ASTType ty, const AST* ast, t_vm_str& prog);
+	t_astret TryFused(ASTType ty, const AST* ast, t_astret dst = nullptr);
+
 	// push constants
 	void PushRealConst(t_vm_real);
 	void PushIntConst(t_vm_int);
@@ -102,8 +115,25 @@ protected:
 	void AssignVar(t_astret sym);
 	void CallExternal(const t_str& funcname);
 
+	// emits a statement and discards the unused results of a call
+	void EmitStatement(const ASTPtr& stmt);
+
+	// checks writes to shared variables in parallel loops
+	void CheckParLoopWrite(const Symbol* sym, bool elem = false, bool indexed = false) const;
+
+	// emits the power of an already evaluated term
+	t_astret Pow(t_astret term1, const ASTPtr& exp);
+
 	Symbol* GetTypeConst(SymbolType ty) const;
 
+	// finds the functions without side effects
+	std::unordered_set<t_str> GetPureFunctions() const;
+
+	// writes the symbol, line and pure function tables
+	void WriteSymbolSection(std::ostream& ostr) const;
+	void WriteLineSection(std::ostream& ostr) const;
+	void WritePureSection(std::ostream& ostr) const;
+
 
 private:
 	// symbol table
@@ -112,8 +142,12 @@ private:
 	// constants table
 	ConstTab m_consttab{};
 
-	// code output
-	std::ostream* m_ostr{&std::cout};
+	// binary file output
+	std::ostream* m_ostr_bin{&std::cout};
+
+	// code output, written to the code section of the binary file
+	std::stringstream m_code{};
+	std::ostream* m_ostr{&m_code};
 
 	// currently active function scope
 	std::vector<t_str> m_curscope{};
@@ -126,8 +160,24 @@ private:
 	std::vector<std::streampos> m_endfunc_comefroms{};
 	std::vector<std::tuple<std::streampos, std::streampos>> m_const_addrs{};
 
+	// internal and external functions called by each function
+	std::unordered_map<t_str, std::unordered_set<t_str>> m_func_callees{};
+
+	// code addresses and source lines of the statements
+	std::vector<std::pair<t_vm_addr, t_vm_addr>> m_lines{};
+
 	// currently active loops in function
+	std::size_t m_loop_ident{0};
 	std::vector<std::size_t> m_cur_loop{};
+	std::unordered_set<std::size_t> m_parloops{};
+
+	// stack frame before the body of the outermost parallel loop, the loop
+	// variables and accumulators private to its iterations, and the number
+	// of reads of the loop variables
+	std::optional<t_vm_addr> m_parloop_frame{};
+	std::unordered_set<const Symbol*> m_parloop_privs{};
+	std::unordered_set<const Symbol*> m_parloop_vars{};
+	std::size_t m_parloop_var_reads{0};
 	std::unordered_multimap<std::size_t, std::streampos>
 		m_loop_begin_comefroms{}, m_loop_end_comefroms{};
 
@@ -6,6 +6,7 @@
  */
 
 #include "asm.h"
+#include "common/ext_funcs.h"
 
 
 /**
@@ -33,6 +34,7 @@ t_astret ZeroACAsm::visit(const ASTFunc* ast)
 {
 	const t_str& funcname = ast->GetIdent();
 	m_curscope.push_back(funcname);
+	m_func_callees.try_emplace(funcname);
 
 	auto argnames = ast->GetArgs();
 	t_vm_int num_args = static_cast<t_vm_int>(argnames.size());
@@ -149,8 +151,55 @@ t_astret ZeroACAsm::visit(const ASTCall* ast)
 	if(static_cast<t_vm_int>(ast->GetArgumentList().size()) != num_args)
 		throw std::runtime_error("ASTCall: Invalid number of function parameters for \"" + (*funcname) + "\".");
 
+	// the result of a solve has the shape of the right-hand side,
+	// element-wise math functions of arrays have the shape of their argument
+	t_astret solve_rhs = nullptr;
+	t_astret elem_arg = nullptr;
+
 	for(auto iter = ast->GetArgumentList().rbegin(); iter != ast->GetArgumentList().rend(); ++iter)
-		(*iter)->accept(this);
+	{
+		std::size_t argidx = static_cast<std::size_t>(
+			std::distance(iter, ast->GetArgumentList().rend())) - 1;
+
+		// push the address of variables passed by reference
+		if(func->is_external && is_ref_ext_func_arg(*funcname, argidx))
+		{
+			if((*iter)->type() != ASTType::Var)
+			{
+				throw std::runtime_error("ASTCall: Argument " + std::to_string(argidx + 1) +
+					" of \"" + (*funcname) + "\" has to be a variable.");
+			}
+
+			const t_str& varname = static_cast<const ASTVar*>(iter->get())->GetIdent();
+			t_astret sym = GetSym(varname);
+			if(!sym || !sym->addr)
+				throw std::runtime_error("ASTCall: Variable \"" + varname + "\" has not been declared.");
+			if(sym->ty != func->argty[argidx])
+				throw std::runtime_error("ASTCall: Variable \"" + varname + "\" has the wrong type.");
+			CheckParLoopWrite(sym);
+
+			m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+			m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
+			t_vm_addr addr = static_cast<t_vm_addr>(*sym->addr);
+			m_ostr->write(reinterpret_cast<const char*>(&addr), vm_type_size<VMType::ADDR_BP, false>);
+			continue;
+		}
+
+		t_astret arg = (*iter)->accept(this);
+		if(func->is_external && *funcname == "solve" && argidx == 1)
+			solve_rhs = arg;
+		if(func->is_external && argidx == 0 && is_elementwise_ext_func(*funcname))
+		{
+			if(arg && arg->ty == SymbolType::FUNC)
+				arg = GetTypeConst(arg->retty);
+			if(arg && (arg->ty == SymbolType::VECTOR || arg->ty == SymbolType::MATRIX))
+				elem_arg = arg;
+		}
+	}
+
+	// remember the call graph for the purity analysis
+	if(m_curscope.size())
+		m_func_callees[*m_curscope.begin()].insert(*funcname);
 
 	// call external function
 	if(func->is_external)
@@ -159,6 +208,11 @@ t_astret ZeroACAsm::visit(const ASTCall* ast)
 		//if(func->ext_name)
 		//	funcname = &(*func->ext_name);
 		CallExternal(*funcname);
+
+		if(solve_rhs)
+			return solve_rhs;
+		if(elem_arg)
+			return elem_arg;
 	}
 
 	// call internal function
@@ -192,10 +246,65 @@ t_astret ZeroACAsm::visit(const ASTCall* ast)
 }
 
 
+/**
+ * calls a function for each element of an array,
+ * the vm runs the calls directly on the array's elements
+ */
+t_astret ZeroACAsm::visit(const ASTMap* ast)
+{
+	const t_str& funcname = ast->GetIdent();
+	t_astret func = GetSym(funcname);
+	if(!func)
+		throw std::runtime_error("ASTMap: Function \"" + funcname + "\" is not in symbol table.");
+	if(func->is_external)
+		throw std::runtime_error("ASTMap: Function \"" + funcname + "\" is external.");
+	if(func->argty.size() != 1 || func->argty[0] != SymbolType::SCALAR)
+		throw std::runtime_error("ASTMap: Function \"" + funcname + "\" has to take a scalar argument.");
+	if(func->retty != SymbolType::SCALAR && func->retty != SymbolType::INT)
+		throw std::runtime_error("ASTMap: Function \"" + funcname + "\" has to return a scalar.");
+
+	t_astret term = ast->GetTerm()->accept(this);
+	if(term && term->ty == SymbolType::FUNC)
+		term = GetTypeConst(term->retty);
+	if(!term || (term->ty != SymbolType::VECTOR && term->ty != SymbolType::MATRIX))
+		throw std::runtime_error("ASTMap: Argument of \"" + funcname + "\" has to be a vector or matrix.");
+
+	// remember the call graph for the purity analysis
+	if(m_curscope.size())
+		m_func_callees[*m_curscope.begin()].insert(funcname);
+
+	// push stack frame size
+	t_vm_int framesize = static_cast<t_vm_int>(GetStackFrameSize(func));
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+	m_ostr->put(static_cast<t_vm_byte>(VMType::INT));
+	m_ostr->write(reinterpret_cast<const char*>(&framesize), vm_type_size<VMType::INT, false>);
+
+	// push function address relative to instruction pointer, to be filled in later
+	t_vm_addr to_skip = 0;
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_IP));
+	std::streampos addr_pos = m_ostr->tellp();
+	m_ostr->write(reinterpret_cast<const char*>(&to_skip), vm_type_size<VMType::ADDR_IP, false>);
+
+	// call the function for each element
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::MAP));
+
+	m_func_comefroms.emplace_back(
+		std::make_tuple(funcname, addr_pos, 1, ast));
+
+	return term;
+}
+
+
 t_astret ZeroACAsm::visit(const ASTReturn* ast)
 {
 	if(!m_curscope.size())
 		throw std::runtime_error("ASTReturn: Not in a function.");
+	for(std::size_t loop_ident : m_cur_loop)
+	{
+		if(m_parloops.contains(loop_ident))
+			throw std::runtime_error("ASTReturn: Cannot return from a parallel loop.");
+	}
 
 	/*const t_str& cur_func = *m_curscope.rbegin();
 	t_astret func = GetSym(cur_func);
@@ -229,8 +338,47 @@ t_astret ZeroACAsm::visit(const ASTReturn* ast)
 t_astret ZeroACAsm::visit(const ASTStmts* ast)
 {
 	for(const auto& stmt : ast->GetStatementList())
-		stmt->accept(this);
+	{
+		// remember the code address of the statement's source line
+		if(stmt->GetLine())
+		{
+			m_lines.emplace_back(std::make_pair(
+				static_cast<t_vm_addr>(m_ostr->tellp()),
+				static_cast<t_vm_addr>(*stmt->GetLine())));
+		}
+
+		EmitStatement(stmt);
+	}
 
 	return nullptr;
 }
+
+
+/**
+ * emits a statement, the return values of a call or map statement are not used
+ * and have to be removed from the stack, otherwise the stack depths at the joins
+ * of branches would differ and the values would be returned by the function
+ */
+void ZeroACAsm::EmitStatement(const ASTPtr& stmt)
+{
+	stmt->accept(this);
+
+	std::size_t num_rets = 0;
+	if(stmt->type() == ASTType::Call)
+	{
+		const t_str& funcname = static_cast<const ASTCall*>(stmt.get())->GetIdent();
+		t_astret func = GetSym(funcname);
+		if(func->retty == SymbolType::COMP)
+			num_rets = func->elems.size();
+		else if(func->retty != SymbolType::VOID)
+			num_rets = 1;
+	}
+	else if(stmt->type() == ASTType::Map)
+	{
+		num_rets = 1;
+	}
+
+	for(std::size_t ret = 0; ret < num_rets; ++ret)
+		m_ostr->put(static_cast<t_vm_byte>(OpCode::POP));
+}
 // ----------------------------------------------------------------------------
@@ -5,10 +5,11 @@
  * @license see 'LICENSE' file
  */
 
-// g++ -DUSE_DIRECT_PARSER -I.. -std=c++20 -o parser ../parser_direct/parser.cpp ../parser_direct/grammar.cpp ../parser_direct/lexer.cpp main_direct.cpp asm.cpp arr.cpp func.cpp ops.cpp var.cpp ../ast/printast.cpp  -llalr1 -lboost_program_options
+// g++ -DUSE_DIRECT_PARSER -I.. -std=c++20 -o parser ../parser_direct/parser.cpp ../parser_direct/grammar.cpp ../parser_direct/lexer.cpp main_direct.cpp asm.cpp arr.cpp func.cpp ops.cpp var.cpp ../ast/printast.cpp ../ast/multchain.cpp  -llalr1 -lboost_program_options
 
 #include "ast/ast.h"
 #include "ast/printast.h"
+#include "ast/multchain.h"
 #include "ast/semantics.h"
 #include "common/helpers.h"
 #include "common/version.h"
@@ -201,6 +202,11 @@ int main(int argc, char** argv)
 		auto [parse_time, parse_time_unit] = get_elapsed_time<
 			t_real, t_timepoint>(parse_start_time);
 
+		// re-associate chains of matrix products
+		MultChain multchain{&ctx.GetSymbols()};
+		for(const auto& stmt : ctx.GetStatements()->GetStatementList())
+			multchain.Optimise(stmt);
+
 		if(show_symbols)
 		{
 			std::cout << "Writing symbol table to \"" << outprog_syms << "\"..." << std::endl;
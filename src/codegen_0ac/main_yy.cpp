@@ -7,6 +7,7 @@
 
 #include "ast/ast.h"
 #include "ast/printast.h"
+#include "ast/multchain.h"
 #include "ast/semantics.h"
 #include "common/helpers.h"
 #include "common/version.h"
@@ -130,6 +131,11 @@ int main(int argc, char** argv)
 			return res;
 		}
 
+		// re-associate chains of matrix products
+		MultChain multchain{&ctx.GetSymbols()};
+		for(const auto& stmt : ctx.GetStatements()->GetStatementList())
+			multchain.Optimise(stmt);
+
 		if(show_symbols)
 		{
 			std::cout << "Writing symbol table to \"" << outprog_syms << "\"..." << std::endl;
@@ -158,8 +158,230 @@ void ZeroACAsm::CastTo(t_astret ty_to,
 }
 
 
+/**
+ * finds the type of an element-wise expression without emitting code,
+ * counts the operations on arrays in num_ops
+ * @returns nullptr if the expression is not an element-wise one
+ */
+t_astret ZeroACAsm::GetFusedType(ASTType ty, const AST* ast, std::size_t& num_ops) const
+{
+	auto is_array = [](t_astret sym) -> bool
+	{
+		return sym->ty == SymbolType::VECTOR || sym->ty == SymbolType::MATRIX;
+	};
+
+	switch(ty)
+	{
+		case ASTType::Var:
+		{
+			t_astret sym = GetSym(static_cast<const ASTVar*>(ast)->GetIdent());
+			if(sym && (sym->ty == SymbolType::SCALAR || sym->ty == SymbolType::INT ||
+				is_array(sym)))
+				return sym;
+			return nullptr;
+		}
+
+		case ASTType::NumConst:
+		{
+			if(dynamic_cast<const ASTNumConst<t_real>*>(ast))
+				return m_scalar_const;
+			if(dynamic_cast<const ASTNumConst<t_int>*>(ast))
+				return m_int_const;
+			return nullptr;
+		}
+
+		case ASTType::UMinus:
+		{
+			const ASTPtr& term = static_cast<const ASTUMinus*>(ast)->GetTerm();
+			t_astret sym = GetFusedType(term->type(), term.get(), num_ops);
+			if(sym && is_array(sym))
+				++num_ops;
+			return sym;
+		}
+
+		case ASTType::Plus:
+		case ASTType::Mult:
+		case ASTType::ElemMult:
+		{
+			ASTPtr term1, term2;
+			bool inverted = false;
+			if(ty == ASTType::Plus)
+			{
+				const ASTPlus* plus = static_cast<const ASTPlus*>(ast);
+				term1 = plus->GetTerm1();
+				term2 = plus->GetTerm2();
+			}
+			else if(ty == ASTType::Mult)
+			{
+				const ASTMult* mult = static_cast<const ASTMult*>(ast);
+				term1 = mult->GetTerm1();
+				term2 = mult->GetTerm2();
+				inverted = mult->IsInverted();
+			}
+			else
+			{
+				const ASTElemMult* mult = static_cast<const ASTElemMult*>(ast);
+				term1 = mult->GetTerm1();
+				term2 = mult->GetTerm2();
+			}
+
+			t_astret sym1 = GetFusedType(term1->type(), term1.get(), num_ops);
+			t_astret sym2 = GetFusedType(term2->type(), term2.get(), num_ops);
+			if(!sym1 || !sym2)
+				return nullptr;
+
+			const bool is_arr1 = is_array(sym1);
+			const bool is_arr2 = is_array(sym2);
+
+			// scalar operation
+			if(!is_arr1 && !is_arr2)
+			{
+				if(sym1->ty == SymbolType::INT && sym2->ty == SymbolType::INT)
+					return m_int_const;
+				return m_scalar_const;
+			}
+
+			if(is_arr1 && is_arr2)
+			{
+				// matrix or inner product
+				if(ty == ASTType::Mult)
+					return nullptr;
+				// vector-matrix operation
+				if(sym1->ty != sym2->ty)
+					return nullptr;
+			}
+
+			// division of a scalar by an array
+			if(ty == ASTType::Mult && inverted && !is_arr1)
+				return nullptr;
+
+			++num_ops;
+			return is_arr1 ? sym1 : sym2;
+		}
+
+		default:
+		{
+			return nullptr;
+		}
+	}
+}
+
+
+/**
+ * emits the operands of an element-wise expression and appends their
+ * operations to the program, scalar sub-expressions are single operands
+ */
+void ZeroACAsm::EmitFused(ASTType ty, const AST* ast, t_vm_str& prog)
+{
+	auto emit_term = [this, &prog](const ASTPtr& term)
+	{
+		EmitFused(term->type(), term.get(), prog);
+	};
+
+	std::size_t num_ops = 0;
+	t_astret sym = GetFusedType(ty, ast, num_ops);
+
+	if(ty == ASTType::UMinus && num_ops)
+	{
+		emit_term(static_cast<const ASTUMinus*>(ast)->GetTerm());
+		prog += static_cast<char>(FusedOp::NEG);
+	}
+	else if(ty == ASTType::Plus && num_ops)
+	{
+		const ASTPlus* plus = static_cast<const ASTPlus*>(ast);
+		emit_term(plus->GetTerm1());
+		emit_term(plus->GetTerm2());
+		prog += static_cast<char>(plus->IsInverted() ? FusedOp::SUB : FusedOp::ADD);
+	}
+	else if(ty == ASTType::Mult && num_ops)
+	{
+		const ASTMult* mult = static_cast<const ASTMult*>(ast);
+		emit_term(mult->GetTerm1());
+		emit_term(mult->GetTerm2());
+		prog += static_cast<char>(mult->IsInverted() ? FusedOp::DIV : FusedOp::MUL);
+	}
+	else if(ty == ASTType::ElemMult && num_ops)
+	{
+		const ASTElemMult* mult = static_cast<const ASTElemMult*>(ast);
+		emit_term(mult->GetTerm1());
+		emit_term(mult->GetTerm2());
+		prog += static_cast<char>(mult->IsInverted() ? FusedOp::DIV : FusedOp::MUL);
+	}
+	else
+	{
+		// array variable or scalar sub-expression
+		if(!sym)
+			throw std::runtime_error("EmitFused: Invalid operand in element-wise expression.");
+
+		if(ty == ASTType::Var && (sym->ty == SymbolType::VECTOR || sym->ty == SymbolType::MATRIX))
+		{
+			// the vm reads array variables in place, push only their address
+			m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+			m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
+			t_vm_addr addr = static_cast<t_vm_addr>(*sym->addr);
+			m_ostr->write(reinterpret_cast<const char*>(&addr),
+				vm_type_size<VMType::ADDR_BP, false>);
+		}
+		else
+		{
+			ast->accept(this);
+		}
+
+		prog += static_cast<char>(FusedOp::LOAD);
+	}
+}
+
+
+/**
+ * emits a single FUSED operation for a tree of element-wise array operations,
+ * which is evaluated without intermediate arrays,
+ * if an array variable dst of the same shape is given, the result is written into it
+ * @returns nullptr if the expression has to be evaluated operation by operation
+ */
+t_astret ZeroACAsm::TryFused(ASTType ty, const AST* ast, t_astret dst)
+{
+	std::size_t num_ops = 0;
+	t_astret sym = GetFusedType(ty, ast, num_ops);
+
+	// a single operation is not worth fusing
+	if(!sym || num_ops < 2)
+		return nullptr;
+
+	if(dst)
+	{
+		if(dst->ty != sym->ty || !dst->addr)
+			return nullptr;
+		if(std::get<0>(dst->dims) != std::get<0>(sym->dims))
+			return nullptr;
+		if(dst->ty == SymbolType::MATRIX && std::get<1>(dst->dims) != std::get<1>(sym->dims))
+			return nullptr;
+	}
+
+	t_vm_str prog;
+	EmitFused(ty, ast, prog);
+
+	if(dst)
+	{
+		// push the address of the variable receiving the result
+		m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+		m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
+		t_vm_addr addr = static_cast<t_vm_addr>(*dst->addr);
+		m_ostr->write(reinterpret_cast<const char*>(&addr),
+			vm_type_size<VMType::ADDR_BP, false>);
+	}
+
+	PushStrConst(prog);
+	m_ostr->put(static_cast<t_vm_byte>(dst ? OpCode::FUSEDMEM : OpCode::FUSED));
+
+	return dst ? dst : sym;
+}
+
+
 t_astret ZeroACAsm::visit(const ASTUMinus* ast)
 {
+	if(t_astret sym = TryFused(ASTType::UMinus, ast); sym)
+		return sym;
+
 	t_astret term = ast->GetTerm()->accept(this);
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::USUB));
 
@@ -169,6 +391,9 @@ t_astret ZeroACAsm::visit(const ASTUMinus* ast)
 
 t_astret ZeroACAsm::visit(const ASTPlus* ast)
 {
+	if(t_astret sym = TryFused(ASTType::Plus, ast); sym)
+		return sym;
+
 	t_astret term1 = ast->GetTerm1()->accept(this);
 	std::streampos term1_pos = m_ostr->tellp();
 	// placeholder for potential cast
@@ -199,7 +424,42 @@ t_astret ZeroACAsm::visit(const ASTPlus* ast)
 
 t_astret ZeroACAsm::visit(const ASTMult* ast)
 {
-	t_astret term1 = ast->GetTerm1()->accept(this);
+	if(t_astret sym = TryFused(ASTType::Mult, ast); sym)
+		return sym;
+
+	t_astret term1 = nullptr;
+
+	// A^(-1) * x is solved for x instead of inverting A
+	if(const ASTPow* inv = ast->IsInverted() ? nullptr : get_inversion(ast->GetTerm1()); inv)
+	{
+		term1 = inv->GetTerm1()->accept(this);
+
+		// use return type for function
+		t_astret base = term1;
+		if(base && base->ty == SymbolType::FUNC)
+			base = GetTypeConst(base->retty);
+
+		if(base && base->ty == SymbolType::MATRIX)
+		{
+			t_astret term2 = ast->GetTerm2()->accept(this);
+			CallExternal("inv_mult");
+
+			// the result has the shape of term2, or of the matrix for a scalar term2
+			t_astret rhs = term2;
+			if(rhs && rhs->ty == SymbolType::FUNC)
+				rhs = GetTypeConst(rhs->retty);
+			if(rhs && (rhs->ty == SymbolType::VECTOR || rhs->ty == SymbolType::MATRIX))
+				return term2;
+			return term1;
+		}
+
+		term1 = Pow(term1, inv->GetTerm2());
+	}
+	else
+	{
+		term1 = ast->GetTerm1()->accept(this);
+	}
+
 	std::streampos term1_pos = m_ostr->tellp();
 	// placeholder for potential cast
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::NOP));
@@ -227,6 +487,39 @@ t_astret ZeroACAsm::visit(const ASTMult* ast)
 }
 
 
+t_astret ZeroACAsm::visit(const ASTElemMult* ast)
+{
+	if(t_astret sym = TryFused(ASTType::ElemMult, ast); sym)
+		return sym;
+
+	t_astret term1 = ast->GetTerm1()->accept(this);
+	std::streampos term1_pos = m_ostr->tellp();
+	// placeholder for potential cast
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::NOP));
+
+	t_astret term2 = ast->GetTerm2()->accept(this);
+	std::streampos term2_pos = m_ostr->tellp();
+
+	t_astret common_type = term1;
+
+	// cast if needed
+	auto [first_ty, second_ty, res_ty]
+		= GetCastSymType(term1, term2);
+	if(first_ty)
+		CastTo(first_ty, term1_pos);
+	if(second_ty)
+		CastTo(second_ty, term2_pos);
+	common_type = res_ty;
+
+	if(ast->IsInverted())
+		m_ostr->put(static_cast<t_vm_byte>(OpCode::EDIV));
+	else
+		m_ostr->put(static_cast<t_vm_byte>(OpCode::EMUL));
+
+	return common_type;
+}
+
+
 t_astret ZeroACAsm::visit(const ASTMod* ast)
 {
 	t_astret term1 = ast->GetTerm1()->accept(this);
@@ -257,11 +550,20 @@ t_astret ZeroACAsm::visit(const ASTMod* ast)
 t_astret ZeroACAsm::visit(const ASTPow* ast)
 {
 	t_astret term1 = ast->GetTerm1()->accept(this);
+	return Pow(term1, ast->GetTerm2());
+}
+
+
+/**
+ * raises the already evaluated term1 to the given power
+ */
+t_astret ZeroACAsm::Pow(t_astret term1, const ASTPtr& exp)
+{
 	std::streampos term1_pos = m_ostr->tellp();
 	// placeholder for potential cast
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::NOP));
 
-	t_astret term2 = ast->GetTerm2()->accept(this);
+	t_astret term2 = exp->accept(this);
 	std::streampos term2_pos = m_ostr->tellp();
 
 	t_astret common_type = term1;
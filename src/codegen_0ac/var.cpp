@@ -161,6 +161,9 @@ t_astret ZeroACAsm::visit(const ASTVar* ast)
 	if(!sym->addr)
 		throw std::runtime_error("ASTVar: Variable \"" + varname + "\" has not been declared.");
 
+	if(m_parloop_vars.contains(sym))
+		++m_parloop_var_reads;
+
 	// push variable address
 	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
 	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
@@ -194,6 +197,20 @@ void ZeroACAsm::AssignVar(t_astret sym)
 
 t_astret ZeroACAsm::visit(const ASTAssign* ast)
 {
+	for(const t_str& varname : ast->GetIdents())
+		CheckParLoopWrite(GetSym(varname));
+
+	// evaluate an element-wise array expression directly into the variable
+	if(ast->GetExpr() && ast->GetIdents().size() == 1)
+	{
+		const ASTPtr& expr = ast->GetExpr();
+		if(t_astret sym = GetSym(ast->GetIdents()[0]); sym && sym->addr)
+		{
+			if(TryFused(expr->type(), expr.get(), sym))
+				return sym;
+		}
+	}
+
 	if(ast->GetExpr())
 		ast->GetExpr()->accept(this);
 	t_astret sym_ret = nullptr;
@@ -215,6 +232,75 @@ t_astret ZeroACAsm::visit(const ASTAssign* ast)
 
 	return sym_ret;
 }
+
+
+t_astret ZeroACAsm::visit(const ASTCompoundAssign* ast)
+{
+	const t_str& varname = ast->GetIdent();
+	t_astret sym = GetSym(varname);
+	if(!sym)
+		throw std::runtime_error("ASTCompoundAssign: Variable \"" + varname + "\" is not in symbol table.");
+	if(!sym->addr)
+		throw std::runtime_error("ASTCompoundAssign: Variable \"" + varname + "\" has not been declared.");
+
+	// non-array variables are assigned like "var = var op expr"
+	if(sym->ty != SymbolType::VECTOR && sym->ty != SymbolType::MATRIX)
+		return ast->GetAssignment()->accept(this);
+
+	CheckParLoopWrite(sym);
+	t_astret term = ast->GetExpr()->accept(this);
+
+	// use return type for function
+	if(term && term->ty == SymbolType::FUNC)
+		term = GetTypeConst(term->retty);
+	if(!term)
+		throw std::runtime_error("ASTCompoundAssign: Invalid operand for \"" + varname + "\".");
+
+	OpCode op = OpCode::INVALID;
+
+	switch(ast->GetOp())
+	{
+		case ASTCompoundAssign::ADD:
+		case ASTCompoundAssign::SUB:
+		{
+			// element-wise operation, the vm combines scalars with all elements
+			if(term->ty != sym->ty && term->ty != SymbolType::SCALAR && term->ty != SymbolType::INT)
+			{
+				throw std::runtime_error("ASTCompoundAssign: Type mismatch for array \""
+					+ varname + "\".");
+			}
+
+			op = (ast->GetOp() == ASTCompoundAssign::ADD ? OpCode::ADDMEM : OpCode::SUBMEM);
+			break;
+		}
+
+		case ASTCompoundAssign::MUL:
+		case ASTCompoundAssign::DIV:
+		{
+			// arrays can only be scaled in place
+			if(term->ty != SymbolType::SCALAR && term->ty != SymbolType::INT)
+			{
+				throw std::runtime_error("ASTCompoundAssign: Array \"" + varname
+					+ "\" can only be scaled by a scalar.");
+			}
+
+			op = (ast->GetOp() == ASTCompoundAssign::MUL ? OpCode::MULMEM : OpCode::DIVMEM);
+			break;
+		}
+	}
+
+	// push variable address
+	m_ostr->put(static_cast<t_vm_byte>(OpCode::PUSH));
+	m_ostr->put(static_cast<t_vm_byte>(VMType::ADDR_BP));
+	t_vm_addr addr = static_cast<t_vm_addr>(*sym->addr);
+	m_ostr->write(reinterpret_cast<const char*>(&addr),
+		vm_type_size<VMType::ADDR_BP, false>);
+
+	// operate on the variable in place
+	m_ostr->put(static_cast<t_vm_byte>(op));
+
+	return sym;
+}
 // ----------------------------------------------------------------------------
 
 
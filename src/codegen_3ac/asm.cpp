@@ -12,6 +12,7 @@
 
 #include "asm.h"
 #include <sstream>
+#include <algorithm>
 
 
 // type names
@@ -73,6 +74,242 @@ t_astret LLAsm::visit(const ASTLoop* ast)
 }
 
 
+/**
+ * parallel loop: the body is outlined into a function which is called by the
+ * runtime on several threads, each of them running a chunk of the index range;
+ * the variables of the enclosing function are passed as pointers in a context
+ * array, the loop variable and the accumulators are private to each chunk
+ */
+t_astret LLAsm::visit(const ASTParLoop* ast)
+{
+	if(m_funcstack.empty())
+		throw std::runtime_error("ASTParLoop: Parallel loop is not inside a function.");
+
+	t_astret loopvar = get_sym(ast->GetIdent());
+	if(loopvar->ty != SymbolType::INT)
+		throw std::runtime_error("ASTParLoop: Loop variable \"" + ast->GetIdent() + "\" has to be an integer.");
+
+	std::vector<t_astret> accs;
+	for(const t_str& accname : ast->GetAccumulators())
+	{
+		t_astret acc = get_sym(accname);
+		if(acc->ty != SymbolType::SCALAR && acc->ty != SymbolType::INT &&
+			acc->ty != SymbolType::VECTOR && acc->ty != SymbolType::MATRIX)
+			throw std::runtime_error("ASTParLoop: Accumulator \"" + accname + "\" has to be numeric.");
+		accs.push_back(acc);
+	}
+
+	t_astret begin = convert_sym(ast->GetBegin()->accept(this), SymbolType::INT);
+	t_astret end = convert_sym(ast->GetEnd()->accept(this), SymbolType::INT);
+
+	const t_str funcname = "__parfor_" + std::to_string(m_parLoopCount++);
+
+
+	// --------------------------------------------------------------------
+	// generate the body of the outlined function
+	// --------------------------------------------------------------------
+	ParLoopVars vars{};
+	std::ostringstream ostrBody;
+	ostrBody.precision(m_ostr->precision());
+
+	ParLoopVars* outerVars = m_parLoopVars;
+	std::ostream* outerOstr = m_ostr;
+	std::vector<t_str> outerLoopStart, outerLoopEnd;
+	std::swap(outerLoopStart, m_loopStartStack);
+	std::swap(outerLoopEnd, m_loopEndStack);
+	m_parLoopVars = &vars;
+	m_ostr = &ostrBody;
+
+	// the accumulators are always needed for the reduction
+	vars.used = accs;
+
+	t_astret ctr = get_tmp_var(SymbolType::INT);
+	(*m_ostr) << "%" << ctr->name << " = alloca " << m_int << "\n";
+	(*m_ostr) << "store " << m_int << " %__begin, " << m_intptr << " %" << ctr->name << "\n";
+
+	generate_loop([this, ctr, loopvar]() -> t_astret
+	{
+		// loop condition: ctr < end, the counter is incremented here to also cover "next"
+		t_astret ctrval = get_tmp_var(SymbolType::INT);
+		(*m_ostr) << "%" << ctrval->name << " = load " << m_int << ", " << m_intptr
+			<< " %" << ctr->name << "\n";
+		(*m_ostr) << "store " << m_int << " %" << ctrval->name << ", " << m_intptr
+			<< " %" << loopvar->name << "\n";
+
+		t_astret newctrval = get_tmp_var(SymbolType::INT);
+		(*m_ostr) << "%" << newctrval->name << " = add " << m_int
+			<< " %" << ctrval->name << ", 1\n";
+		(*m_ostr) << "store " << m_int << " %" << newctrval->name << ", " << m_intptr
+			<< " %" << ctr->name << "\n";
+
+		t_astret _cond = get_tmp_var();
+		(*m_ostr) << "%" << _cond->name << " = icmp slt " << m_int
+			<< " %" << ctrval->name << ", %__end\n";
+		return _cond;
+	}, [this, ast]
+	{
+		ast->GetLoopStmt()->accept(this);
+	});
+
+	// add the private accumulators to the shared ones
+	if(accs.size())
+	{
+		(*m_ostr) << "call void @ext_parfor_lock()\n";
+		for(t_astret acc : accs)
+		{
+			t_str ty = LLAsm::get_type_name(acc->ty);
+
+			if(acc->ty == SymbolType::SCALAR || acc->ty == SymbolType::INT)
+			{
+				t_astret priv = get_tmp_var(acc->ty);
+				t_astret shared = get_tmp_var(acc->ty);
+				t_astret sum = get_tmp_var(acc->ty);
+
+				(*m_ostr) << "%" << priv->name << " = load " << ty << ", " << ty << "* %" << acc->name << "\n";
+				(*m_ostr) << "%" << shared->name << " = load " << ty << ", " << ty << "* %__shared_" << acc->name << "\n";
+				(*m_ostr) << "%" << sum->name << " = " << (acc->ty == SymbolType::INT ? "add " : "fadd ")
+					<< ty << " %" << shared->name << ", %" << priv->name << "\n";
+				(*m_ostr) << "store " << ty << " %" << sum->name << ", " << ty << "* %__shared_" << acc->name << "\n";
+			}
+			else
+			{
+				std::size_t dim = get_arraydim(acc);
+
+				generate_loop(0, static_cast<t_int>(dim), [this, acc, dim](t_astret ctrval)
+				{
+					t_astret privptr = get_tmp_var();
+					t_astret sharedptr = get_tmp_var();
+					t_astret priv = get_tmp_var(SymbolType::SCALAR);
+					t_astret shared = get_tmp_var(SymbolType::SCALAR);
+					t_astret sum = get_tmp_var(SymbolType::SCALAR);
+
+					(*m_ostr) << "%" << privptr->name << " = getelementptr [" << dim << " x " << m_real << "], ["
+						<< dim << " x " << m_real << "]* %" << acc->name << ", " << m_int << " 0, "
+						<< m_int << " %" << ctrval->name << "\n";
+					(*m_ostr) << "%" << sharedptr->name << " = getelementptr [" << dim << " x " << m_real << "], ["
+						<< dim << " x " << m_real << "]* %__shared_" << acc->name << ", " << m_int << " 0, "
+						<< m_int << " %" << ctrval->name << "\n";
+					(*m_ostr) << "%" << priv->name << " = load " << m_real << ", " << m_realptr << " %" << privptr->name << "\n";
+					(*m_ostr) << "%" << shared->name << " = load " << m_real << ", " << m_realptr << " %" << sharedptr->name << "\n";
+					(*m_ostr) << "%" << sum->name << " = fadd " << m_real << " %" << shared->name << ", %" << priv->name << "\n";
+					(*m_ostr) << "store " << m_real << " %" << sum->name << ", " << m_realptr << " %" << sharedptr->name << "\n";
+				});
+			}
+		}
+		(*m_ostr) << "call void @ext_parfor_unlock()\n";
+	}
+
+	m_ostr = outerOstr;
+	m_parLoopVars = outerVars;
+	std::swap(outerLoopStart, m_loopStartStack);
+	std::swap(outerLoopEnd, m_loopEndStack);
+
+
+	// --------------------------------------------------------------------
+	// variables of the enclosing function which have to be passed to the body
+	// --------------------------------------------------------------------
+	std::vector<t_astret> captured;
+	for(t_astret sym : vars.used)
+	{
+		if(sym == loopvar ||
+			std::find(vars.declared.begin(), vars.declared.end(), sym) != vars.declared.end())
+			continue;
+		captured.push_back(sym);
+
+		// also pass them on from an enclosing parallel loop
+		if(m_parLoopVars && std::find(m_parLoopVars->used.begin(), m_parLoopVars->used.end(), sym)
+			== m_parLoopVars->used.end())
+			m_parLoopVars->used.push_back(sym);
+	}
+
+	auto get_alloca_type = [](t_astret sym) -> t_str
+	{
+		if(sym->ty == SymbolType::VECTOR || sym->ty == SymbolType::MATRIX)
+			return "[" + std::to_string(get_arraydim(sym)) + " x " + m_real + "]";
+		else if(sym->ty == SymbolType::STRING)
+			return "[" + std::to_string(std::get<0>(sym->dims)) + " x i8]";
+		return LLAsm::get_type_name(sym->ty);
+	};
+
+
+	// --------------------------------------------------------------------
+	// outlined function
+	// --------------------------------------------------------------------
+	std::ostringstream ostrFunc;
+	ostrFunc << "define void @" << funcname << "(i8* %__ctx, "
+		<< m_int << " %__begin, " << m_int << " %__end)\n{\n";
+	ostrFunc << "%__ctxarr = bitcast i8* %__ctx to i8**\n";
+
+	for(std::size_t idx=0; idx<captured.size(); ++idx)
+	{
+		t_astret sym = captured[idx];
+		t_str ty = get_alloca_type(sym);
+
+		bool is_acc = std::find(accs.begin(), accs.end(), sym) != accs.end();
+		t_str name = is_acc ? "__shared_" + sym->name : sym->name;
+
+		ostrFunc << "%__ctxptr_" << idx << " = getelementptr i8*, i8** %__ctxarr, "
+			<< m_int << " " << idx << "\n";
+		ostrFunc << "%__ctxval_" << idx << " = load i8*, i8** %__ctxptr_" << idx << "\n";
+		ostrFunc << "%" << name << " = bitcast i8* %__ctxval_" << idx << " to " << ty << "*\n";
+	}
+
+	// private loop variable and accumulators
+	ostrFunc << "%" << loopvar->name << " = alloca " << m_int << "\n";
+	for(t_astret acc : accs)
+	{
+		t_str ty = get_alloca_type(acc);
+		ostrFunc << "%" << acc->name << " = alloca " << ty << "\n";
+
+		if(acc->ty == SymbolType::INT)
+			ostrFunc << "store " << ty << " 0, " << ty << "* %" << acc->name << "\n";
+		else if(acc->ty == SymbolType::SCALAR)
+			ostrFunc << "store " << ty << " 0.0, " << ty << "* %" << acc->name << "\n";
+		else
+			ostrFunc << "store " << ty << " zeroinitializer, " << ty << "* %" << acc->name << "\n";
+	}
+
+	ostrFunc << ostrBody.str();
+	ostrFunc << "ret void\n}\n";
+	m_parLoopFuncs.push_back(ostrFunc.str());
+
+
+	// --------------------------------------------------------------------
+	// call the outlined function for the index range [begin, end]
+	// --------------------------------------------------------------------
+	t_str ctx = "__ctx_" + std::to_string(m_parLoopCount - 1);
+	(*m_ostr) << "%" << ctx << " = alloca [" << captured.size() << " x i8*]\n";
+	for(std::size_t idx=0; idx<captured.size(); ++idx)
+	{
+		t_astret sym = captured[idx];
+		t_str ty = get_alloca_type(sym);
+
+		t_astret ctxptr = get_tmp_var();
+		t_astret ptr = get_tmp_var();
+		(*m_ostr) << "%" << ctxptr->name << " = getelementptr [" << captured.size() << " x i8*], ["
+			<< captured.size() << " x i8*]* %" << ctx << ", " << m_int << " 0, " << m_int << " " << idx << "\n";
+		(*m_ostr) << "%" << ptr->name << " = bitcast " << ty << "* %" << sym->name << " to i8*\n";
+		(*m_ostr) << "store i8* %" << ptr->name << ", i8** %" << ctxptr->name << "\n";
+	}
+
+	t_astret ctxptr = get_tmp_var();
+	(*m_ostr) << "%" << ctxptr->name << " = bitcast [" << captured.size() << " x i8*]* %"
+		<< ctx << " to i8*\n";
+
+	t_astret end1 = get_tmp_var(SymbolType::INT);
+	(*m_ostr) << "%" << end1->name << " = add " << m_int << " %" << end->name << ", 1\n";
+	(*m_ostr) << "call void @ext_parfor(void (i8*, " << m_int << ", " << m_int << ")* @" << funcname
+		<< ", i8* %" << ctxptr->name << ", " << m_int << " %" << begin->name
+		<< ", " << m_int << " %" << end1->name << ")\n";
+
+	// the loop variable holds the last index, as after a sequential loop
+	(*m_ostr) << "store " << m_int << " %" << end->name << ", " << m_intptr
+		<< " %" << loopvar->name << "\n";
+
+	return nullptr;
+}
+
+
 t_astret LLAsm::visit(const ASTLoopBreak* ast)
 {
 	if(!m_loopEndStack.size())
@@ -84,6 +321,10 @@ t_astret LLAsm::visit(const ASTLoopBreak* ast)
 	if(static_cast<std::size_t>(loop_depth) >= m_loopEndStack.size() || loop_depth < 0)
 		loop_depth = static_cast<t_int>(m_loopEndStack.size()-1);
 
+	// the outermost loop of an outlined body is the parallel loop
+	if(m_parLoopVars && static_cast<std::size_t>(loop_depth) == m_loopEndStack.size()-1)
+		throw std::runtime_error("ASTLoopBreak: Cannot break out of a parallel loop.");
+
 	const t_str& labelEnd = *(m_loopEndStack.rbegin() + loop_depth);
 	(*m_ostr) << "br label %" << labelEnd << "\n";
 
@@ -322,6 +563,12 @@ t_astret LLAsm::get_sym(const t_str& name) const
 	if(sym == nullptr)
 		throw std::runtime_error("get_sym: \"" + scoped_name + "\" does not have an associated symbol.");
 
+	// remember the variables used in the body of a parallel loop
+	if(m_parLoopVars && !sym->is_tmp && sym->ty != SymbolType::FUNC &&
+		std::find(m_parLoopVars->used.begin(), m_parLoopVars->used.end(), sym)
+			== m_parLoopVars->used.end())
+		m_parLoopVars->used.push_back(sym);
+
 	//++sym->refcnt;	// increment symbol's reference counter
 	return sym;
 }
@@ -340,6 +587,17 @@ t_astret LLAsm::convert_sym(t_astret sym, SymbolType ty_to)
 	else if(ty_to == SymbolType::MATRIX && sym->ty == SymbolType::VECTOR)
 		return sym;
 
+	// re-interpret matrix as vector of all its elements
+	else if(ty_to == SymbolType::VECTOR && sym->ty == SymbolType::MATRIX)
+	{
+		std::size_t dim = get_arraydim(sym);
+		std::array<std::size_t, 2> dims{{dim, 1}};
+		t_astret var = get_tmp_var(SymbolType::VECTOR, &dims);
+		(*m_ostr) << "%" << var->name << " = bitcast [" << dim << " x " << m_real << "]* %"
+			<< sym->name << " to [" << dim << " x " << m_real << "]*\n";
+		return var;
+	}
+
 
 	// scalar conversions
 	if(ty_to == SymbolType::SCALAR || ty_to == SymbolType::INT)
@@ -643,6 +901,391 @@ t_astret LLAsm::scalar_matrix_prod(t_astret scalar, t_astret matrix, bool mul_or
 }
 
 
+/**
+ * solves lhs*x = rhs for a matrix or an lu decomposition handle lhs,
+ * the result has the shape of the right-hand side
+ */
+t_astret LLAsm::solve(t_astret lhs, t_astret rhs)
+{
+	if(rhs->ty != SymbolType::VECTOR && rhs->ty != SymbolType::MATRIX)
+	{
+		throw std::runtime_error("solve: The right-hand side \"" + rhs->name
+			+ "\" has to be a vector or a matrix.");
+	}
+
+	std::size_t dim_n = std::get<0>(rhs->dims);
+	std::size_t dim_cols = rhs->ty == SymbolType::MATRIX ? std::get<1>(rhs->dims) : 1;
+	std::size_t dim = get_arraydim(rhs);
+
+	// cast right-hand side pointer to element pointer
+	t_astret rhsptr = get_tmp_var();
+	(*m_ostr) << "%" << rhsptr->name << " = bitcast ["
+		<< dim << " x " << m_real << "]* %" << rhs->name << " to " << m_realptr << "\n";
+
+	// allocate result array
+	t_astret result_mem = get_tmp_var(rhs->ty, &rhs->dims);
+	(*m_ostr) << "%" << result_mem->name << " = alloca [" << dim << " x " << m_real << "]\n";
+	t_astret resultptr = get_tmp_var();
+	(*m_ostr) << "%" << resultptr->name << " = bitcast ["
+		<< dim << " x " << m_real << "]* %" << result_mem->name << " to " << m_realptr << "\n";
+
+	// a singular matrix or an invalid handle give a zero result
+	t_astret result_status = get_tmp_var(SymbolType::INT);
+
+	if(lhs->ty == SymbolType::MATRIX)
+	{
+		if(std::get<0>(lhs->dims) != dim_n || std::get<1>(lhs->dims) != dim_n)
+		{
+			throw std::runtime_error("solve: Dimension mismatch in linear system of \""
+				+ lhs->name + "\" and \"" + rhs->name + "\".");
+		}
+
+		t_astret lhsptr = get_tmp_var();
+		(*m_ostr) << "%" << lhsptr->name << " = bitcast ["
+			<< dim_n*dim_n << " x " << m_real << "]* %" << lhs->name << " to " << m_realptr << "\n";
+
+		(*m_ostr) << "%" << result_status->name << " = call " << m_int << " @ext_solve_mat("
+			<< m_realptr << " %" << lhsptr->name << ", "
+			<< m_realptr << " %" << rhsptr->name << ", "
+			<< m_realptr << " %" << resultptr->name << ", "
+			<< m_int << " " << dim_n << ", " << m_int << " " << dim_cols << ")\n";
+	}
+	else
+	{
+		// lu decomposition handle returned by factor()
+		lhs = convert_sym(lhs, SymbolType::INT);
+
+		(*m_ostr) << "%" << result_status->name << " = call " << m_int << " @ext_solve_factor("
+			<< m_int << " %" << lhs->name << ", "
+			<< m_realptr << " %" << rhsptr->name << ", "
+			<< m_realptr << " %" << resultptr->name << ", "
+			<< m_int << " " << dim_n << ", " << m_int << " " << dim_cols << ")\n";
+	}
+
+	return result_mem;
+}
+
+
+/**
+ * qr, cholesky or symmetric eigen decomposition of a matrix,
+ * returns a compound symbol whose elements are shaped by the matrix
+ */
+t_astret LLAsm::decomposition(const t_str& funcname, t_astret mat)
+{
+	if(mat->ty != SymbolType::MATRIX)
+		throw std::runtime_error(funcname + ": Argument \"" + mat->name + "\" has to be a matrix.");
+
+	const std::size_t rows = std::get<0>(mat->dims);
+	const std::size_t cols = std::get<1>(mat->dims);
+	if(funcname != "qr" && rows != cols)
+		throw std::runtime_error(funcname + ": Matrix \"" + mat->name + "\" has to be square.");
+
+	auto make_elem = [](SymbolType ty, std::size_t dim1, std::size_t dim2) -> SymbolPtr
+	{
+		auto elem = std::make_shared<Symbol>();
+		elem->ty = ty;
+		elem->dims = {{ dim1, dim2 }};
+		return elem;
+	};
+
+	std::vector<SymbolPtr> elems;
+	if(funcname == "qr")
+		elems = { make_elem(SymbolType::MATRIX, rows, rows), make_elem(SymbolType::MATRIX, rows, cols) };
+	else if(funcname == "chol")
+		elems = { make_elem(SymbolType::MATRIX, rows, rows), make_elem(SymbolType::INT, 1, 1) };
+	else
+		elems = { make_elem(SymbolType::VECTOR, rows, 1), make_elem(SymbolType::MATRIX, rows, rows) };
+
+	t_astret matptr = get_tmp_var();
+	(*m_ostr) << "%" << matptr->name << " = bitcast ["
+		<< rows*cols << " x " << m_real << "]* %" << mat->name << " to " << m_realptr << "\n";
+
+	// the runtime returns the elements in a heap memory block
+	t_astret retvar = get_tmp_var(SymbolType::COMP);
+	(*m_ostr) << "%" << retvar->name << " = call i8* @ext_" << funcname << "("
+		<< m_realptr << " %" << matptr->name << ", "
+		<< m_int << " " << rows << ", " << m_int << " " << cols << ")\n";
+
+	// the element dimensions are known and are checked on assignment
+	Symbol *comp = const_cast<Symbol*>(retvar);
+	comp->elems = elems;
+	comp->is_external = true;
+
+	return retvar;
+}
+
+
+/**
+ * sin, cos, tan, exp, sqrt or pow of all elements of a vector or matrix,
+ * groups of elements are passed to llvm's vector intrinsics
+ */
+t_astret LLAsm::elementwise_func(const t_str& funcname, t_astret arg, t_astret exp)
+{
+	const std::size_t dim = get_arraydim(arg);
+	const std::size_t dim_simd = dim / m_simd_lanes * m_simd_lanes;
+
+	const t_str sfx = get_llintrinsic_suffix<t_real>();
+	const t_str vecty = "<" + std::to_string(m_simd_lanes) + " x " + m_real + ">";
+	const t_str vecsfx = "v" + std::to_string(m_simd_lanes) + sfx;
+
+	// the exponent is a scalar, also splat it to all lanes
+	t_astret exp_vec = nullptr;
+	if(funcname == "pow")
+	{
+		if(!exp || (exp->ty != SymbolType::SCALAR && exp->ty != SymbolType::INT))
+			throw std::runtime_error("pow: The exponent of \"" + arg->name + "\" has to be a scalar.");
+		exp = convert_sym(exp, SymbolType::SCALAR);
+
+		t_astret exp_ins = get_tmp_var();
+		exp_vec = get_tmp_var();
+		(*m_ostr) << "%" << exp_ins->name << " = insertelement " << vecty << " undef, "
+			<< m_real << " %" << exp->name << ", i32 0\n";
+		(*m_ostr) << "%" << exp_vec->name << " = shufflevector " << vecty << " %"
+			<< exp_ins->name << ", " << vecty << " undef, <" << m_simd_lanes
+			<< " x i32> zeroinitializer\n";
+	}
+
+	// calls the intrinsic for the given (vector or scalar) type,
+	// tan is not available as intrinsic and is calculated as sin/cos
+	auto call_func = [this, &funcname, exp, exp_vec](const t_str& ty,
+		const t_str& tysfx, t_astret val) -> t_astret
+	{
+		t_astret result = get_tmp_var();
+
+		if(funcname == "tan")
+		{
+			t_astret sinval = get_tmp_var();
+			t_astret cosval = get_tmp_var();
+			(*m_ostr) << "%" << sinval->name << " = call " << ty << " @llvm.sin." << tysfx
+				<< "(" << ty << " %" << val->name << ")\n";
+			(*m_ostr) << "%" << cosval->name << " = call " << ty << " @llvm.cos." << tysfx
+				<< "(" << ty << " %" << val->name << ")\n";
+			(*m_ostr) << "%" << result->name << " = fdiv " << ty << " %"
+				<< sinval->name << ", %" << cosval->name << "\n";
+		}
+		else if(funcname == "pow")
+		{
+			t_astret expval = (ty == m_real ? exp : exp_vec);
+			(*m_ostr) << "%" << result->name << " = call " << ty << " @llvm.pow." << tysfx
+				<< "(" << ty << " %" << val->name << ", " << ty << " %" << expval->name << ")\n";
+		}
+		else
+		{
+			(*m_ostr) << "%" << result->name << " = call " << ty << " @llvm." << funcname
+				<< "." << tysfx << "(" << ty << " %" << val->name << ")\n";
+		}
+
+		return result;
+	};
+
+	// allocate real array for result
+	t_astret vec_mem = get_tmp_var(arg->ty, &arg->dims);
+	(*m_ostr) << "%" << vec_mem->name << " = alloca [" << dim << " x " << m_real << "]\n";
+
+	// element pointer for the given index
+	auto get_elemptr = [this, dim](t_astret arr, const t_str& idx) -> t_astret
+	{
+		t_astret elemptr = get_tmp_var();
+		(*m_ostr) << "%" << elemptr->name << " = getelementptr ["
+			<< dim << " x " << m_real << "], ["
+			<< dim << " x " << m_real << "]* %"
+			<< arr->name << ", " << m_int << " 0, " << m_int
+			<< " " << idx << "\n";
+		return elemptr;
+	};
+
+	// full groups of elements, the arrays are only aligned to their elements
+	if(dim_simd)
+	{
+		generate_loop(0, static_cast<t_int>(dim_simd / m_simd_lanes),
+			[this, arg, vec_mem, &vecty, &vecsfx, &call_func, &get_elemptr](t_astret ctrval)
+		{
+			t_astret idx = get_tmp_var(SymbolType::INT);
+			(*m_ostr) << "%" << idx->name << " = mul " << m_int << " %"
+				<< ctrval->name << ", " << m_simd_lanes << "\n";
+
+			t_astret elemptr_src = get_elemptr(arg, "%" + idx->name);
+			t_astret vecptr_src = get_tmp_var();
+			t_astret vec_src = get_tmp_var();
+			(*m_ostr) << "%" << vecptr_src->name << " = bitcast " << m_realptr
+				<< " %" << elemptr_src->name << " to " << vecty << "*\n";
+			(*m_ostr) << "%" << vec_src->name << " = load " << vecty << ", "
+				<< vecty << "* %" << vecptr_src->name << ", align " << sizeof(t_real) << "\n";
+
+			t_astret vec_dst = call_func(vecty, vecsfx, vec_src);
+
+			t_astret elemptr_dst = get_elemptr(vec_mem, "%" + idx->name);
+			t_astret vecptr_dst = get_tmp_var();
+			(*m_ostr) << "%" << vecptr_dst->name << " = bitcast " << m_realptr
+				<< " %" << elemptr_dst->name << " to " << vecty << "*\n";
+			(*m_ostr) << "store " << vecty << " %" << vec_dst->name << ", "
+				<< vecty << "* %" << vecptr_dst->name << ", align " << sizeof(t_real) << "\n";
+		});
+	}
+
+	// remaining elements
+	for(std::size_t idx=dim_simd; idx<dim; ++idx)
+	{
+		t_astret elemptr_src = get_elemptr(arg, std::to_string(idx));
+		t_astret elem_src = get_tmp_var();
+		(*m_ostr) << "%" << elem_src->name << " = load "
+			<< m_real << ", " << m_realptr << " %" << elemptr_src->name << "\n";
+
+		t_astret elem_dst = call_func(m_real, sfx, elem_src);
+
+		t_astret elemptr_dst = get_elemptr(vec_mem, std::to_string(idx));
+		(*m_ostr) << "store " << m_real << " %" << elem_dst->name
+			<< ", " << m_realptr << " %" << elemptr_dst->name << "\n";
+	}
+
+	return vec_mem;
+}
+
+
+/**
+ * element-wise addition, subtraction, multiplication or division of two arrays of
+ * the same shape, or of an array and a scalar which is combined with all elements,
+ * groups of elements are processed as llvm vectors
+ */
+t_astret LLAsm::elementwise_arith(char op, t_astret term1, t_astret term2)
+{
+	const bool is_arr1 = (term1->ty == SymbolType::VECTOR || term1->ty == SymbolType::MATRIX);
+	const bool is_arr2 = (term2->ty == SymbolType::VECTOR || term2->ty == SymbolType::MATRIX);
+	t_astret arr = is_arr1 ? term1 : term2;
+
+	if(is_arr1 && is_arr2 && (term1->ty != term2->ty ||
+		std::get<0>(term1->dims) != std::get<0>(term2->dims) ||
+		(term1->ty == SymbolType::MATRIX && std::get<1>(term1->dims) != std::get<1>(term2->dims))))
+	{
+		throw std::runtime_error("Dimension mismatch in element-wise operation of \""
+			+ term1->name + "\" and \"" + term2->name + "\".");
+	}
+
+	for(t_astret term : { term1, term2 })
+	{
+		if(term->ty != SymbolType::VECTOR && term->ty != SymbolType::MATRIX &&
+			term->ty != SymbolType::SCALAR && term->ty != SymbolType::INT)
+		{
+			throw std::runtime_error("Invalid operand \"" + term->name
+				+ "\" in element-wise operation.");
+		}
+	}
+
+	const std::size_t dim = get_arraydim(arr);
+	const std::size_t dim_simd = dim / m_simd_lanes * m_simd_lanes;
+	const t_str vecty = "<" + std::to_string(m_simd_lanes) + " x " + m_real + ">";
+
+	t_str opname = "fadd";
+	if(op == '-')
+		opname = "fsub";
+	else if(op == '*')
+		opname = "fmul";
+	else if(op == '/')
+		opname = "fdiv";
+
+	// scalar operands are also splat to all lanes
+	std::array<t_astret, 2> terms{{ term1, term2 }};
+	std::array<t_astret, 2> splats{{ nullptr, nullptr }};
+	for(std::size_t idx=0; idx<terms.size(); ++idx)
+	{
+		if(terms[idx]->ty == SymbolType::VECTOR || terms[idx]->ty == SymbolType::MATRIX)
+			continue;
+
+		terms[idx] = convert_sym(terms[idx], SymbolType::SCALAR);
+		if(!dim_simd)
+			continue;
+
+		t_astret ins = get_tmp_var();
+		splats[idx] = get_tmp_var();
+		(*m_ostr) << "%" << ins->name << " = insertelement " << vecty << " undef, "
+			<< m_real << " %" << terms[idx]->name << ", i32 0\n";
+		(*m_ostr) << "%" << splats[idx]->name << " = shufflevector " << vecty << " %"
+			<< ins->name << ", " << vecty << " undef, <" << m_simd_lanes
+			<< " x i32> zeroinitializer\n";
+	}
+
+	// allocate real array for result
+	t_astret vec_mem = get_tmp_var(arr->ty, &arr->dims);
+	(*m_ostr) << "%" << vec_mem->name << " = alloca [" << dim << " x " << m_real << "]\n";
+
+	// element pointer for the given index
+	auto get_elemptr = [this, dim](t_astret sym, const t_str& idx) -> t_astret
+	{
+		t_astret elemptr = get_tmp_var();
+		(*m_ostr) << "%" << elemptr->name << " = getelementptr ["
+			<< dim << " x " << m_real << "], ["
+			<< dim << " x " << m_real << "]* %"
+			<< sym->name << ", " << m_int << " 0, " << m_int
+			<< " " << idx << "\n";
+		return elemptr;
+	};
+
+	// full groups of elements, the arrays are only aligned to their elements
+	if(dim_simd)
+	{
+		generate_loop(0, static_cast<t_int>(dim_simd / m_simd_lanes),
+			[this, &terms, &splats, vec_mem, &vecty, &opname, &get_elemptr](t_astret ctrval)
+		{
+			t_astret idx = get_tmp_var(SymbolType::INT);
+			(*m_ostr) << "%" << idx->name << " = mul " << m_int << " %"
+				<< ctrval->name << ", " << m_simd_lanes << "\n";
+
+			std::array<t_astret, 2> vals{{ splats[0], splats[1] }};
+			for(std::size_t term=0; term<terms.size(); ++term)
+			{
+				if(vals[term])
+					continue;
+
+				t_astret elemptr = get_elemptr(terms[term], "%" + idx->name);
+				t_astret vecptr = get_tmp_var();
+				vals[term] = get_tmp_var();
+				(*m_ostr) << "%" << vecptr->name << " = bitcast " << m_realptr
+					<< " %" << elemptr->name << " to " << vecty << "*\n";
+				(*m_ostr) << "%" << vals[term]->name << " = load " << vecty << ", "
+					<< vecty << "* %" << vecptr->name << ", align " << sizeof(t_real) << "\n";
+			}
+
+			t_astret vec_dst = get_tmp_var();
+			(*m_ostr) << "%" << vec_dst->name << " = " << opname << " " << vecty
+				<< " %" << vals[0]->name << ", %" << vals[1]->name << "\n";
+
+			t_astret elemptr_dst = get_elemptr(vec_mem, "%" + idx->name);
+			t_astret vecptr_dst = get_tmp_var();
+			(*m_ostr) << "%" << vecptr_dst->name << " = bitcast " << m_realptr
+				<< " %" << elemptr_dst->name << " to " << vecty << "*\n";
+			(*m_ostr) << "store " << vecty << " %" << vec_dst->name << ", "
+				<< vecty << "* %" << vecptr_dst->name << ", align " << sizeof(t_real) << "\n";
+		});
+	}
+
+	// remaining elements
+	for(std::size_t idx=dim_simd; idx<dim; ++idx)
+	{
+		std::array<t_astret, 2> vals{{ terms[0], terms[1] }};
+		for(std::size_t term=0; term<terms.size(); ++term)
+		{
+			if(terms[term]->ty == SymbolType::SCALAR)
+				continue;
+
+			t_astret elemptr = get_elemptr(terms[term], std::to_string(idx));
+			vals[term] = get_tmp_var();
+			(*m_ostr) << "%" << vals[term]->name << " = load "
+				<< m_real << ", " << m_realptr << " %" << elemptr->name << "\n";
+		}
+
+		t_astret elem_dst = get_tmp_var(SymbolType::SCALAR);
+		(*m_ostr) << "%" << elem_dst->name << " = " << opname << " " << m_real
+			<< " %" << vals[0]->name << ", %" << vals[1]->name << "\n";
+
+		t_astret elemptr_dst = get_elemptr(vec_mem, std::to_string(idx));
+		(*m_ostr) << "store " << m_real << " %" << elem_dst->name
+			<< ", " << m_realptr << " %" << elemptr_dst->name << "\n";
+	}
+
+	return vec_mem;
+}
+
+
 /**
  * copy the memory of a compound symbol
  */
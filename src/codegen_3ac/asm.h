@@ -48,6 +48,23 @@ t_str get_lltype_name()
 }
 
 
+/**
+ * type suffix of llvm's overloaded intrinsics, e.g. llvm.sin.f64
+ */
+template<class t_type, class t_str = const char*>
+t_str get_llintrinsic_suffix()
+{
+	if constexpr(std::is_same_v<std::decay_t<t_type>, long double>)
+		return "f80";
+	else if constexpr(std::is_same_v<std::decay_t<t_type>, double>)
+		return "f64";
+	else if constexpr(std::is_same_v<std::decay_t<t_type>, float>)
+		return "f32";
+	else
+		return "<unknown>";
+}
+
+
 class LLAsm : public ASTVisitor
 {
 public:
@@ -60,6 +77,7 @@ public:
 	virtual t_astret visit(const ASTUMinus* ast) override;
 	virtual t_astret visit(const ASTPlus* ast) override;
 	virtual t_astret visit(const ASTMult* ast) override;
+	virtual t_astret visit(const ASTElemMult* ast) override;
 	virtual t_astret visit(const ASTMod* ast) override;
 	virtual t_astret visit(const ASTPow* ast) override;
 	virtual t_astret visit(const ASTTransp* ast) override;
@@ -68,6 +86,7 @@ public:
 	virtual t_astret visit(const ASTVarDecl* ast) override;
 	virtual t_astret visit(const ASTVar* ast) override;
 	virtual t_astret visit(const ASTAssign* ast) override;
+	virtual t_astret visit(const ASTCompoundAssign* ast) override;
 
 	virtual t_astret visit(const ASTArrayAccess* ast) override;
 	virtual t_astret visit(const ASTArrayAssign* ast) override;
@@ -78,11 +97,13 @@ public:
 
 	virtual t_astret visit(const ASTFunc* ast) override;
 	virtual t_astret visit(const ASTCall* ast) override;
+	virtual t_astret visit(const ASTMap* ast) override;
 	virtual t_astret visit(const ASTReturn* ast) override;
 	virtual t_astret visit(const ASTStmts* ast) override;
 
 	virtual t_astret visit(const ASTCond* ast) override;
 	virtual t_astret visit(const ASTLoop* ast) override;
+	virtual t_astret visit(const ASTParLoop* ast) override;
 	virtual t_astret visit(const ASTLoopBreak* ast) override;
 	virtual t_astret visit(const ASTLoopNext* ast) override;
 
@@ -202,6 +223,11 @@ private:
 
 	// helper functions to reduce code redundancy
 	t_astret scalar_matrix_prod(t_astret scalar, t_astret matrix, bool mul_or_div=1);
+	t_astret power(t_astret term1, t_astret term2);
+	t_astret solve(t_astret lhs, t_astret rhs);
+	t_astret decomposition(const t_str& funcname, t_astret mat);
+	t_astret elementwise_func(const t_str& funcname, t_astret arg, t_astret exp = nullptr);
+	t_astret elementwise_arith(char op, t_astret term1, t_astret term2);
 
 	// stack only needed for (future) nested functions
 	std::stack<const ASTFunc*> m_funcstack{};
@@ -209,11 +235,25 @@ private:
 	// stack of nested loops in a function
 	std::vector<t_str> m_loopStartStack{}, m_loopEndStack{};
 
+	// variables used and declared in the body of a parallel loop
+	struct ParLoopVars
+	{
+		std::vector<t_astret> used{};
+		std::vector<t_astret> declared{};
+	};
+
+	ParLoopVars* m_parLoopVars = nullptr;
+	std::size_t m_parLoopCount = 0;         // # of parallel loops
+	std::vector<t_str> m_parLoopFuncs{};    // outlined loop bodies
+
 	// type names
 	static const t_str m_real;
 	static const t_str m_int;
 	static const t_str m_realptr;
 	static const t_str m_intptr;
+
+	// number of elements per vector intrinsic call, see the startup code
+	static constexpr const std::size_t m_simd_lanes = 4;
 };
 
 
@@ -11,6 +11,7 @@
  */
 
 #include "asm.h"
+#include "common/ext_funcs.h"
 #include <sstream>
 
 
@@ -24,6 +25,50 @@ t_astret LLAsm::visit(const ASTCall* ast)
 	if(ast->GetArgumentList().size() != func->argty.size())
 		throw std::runtime_error("ASTCall: Invalid number of function parameters for \"" + funcname + "\".");
 
+	// the result of a solve has the shape of its right-hand side
+	if(func->is_external && funcname == "solve")
+	{
+		t_astret lhs = ast->GetArgumentList().front()->accept(this);
+		t_astret rhs = ast->GetArgumentList().back()->accept(this);
+		return solve(lhs, rhs);
+	}
+
+	// the values returned by a matrix decomposition are shaped by its argument
+	if(func->is_external && (funcname == "qr" || funcname == "chol" || funcname == "eig_sym"))
+	{
+		t_astret mat = ast->GetArgumentList().front()->accept(this);
+		return decomposition(funcname, mat);
+	}
+
+	// math functions of vectors and matrices are evaluated element-wise
+	if(func->is_external && is_elementwise_ext_func(funcname))
+	{
+		t_astret arg = ast->GetArgumentList().front()->accept(this);
+		if(arg->ty == SymbolType::VECTOR || arg->ty == SymbolType::MATRIX)
+		{
+			t_astret exp = nullptr;
+			if(funcname == "pow")
+				exp = ast->GetArgumentList().back()->accept(this);
+			return elementwise_func(funcname, arg, exp);
+		}
+
+		// call the external function for a scalar argument
+		arg = convert_sym(arg, SymbolType::SCALAR);
+		t_astret exp = nullptr;
+		if(funcname == "pow")
+			exp = convert_sym(ast->GetArgumentList().back()->accept(this), SymbolType::SCALAR);
+
+		t_astret retvar = get_tmp_var(SymbolType::SCALAR);
+		(*m_ostr) << "%" << retvar->name << " = call " << m_real << " @"
+			<< (func->ext_name ? *func->ext_name : funcname) << "("
+			<< m_real << " %" << arg->name;
+		if(exp)
+			(*m_ostr) << ", " << m_real << " %" << exp->name;
+		(*m_ostr) << ")\n";
+
+		return retvar;
+	}
+
 
 	// prepare arguments
 	std::vector<t_astret> args;
@@ -156,6 +201,66 @@ t_astret LLAsm::visit(const ASTCall* ast)
 }
 
 
+/**
+ * calls a function for each element of an array
+ */
+t_astret LLAsm::visit(const ASTMap* ast)
+{
+	const t_str& funcname = ast->GetIdent();
+	t_astret func = get_sym(funcname);
+
+	if(func == nullptr)
+		throw std::runtime_error("ASTMap: Function \"" + funcname + "\" not in symbol table.");
+	if(func->argty.size() != 1 || func->argty[0] != SymbolType::SCALAR)
+		throw std::runtime_error("ASTMap: Function \"" + funcname + "\" has to take a scalar argument.");
+	if(func->retty != SymbolType::SCALAR && func->retty != SymbolType::INT)
+		throw std::runtime_error("ASTMap: Function \"" + funcname + "\" has to return a scalar.");
+
+	t_astret term = ast->GetTerm()->accept(this);
+	if(term->ty != SymbolType::VECTOR && term->ty != SymbolType::MATRIX)
+		throw std::runtime_error("ASTMap: Argument of \"" + funcname + "\" has to be a vector or matrix.");
+
+	std::size_t dim = get_arraydim(term);
+	const t_str& callname = func->ext_name ? *func->ext_name : funcname;
+	t_str retty = LLAsm::get_type_name(func->retty);
+
+	// allocate result array
+	t_astret result_mem = get_tmp_var(term->ty, &term->dims);
+	(*m_ostr) << "%" << result_mem->name << " = alloca [" << dim << " x " << m_real << "]\n";
+
+	// call the function directly on each element
+	generate_loop(0, dim, [this, term, dim, result_mem, &callname, &retty, func](t_astret ctrval)
+	{
+		t_astret elemptr_term = get_tmp_var();
+		(*m_ostr) << "%" << elemptr_term->name << " = getelementptr ["
+			<< dim << " x " << m_real << "], ["
+			<< dim << " x " << m_real << "]* %"
+			<< term->name << ", " << m_int << " 0, " << m_int
+			<< " %" << ctrval->name << "\n";
+		t_astret elemptr_result = get_tmp_var();
+		(*m_ostr) << "%" << elemptr_result->name << " = getelementptr ["
+			<< dim << " x " << m_real << "], ["
+			<< dim << " x " << m_real << "]* %"
+			<< result_mem->name << ", " << m_int << " 0, " << m_int
+			<< " %" << ctrval->name << "\n";
+
+		t_astret elem_term = get_tmp_var(SymbolType::SCALAR);
+		(*m_ostr) << "%" << elem_term->name << " = load " << m_real << ", " << m_realptr
+			<< " %" << elemptr_term->name << "\n";
+
+		t_astret retvar = get_tmp_var(func->retty);
+		(*m_ostr) << "%" << retvar->name << " = call " << retty << " @" << callname
+			<< "(" << m_real << " %" << elem_term->name << ")\n";
+		t_astret elem_result = convert_sym(retvar, SymbolType::SCALAR);
+
+		(*m_ostr) << "store " << m_real << " %" << elem_result->name << ", " << m_realptr
+			<< " %" << elemptr_result->name << "\n";
+	});
+
+	return result_mem;
+}
+
+
 t_astret LLAsm::visit(const ASTFunc* ast)
 {
 	m_funcstack.push(ast);
@@ -258,6 +363,12 @@ t_astret LLAsm::visit(const ASTFunc* ast)
 	}
 
 	(*m_ostr) << "}\n";
+
+	// outlined bodies of the function's parallel loops
+	for(const t_str& parloop : m_parLoopFuncs)
+		(*m_ostr) << "\n" << parloop;
+	m_parLoopFuncs.clear();
+
 	m_curscope.pop_back();
 	m_funcstack.pop();
 
@@ -267,6 +378,9 @@ t_astret LLAsm::visit(const ASTFunc* ast)
 
 t_astret LLAsm::visit(const ASTReturn* ast)
 {
+	if(m_parLoopVars)
+		throw std::runtime_error("ASTReturn: Cannot return from a parallel loop.");
+
 	const ASTFunc* thisfunc = m_funcstack.top();
 
 	const auto& retvals = ast->GetRets()->GetList();
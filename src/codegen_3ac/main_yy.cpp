@@ -7,6 +7,7 @@
 
 #include "ast/ast.h"
 #include "ast/printast.h"
+#include "ast/multchain.h"
 #include "ast/semantics.h"
 #include "common/helpers.h"
 #include "common/version.h"
@@ -219,6 +220,11 @@ int main(int argc, char** argv)
 			return res;
 		}
 
+		// re-associate chains of matrix products
+		MultChain multchain{&ctx.GetSymbols()};
+		for(const auto& stmt : ctx.GetStatements()->GetStatementList())
+			multchain.Optimise(stmt);
+
 		if(show_symbols)
 		{
 			std::cout << "Writing symbol table to \"" << outprog_syms << "\"..." << std::endl;
@@ -296,6 +302,24 @@ declare i8* @ext_heap_alloc(%%t_int%%, %%t_int%%)
 declare void @ext_heap_free(i8*)
 declare void @ext_init()
 declare void @ext_deinit()
+declare void @ext_putstr(i8*)
+declare void @ext_putprompt(i8*)
+; -----------------------------------------------------------------------------
+
+
+; -----------------------------------------------------------------------------
+; math intrinsics for element-wise functions of vectors and matrices,
+; the vector types have to match LLAsm::m_simd_lanes
+declare %%t_real%% @llvm.sin.%%t_real_sfx%%(%%t_real%%)
+declare %%t_real%% @llvm.cos.%%t_real_sfx%%(%%t_real%%)
+declare %%t_real%% @llvm.exp.%%t_real_sfx%%(%%t_real%%)
+declare %%t_real%% @llvm.sqrt.%%t_real_sfx%%(%%t_real%%)
+declare %%t_real%% @llvm.pow.%%t_real_sfx%%(%%t_real%%, %%t_real%%)
+declare <4 x %%t_real%%> @llvm.sin.v4%%t_real_sfx%%(<4 x %%t_real%%>)
+declare <4 x %%t_real%%> @llvm.cos.v4%%t_real_sfx%%(<4 x %%t_real%%>)
+declare <4 x %%t_real%%> @llvm.exp.v4%%t_real_sfx%%(<4 x %%t_real%%>)
+declare <4 x %%t_real%%> @llvm.sqrt.v4%%t_real_sfx%%(<4 x %%t_real%%>)
+declare <4 x %%t_real%%> @llvm.pow.v4%%t_real_sfx%%(<4 x %%t_real%%>, <4 x %%t_real%%>)
 ; -----------------------------------------------------------------------------
 
 
@@ -303,7 +327,14 @@ declare void @ext_deinit()
 ; external functions from runtime.c which are not exposed to the compiler
 declare %%t_real%% @ext_determinant(%%t_real%%*, %%t_int%%)
 declare %%t_int%% @ext_power(%%t_real%%*, %%t_real%%*, %%t_int%%, %%t_int%%)
+declare %%t_int%% @ext_power_int(%%t_int%%, %%t_int%%)
+declare void @ext_mult(%%t_real%%*, %%t_real%%*, %%t_real%%*, %%t_int%%, %%t_int%%, %%t_int%%)
+declare %%t_int%% @ext_solve_mat(%%t_real%%*, %%t_real%%*, %%t_real%%*, %%t_int%%, %%t_int%%)
+declare %%t_int%% @ext_solve_factor(%%t_int%%, %%t_real%%*, %%t_real%%*, %%t_int%%, %%t_int%%)
 declare %%t_int%% @ext_transpose(%%t_real%%*, %%t_real%%*, %%t_int%%, %%t_int%%)
+declare void @ext_parfor(void (i8*, %%t_int%%, %%t_int%%)*, i8*, %%t_int%%, %%t_int%%)
+declare void @ext_parfor_lock()
+declare void @ext_parfor_unlock()
 ; -----------------------------------------------------------------------------
 
 
@@ -360,7 +391,7 @@ define void @int_to_str(%%t_int%% %i, i8* %strptr, %%t_int%% %len)
 ; output a string
 define void @putstr(i8* %val)
 {
-	call i32 (i8*) @puts(i8* %val)
+	call void (i8*) @ext_putstr(i8* %val)
 	ret void
 }
 
@@ -394,8 +425,7 @@ define void @putint(%%t_int%% %val)
 define %%t_real%% @getflt(i8* %str)
 {
 	; output given string
-	%fmtptr_s = bitcast [3 x i8]* @__strfmt_s to i8*
-	call i32 (i8*, ...) @printf(i8* %fmtptr_s, i8* %str)
+	call void (i8*) @ext_putprompt(i8* %str)
 
 	; alloc %%t_real%%
 	%d_ptr = alloca %%t_real%%
@@ -412,8 +442,7 @@ define %%t_real%% @getflt(i8* %str)
 define %%t_int%% @getint(i8* %str)
 {
 	; output given string
-	%fmtptr_s = bitcast [3 x i8]* @__strfmt_s to i8*
-	call i32 (i8*, ...) @printf(i8* %fmtptr_s, i8* %str)
+	call void (i8*) @ext_putprompt(i8* %str)
 
 	; alloc int
 	%i_ptr = alloca %%t_int%%
@@ -449,6 +478,7 @@ define i32 @main()
 		auto [ fmt_real, fmt_real_len ] = get_format_string<t_real>();
 		auto [ fmt_int, fmt_int_len ] = get_format_string<t_int>();
 		boost::replace_all(startup_code, "%%t_real%%", get_lltype_name<t_real>());
+		boost::replace_all(startup_code, "%%t_real_sfx%%", get_llintrinsic_suffix<t_real>());
 		boost::replace_all(startup_code, "%%fmt_real%%", fmt_real);
 		boost::replace_all(startup_code, "%%fmt_real_len%%", std::to_string(fmt_real_len));
 		boost::replace_all(startup_code, "%%t_int%%", get_lltype_name<t_int>());
@@ -587,7 +617,7 @@ define i32 @main()
 
 			std::string opt_flag_exec = optimise ? "-O2" : "";
 			std::string cmd_exec = tool_exec + opt_verbose + " " +
-				opt_flag_exec + " -o " + outprog + " " + outprog_o + " -lm -lc";
+				opt_flag_exec + " -o " + outprog + " " + outprog_o + " -lm -lc -lpthread";
 			if(std::system(cmd_exec.c_str()) != 0)
 			{
 				std::cerr << "Failed." << std::endl;
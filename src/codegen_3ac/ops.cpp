@@ -88,78 +88,12 @@ t_astret LLAsm::visit(const ASTPlus* ast)
 	t_astret term1 = ast->GetTerm1()->accept(this);
 	t_astret term2 = ast->GetTerm2()->accept(this);
 
-	// array types
-	if(term1->ty == SymbolType::VECTOR || term1->ty == SymbolType::MATRIX)
+	// array types, scalars are added to all elements
+	if(term1->ty == SymbolType::VECTOR || term1->ty == SymbolType::MATRIX ||
+		((term2->ty == SymbolType::VECTOR || term2->ty == SymbolType::MATRIX) &&
+		(term1->ty == SymbolType::SCALAR || term1->ty == SymbolType::INT)))
 	{
-		if(term2->ty != term1->ty)
-		{
-			throw std::runtime_error("ASTPlus: Type mismatch in addition/subtraction of \""
-				+ term1->name + "\" and \"" + term2->name + "\".");
-		}
-
-		if(std::get<0>(term1->dims) != std::get<0>(term2->dims))
-		{
-			throw std::runtime_error("ASTPlus: Dimension mismatch in addition/subtraction of \""
-				+ term1->name + "\" and \"" + term2->name + "\".");
-		}
-
-		std::size_t dim = std::get<0>(term1->dims);
-		if(term1->ty == SymbolType::MATRIX)
-		{
-			throw std::runtime_error("ASTPlus: Dimension mismatch in addition/subtraction of \""
-				+ term1->name + "\" and \"" + term2->name + "\".");
-
-			dim *= std::get<1>(term1->dims);
-		}
-
-		// allocate real array for result
-		t_astret vec_mem = get_tmp_var(term1->ty, &term1->dims);
-		(*m_ostr) << "%" << vec_mem->name << " = alloca [" << dim << " x " << m_real << "]\n";
-
-		t_str op = ast->IsInverted() ? "fsub" : "fadd";
-
-		// copy elements in a loop
-		generate_loop(0, dim, [this, term1, term2, dim, vec_mem, &op](t_astret ctrval)
-		{
-			// loop statements
-			t_astret elemptr_src1 = get_tmp_var();
-			(*m_ostr) << "%" << elemptr_src1->name << " = getelementptr ["
-				<< dim << " x " << m_real << "], ["
-				<< dim << " x " << m_real << "]* %"
-				<< term1->name << ", " << m_int << " 0, " << m_int
-				<< " %" << ctrval->name << "\n";
-			t_astret elemptr_src2 = get_tmp_var();
-			(*m_ostr) << "%" << elemptr_src2->name << " = getelementptr ["
-				<< dim << " x " << m_real << "], ["
-				<< dim << " x " << m_real << "]* %"
-				<< term2->name << ", " << m_int << " 0, " << m_int
-				<< " %" << ctrval->name << "\n";
-
-			t_astret elem_src1 = get_tmp_var();
-			(*m_ostr) << "%" << elem_src1->name << " = load " << m_real << ", " << m_realptr
-				<< " %" << elemptr_src1->name << "\n";
-			t_astret elem_src2 = get_tmp_var();
-			(*m_ostr) << "%" << elem_src2->name << " = load " << m_real << ", " << m_realptr
-				<< " %" << elemptr_src2->name << "\n";
-
-			t_astret elemptr_dst = get_tmp_var();
-			(*m_ostr) << "%" << elemptr_dst->name << " = getelementptr ["
-				<< dim << " x " << m_real << "], ["
-				<< dim << " x " << m_real << "]* %"
-				<< vec_mem->name << ", " << m_int << " 0, " << m_int
-				<< " %" << ctrval->name << "\n";
-
-			// add/subtract
-			t_astret elem_dst = get_tmp_var(SymbolType::SCALAR);
-			(*m_ostr) << "%" << elem_dst->name << " = " << op << " "
-				<< m_real << " %" << elem_src1->name << ", %" << elem_src2->name << "\n";
-
-			// save result in array
-			(*m_ostr) << "store " << m_real << " %" << elem_dst->name << ", " << m_realptr
-				<< " %" << elemptr_dst->name << "\n";
-		});
-
-		return vec_mem;
+		return elementwise_arith(ast->IsInverted() ? '-' : '+', term1, term2);
 	}
 
 	// concatenate strings
@@ -233,8 +167,51 @@ t_astret LLAsm::visit(const ASTPlus* ast)
 
 t_astret LLAsm::visit(const ASTMult* ast)
 {
-	t_astret term1 = ast->GetTerm1()->accept(this);
-	t_astret term2 = ast->GetTerm2()->accept(this);
+	t_astret term1 = nullptr, term2 = nullptr;
+
+	// A^(-1) * x is solved for x instead of inverting A
+	if(const ASTPow* inv = ast->IsInverted() ? nullptr : get_inversion(ast->GetTerm1()); inv)
+	{
+		t_astret base = inv->GetTerm1()->accept(this);
+		t_astret exp = inv->GetTerm2()->accept(this);
+		term2 = ast->GetTerm2()->accept(this);
+
+		if(base->ty == SymbolType::MATRIX &&
+			(term2->ty == SymbolType::VECTOR || term2->ty == SymbolType::MATRIX))
+			return solve(base, term2);
+
+		term1 = power(base, exp);
+	}
+	else
+	{
+		term1 = ast->GetTerm1()->accept(this);
+		term2 = ast->GetTerm2()->accept(this);
+	}
+
+	// calls the runtime's matrix product: res^i_j = M1^i_k M2^k_j
+	auto call_mult = [this](t_astret M1, std::size_t size1, t_astret M2, std::size_t size2,
+		t_astret res, std::size_t size_res, std::size_t dim_i, std::size_t dim_j, std::size_t dim_k)
+	{
+		// cast array pointers to element pointers
+		std::array<t_astret, 3> ptrs{{ get_tmp_var(), get_tmp_var(), get_tmp_var() }};
+		std::array<t_astret, 3> arrs{{ M1, M2, res }};
+		std::array<std::size_t, 3> sizes{{ size1, size2, size_res }};
+
+		for(std::size_t idx=0; idx<ptrs.size(); ++idx)
+		{
+			(*m_ostr) << "%" << ptrs[idx]->name << " = bitcast ["
+				<< sizes[idx] << " x " << m_real << "]* %" << arrs[idx]->name
+				<< " to " << m_realptr << "\n";
+		}
+
+		(*m_ostr) << "call void @ext_mult("
+			<< m_realptr << " %" << ptrs[0]->name << ", "
+			<< m_realptr << " %" << ptrs[1]->name << ", "
+			<< m_realptr << " %" << ptrs[2]->name << ", "
+			<< m_int << " " << dim_i << ", "
+			<< m_int << " " << dim_j << ", "
+			<< m_int << " " << dim_k << ")\n";
+	};
 
 	// inner product of vectors: s = v^i v_i
 	if(term1->ty == SymbolType::VECTOR && term2->ty == SymbolType::VECTOR)
@@ -331,80 +308,8 @@ t_astret LLAsm::visit(const ASTMult* ast)
 		t_astret w_mem = get_tmp_var(SymbolType::VECTOR, &w_dims);
 		(*m_ostr) << "%" << w_mem->name << " = alloca [" << dim_i << " x " << m_real << "]\n";
 
-		// loop i
-		generate_loop(0, dim_i, [this, term1, term2, dim_i, dim_j, w_mem](t_astret ctr_i_val)
-		{
-			// w[i] pointer
-			t_astret elemptr_w_i = get_tmp_var();
-			(*m_ostr) << "%" << elemptr_w_i->name << " = getelementptr ["
-				<< dim_i << " x " << m_real << "], ["
-				<< dim_i << " x " << m_real << "]* %"
-				<< w_mem->name << ", " << m_int << " 0, " << m_int
-				<< " %" << ctr_i_val->name << "\n";
-
-			// w[i] = 0
-			(*m_ostr) << "store " << m_real << " 0., " << m_realptr
-				<< " %" << elemptr_w_i->name << "\n";
-
-			// loop i index of M: i*dim_j
-			t_astret M_idx_i = get_tmp_var();
-			(*m_ostr) << "%" << M_idx_i->name << " = mul " << m_int
-				<< " %" << ctr_i_val->name << ", " << dim_j << "\n";
-
-			// loop j
-			generate_loop(0, dim_j, [this, term1, term2, dim_i, dim_j, M_idx_i, elemptr_w_i](t_astret ctr_j_val)
-			{
-				// v[j] pointer
-				t_astret elemptr_v_j = get_tmp_var();
-				(*m_ostr) << "%" << elemptr_v_j->name << " = getelementptr ["
-					<< dim_j << " x " << m_real << "], ["
-					<< dim_j << " x " << m_real << "]* %"
-					<< term2->name << ", " << m_int << " 0, " << m_int
-					<< " %" << ctr_j_val->name << "\n";
-
-				// M index: i*dim_j + j
-				t_astret M_idx = get_tmp_var();
-				(*m_ostr) << "%" << M_idx->name << " = add " << m_int
-					<< " %" << M_idx_i->name << ", %" << ctr_j_val->name << "\n";
-
-				// M[i,j] pointer
-				t_astret elemptr_M_ij = get_tmp_var();
-				(*m_ostr) << "%" << elemptr_M_ij->name << " = getelementptr ["
-					<< dim_i*dim_j << " x " << m_real << "], ["
-					<< dim_i*dim_j << " x " << m_real << "]* %"
-					<< term1->name << ", " << m_int << " 0, " << m_int
-					<< " %" << M_idx->name << "\n";
-
-				// v[j] value
-				t_astret elem_v_j = get_tmp_var();
-				(*m_ostr) << "%" << elem_v_j->name << " = load " << m_real << ", " << m_realptr
-					<< " %" << elemptr_v_j->name << "\n";
-
-				// M[i,j] value
-				t_astret elem_M_ij = get_tmp_var();
-				(*m_ostr) << "%" << elem_M_ij->name << " = load " << m_real << ", " << m_realptr
-					<< " %" << elemptr_M_ij->name << "\n";
-
-				// m = M[i,j]*v[j]
-				t_astret m = get_tmp_var();
-				(*m_ostr) << "%" << m->name << " = fmul " << m_real
-					<< " %" << elem_M_ij->name << ", %" << elem_v_j->name << "\n";
-
-				// current w[i] value
-				t_astret elem_w_i = get_tmp_var();
-				(*m_ostr) << "%" << elem_w_i->name << " = load " << m_real << ", " << m_realptr
-					<< " %" << elemptr_w_i->name << "\n";
-
-				// d = w[i] + m
-				t_astret d = get_tmp_var();
-				(*m_ostr) << "%" << d->name << " = fadd " << m_real
-					<< " %" << elem_w_i->name << ", %" << m->name << "\n";
-
-				// w[i] = d
-				(*m_ostr) << "store " << m_real << " %" << d->name << ", " << m_realptr
-					<< " %" << elemptr_w_i->name << "\n";
-			});
-		});
+		// matrix-vector product kernel in the runtime library
+		call_mult(term1, dim_i*dim_j, term2, dim_j, w_mem, dim_i, dim_i, 1, dim_j);
 
 		return w_mem;
 	}
@@ -433,111 +338,8 @@ t_astret LLAsm::visit(const ASTMult* ast)
 		t_astret L_mem = get_tmp_var(SymbolType::MATRIX, &L_dims);
 		(*m_ostr) << "%" << L_mem->name << " = alloca [" << dim_i*dim_j << " x " << m_real << "]\n";
 
-		// loop i
-		generate_loop(0, dim_i, [this, term1, term2, dim_i, dim_j, dim_k, L_mem](t_astret ctr_i_val)
-		{
-			// loop i index of L: i*dim_j
-			t_astret L_idx_i = get_tmp_var();
-			(*m_ostr) << "%" << L_idx_i->name << " = mul " << m_int
-				<< " %" << ctr_i_val->name << ", " << dim_j << "\n";
-
-			// loop i index of M: i*dim_k
-			t_astret M_idx_i = get_tmp_var();
-			(*m_ostr) << "%" << M_idx_i->name << " = mul " << m_int
-				<< " %" << ctr_i_val->name << ", " << dim_k << "\n";
-
-			// loop j
-			generate_loop(0, dim_j, [this, term1, term2, dim_i, dim_j, dim_k, L_idx_i, M_idx_i, L_mem](t_astret ctr_j_val)
-			{
-				// d = 0
-				t_astret d = get_tmp_var(SymbolType::SCALAR);
-				(*m_ostr) << "%" << d->name << " = alloca " << m_real << "\n";
-				(*m_ostr) << "store " << m_real << " 0., " << m_realptr
-					<< " %" << d->name << "\n";
-
-				// loop k
-				generate_loop(0, dim_k, [this, term1, term2, dim_i, dim_j, dim_k, M_idx_i, ctr_j_val, d](t_astret ctr_k_val)
-				{
-					// M index: i*dim_k + k
-					t_astret M_idx = get_tmp_var();
-					(*m_ostr) << "%" << M_idx->name << " = add " << m_int
-						<< " %" << M_idx_i->name << ", %" << ctr_k_val->name << "\n";
-
-					// M[i,k] pointer
-					t_astret elemptr_M_ik = get_tmp_var();
-					(*m_ostr) << "%" << elemptr_M_ik->name << " = getelementptr ["
-						<< dim_i*dim_k << " x " << m_real << "], ["
-						<< dim_i*dim_k << " x " << m_real << "]* %"
-						<< term1->name << ", " << m_int << " 0, " << m_int
-						<< " %" << M_idx->name << "\n";
-
-					// M[i,k] value
-					t_astret elem_M_ik = get_tmp_var();
-					(*m_ostr) << "%" << elem_M_ik->name << " = load " << m_real << ", " << m_realptr
-						<< " %" << elemptr_M_ik->name << "\n";
-
-
-					// loop k index of N: k*dim_j
-					t_astret N_idx_k = get_tmp_var();
-					(*m_ostr) << "%" << N_idx_k->name << " = mul " << m_int
-						<< " %" << ctr_k_val->name << ", " << dim_j << "\n";
-
-					// N index: k*dim_j + j
-					t_astret N_idx = get_tmp_var();
-					(*m_ostr) << "%" << N_idx->name << " = add " << m_int
-						<< " %" << N_idx_k->name << ", %" << ctr_j_val->name << "\n";
-
-					// N[k,j] pointer
-					t_astret elemptr_N_kj = get_tmp_var();
-					(*m_ostr) << "%" << elemptr_N_kj->name << " = getelementptr ["
-						<< dim_k*dim_j << " x " << m_real << "], ["
-						<< dim_k*dim_j << " x " << m_real << "]* %"
-						<< term2->name << ", " << m_int << " 0, " << m_int
-						<< " %" << N_idx->name << "\n";
-
-					// N[k,l] value
-					t_astret elem_N_kj = get_tmp_var();
-					(*m_ostr) << "%" << elem_N_kj->name << " = load " << m_real << ", " << m_realptr
-						<< " %" << elemptr_N_kj->name << "\n";
-
-
-					// val = M[i,k] * N[k,j]
-					t_astret val = get_tmp_var();
-					(*m_ostr) << "%" << val->name << " = fmul " << m_real
-						<< " %" << elem_M_ik->name << ", %" << elem_N_kj->name << "\n";
-
-					// d += val
-					t_astret d_val_old = get_tmp_var();
-					(*m_ostr) << "%" << d_val_old->name << " = load " << m_real << ", " << m_realptr
-						<< " %" << d->name << "\n";
-					t_astret d_val_new = get_tmp_var();
-					(*m_ostr) << "%" << d_val_new->name << " = fadd " << m_real
-						<< " %" << d_val_old->name << ", %" << val->name << "\n";
-					(*m_ostr) << "store " << m_real << " %" << d_val_new->name <<  ", " << m_realptr
-						<< " %" << d->name << "\n";
-				});
-
-				// L index: i*dim_j + j
-				t_astret L_idx = get_tmp_var();
-				(*m_ostr) << "%" << L_idx->name << " = add " << m_int
-					<< " %" << L_idx_i->name << ", %" << ctr_j_val->name << "\n";
-
-				// L[i,j] pointer
-				t_astret elemptr_L_ij = get_tmp_var();
-				(*m_ostr) << "%" << elemptr_L_ij->name << " = getelementptr ["
-					<< dim_i*dim_j << " x " << m_real << "], ["
-					<< dim_i*dim_j << " x " << m_real << "]* %"
-					<< L_mem->name << ", " << m_int << " 0, " << m_int
-					<< " %" << L_idx->name << "\n";
-
-				// L[i,j] = d
-				t_astret d_val = get_tmp_var();
-				(*m_ostr) << "%" << d_val->name << " = load " << m_real << ", " << m_realptr
-					<<" %" << d->name << "\n";
-				(*m_ostr) << "store " << m_real << " %" << d_val->name << ", "
-					<< m_realptr << " %" << elemptr_L_ij->name << "\n";
-			});
-		});
+		// blocked matrix-matrix product kernel in the runtime library
+		call_mult(term1, dim_i*dim_k, term2, dim_k*dim_j, L_mem, dim_i*dim_j, dim_i, dim_j, dim_k);
 
 		return L_mem;
 	}
@@ -593,6 +395,45 @@ t_astret LLAsm::visit(const ASTMult* ast)
 }
 
 
+t_astret LLAsm::visit(const ASTElemMult* ast)
+{
+	t_astret term1 = ast->GetTerm1()->accept(this);
+	t_astret term2 = ast->GetTerm2()->accept(this);
+
+	// array types, scalars are combined with all elements
+	if(term1->ty == SymbolType::VECTOR || term1->ty == SymbolType::MATRIX ||
+		term2->ty == SymbolType::VECTOR || term2->ty == SymbolType::MATRIX)
+	{
+		return elementwise_arith(ast->IsInverted() ? '/' : '*', term1, term2);
+	}
+
+	// scalar types
+	SymbolType ty = term1->ty;
+	if(term1->ty==SymbolType::SCALAR || term2->ty==SymbolType::SCALAR)
+		ty = SymbolType::SCALAR;
+	if(ty != SymbolType::SCALAR && ty != SymbolType::INT)
+	{
+		throw std::runtime_error("ASTElemMult: Invalid element-wise operation between \""
+			+ term1->name + "\" and \"" + term2->name + "\".");
+	}
+
+	t_astret var = get_tmp_var(ty, &term1->dims);
+	term1 = convert_sym(term1, ty);
+	term2 = convert_sym(term2, ty);
+
+	t_str op = ast->IsInverted() ? "div" : "mul";
+	if(ty == SymbolType::SCALAR)
+		op = "f" + op;
+	else if(ast->IsInverted())
+		op = "s" + op;
+
+	(*m_ostr) << "%" << var->name << " = " << op << " "
+		<< LLAsm::get_type_name(ty) << " %" << term1->name << ", %" << term2->name << "\n";
+
+	return var;
+}
+
+
 t_astret LLAsm::visit(const ASTMod* ast)
 {
 	t_astret term1 = ast->GetTerm1()->accept(this);
@@ -626,6 +467,15 @@ t_astret LLAsm::visit(const ASTPow* ast)
 	t_astret term1 = ast->GetTerm1()->accept(this);
 	t_astret term2 = ast->GetTerm2()->accept(this);
 
+	return power(term1, term2);
+}
+
+
+/**
+ * power of a scalar or a square matrix
+ */
+t_astret LLAsm::power(t_astret term1, t_astret term2)
+{
 	if(term1->ty == SymbolType::MATRIX)
 	{
 		// only integer powers are supported for matrix powers
@@ -677,6 +527,15 @@ t_astret LLAsm::visit(const ASTPow* ast)
 		term1 = convert_sym(term1, ty);
 		term2 = convert_sym(term2, ty);
 
+		// integer power by repeated squaring in the runtime library
+		if(ty == SymbolType::INT)
+		{
+			(*m_ostr) << "%" << var->name << " = call " << m_int << " @ext_power_int("
+				<< m_int << " %" << term1->name << ", "
+				<< m_int << " %" << term2->name << ")\n";
+			return var;
+		}
+
 		(*m_ostr) << "%" << var->name << " = call " << m_real << " ";
 
 		if constexpr(std::is_same_v<std::decay_t<t_real>, float>)
@@ -881,6 +740,90 @@ t_astret LLAsm::visit(const ASTNorm* ast)
 }
 
 
+t_astret LLAsm::visit(const ASTCompoundAssign* ast)
+{
+	t_astret sym = get_sym(ast->GetIdent());
+
+	// non-array variables are assigned like "var = var op expr"
+	if(sym->ty != SymbolType::VECTOR && sym->ty != SymbolType::MATRIX)
+		return ast->GetAssignment()->accept(this);
+
+	t_astret term = ast->GetExpr()->accept(this);
+	const bool scalar_term = (term->ty == SymbolType::SCALAR || term->ty == SymbolType::INT);
+
+	t_str op;
+	switch(ast->GetOp())
+	{
+		case ASTCompoundAssign::ADD: op = "fadd"; break;
+		case ASTCompoundAssign::SUB: op = "fsub"; break;
+		case ASTCompoundAssign::MUL: op = "fmul"; break;
+		case ASTCompoundAssign::DIV: op = "fdiv"; break;
+	}
+
+	if(scalar_term)
+	{
+		// scalars are broadcast to all elements
+		term = convert_sym(term, SymbolType::SCALAR);
+	}
+	else
+	{
+		if(ast->GetOp() == ASTCompoundAssign::MUL || ast->GetOp() == ASTCompoundAssign::DIV)
+		{
+			throw std::runtime_error("ASTCompoundAssign: Array \"" + sym->name
+				+ "\" can only be scaled by a scalar.");
+		}
+
+		if(term->ty != sym->ty || term->dims != sym->dims)
+		{
+			throw std::runtime_error("ASTCompoundAssign: Type or dimension mismatch between \""
+				+ sym->name + "\" and \"" + term->name + "\".");
+		}
+	}
+
+	std::size_t dim = get_arraydim(sym);
+
+	// update the elements in place
+	generate_loop(0, dim, [this, sym, term, dim, scalar_term, &op](t_astret ctrval)
+	{
+		// loop statements
+		t_astret elemptr_dst = get_tmp_var();
+		(*m_ostr) << "%" << elemptr_dst->name << " = getelementptr ["
+			<< dim << " x " << m_real << "], ["
+			<< dim << " x " << m_real << "]* %"
+			<< sym->name << ", " << m_int << " 0, " << m_int
+			<< " %" << ctrval->name << "\n";
+
+		t_astret elem_dst = get_tmp_var();
+		(*m_ostr) << "%" << elem_dst->name << " = load " << m_real << ", " << m_realptr
+			<< " %" << elemptr_dst->name << "\n";
+
+		t_astret elem_src = term;
+		if(!scalar_term)
+		{
+			t_astret elemptr_src = get_tmp_var();
+			(*m_ostr) << "%" << elemptr_src->name << " = getelementptr ["
+				<< dim << " x " << m_real << "], ["
+				<< dim << " x " << m_real << "]* %"
+				<< term->name << ", " << m_int << " 0, " << m_int
+				<< " %" << ctrval->name << "\n";
+
+			elem_src = get_tmp_var();
+			(*m_ostr) << "%" << elem_src->name << " = load " << m_real << ", " << m_realptr
+				<< " %" << elemptr_src->name << "\n";
+		}
+
+		t_astret elem_res = get_tmp_var(SymbolType::SCALAR);
+		(*m_ostr) << "%" << elem_res->name << " = " << op << " "
+			<< m_real << " %" << elem_dst->name << ", %" << elem_src->name << "\n";
+
+		(*m_ostr) << "store " << m_real << " %" << elem_res->name << ", " << m_realptr
+			<< " %" << elemptr_dst->name << "\n";
+	});
+
+	return sym;
+}
+
+
 t_astret LLAsm::visit(const ASTComp* ast)
 {
 	// code generation for equality test of two scalars
@@ -57,6 +57,10 @@ t_astret LLAsm::visit(const ASTVarDecl* ast)
 		if(!sym)
 			throw std::runtime_error("ASTVarDecl: Variable \"" + varname + "\" not in symbol table.");
 
+		// variables declared in the body of a parallel loop are private to it
+		if(m_parLoopVars)
+			m_parLoopVars->declared.push_back(sym);
+
 		t_str ty = LLAsm::get_type_name(sym->ty);
 
 		if(sym->ty == SymbolType::SCALAR || sym->ty == SymbolType::INT)
@@ -172,6 +176,19 @@ t_astret LLAsm::visit(const ASTAssign* ast)
 			// read real array from memory block
 			else if(sym->ty == SymbolType::VECTOR || sym->ty == SymbolType::MATRIX)
 			{
+				// external functions give the exact element dimensions
+				if(expr->is_external && (sym->ty != retsym->ty || sym->dims != retsym->dims))
+				{
+					std::ostringstream ostrErr;
+					ostrErr << "ASTAssign: Multi-assignment type or dimension mismatch: ";
+					ostrErr << Symbol::get_type_name(sym->ty) << "["
+						<< std::get<0>(sym->dims) << ", " << std::get<1>(sym->dims)
+						<< "] != " << Symbol::get_type_name(retsym->ty) << "["
+						<< std::get<0>(retsym->dims) << ", " << std::get<1>(retsym->dims)
+						<< "].";
+					throw std::runtime_error(ostrErr.str());
+				}
+
 				cp_mem_vec(varmemptr, sym, false);
 			}
 
@@ -11,6 +11,63 @@
 
 #include "context.h"
 #include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * external runtime functions without side effects,
+ * their results only depend on their arguments (and the comparison epsilon)
+ */
+inline bool is_pure_ext_func(const std::string& name)
+{
+	static const std::unordered_set<std::string> pure_funcs
+	{
+		"pow", "exp", "sin", "cos", "tan", "sqrt", "fabs", "abs",
+		"norm", "determinant", "transpose", "strlen",
+		"sum", "prod", "min", "max", "mean", "argmin", "argmax",
+	};
+
+	return pure_funcs.contains(name);
+}
+
+
+/**
+ * external math functions which are applied to each element of a vector
+ * or matrix argument, the result has the shape of the (first) argument
+ */
+inline bool is_elementwise_ext_func(const std::string& name)
+{
+	static const std::unordered_set<std::string> elem_funcs
+	{
+		"pow", "exp", "sin", "cos", "tan", "sqrt",
+	};
+
+	return elem_funcs.contains(name);
+}
+
+
+/**
+ * arguments of external functions which are passed by reference
+ * instead of by value, i.e. the function can write to the variable
+ */
+inline bool is_ref_ext_func_arg(const std::string& name, std::size_t argidx)
+{
+	static const std::unordered_map<std::string, std::size_t> ref_args
+	{
+		{ "load_vec", 1 }, { "load_mat", 1 },
+		{ "save_vec", 1 }, { "save_mat", 1 },
+		{ "csv_next_rows", 1 },
+		{ "sum_axis", 2 }, { "prod_axis", 2 },
+		{ "min_axis", 2 }, { "max_axis", 2 }, { "mean_axis", 2 },
+		{ "argmin_axis", 2 }, { "argmax_axis", 2 },
+	};
+
+	auto iter = ref_args.find(name);
+	return iter != ref_args.end() && iter->second == argidx;
+}
 
 
 /**
@@ -30,6 +87,8 @@ void add_ext_funcs(ParserContext& ctx, bool skip_some = false)
 			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "cos", "cosf",
 			SymbolType::SCALAR, {SymbolType::SCALAR});
+		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "tan", "tanf",
+			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "sqrt", "sqrtf",
 			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "fabs", "fabsf",
@@ -45,6 +104,8 @@ void add_ext_funcs(ParserContext& ctx, bool skip_some = false)
 			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "cos", "cos",
 			SymbolType::SCALAR, {SymbolType::SCALAR});
+		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "tan", "tan",
+			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "sqrt", "sqrt",
 			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "fabs", "fabs",
@@ -60,6 +121,8 @@ void add_ext_funcs(ParserContext& ctx, bool skip_some = false)
 			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "cos", "cosl",
 			SymbolType::SCALAR, {SymbolType::SCALAR});
+		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "tan", "tanl",
+			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "sqrt", "sqrtl",
 			SymbolType::SCALAR, {SymbolType::SCALAR});
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "fabs", "fabsl",
@@ -89,6 +152,77 @@ void add_ext_funcs(ParserContext& ctx, bool skip_some = false)
 	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "get_eps", "get_eps",
 		SymbolType::SCALAR, {});
 
+	// write the buffered output
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "flush", "ext_flush",
+		SymbolType::VOID, {});
+
+	// reductions of all vector or matrix elements,
+	// the arg functions return the index of the first extremum
+	for(const char* name : { "sum", "prod", "min", "max", "mean" })
+	{
+		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), name, std::string("ext_") + name,
+			SymbolType::SCALAR, {SymbolType::VECTOR});
+	}
+	for(const char* name : { "argmin", "argmax" })
+	{
+		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), name, std::string("ext_") + name,
+			SymbolType::INT, {SymbolType::VECTOR});
+	}
+
+	// reductions of the columns (axis 0) or rows (axis 1) of a matrix into a vector,
+	// return the vector's size or -1 if it does not match
+	for(const char* name : { "sum_axis", "prod_axis", "min_axis", "max_axis",
+		"mean_axis", "argmin_axis", "argmax_axis" })
+	{
+		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), name, std::string("ext_") + name,
+			SymbolType::INT, {SymbolType::MATRIX, SymbolType::INT, SymbolType::VECTOR});
+	}
+
+	// vector and matrix files, return 0 on success and -1 on failure
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "load_vec", "ext_load_vec",
+		SymbolType::INT, {SymbolType::STRING, SymbolType::VECTOR});
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "load_mat", "ext_load_mat",
+		SymbolType::INT, {SymbolType::STRING, SymbolType::MATRIX});
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "save_vec", "ext_save_vec",
+		SymbolType::INT, {SymbolType::STRING, SymbolType::VECTOR});
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "save_mat", "ext_save_mat",
+		SymbolType::INT, {SymbolType::STRING, SymbolType::MATRIX});
+
+	// streaming csv files: csv_open returns a handle or -1, csv_next_rows
+	// fills the matrix with the next rows and returns their number
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "csv_open", "ext_csv_open",
+		SymbolType::INT, {SymbolType::STRING});
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "csv_next_rows", "ext_csv_next_rows",
+		SymbolType::INT, {SymbolType::INT, SymbolType::MATRIX});
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "csv_close", "ext_csv_close",
+		SymbolType::INT, {SymbolType::INT});
+
+	// linear systems: solve(A, b) or solve(A, B) takes a matrix or a handle returned
+	// by factor(A), its calls are generated directly by the compilers, as the result
+	// has the shape of the right-hand side; factor returns -1 for a singular matrix,
+	// factor_free returns -1 for an invalid handle
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "solve", "ext_solve",
+		SymbolType::VECTOR, {SymbolType::MATRIX, SymbolType::VECTOR});
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "factor", "ext_factor",
+		SymbolType::INT, {SymbolType::MATRIX});
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "factor_free", "ext_factor_free",
+		SymbolType::INT, {SymbolType::INT});
+
+	// matrix decompositions returning several values, e.g. "assign Q, R = qr(A)":
+	// qr returns the orthogonal rows x rows matrix Q and the upper triangular rows x cols
+	// matrix R, chol returns the lower triangular L and 1 (or a zero L and 0 if A is not
+	// positive definite), eig_sym returns the ascending eigenvalues and the eigenvectors
+	// as columns, chol and eig_sym only use the lower triangle of A
+	const std::vector<SymbolType> qr_rets{ SymbolType::MATRIX, SymbolType::MATRIX };
+	const std::vector<SymbolType> chol_rets{ SymbolType::MATRIX, SymbolType::INT };
+	const std::vector<SymbolType> eig_rets{ SymbolType::VECTOR, SymbolType::MATRIX };
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "qr", "ext_qr",
+		SymbolType::COMP, {SymbolType::MATRIX}, nullptr, &qr_rets);
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "chol", "ext_chol",
+		SymbolType::COMP, {SymbolType::MATRIX}, nullptr, &chol_rets);
+	ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "eig_sym", "ext_eig_sym",
+		SymbolType::COMP, {SymbolType::MATRIX}, nullptr, &eig_rets);
+
 	// functions that could also be declared as internals (e.g. in 3ac module)
 	if(!skip_some)
 	{
@@ -107,6 +241,14 @@ void add_ext_funcs(ParserContext& ctx, bool skip_some = false)
 		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "int_to_str", "int_to_str",
 			SymbolType::VOID, {SymbolType::INT, SymbolType::STRING, SymbolType::INT});
 	}
+
+	// functions only provided by the vm
+	if(!skip_some)
+	{
+		// save the vm state, returns 0 after saving and 1 when resumed
+		ctx.GetSymbols().AddExtFunc(ctx.GetScopeName(), "snapshot", "snapshot",
+			SymbolType::INT, {SymbolType::STRING});
+	}
 }
 
 
@@ -7,6 +7,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "../common/types.h"
 
@@ -15,6 +22,547 @@ static t_real g_eps = REAL_EPSILON;
 static int8_t g_debug = 0;
 
 
+// ----------------------------------------------------------------------------
+// buffered output
+// ----------------------------------------------------------------------------
+
+// output being collected, size 0: write every string directly
+static char *g_outbuf = 0;
+static size_t g_outbuf_size = 0x10000, g_outbuf_len = 0;
+static pthread_mutex_t mtx_out = PTHREAD_MUTEX_INITIALIZER;
+
+// optional writer thread taking over full buffers
+static int8_t g_out_async = 0, g_out_quit = 0, g_out_writing = 0;
+static char *g_outbuf_pending = 0;
+static size_t g_outbuf_pending_len = 0;
+static pthread_cond_t cond_out_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t cond_out_written = PTHREAD_COND_INITIALIZER;
+static pthread_t g_out_writer;
+
+
+/**
+ * function for writer thread
+ */
+static void* out_writer_func(void *arg)
+{
+	(void)arg;
+	pthread_mutex_lock(&mtx_out);
+
+	while(1)
+	{
+		while(!g_out_quit && !g_outbuf_pending_len)
+			pthread_cond_wait(&cond_out_ready, &mtx_out);
+		if(!g_outbuf_pending_len)
+			break;
+
+		// write without blocking the program
+		g_out_writing = 1;
+		pthread_mutex_unlock(&mtx_out);
+
+		fwrite(g_outbuf_pending, 1, g_outbuf_pending_len, stdout);
+		fflush(stdout);
+
+		pthread_mutex_lock(&mtx_out);
+		g_outbuf_pending_len = 0;
+		g_out_writing = 0;
+		pthread_cond_broadcast(&cond_out_written);
+	}
+
+	pthread_mutex_unlock(&mtx_out);
+	return 0;
+}
+
+
+/**
+ * write the buffer or hand it over to the writer thread,
+ * mtx_out has to be locked
+ */
+static void out_write(int8_t flush)
+{
+	if(g_out_async)
+	{
+		// wait until the previous buffer has been written
+		while(g_out_writing || g_outbuf_pending_len)
+			pthread_cond_wait(&cond_out_written, &mtx_out);
+
+		if(g_outbuf_len)
+		{
+			char *buf = g_outbuf_pending;
+			g_outbuf_pending = g_outbuf;
+			g_outbuf_pending_len = g_outbuf_len;
+			g_outbuf = buf;
+			g_outbuf_len = 0;
+			pthread_cond_signal(&cond_out_ready);
+		}
+
+		if(flush)
+		{
+			while(g_out_writing || g_outbuf_pending_len)
+				pthread_cond_wait(&cond_out_written, &mtx_out);
+		}
+	}
+	else
+	{
+		if(g_outbuf_len)
+		{
+			fwrite(g_outbuf, 1, g_outbuf_len, stdout);
+			g_outbuf_len = 0;
+		}
+
+		if(flush)
+			fflush(stdout);
+	}
+}
+
+
+/**
+ * append a string, optionally followed by a new line
+ */
+static void out_put(const char *str, int8_t newline, int8_t flush)
+{
+	size_t len = strlen(str);
+	size_t total = len + (newline ? 1 : 0);
+
+	pthread_mutex_lock(&mtx_out);
+
+	if(g_outbuf_len + total > g_outbuf_size)
+		out_write(0);
+
+	if(total > g_outbuf_size)
+	{
+		// string does not fit into the buffer, write it directly
+		out_write(1);
+		fwrite(str, 1, len, stdout);
+		if(newline)
+			fputc('\n', stdout);
+		fflush(stdout);
+	}
+	else
+	{
+		memcpy(g_outbuf + g_outbuf_len, str, len);
+		g_outbuf_len += len;
+		if(newline)
+			g_outbuf[g_outbuf_len++] = '\n';
+
+		if(flush)
+			out_write(1);
+	}
+
+	pthread_mutex_unlock(&mtx_out);
+}
+
+
+/**
+ * set up the output buffer using the environment variables
+ * MCALC_OUTBUF (buffer size) and MCALC_OUTBUF_ASYNC
+ */
+static void out_init()
+{
+	const char *size = getenv("MCALC_OUTBUF");
+	if(size)
+		g_outbuf_size = (size_t)strtoul(size, 0, 0);
+
+	const char *async = getenv("MCALC_OUTBUF_ASYNC");
+	g_out_async = (async && atoi(async) != 0 && g_outbuf_size > 0);
+
+	if(g_outbuf_size)
+	{
+		g_outbuf = (char*)malloc(g_outbuf_size);
+		if(g_out_async)
+			g_outbuf_pending = (char*)malloc(g_outbuf_size);
+
+		if(!g_outbuf || (g_out_async && !g_outbuf_pending))
+		{
+			// fall back to unbuffered output
+			free(g_outbuf);
+			free(g_outbuf_pending);
+			g_outbuf = g_outbuf_pending = 0;
+			g_outbuf_size = 0;
+			g_out_async = 0;
+		}
+	}
+
+	if(g_out_async)
+	{
+		g_out_quit = 0;
+		if(pthread_create(&g_out_writer, 0, out_writer_func, 0) != 0)
+			g_out_async = 0;
+	}
+}
+
+
+/**
+ * write the remaining output and stop the writer thread
+ */
+static void out_deinit()
+{
+	pthread_mutex_lock(&mtx_out);
+	out_write(1);
+	int8_t async = g_out_async;
+	g_out_quit = 1;
+	pthread_cond_broadcast(&cond_out_ready);
+	pthread_mutex_unlock(&mtx_out);
+
+	if(async)
+		pthread_join(g_out_writer, 0);
+
+	pthread_mutex_lock(&mtx_out);
+	g_out_async = 0;
+	free(g_outbuf);
+	free(g_outbuf_pending);
+	g_outbuf = g_outbuf_pending = 0;
+	g_outbuf_size = g_outbuf_len = 0;
+	pthread_mutex_unlock(&mtx_out);
+}
+
+
+/**
+ * output a string followed by a new line
+ */
+void ext_putstr(const char *str)
+{
+	out_put(str, 1, 0);
+}
+
+
+/**
+ * output an input prompt, which has to be visible immediately
+ */
+void ext_putprompt(const char *str)
+{
+	out_put(str, 0, 1);
+}
+
+
+/**
+ * write the buffered output
+ */
+void ext_flush()
+{
+	pthread_mutex_lock(&mtx_out);
+	out_write(1);
+	pthread_mutex_unlock(&mtx_out);
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// parallel loops
+// ----------------------------------------------------------------------------
+
+// outlined loop body running the iterations [begin, end)
+typedef void (*t_parfor_body)(void* ctx, t_int begin, t_int end);
+
+// remaining iterations of a thread
+struct t_parfor_range
+{
+	pthread_mutex_t mtx;
+	t_int begin, end;
+};
+
+struct t_parfor_job
+{
+	t_parfor_body body;
+	void *ctx;
+	t_int grain;                    // iterations per chunk
+	t_int num_threads;
+	struct t_parfor_range *ranges;
+};
+
+
+// lock for the reduction of the accumulators
+static pthread_mutex_t mtx_parfor = PTHREAD_MUTEX_INITIALIZER;
+
+// nested parallel loops are run sequentially
+static _Thread_local int8_t g_in_parfor = 0;
+
+// number of threads including the calling one, 0: not yet determined
+static t_int g_num_threads = 0;
+
+// minimum work (elements or multiply-adds) for which kernels use several threads
+#define PAR_MIN_ELEMS (1 << 16)
+#define PAR_MIN_FLOPS (1 << 20)
+
+// worker threads shared by all parallel loops and kernels
+static pthread_t *g_pool_threads = 0;
+static t_int g_pool_size = 0;
+static struct t_parfor_job *g_pool_job = 0;
+static uint64_t g_pool_jobctr = 0;
+static t_int g_pool_active = 0;       // workers still running the job
+static int8_t g_pool_quit = 0;
+static pthread_mutex_t mtx_pool = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t mtx_pool_job = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond_pool_start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t cond_pool_done = PTHREAD_COND_INITIALIZER;
+
+
+void ext_parfor_lock()
+{
+	pthread_mutex_lock(&mtx_parfor);
+}
+
+
+void ext_parfor_unlock()
+{
+	pthread_mutex_unlock(&mtx_parfor);
+}
+
+
+/**
+ * number of threads, set by the environment variable MCALC_THREADS,
+ * the default is the number of processors
+ */
+static t_int par_num_threads()
+{
+	if(g_num_threads > 0)
+		return g_num_threads;
+
+	const char *threads = getenv("MCALC_THREADS");
+	if(threads)
+		g_num_threads = (t_int)atol(threads);
+	if(g_num_threads <= 0)
+		g_num_threads = (t_int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(g_num_threads <= 0)
+		g_num_threads = 1;
+
+	return g_num_threads;
+}
+
+
+/**
+ * steal the back half of the largest remaining range of another thread,
+ * returns 0 if there is no work left
+ */
+static int8_t parfor_steal(struct t_parfor_job *job, t_int thread)
+{
+	t_int victim = -1;
+	t_int most = 0;
+
+	for(t_int other=0; other<job->num_threads; ++other)
+	{
+		if(other == thread)
+			continue;
+
+		struct t_parfor_range *range = &job->ranges[other];
+		pthread_mutex_lock(&range->mtx);
+		if(range->end - range->begin > most)
+		{
+			most = range->end - range->begin;
+			victim = other;
+		}
+		pthread_mutex_unlock(&range->mtx);
+	}
+
+	if(victim < 0)
+		return 0;
+
+	t_int begin = 0, end = 0;
+	struct t_parfor_range *range = &job->ranges[victim];
+	pthread_mutex_lock(&range->mtx);
+	t_int remaining = range->end - range->begin;
+	if(remaining > 0)
+	{
+		begin = range->end - (remaining + 1)/2;
+		end = range->end;
+		range->end = begin;
+	}
+	pthread_mutex_unlock(&range->mtx);
+
+	range = &job->ranges[thread];
+	pthread_mutex_lock(&range->mtx);
+	range->begin = begin;
+	range->end = end;
+	pthread_mutex_unlock(&range->mtx);
+
+	return 1;
+}
+
+
+/**
+ * run chunks of the thread's own range, then steal from the others
+ */
+static void parfor_work(struct t_parfor_job *job, t_int thread)
+{
+	struct t_parfor_range *range = &job->ranges[thread];
+
+	g_in_parfor = 1;
+
+	while(1)
+	{
+		t_int begin = 0, end = 0;
+
+		pthread_mutex_lock(&range->mtx);
+		if(range->begin < range->end)
+		{
+			begin = range->begin;
+			end = begin + job->grain;
+			if(end > range->end)
+				end = range->end;
+			range->begin = end;
+		}
+		pthread_mutex_unlock(&range->mtx);
+
+		if(begin >= end)
+		{
+			if(!parfor_steal(job, thread))
+				break;
+			continue;
+		}
+
+		job->body(job->ctx, begin, end);
+	}
+
+	g_in_parfor = 0;
+}
+
+
+/**
+ * function for the pool's worker threads, waiting for the next job
+ */
+static void* pool_worker_func(void *arg)
+{
+	t_int thread = (t_int)(intptr_t)arg;
+	uint64_t jobctr = 0;
+
+	pthread_mutex_lock(&mtx_pool);
+	while(1)
+	{
+		while(!g_pool_quit && g_pool_jobctr == jobctr)
+			pthread_cond_wait(&cond_pool_start, &mtx_pool);
+		if(g_pool_quit)
+			break;
+
+		jobctr = g_pool_jobctr;
+		struct t_parfor_job *job = g_pool_job;
+		pthread_mutex_unlock(&mtx_pool);
+
+		if(thread < job->num_threads)
+			parfor_work(job, thread);
+
+		pthread_mutex_lock(&mtx_pool);
+		if(--g_pool_active == 0)
+			pthread_cond_signal(&cond_pool_done);
+	}
+	pthread_mutex_unlock(&mtx_pool);
+
+	return 0;
+}
+
+
+/**
+ * start the worker threads, the calling thread is thread 0
+ */
+static void pool_init()
+{
+	if(g_pool_threads)
+		return;
+
+	t_int num_threads = par_num_threads();
+	g_pool_threads = (pthread_t*)calloc(num_threads, sizeof(pthread_t));
+	g_pool_quit = 0;
+	g_pool_size = 0;
+
+	for(t_int thread=1; thread<num_threads; ++thread)
+	{
+		if(pthread_create(&g_pool_threads[thread], 0,
+			pool_worker_func, (void*)(intptr_t)thread) != 0)
+			break;
+		++g_pool_size;
+	}
+}
+
+
+/**
+ * stop the worker threads
+ */
+static void pool_deinit()
+{
+	if(!g_pool_threads)
+		return;
+
+	pthread_mutex_lock(&mtx_pool);
+	g_pool_quit = 1;
+	pthread_cond_broadcast(&cond_pool_start);
+	pthread_mutex_unlock(&mtx_pool);
+
+	for(t_int thread=1; thread<=g_pool_size; ++thread)
+		pthread_join(g_pool_threads[thread], 0);
+
+	free(g_pool_threads);
+	g_pool_threads = 0;
+	g_pool_size = 0;
+}
+
+
+/**
+ * run the iterations [begin, end) of a loop body on all processors
+ */
+void ext_parfor(t_parfor_body body, void* ctx, t_int begin, t_int end)
+{
+	if(end <= begin)
+		return;
+
+	t_int num_iter = end - begin;
+	t_int num_threads = par_num_threads();
+	if(num_threads > num_iter)
+		num_threads = num_iter;
+
+	// the pool only runs one job at a time, other callers run sequentially
+	if(num_threads <= 1 || g_in_parfor || pthread_mutex_trylock(&mtx_pool_job) != 0)
+	{
+		body(ctx, begin, end);
+		return;
+	}
+
+	pool_init();
+	if(num_threads > g_pool_size + 1)
+		num_threads = g_pool_size + 1;
+
+	// several chunks per thread leave some work to steal
+	struct t_parfor_job job;
+	job.body = body;
+	job.ctx = ctx;
+	job.num_threads = num_threads;
+	job.grain = num_iter / (num_threads * 8);
+	if(job.grain < 1)
+		job.grain = 1;
+	job.ranges = (struct t_parfor_range*)calloc(num_threads, sizeof(struct t_parfor_range));
+
+	// split the range evenly
+	for(t_int thread=0; thread<num_threads; ++thread)
+	{
+		pthread_mutex_init(&job.ranges[thread].mtx, 0);
+		job.ranges[thread].begin = begin + num_iter*thread / num_threads;
+		job.ranges[thread].end = begin + num_iter*(thread + 1) / num_threads;
+	}
+
+	// wake the workers and take part as thread 0
+	pthread_mutex_lock(&mtx_pool);
+	g_pool_job = &job;
+	g_pool_active = g_pool_size;
+	++g_pool_jobctr;
+	pthread_cond_broadcast(&cond_pool_start);
+	pthread_mutex_unlock(&mtx_pool);
+
+	parfor_work(&job, 0);
+
+	pthread_mutex_lock(&mtx_pool);
+	while(g_pool_active > 0)
+		pthread_cond_wait(&cond_pool_done, &mtx_pool);
+	g_pool_job = 0;
+	pthread_mutex_unlock(&mtx_pool);
+
+	for(t_int thread=0; thread<num_threads; ++thread)
+		pthread_mutex_destroy(&job.ranges[thread].mtx);
+	free(job.ranges);
+
+	pthread_mutex_unlock(&mtx_pool_job);
+}
+// ----------------------------------------------------------------------------
+
+
+
 // ----------------------------------------------------------------------------
 // heap management
 // ----------------------------------------------------------------------------
@@ -71,12 +619,16 @@ void lst_remove(struct t_list *lst, void *elem)
 // list with allocated memory
 // (head node is not used!)
 static struct t_list lst_mem;
+static pthread_mutex_t mtx_mem = PTHREAD_MUTEX_INITIALIZER;
 
 
 void* ext_heap_alloc(uint64_t num, uint64_t elemsize)
 {
 	void *mem = calloc(num, elemsize);
+
+	pthread_mutex_lock(&mtx_mem);
 	lst_append(&lst_mem, mem);
+	pthread_mutex_unlock(&mtx_mem);
 
 	if(g_debug)
 	{
@@ -93,11 +645,13 @@ void ext_heap_free(void* mem)
 	if(!mem)
 		return;
 
-	free(mem);
-	lst_remove(&lst_mem, mem);
-
 	if(g_debug)
 		printf("%s: mem=%08lx.\n", __func__, (uint64_t)mem);
+
+	pthread_mutex_lock(&mtx_mem);
+	lst_remove(&lst_mem, mem);
+	free(mem);
+	pthread_mutex_unlock(&mtx_mem);
 }
 
 
@@ -105,11 +659,16 @@ void ext_init()
 {
 	lst_mem.elem = 0;
 	lst_mem.next = 0;
+
+	out_init();
 }
 
 
 void ext_deinit()
 {
+	out_deinit();
+	pool_deinit();
+
 	// look for non-freed memory
 	struct t_list *lst = &lst_mem;
 
@@ -193,9 +752,9 @@ void ext_submat(const t_real* M, t_int N, t_real* M_new, t_int iremove, t_int jr
 
 
 /**
- * calculates the determinant
+ * calculates the determinant by cofactor expansion, only used for small matrices
  */
-t_real ext_determinant(const t_real* M, t_int N)
+static t_real det_cofactor(const t_real* M, t_int N)
 {
 	// special cases
 	if(N == 0)
@@ -229,7 +788,7 @@ t_real ext_determinant(const t_real* M, t_int N)
 	// recursively expand determiant along a row
 	t_real fullDet = 0.;
 
-	t_real *submat = (t_real*)ext_heap_alloc((N-1)*(N-1), sizeof(t_real));
+	t_real submat[(N-1)*(N-1)];
 	for(t_int col=0; col<N; ++col)
 	{
 		const t_real elem = M[row*N + col];
@@ -238,114 +797,2206 @@ t_real ext_determinant(const t_real* M, t_int N)
 
 		ext_submat(M, N, submat, row, col);
 		const t_real sgn = ((row+col) % 2) == 0 ? 1. : -1.;
-		fullDet += elem * ext_determinant(submat, N-1) * sgn;
+		fullDet += elem * det_cofactor(submat, N-1) * sgn;
 	}
-	ext_heap_free(submat);
 
 	return fullDet;
 }
 
 
+struct t_lu_ctx
+{
+	t_real *LU;
+	t_int N, k;
+};
+
 
 /**
- * inverted matrix
+ * eliminates column k in the rows [begin, end) using the pivot row k
  */
-t_int ext_inverse(const t_real* M, t_real* I, t_int N)
+static void lu_eliminate(void *_ctx, t_int begin, t_int end)
 {
-	t_real fullDet = ext_determinant(M, N);
-
-	// fail if determinant is zero
-	if(ext_equals(fullDet, 0., g_eps))
-		return 0;
+	const struct t_lu_ctx *ctx = (const struct t_lu_ctx*)_ctx;
+	t_real *LU = ctx->LU;
+	const t_int N = ctx->N, k = ctx->k;
+	const t_real diag = LU[k*N + k];
 
-	t_real *submat = (t_real*)ext_heap_alloc((N-1)*(N-1), sizeof(t_real));
-	for(t_int i=0; i<N; ++i)
+	for(t_int i=begin; i<end; ++i)
 	{
-		for(t_int j=0; j<N; ++j)
-		{
-			ext_submat(M, N, submat, i, j);
-			const t_real sgn = ((i+j) % 2) == 0 ? 1. : -1.;
-			I[j*N + i] = ext_determinant(submat, N-1) * sgn / fullDet;
-		}
+		const t_real factor = LU[i*N + k] / diag;
+		LU[i*N + k] = factor;
+		for(t_int j=k+1; j<N; ++j)
+			LU[i*N + j] -= factor * LU[k*N + j];
 	}
-	ext_heap_free(submat);
-
-	return 1;
 }
 
 
 /**
- * matrix-matrix product: RES^i_j = M1^i_k M2^k_j
+ * lu decomposition with partial pivoting, P*M = L*U, done in-place:
+ * the strict lower triangle holds L (with unit diagonal), the upper triangle U,
+ * perm[i] is the original row of row i,
+ * returns 0 for a singular matrix
  */
-void ext_mult(const t_real* M1, const t_real* M2, t_real *RES, t_int I, t_int J, t_int K)
+static t_int lu_decomp(t_real* LU, t_int* perm, t_real* sign, t_int N)
 {
-	for(t_int i=0; i<I; ++i)
+	for(t_int i=0; i<N; ++i)
+		perm[i] = i;
+	*sign = 1.;
+
+	for(t_int k=0; k<N; ++k)
 	{
-		for(t_int j=0; j<J; ++j)
+		// find the pivot row with the largest element in the column
+		t_int pivot = k;
+		t_real pivot_val = LU[k*N + k] < 0. ? -LU[k*N + k] : LU[k*N + k];
+		for(t_int i=k+1; i<N; ++i)
 		{
-			RES[i*J + j] = 0.;
-
-			for(t_int k=0; k<K; ++k)
-				RES[i*J + j] += M1[i*K + k]*M2[k*J + j];
+			t_real val = LU[i*N + k] < 0. ? -LU[i*N + k] : LU[i*N + k];
+			if(val > pivot_val)
+			{
+				pivot = i;
+				pivot_val = val;
+			}
 		}
-	}
-}
 
+		if(pivot_val <= g_eps)
+			return 0;
 
-/**
- * matrix power
- */
-t_int ext_power(const t_real* M, t_real* P, t_int N, t_int POW)
-{
-	t_int POW_pos = POW < 0 ? -POW : POW;
-	t_int status = 1;
+		if(pivot != k)
+		{
+			for(t_int j=0; j<N; ++j)
+			{
+				t_real tmp = LU[k*N + j];
+				LU[k*N + j] = LU[pivot*N + j];
+				LU[pivot*N + j] = tmp;
+			}
+
+			t_int tmp = perm[k];
+			perm[k] = perm[pivot];
+			perm[pivot] = tmp;
+			*sign = -*sign;
+		}
+
+		// eliminate the column below the pivot
+		struct t_lu_ctx ctx = { LU, N, k };
+		if((N - k)*(N - k) >= PAR_MIN_ELEMS)
+			ext_parfor(lu_eliminate, &ctx, k + 1, N);
+		else
+			lu_eliminate(&ctx, k + 1, N);
+	}
 
-	// temporary matrices
-	t_real *Mtmp = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
-	t_real *Mtmp2 = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+	return 1;
+}
 
-	// Mtmp = M
+
+/**
+ * solves L*U*x = P*b for an lu-decomposed matrix,
+ * x is written with the given stride, e.g. into a matrix column
+ */
+static void lu_solve(const t_real* LU, const t_int* perm, const t_real* b, t_real* x,
+	t_int N, t_int stride)
+{
+	// forward substitution with the unit lower triangle
 	for(t_int i=0; i<N; ++i)
-		for(t_int j=0; j<N; ++j)
-			Mtmp[i*N + j] = M[i*N + j];
+	{
+		t_real val = b[perm[i]];
+		for(t_int j=0; j<i; ++j)
+			val -= LU[i*N + j] * x[j*stride];
+		x[i*stride] = val;
+	}
+
+	// backward substitution with the upper triangle
+	for(t_int i=N-1; i>=0; --i)
+	{
+		t_real val = x[i*stride];
+		for(t_int j=i+1; j<N; ++j)
+			val -= LU[i*N + j] * x[j*stride];
+		x[i*stride] = val / LU[i*N + i];
+	}
+}
+
+
+/**
+ * calculates the determinant
+ */
+t_real ext_determinant(const t_real* M, t_int N)
+{
+	if(N <= 3)
+		return det_cofactor(M, N);
+
+	t_real *LU = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+	t_int *perm = (t_int*)ext_heap_alloc(N, sizeof(t_int));
+	memcpy(LU, M, N*N*sizeof(t_real));
+
+	t_real det = 0.;
+	if(lu_decomp(LU, perm, &det, N))
+	{
+		for(t_int i=0; i<N; ++i)
+			det *= LU[i*N + i];
+	}
+	else
+	{
+		det = 0.;
+	}
+
+	ext_heap_free(perm);
+	ext_heap_free(LU);
+	return det;
+}
+
+
+
+struct t_inv_ctx
+{
+	const t_real *LU;
+	const t_int *perm;
+	t_real *I;
+	t_int N;
+};
+
+
+/**
+ * solves for the columns [begin, end) of the inverse matrix
+ */
+static void inv_columns(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_inv_ctx *ctx = (const struct t_inv_ctx*)_ctx;
+	const t_int N = ctx->N;
+	t_real *unit = (t_real*)ext_heap_alloc(N, sizeof(t_real));
+
+	for(t_int j=begin; j<end; ++j)
+	{
+		for(t_int i=0; i<N; ++i)
+			unit[i] = (i == j ? 1. : 0.);
+		lu_solve(ctx->LU, ctx->perm, unit, ctx->I + j, N, N);
+	}
+
+	ext_heap_free(unit);
+}
+
+
+/**
+ * inverted matrix
+ */
+t_int ext_inverse(const t_real* M, t_real* I, t_int N)
+{
+	if(N == 1)
+	{
+		if(ext_equals(M[0], 0., g_eps))
+			return 0;
+		I[0] = 1. / M[0];
+		return 1;
+	}
 
-	// matrix power
-	for(t_int i=0; i<POW_pos-1; ++i)
+	// cofactor expansion for small matrices
+	else if(N <= 3)
 	{
-		ext_mult(Mtmp, M, Mtmp2, N, N, N);
+		t_real fullDet = det_cofactor(M, N);
+
+		// fail if determinant is zero
+		if(ext_equals(fullDet, 0., g_eps))
+			return 0;
 
-		// Mtmp = Mtmp2
+		t_real submat[(N-1)*(N-1)];
 		for(t_int i=0; i<N; ++i)
+		{
 			for(t_int j=0; j<N; ++j)
-				Mtmp[i*N + j] = Mtmp2[i*N + j];
+			{
+				ext_submat(M, N, submat, i, j);
+				const t_real sgn = ((i+j) % 2) == 0 ? 1. : -1.;
+				I[j*N + i] = det_cofactor(submat, N-1) * sgn / fullDet;
+			}
+		}
+
+		return 1;
 	}
 
-	// invert
-	if(POW < 0)
-		status = ext_inverse(Mtmp, Mtmp2, N);
+	// solve for each column of the unit matrix
+	t_real *LU = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+	t_int *perm = (t_int*)ext_heap_alloc(N, sizeof(t_int));
+	memcpy(LU, M, N*N*sizeof(t_real));
 
-	// P = Mtmp2
-	for(t_int i=0; i<N; ++i)
-		for(t_int j=0; j<N; ++j)
-			P[i*N + j] = Mtmp2[i*N + j];
+	t_real sign = 1.;
+	t_int ok = lu_decomp(LU, perm, &sign, N);
+	if(ok)
+	{
+		struct t_inv_ctx ctx = { LU, perm, I, N };
+		if(N*N*N >= PAR_MIN_FLOPS)
+			ext_parfor(inv_columns, &ctx, 0, N);
+		else
+			inv_columns(&ctx, 0, N);
+	}
 
-	ext_heap_free(Mtmp);
-	ext_heap_free(Mtmp2);
-	return status;
+	ext_heap_free(perm);
+	ext_heap_free(LU);
+	return ok;
 }
 
 
 
+struct t_solve_ctx
+{
+	const t_real *LU;
+	const t_int *perm;
+	const t_real *B;
+	t_real *X;
+	t_int N, COLS;
+};
+
+
 /**
- * transposed matrix
+ * solves for the columns [begin, end) of the right-hand side
  */
-void ext_transpose(const t_real* M, t_real* T, t_int rows, t_int cols)
+static void solve_columns(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_solve_ctx *ctx = (const struct t_solve_ctx*)_ctx;
+	const t_int N = ctx->N, COLS = ctx->COLS;
+	t_real *col = (t_real*)ext_heap_alloc(N, sizeof(t_real));
+
+	for(t_int j=begin; j<end; ++j)
+	{
+		for(t_int i=0; i<N; ++i)
+			col[i] = ctx->B[i*COLS + j];
+		lu_solve(ctx->LU, ctx->perm, col, ctx->X + j, N, COLS);
+	}
+
+	ext_heap_free(col);
+}
+
+
+/**
+ * solves L*U*X = P*B for the N x COLS matrix X, COLS = 1 for vectors
+ */
+static void lu_solve_cols(const t_real* LU, const t_int* perm, const t_real* B, t_real* X,
+	t_int N, t_int COLS)
+{
+	struct t_solve_ctx ctx = { LU, perm, B, X, N, COLS };
+	if(COLS > 1 && N*N*COLS >= PAR_MIN_FLOPS)
+		ext_parfor(solve_columns, &ctx, 0, COLS);
+	else
+		solve_columns(&ctx, 0, COLS);
+}
+
+
+/**
+ * solves the linear system M*X = B without inverting M,
+ * returns 0 (and a zero X) for a singular matrix
+ */
+t_int ext_solve_mat(const t_real* M, const t_real* B, t_real* X, t_int N, t_int COLS)
+{
+	t_real *LU = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+	t_int *perm = (t_int*)ext_heap_alloc(N, sizeof(t_int));
+	memcpy(LU, M, N*N*sizeof(t_real));
+
+	t_real sign = 1.;
+	t_int ok = lu_decomp(LU, perm, &sign, N);
+	if(ok)
+		lu_solve_cols(LU, perm, B, X, N, COLS);
+	else
+		memset(X, 0, N*COLS*sizeof(t_real));
+
+	ext_heap_free(perm);
+	ext_heap_free(LU);
+	return ok;
+}
+
+
+// lu-decomposed matrix, reused for several right-hand sides
+struct t_lu_factor
+{
+	t_real *LU;
+	t_int *perm;
+	t_int N;
+};
+
+static struct t_lu_factor **g_factors = 0;
+static t_int g_num_factors = 0;
+
+// solving only reads the factors and can run concurrently
+static pthread_rwlock_t mtx_factors = PTHREAD_RWLOCK_INITIALIZER;
+
+
+/**
+ * lu-decomposes a square matrix and returns its handle,
+ * or -1 for a singular or non-square matrix
+ */
+t_int ext_factor(const t_real* M, t_int ROWS, t_int COLS)
+{
+	if(ROWS != COLS)
+		return -1;
+
+	const t_int N = ROWS;
+	struct t_lu_factor *factor = (struct t_lu_factor*)calloc(1, sizeof(struct t_lu_factor));
+	factor->LU = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+	factor->perm = (t_int*)ext_heap_alloc(N, sizeof(t_int));
+	factor->N = N;
+	memcpy(factor->LU, M, N*N*sizeof(t_real));
+
+	t_real sign = 1.;
+	if(!lu_decomp(factor->LU, factor->perm, &sign, N))
+	{
+		ext_heap_free(factor->perm);
+		ext_heap_free(factor->LU);
+		free(factor);
+		return -1;
+	}
+
+	pthread_rwlock_wrlock(&mtx_factors);
+	t_int handle = g_num_factors++;
+	g_factors = (struct t_lu_factor**)realloc(g_factors,
+		g_num_factors * sizeof(struct t_lu_factor*));
+	g_factors[handle] = factor;
+	pthread_rwlock_unlock(&mtx_factors);
+
+	return handle;
+}
+
+
+/**
+ * solves M*X = B with the lu-decomposed matrix M,
+ * returns 0 (and a zero X) for an invalid handle or a size mismatch
+ */
+t_int ext_solve_factor(t_int handle, const t_real* B, t_real* X, t_int N, t_int COLS)
+{
+	pthread_rwlock_rdlock(&mtx_factors);
+
+	struct t_lu_factor *factor = 0;
+	if(handle >= 0 && handle < g_num_factors)
+		factor = g_factors[handle];
+
+	t_int ok = factor && factor->N == N;
+	if(ok)
+		lu_solve_cols(factor->LU, factor->perm, B, X, N, COLS);
+	else
+		memset(X, 0, N*COLS*sizeof(t_real));
+
+	pthread_rwlock_unlock(&mtx_factors);
+	return ok;
+}
+
+
+/**
+ * frees an lu decomposition, returns -1 for an invalid handle
+ */
+t_int ext_factor_free(t_int handle)
+{
+	pthread_rwlock_wrlock(&mtx_factors);
+
+	struct t_lu_factor *factor = 0;
+	if(handle >= 0 && handle < g_num_factors)
+	{
+		factor = g_factors[handle];
+		g_factors[handle] = 0;
+	}
+
+	pthread_rwlock_unlock(&mtx_factors);
+
+	if(!factor)
+		return -1;
+
+	ext_heap_free(factor->perm);
+	ext_heap_free(factor->LU);
+	free(factor);
+	return 0;
+}
+
+
+// panel width of the blocked householder qr decomposition
+#define QR_BLOCK 32
+
+
+/**
+ * householder reflector for the column j of the ROWS x COLS matrix A below row j:
+ * the reflector's vector (with an implicit 1 at row j) is stored below the diagonal,
+ * the diagonal receives beta, returns tau with H = I - tau*v*v^T
+ */
+static t_real householder_vec(t_real *A, t_int ROWS, t_int COLS, t_int j)
+{
+	t_real norm2 = 0.;
+	for(t_int r=j+1; r<ROWS; ++r)
+		norm2 += A[r*COLS + j] * A[r*COLS + j];
+	if(norm2 == 0.)
+		return 0.;
+
+	const t_real x0 = A[j*COLS + j];
+	const t_real beta = -copysign(sqrt(x0*x0 + norm2), x0);
+	const t_real scale = 1. / (x0 - beta);
+
+	for(t_int r=j+1; r<ROWS; ++r)
+		A[r*COLS + j] *= scale;
+	A[j*COLS + j] = beta;
+
+	return (beta - x0) / beta;
+}
+
+
+struct t_qr_ctx
+{
+	const t_real *V;   // reflectors below the diagonal of the columns [p, p+nb)
+	t_int VCOLS;
+	const t_real *T;   // nb x nb upper triangular factor
+	t_int p, nb;
+	t_real *A;         // matrix to update
+	t_int ROWS, COLS;
+	int8_t trans;
+};
+
+
+/**
+ * applies the block reflector I - V*T*V^T (or its transpose)
+ * to the columns [begin, end) of the matrix, starting at row p
+ */
+static void qr_apply_block(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_qr_ctx *ctx = (const struct t_qr_ctx*)_ctx;
+	const t_int p = ctx->p, nb = ctx->nb, ROWS = ctx->ROWS, COLS = ctx->COLS;
+	const t_real *V = ctx->V, *T = ctx->T;
+	t_real *A = ctx->A;
+
+	t_real *w = (t_real*)ext_heap_alloc(2*nb, sizeof(t_real));
+	t_real *tw = w + nb;
+
+	for(t_int c=begin; c<end; ++c)
+	{
+		// w = V^T * c
+		for(t_int i=0; i<nb; ++i)
+		{
+			w[i] = A[(p + i)*COLS + c];
+			for(t_int r=p+i+1; r<ROWS; ++r)
+				w[i] += V[r*ctx->VCOLS + p + i] * A[r*COLS + c];
+		}
+
+		// w = T*w or T^T*w
+		for(t_int i=0; i<nb; ++i)
+		{
+			tw[i] = 0.;
+			if(ctx->trans)
+			{
+				for(t_int k=0; k<=i; ++k)
+					tw[i] += T[k*nb + i] * w[k];
+			}
+			else
+			{
+				for(t_int k=i; k<nb; ++k)
+					tw[i] += T[i*nb + k] * w[k];
+			}
+		}
+
+		// c -= V * w
+		for(t_int i=0; i<nb; ++i)
+		{
+			A[(p + i)*COLS + c] -= tw[i];
+			for(t_int r=p+i+1; r<ROWS; ++r)
+				A[r*COLS + c] -= V[r*ctx->VCOLS + p + i] * tw[i];
+		}
+	}
+
+	ext_heap_free(w);
+}
+
+
+/**
+ * blocked householder qr decomposition, M = Q*R with an orthogonal ROWS x ROWS
+ * matrix Q and an upper triangular ROWS x COLS matrix R: the reflectors of each
+ * panel are combined into a block reflector I - V*T*V^T, which then updates
+ * the trailing columns (and builds Q) column-parallel in one sweep,
+ * returns a heap memory block holding Q and R
+ */
+void* ext_qr(const t_real* M, t_int ROWS, t_int COLS)
+{
+	t_real *mem = (t_real*)ext_heap_alloc(ROWS*ROWS + ROWS*COLS, sizeof(t_real));
+	t_real *Q = mem, *R = mem + ROWS*ROWS;
+	const t_int K = ROWS < COLS ? ROWS : COLS;
+	const t_int num_blocks = (K + QR_BLOCK - 1) / QR_BLOCK;
+
+	// R holds the reflectors below its diagonal until the end
+	memcpy(R, M, ROWS*COLS*sizeof(t_real));
+	t_real *Ts = (t_real*)ext_heap_alloc(num_blocks*QR_BLOCK*QR_BLOCK + 1, sizeof(t_real));
+	t_real taus[QR_BLOCK], t[QR_BLOCK];
+
+	for(t_int p=0; p<K; p+=QR_BLOCK)
+	{
+		const t_int nb = K - p < QR_BLOCK ? K - p : QR_BLOCK;
+		t_real *T = Ts + (p/QR_BLOCK)*QR_BLOCK*QR_BLOCK;
+
+		// factorise the panel column by column
+		for(t_int i=0; i<nb; ++i)
+		{
+			const t_int j = p + i;
+			const t_real tau = taus[i] = householder_vec(R, ROWS, COLS, j);
+			if(tau == 0.)
+				continue;
+
+			for(t_int c=j+1; c<p+nb; ++c)
+			{
+				t_real w = R[j*COLS + c];
+				for(t_int r=j+1; r<ROWS; ++r)
+					w += R[r*COLS + j] * R[r*COLS + c];
+				w *= tau;
+
+				R[j*COLS + c] -= w;
+				for(t_int r=j+1; r<ROWS; ++r)
+					R[r*COLS + c] -= w * R[r*COLS + j];
+			}
+		}
+
+		// upper triangular factor, H_p*...*H_(p+nb-1) = I - V*T*V^T
+		for(t_int i=0; i<nb; ++i)
+		{
+			for(t_int k=0; k<i; ++k)
+			{
+				// V(:, k)^T * V(:, i)
+				t_real dot = R[(p + i)*COLS + p + k];
+				for(t_int r=p+i+1; r<ROWS; ++r)
+					dot += R[r*COLS + p + k] * R[r*COLS + p + i];
+				t[k] = -taus[i] * dot;
+			}
+
+			for(t_int k=0; k<i; ++k)
+			{
+				T[k*nb + i] = 0.;
+				for(t_int u=k; u<i; ++u)
+					T[k*nb + i] += T[k*nb + u] * t[u];
+			}
+			for(t_int k=i+1; k<nb; ++k)
+				T[k*nb + i] = 0.;
+			T[i*nb + i] = taus[i];
+		}
+
+		// apply the transposed block reflector to the trailing columns
+		const t_int trail = p + nb;
+		struct t_qr_ctx ctx = { R, COLS, T, p, nb, R, ROWS, COLS, 1 };
+		if((ROWS - p)*(COLS - trail)*nb >= PAR_MIN_FLOPS)
+			ext_parfor(qr_apply_block, &ctx, trail, COLS);
+		else
+			qr_apply_block(&ctx, trail, COLS);
+	}
+
+	// accumulate Q = H_0*...*H_(K-1) backwards, the block reflector
+	// starting at row p leaves the unit columns before p unchanged
+	for(t_int i=0; i<ROWS; ++i)
+		Q[i*ROWS + i] = 1.;
+
+	for(t_int b=num_blocks-1; b>=0; --b)
+	{
+		const t_int p = b*QR_BLOCK;
+		const t_int nb = K - p < QR_BLOCK ? K - p : QR_BLOCK;
+
+		struct t_qr_ctx ctx = { R, COLS, Ts + b*QR_BLOCK*QR_BLOCK, p, nb, Q, ROWS, ROWS, 0 };
+		if((ROWS - p)*(ROWS - p)*nb >= PAR_MIN_FLOPS)
+			ext_parfor(qr_apply_block, &ctx, p, ROWS);
+		else
+			qr_apply_block(&ctx, p, ROWS);
+	}
+
+	for(t_int i=1; i<ROWS; ++i)
+		for(t_int j=0; j<i && j<COLS; ++j)
+			R[i*COLS + j] = 0.;
+
+	ext_heap_free(Ts);
+	return mem;
+}
+
+
+
+struct t_chol_ctx
+{
+	const t_real *M;
+	t_real *L;
+	t_int N, j;
+};
+
+
+/**
+ * computes the rows [begin, end) of the column j of L
+ */
+static void chol_rows(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_chol_ctx *ctx = (const struct t_chol_ctx*)_ctx;
+	const t_int N = ctx->N, j = ctx->j;
+	t_real *L = ctx->L;
+
+	for(t_int i=begin; i<end; ++i)
+	{
+		t_real val = ctx->M[i*N + j];
+		for(t_int k=0; k<j; ++k)
+			val -= L[i*N + k] * L[j*N + k];
+		L[i*N + j] = val / L[j*N + j];
+	}
+}
+
+
+/**
+ * cholesky decomposition M = L*L^T of a symmetric matrix using its lower triangle,
+ * returns a heap memory block holding L and 1, or a zero L and 0 if the
+ * matrix is not positive definite or not square
+ */
+void* ext_chol(const t_real* M, t_int ROWS, t_int COLS)
+{
+	const t_int N = ROWS;
+	t_real *mem = (t_real*)ext_heap_alloc(N*N*sizeof(t_real) + sizeof(t_int), 1);
+	t_real *L = mem;
+	t_int *ok = (t_int*)(mem + N*N);
+
+	*ok = (ROWS == COLS);
+	for(t_int j=0; j<N && *ok; ++j)
+	{
+		t_real diag = M[j*N + j];
+		for(t_int k=0; k<j; ++k)
+			diag -= L[j*N + k] * L[j*N + k];
+
+		// also catches nan
+		if(!(diag > 0.))
+		{
+			*ok = 0;
+			break;
+		}
+		L[j*N + j] = sqrt(diag);
+
+		// the rows below the diagonal are independent
+		struct t_chol_ctx ctx = { M, L, N, j };
+		if((N - j)*j >= PAR_MIN_FLOPS)
+			ext_parfor(chol_rows, &ctx, j + 1, N);
+		else
+			chol_rows(&ctx, j + 1, N);
+	}
+
+	if(!*ok)
+		memset(L, 0, N*N*sizeof(t_real));
+	return mem;
+}
+
+
+/**
+ * householder reduction of the symmetric matrix V to tridiagonal form,
+ * d receives the diagonal, e the sub-diagonal, V the transformation
+ * @see the tred2 algorithm of the eispack library
+ */
+static void eig_tridiag(t_real *V, t_real *d, t_real *e, t_int N)
+{
+	for(t_int j=0; j<N; ++j)
+		d[j] = V[(N - 1)*N + j];
+
+	for(t_int i=N-1; i>0; --i)
+	{
+		t_real scale = 0., h = 0.;
+		for(t_int k=0; k<i; ++k)
+			scale += fabs(d[k]);
+
+		if(scale == 0.)
+		{
+			e[i] = d[i - 1];
+			for(t_int j=0; j<i; ++j)
+			{
+				d[j] = V[(i - 1)*N + j];
+				V[i*N + j] = V[j*N + i] = 0.;
+			}
+		}
+		else
+		{
+			for(t_int k=0; k<i; ++k)
+			{
+				d[k] /= scale;
+				h += d[k] * d[k];
+			}
+
+			t_real f = d[i - 1];
+			t_real g = sqrt(h);
+			if(f > 0.)
+				g = -g;
+			e[i] = scale * g;
+			h -= f * g;
+			d[i - 1] = f - g;
+
+			for(t_int j=0; j<i; ++j)
+				e[j] = 0.;
+
+			for(t_int j=0; j<i; ++j)
+			{
+				f = d[j];
+				V[j*N + i] = f;
+				g = e[j] + V[j*N + j] * f;
+				for(t_int k=j+1; k<i; ++k)
+				{
+					g += V[k*N + j] * d[k];
+					e[k] += V[k*N + j] * f;
+				}
+				e[j] = g;
+			}
+
+			f = 0.;
+			for(t_int j=0; j<i; ++j)
+			{
+				e[j] /= h;
+				f += e[j] * d[j];
+			}
+
+			const t_real hh = f / (h + h);
+			for(t_int j=0; j<i; ++j)
+				e[j] -= hh * d[j];
+
+			for(t_int j=0; j<i; ++j)
+			{
+				f = d[j];
+				g = e[j];
+				for(t_int k=j; k<i; ++k)
+					V[k*N + j] -= (f * e[k] + g * d[k]);
+				d[j] = V[(i - 1)*N + j];
+				V[i*N + j] = 0.;
+			}
+		}
+
+		d[i] = h;
+	}
+
+	// accumulate the transformations
+	for(t_int i=0; i<N-1; ++i)
+	{
+		V[(N - 1)*N + i] = V[i*N + i];
+		V[i*N + i] = 1.;
+
+		const t_real h = d[i + 1];
+		if(h != 0.)
+		{
+			for(t_int k=0; k<=i; ++k)
+				d[k] = V[k*N + i + 1] / h;
+
+			for(t_int j=0; j<=i; ++j)
+			{
+				t_real g = 0.;
+				for(t_int k=0; k<=i; ++k)
+					g += V[k*N + i + 1] * V[k*N + j];
+				for(t_int k=0; k<=i; ++k)
+					V[k*N + j] -= g * d[k];
+			}
+		}
+
+		for(t_int k=0; k<=i; ++k)
+			V[k*N + i + 1] = 0.;
+	}
+
+	for(t_int j=0; j<N; ++j)
+	{
+		d[j] = V[(N - 1)*N + j];
+		V[(N - 1)*N + j] = 0.;
+	}
+	V[(N - 1)*N + N - 1] = 1.;
+	e[0] = 0.;
+}
+
+
+/**
+ * implicit ql iterations on the tridiagonal matrix given by d and e,
+ * accumulating the rotations in V, returns 0 if they do not converge
+ * @see the tql2 algorithm of the eispack library
+ */
+static t_int eig_tridiag_ql(t_real *V, t_real *d, t_real *e, t_int N)
 {
-	for(t_int ctr=0; ctr<rows*cols; ++ctr)
+	for(t_int i=1; i<N; ++i)
+		e[i - 1] = e[i];
+	e[N - 1] = 0.;
+
+	const t_int max_iter = 30*N;
+	t_real f = 0., tst1 = 0.;
+
+	for(t_int l=0; l<N; ++l)
 	{
-		t_int i = ctr/cols;
-		t_int j = ctr%cols;
-		T[j*rows + i] = M[i*cols + j];
+		// find a small sub-diagonal element
+		t_real tst = fabs(d[l]) + fabs(e[l]);
+		if(tst > tst1)
+			tst1 = tst;
+		t_int m = l;
+		while(m < N - 1 && fabs(e[m]) > REAL_EPSILON*tst1)
+			++m;
+
+		t_int iter = 0;
+		while(m > l)
+		{
+			if(++iter > max_iter)
+				return 0;
+
+			// implicit shift
+			t_real g = d[l];
+			t_real p = (d[l + 1] - g) / (2. * e[l]);
+			t_real r = hypot(p, 1.);
+			if(p < 0.)
+				r = -r;
+
+			d[l] = e[l] / (p + r);
+			d[l + 1] = e[l] * (p + r);
+			const t_real dl1 = d[l + 1];
+			t_real h = g - d[l];
+			for(t_int i=l+2; i<N; ++i)
+				d[i] -= h;
+			f += h;
+
+			// ql transformation
+			p = d[m];
+			t_real c = 1., c2 = 1., c3 = 1.;
+			t_real s = 0., s2 = 0.;
+			const t_real el1 = e[l + 1];
+
+			for(t_int i=m-1; i>=l; --i)
+			{
+				c3 = c2;
+				c2 = c;
+				s2 = s;
+				g = c * e[i];
+				h = c * p;
+				r = hypot(p, e[i]);
+				e[i + 1] = s * r;
+				s = e[i] / r;
+				c = p / r;
+				p = c * d[i] - s * g;
+				d[i + 1] = h + s * (c * g + s * d[i]);
+
+				// accumulate the rotation
+				for(t_int k=0; k<N; ++k)
+				{
+					h = V[k*N + i + 1];
+					V[k*N + i + 1] = s * V[k*N + i] + c * h;
+					V[k*N + i] = c * V[k*N + i] - s * h;
+				}
+			}
+
+			p = -s * s2 * c3 * el1 * e[l] / dl1;
+			e[l] = s * p;
+			d[l] = c * p;
+
+			if(fabs(e[l]) <= REAL_EPSILON*tst1)
+				break;
+		}
+
+		d[l] += f;
+		e[l] = 0.;
 	}
+
+	return 1;
+}
+
+
+/**
+ * eigenvalues and eigenvectors of a symmetric matrix using its lower triangle,
+ * returns a heap memory block holding the ascending eigenvalues and the
+ * eigenvectors as columns, or zeros if the matrix is not square or the
+ * iteration does not converge
+ */
+void* ext_eig_sym(const t_real* M, t_int ROWS, t_int COLS)
+{
+	const t_int N = ROWS;
+	t_real *mem = (t_real*)ext_heap_alloc(N + N*N, sizeof(t_real));
+	t_real *d = mem, *V = mem + N;
+	if(ROWS != COLS || N == 0)
+		return mem;
+
+	t_real *e = (t_real*)ext_heap_alloc(N, sizeof(t_real));
+	memcpy(V, M, N*N*sizeof(t_real));
+
+	eig_tridiag(V, d, e, N);
+	if(!eig_tridiag_ql(V, d, e, N))
+	{
+		memset(mem, 0, (N + N*N)*sizeof(t_real));
+		ext_heap_free(e);
+		return mem;
+	}
+
+	// sort the eigenvalues and eigenvectors
+	for(t_int i=0; i<N-1; ++i)
+	{
+		t_int k = i;
+		for(t_int j=i+1; j<N; ++j)
+			if(d[j] < d[k])
+				k = j;
+
+		if(k != i)
+		{
+			t_real tmp = d[k];
+			d[k] = d[i];
+			d[i] = tmp;
+
+			for(t_int j=0; j<N; ++j)
+			{
+				tmp = V[j*N + i];
+				V[j*N + i] = V[j*N + k];
+				V[j*N + k] = tmp;
+			}
+		}
+	}
+
+	ext_heap_free(e);
+	return mem;
+}
+
+
+// blocked matrix product: the rows of M1 and a packed panel of M2 are
+// split into cache-sized blocks, a register-tiled micro-kernel computes
+// MR x NR tiles of the result
+#define GEMM_MR 4
+#define GEMM_NR 8
+#define GEMM_MC 64
+#define GEMM_KC 256
+#define GEMM_NC 512
+
+typedef void (*t_gemm_kernel)(t_int kc, const t_real *A, t_int lda,
+	const t_real *Bpack, t_real *C, t_int ldc, t_int mr, t_int nr);
+
+
+/**
+ * C += A*B for a tile of at most MR x NR elements, B is packed NR-wide
+ */
+static void gemm_kernel_scalar(t_int kc, const t_real *A, t_int lda,
+	const t_real *Bpack, t_real *C, t_int ldc, t_int mr, t_int nr)
+{
+	t_real acc[GEMM_MR][GEMM_NR];
+	memset(acc, 0, sizeof(acc));
+
+	for(t_int k=0; k<kc; ++k)
+	{
+		const t_real *b = Bpack + k*GEMM_NR;
+		for(t_int i=0; i<mr; ++i)
+		{
+			t_real a = A[i*lda + k];
+			for(t_int j=0; j<GEMM_NR; ++j)
+				acc[i][j] += a * b[j];
+		}
+	}
+
+	for(t_int i=0; i<mr; ++i)
+		for(t_int j=0; j<nr; ++j)
+			C[i*ldc + j] += acc[i][j];
+}
+
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+/**
+ * avx2/fma micro-kernel for full 4x8 tiles, only used if t_real is a double
+ */
+__attribute__((target("avx2,fma")))
+static void gemm_kernel_avx2(t_int kc, const t_real *_A, t_int lda,
+	const t_real *_Bpack, t_real *_C, t_int ldc, t_int mr, t_int nr)
+{
+	if(mr != GEMM_MR || nr != GEMM_NR)
+	{
+		gemm_kernel_scalar(kc, _A, lda, _Bpack, _C, ldc, mr, nr);
+		return;
+	}
+
+	const double *A = (const double*)_A;
+	const double *Bpack = (const double*)_Bpack;
+	double *C = (double*)_C;
+
+	__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+	__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+	__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+	__m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+	for(t_int k=0; k<kc; ++k)
+	{
+		__m256d b0 = _mm256_loadu_pd(Bpack + k*GEMM_NR);
+		__m256d b1 = _mm256_loadu_pd(Bpack + k*GEMM_NR + 4);
+
+		__m256d a = _mm256_broadcast_sd(A + k);
+		c00 = _mm256_fmadd_pd(a, b0, c00);
+		c01 = _mm256_fmadd_pd(a, b1, c01);
+		a = _mm256_broadcast_sd(A + lda + k);
+		c10 = _mm256_fmadd_pd(a, b0, c10);
+		c11 = _mm256_fmadd_pd(a, b1, c11);
+		a = _mm256_broadcast_sd(A + 2*lda + k);
+		c20 = _mm256_fmadd_pd(a, b0, c20);
+		c21 = _mm256_fmadd_pd(a, b1, c21);
+		a = _mm256_broadcast_sd(A + 3*lda + k);
+		c30 = _mm256_fmadd_pd(a, b0, c30);
+		c31 = _mm256_fmadd_pd(a, b1, c31);
+	}
+
+	_mm256_storeu_pd(C, _mm256_add_pd(_mm256_loadu_pd(C), c00));
+	_mm256_storeu_pd(C + 4, _mm256_add_pd(_mm256_loadu_pd(C + 4), c01));
+	_mm256_storeu_pd(C + ldc, _mm256_add_pd(_mm256_loadu_pd(C + ldc), c10));
+	_mm256_storeu_pd(C + ldc + 4, _mm256_add_pd(_mm256_loadu_pd(C + ldc + 4), c11));
+	_mm256_storeu_pd(C + 2*ldc, _mm256_add_pd(_mm256_loadu_pd(C + 2*ldc), c20));
+	_mm256_storeu_pd(C + 2*ldc + 4, _mm256_add_pd(_mm256_loadu_pd(C + 2*ldc + 4), c21));
+	_mm256_storeu_pd(C + 3*ldc, _mm256_add_pd(_mm256_loadu_pd(C + 3*ldc), c30));
+	_mm256_storeu_pd(C + 3*ldc + 4, _mm256_add_pd(_mm256_loadu_pd(C + 3*ldc + 4), c31));
+}
+#endif
+
+
+/**
+ * selects the micro-kernel for the cpu the program runs on
+ */
+static t_gemm_kernel gemm_get_kernel()
+{
+	static t_gemm_kernel kernel = 0;
+	if(kernel)
+		return kernel;
+
+	kernel = gemm_kernel_scalar;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	if(sizeof(t_real) == sizeof(double) &&
+		__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		kernel = gemm_kernel_avx2;
+#endif
+
+	return kernel;
+}
+
+
+/**
+ * packs kc rows and nc columns of B into NR-wide slivers, padded with zeros
+ */
+static void gemm_pack_b(const t_real *B, t_int ldb, t_int kc, t_int nc, t_real *Bpack)
+{
+	for(t_int jr=0; jr<nc; jr+=GEMM_NR)
+	{
+		t_int nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+
+		for(t_int k=0; k<kc; ++k)
+		{
+			for(t_int j=0; j<nr; ++j)
+				Bpack[k*GEMM_NR + j] = B[k*ldb + jr + j];
+			for(t_int j=nr; j<GEMM_NR; ++j)
+				Bpack[k*GEMM_NR + j] = 0.;
+		}
+
+		Bpack += kc*GEMM_NR;
+	}
+}
+
+
+// operands of a matrix product or transposition
+struct t_mult_ctx
+{
+	const t_real *M1, *M2;
+	t_real *RES;
+	t_int I, J, K;
+};
+
+
+/**
+ * matrix-vector product for the rows [begin, end): RES^i = M^i_k v^k
+ */
+static void gemv_rows(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_mult_ctx *ctx = (const struct t_mult_ctx*)_ctx;
+	const t_int K = ctx->K;
+
+	for(t_int i=begin; i<end; ++i)
+	{
+		const t_real *row = ctx->M1 + i*K;
+		const t_real *v = ctx->M2;
+
+		// independent accumulators, lets the compiler vectorise the loop
+		t_real acc[GEMM_NR];
+		memset(acc, 0, sizeof(acc));
+
+		t_int k = 0;
+		for(; k+GEMM_NR<=K; k+=GEMM_NR)
+			for(t_int lane=0; lane<GEMM_NR; ++lane)
+				acc[lane] += row[k + lane] * v[k + lane];
+
+		t_real sum = 0.;
+		for(t_int lane=0; lane<GEMM_NR; ++lane)
+			sum += acc[lane];
+		for(; k<K; ++k)
+			sum += row[k] * v[k];
+		ctx->RES[i] = sum;
+	}
+}
+
+
+/**
+ * matrix-matrix product for the row blocks [begin, end) of size MC,
+ * each call packs its own panels of M2
+ */
+static void gemm_rows(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_mult_ctx *ctx = (const struct t_mult_ctx*)_ctx;
+	const t_real *M1 = ctx->M1, *M2 = ctx->M2;
+	t_real *RES = ctx->RES;
+	const t_int J = ctx->J, K = ctx->K;
+
+	t_int row_begin = begin*GEMM_MC;
+	t_int row_end = end*GEMM_MC < ctx->I ? end*GEMM_MC : ctx->I;
+
+	t_gemm_kernel kernel = gemm_get_kernel();
+	t_int kc_max = K < GEMM_KC ? K : GEMM_KC;
+	t_int nc_max = J < GEMM_NC ? J : GEMM_NC;
+	nc_max = (nc_max + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+	t_real *Bpack = (t_real*)ext_heap_alloc(kc_max*nc_max, sizeof(t_real));
+
+	for(t_int jc=0; jc<J; jc+=GEMM_NC)
+	{
+		t_int nc = J - jc < GEMM_NC ? J - jc : GEMM_NC;
+
+		for(t_int pc=0; pc<K; pc+=GEMM_KC)
+		{
+			t_int kc = K - pc < GEMM_KC ? K - pc : GEMM_KC;
+			gemm_pack_b(M2 + pc*J + jc, J, kc, nc, Bpack);
+
+			for(t_int ic=row_begin; ic<row_end; ic+=GEMM_MC)
+			{
+				t_int mc = row_end - ic < GEMM_MC ? row_end - ic : GEMM_MC;
+
+				for(t_int jr=0; jr<nc; jr+=GEMM_NR)
+				{
+					t_int nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+					const t_real *b = Bpack + (jr/GEMM_NR)*kc*GEMM_NR;
+
+					for(t_int ir=0; ir<mc; ir+=GEMM_MR)
+					{
+						t_int mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+						kernel(kc, M1 + (ic + ir)*K + pc, K, b,
+							RES + (ic + ir)*J + jc + jr, J, mr, nr);
+					}
+				}
+			}
+		}
+	}
+
+	ext_heap_free(Bpack);
+}
+
+
+/**
+ * matrix-matrix product: RES^i_j = M1^i_k M2^k_j,
+ * a matrix-vector product if J == 1,
+ * large products are split by rows across the threads
+ */
+void ext_mult(const t_real* M1, const t_real* M2, t_real *RES, t_int I, t_int J, t_int K)
+{
+	struct t_mult_ctx ctx = { M1, M2, RES, I, J, K };
+	int8_t parallel = (I*J*K >= PAR_MIN_FLOPS);
+
+	if(J == 1)
+	{
+		if(parallel)
+			ext_parfor(gemv_rows, &ctx, 0, I);
+		else
+			gemv_rows(&ctx, 0, I);
+		return;
+	}
+
+	memset(RES, 0, I*J*sizeof(t_real));
+	if(I <= 0 || J <= 0 || K <= 0)
+		return;
+
+	// select the micro-kernel before starting the threads
+	gemm_get_kernel();
+
+	t_int num_blocks = (I + GEMM_MC - 1) / GEMM_MC;
+	if(parallel)
+		ext_parfor(gemm_rows, &ctx, 0, num_blocks);
+	else
+		gemm_rows(&ctx, 0, num_blocks);
+}
+
+
+/**
+ * matrix power by repeated squaring,
+ * negative powers invert the matrix once
+ */
+t_int ext_power(const t_real* M, t_real* P, t_int N, t_int POW)
+{
+	// negate in unsigned arithmetic, which also works for the minimum t_int
+	uint64_t POW_pos = POW < 0 ? -(uint64_t)POW : (uint64_t)POW;
+	t_int status = 1;
+
+	// ping-pong buffers for the squared matrix, the result and the products
+	t_real *base = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+	t_real *res = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+	t_real *tmp = (t_real*)ext_heap_alloc(N*N, sizeof(t_real));
+
+	if(POW < 0)
+		status = ext_inverse(M, base, N);
+	else
+		memcpy(base, M, N*N*sizeof(t_real));
+
+	// the result is the unit matrix until the first factor is multiplied
+	int8_t res_unit = 1;
+
+	while(status && POW_pos)
+	{
+		if(POW_pos & 1)
+		{
+			if(res_unit)
+			{
+				memcpy(res, base, N*N*sizeof(t_real));
+				res_unit = 0;
+			}
+			else
+			{
+				ext_mult(res, base, tmp, N, N, N);
+				t_real *swap = res;
+				res = tmp;
+				tmp = swap;
+			}
+		}
+
+		POW_pos >>= 1;
+		if(POW_pos)
+		{
+			ext_mult(base, base, tmp, N, N, N);
+			t_real *swap = base;
+			base = tmp;
+			tmp = swap;
+		}
+	}
+
+	if(res_unit)
+	{
+		for(t_int i=0; i<N; ++i)
+			for(t_int j=0; j<N; ++j)
+				P[i*N + j] = (i == j ? 1. : 0.);
+	}
+	else
+	{
+		memcpy(P, res, N*N*sizeof(t_real));
+	}
+
+	ext_heap_free(tmp);
+	ext_heap_free(res);
+	ext_heap_free(base);
+	return status;
+}
+
+
+/**
+ * integer power by repeated squaring
+ */
+t_int ext_power_int(t_int base, t_int POW)
+{
+	if(POW < 0)
+	{
+		// only 1 and -1 have integer inverses
+		if(base == 1)
+			return 1;
+		else if(base == -1)
+			return (POW % 2) ? -1 : 1;
+		return 0;
+	}
+
+	// multiply in unsigned arithmetic, overflows wrap around
+	uint64_t res = 1, ubase = (uint64_t)base;
+	while(POW)
+	{
+		if(POW & 1)
+			res *= ubase;
+		POW >>= 1;
+		if(POW)
+			ubase *= ubase;
+	}
+
+	return (t_int)res;
+}
+
+
+
+/**
+ * transposes the rows [begin, end) of a rows x cols matrix
+ */
+static void transpose_rows(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_mult_ctx *ctx = (const struct t_mult_ctx*)_ctx;
+	const t_int rows = ctx->I, cols = ctx->J;
+
+	for(t_int i=begin; i<end; ++i)
+		for(t_int j=0; j<cols; ++j)
+			ctx->RES[j*rows + i] = ctx->M1[i*cols + j];
+}
+
+
+/**
+ * transposed matrix
+ */
+void ext_transpose(const t_real* M, t_real* T, t_int rows, t_int cols)
+{
+	struct t_mult_ctx ctx = { M, 0, T, rows, cols, 0 };
+	if(rows*cols >= PAR_MIN_ELEMS)
+		ext_parfor(transpose_rows, &ctx, 0, rows);
+	else
+		transpose_rows(&ctx, 0, rows);
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// reductions
+// ----------------------------------------------------------------------------
+
+enum t_reduce_op
+{
+	REDUCE_SUM, REDUCE_PROD,
+	REDUCE_MIN, REDUCE_MAX,
+	REDUCE_MEAN,
+	REDUCE_ARGMIN, REDUCE_ARGMAX,
+};
+
+// number of independent accumulators, lets the compiler vectorise the loops
+#define REDUCE_LANES 8
+
+
+/**
+ * pairwise summation, the rounding error grows with log(n) instead of n
+ */
+static t_real pairwise_sum(const t_real *x, t_int n, t_int stride)
+{
+	if(n > 128)
+	{
+		// split at a multiple of the lanes
+		t_int half = (n / 2) / REDUCE_LANES * REDUCE_LANES;
+		return pairwise_sum(x, half, stride) +
+			pairwise_sum(x + half*stride, n - half, stride);
+	}
+
+	t_real lanes[REDUCE_LANES] = { 0 };
+	t_int i = 0;
+	for(; i + REDUCE_LANES <= n; i += REDUCE_LANES)
+		for(t_int lane=0; lane<REDUCE_LANES; ++lane)
+			lanes[lane] += x[(i + lane)*stride];
+
+	t_real sum = 0.;
+	for(t_int lane=0; lane<REDUCE_LANES; ++lane)
+		sum += lanes[lane];
+	for(; i<n; ++i)
+		sum += x[i*stride];
+
+	return sum;
+}
+
+
+static t_real lanes_prod(const t_real *x, t_int n, t_int stride)
+{
+	t_real lanes[REDUCE_LANES];
+	for(t_int lane=0; lane<REDUCE_LANES; ++lane)
+		lanes[lane] = 1.;
+
+	t_int i = 0;
+	for(; i + REDUCE_LANES <= n; i += REDUCE_LANES)
+		for(t_int lane=0; lane<REDUCE_LANES; ++lane)
+			lanes[lane] *= x[(i + lane)*stride];
+
+	t_real prod = 1.;
+	for(t_int lane=0; lane<REDUCE_LANES; ++lane)
+		prod *= lanes[lane];
+	for(; i<n; ++i)
+		prod *= x[i*stride];
+
+	return prod;
+}
+
+
+/**
+ * minimum or maximum of a non-empty range
+ */
+static t_real lanes_extremum(const t_real *x, t_int n, t_int stride, int8_t is_max)
+{
+	t_real lanes[REDUCE_LANES];
+	for(t_int lane=0; lane<REDUCE_LANES; ++lane)
+		lanes[lane] = x[0];
+
+	t_int i = 0;
+	for(; i + REDUCE_LANES <= n; i += REDUCE_LANES)
+	{
+		for(t_int lane=0; lane<REDUCE_LANES; ++lane)
+		{
+			t_real val = x[(i + lane)*stride];
+			if(is_max)
+				lanes[lane] = val > lanes[lane] ? val : lanes[lane];
+			else
+				lanes[lane] = val < lanes[lane] ? val : lanes[lane];
+		}
+	}
+
+	t_real result = lanes[0];
+	for(t_int lane=1; lane<REDUCE_LANES; ++lane)
+	{
+		if(is_max)
+			result = lanes[lane] > result ? lanes[lane] : result;
+		else
+			result = lanes[lane] < result ? lanes[lane] : result;
+	}
+	for(; i<n; ++i)
+	{
+		t_real val = x[i*stride];
+		if(is_max)
+			result = val > result ? val : result;
+		else
+			result = val < result ? val : result;
+	}
+
+	return result;
+}
+
+
+/**
+ * index of the first minimum or maximum of a non-empty range
+ */
+static t_int arg_extremum(const t_real *x, t_int n, t_int stride, int8_t is_max)
+{
+	t_int idx = 0;
+	for(t_int i=1; i<n; ++i)
+	{
+		if(is_max ? x[i*stride] > x[idx*stride] : x[i*stride] < x[idx*stride])
+			idx = i;
+	}
+
+	return idx;
+}
+
+
+/**
+ * reduces n elements with the given stride,
+ * the arg functions return the index and -1 for an empty range
+ */
+static t_real reduce_seq(enum t_reduce_op op, const t_real *x, t_int n, t_int stride)
+{
+	switch(op)
+	{
+		case REDUCE_SUM:
+			return pairwise_sum(x, n, stride);
+		case REDUCE_PROD:
+			return lanes_prod(x, n, stride);
+		case REDUCE_MEAN:
+			return n > 0 ? pairwise_sum(x, n, stride) / (t_real)n : 0.;
+		case REDUCE_MIN:
+			return n > 0 ? lanes_extremum(x, n, stride, 0) : 0.;
+		case REDUCE_MAX:
+			return n > 0 ? lanes_extremum(x, n, stride, 1) : 0.;
+		case REDUCE_ARGMIN:
+			return n > 0 ? (t_real)arg_extremum(x, n, stride, 0) : -1.;
+		case REDUCE_ARGMAX:
+			return n > 0 ? (t_real)arg_extremum(x, n, stride, 1) : -1.;
+	}
+
+	return 0.;
+}
+
+
+// a large range is split into a fixed number of blocks,
+// so that the result does not depend on the number of threads
+#define REDUCE_PAR_BLOCKS 64
+
+struct t_reduce_ctx
+{
+	enum t_reduce_op op;
+	const t_real *x;
+	t_int n, stride;
+
+	// results of the blocks or of the matrix rows or columns
+	t_real *results;
+	t_int result_stride;
+};
+
+
+/**
+ * reduces the blocks [begin, end) of a range,
+ * the arg functions give the index in the full range
+ */
+static void reduce_blocks(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_reduce_ctx *ctx = (const struct t_reduce_ctx*)_ctx;
+	enum t_reduce_op op = ctx->op == REDUCE_MEAN ? REDUCE_SUM : ctx->op;
+
+	for(t_int block=begin; block<end; ++block)
+	{
+		t_int first = ctx->n*block / REDUCE_PAR_BLOCKS;
+		t_int last = ctx->n*(block + 1) / REDUCE_PAR_BLOCKS;
+
+		t_real result = reduce_seq(op, ctx->x + first*ctx->stride, last - first, ctx->stride);
+		if(op == REDUCE_ARGMIN || op == REDUCE_ARGMAX)
+			result += (t_real)first;
+		ctx->results[block] = result;
+	}
+}
+
+
+/**
+ * reduces n elements with the given stride,
+ * large ranges are split across the threads
+ */
+static t_real reduce(enum t_reduce_op op, const t_real *x, t_int n, t_int stride)
+{
+	if(n < PAR_MIN_ELEMS)
+		return reduce_seq(op, x, n, stride);
+
+	t_real partial[REDUCE_PAR_BLOCKS];
+	struct t_reduce_ctx ctx = { op, x, n, stride, partial, 1 };
+	ext_parfor(reduce_blocks, &ctx, 0, REDUCE_PAR_BLOCKS);
+
+	switch(op)
+	{
+		case REDUCE_SUM:
+			return pairwise_sum(partial, REDUCE_PAR_BLOCKS, 1);
+		case REDUCE_PROD:
+			return lanes_prod(partial, REDUCE_PAR_BLOCKS, 1);
+		case REDUCE_MEAN:
+			return pairwise_sum(partial, REDUCE_PAR_BLOCKS, 1) / (t_real)n;
+		case REDUCE_MIN:
+			return lanes_extremum(partial, REDUCE_PAR_BLOCKS, 1, 0);
+		case REDUCE_MAX:
+			return lanes_extremum(partial, REDUCE_PAR_BLOCKS, 1, 1);
+		case REDUCE_ARGMIN:
+		case REDUCE_ARGMAX:
+		{
+			// first block with the extremum
+			t_int idx = (t_int)partial[0];
+			for(t_int block=1; block<REDUCE_PAR_BLOCKS; ++block)
+			{
+				t_int cur = (t_int)partial[block];
+				if(op == REDUCE_ARGMIN ? x[cur*stride] < x[idx*stride] : x[cur*stride] > x[idx*stride])
+					idx = cur;
+			}
+			return (t_real)idx;
+		}
+	}
+
+	return 0.;
+}
+
+
+/**
+ * reduces the matrix rows or columns [begin, end)
+ */
+static void reduce_lines(void *_ctx, t_int begin, t_int end)
+{
+	const struct t_reduce_ctx *ctx = (const struct t_reduce_ctx*)_ctx;
+
+	for(t_int idx=begin; idx<end; ++idx)
+	{
+		ctx->results[idx] = reduce_seq(ctx->op, ctx->x + idx*ctx->result_stride,
+			ctx->n, ctx->stride);
+	}
+}
+
+
+/**
+ * reduces the columns (axis 0) or rows (axis 1) of a matrix into a vector
+ */
+static t_int reduce_axis(enum t_reduce_op op, const t_real *M, t_int ROWS, t_int COLS,
+	t_int axis, t_real *vec, t_int N)
+{
+	t_int num_results, num_elems, elem_stride, result_stride;
+	if(axis == 0)
+	{
+		num_results = COLS;
+		num_elems = ROWS;
+		elem_stride = COLS;
+		result_stride = 1;
+	}
+	else if(axis == 1)
+	{
+		num_results = ROWS;
+		num_elems = COLS;
+		elem_stride = 1;
+		result_stride = COLS;
+	}
+	else
+	{
+		return -1;
+	}
+
+	if(N != num_results)
+		return -1;
+
+	struct t_reduce_ctx ctx = { op, M, num_elems, elem_stride, vec, result_stride };
+	if(num_results*num_elems >= PAR_MIN_ELEMS)
+		ext_parfor(reduce_lines, &ctx, 0, num_results);
+	else
+		reduce_lines(&ctx, 0, num_results);
+
+	return num_results;
+}
+
+
+t_real ext_sum(const t_real *vec, t_int N) { return reduce(REDUCE_SUM, vec, N, 1); }
+t_real ext_prod(const t_real *vec, t_int N) { return reduce(REDUCE_PROD, vec, N, 1); }
+t_real ext_min(const t_real *vec, t_int N) { return reduce(REDUCE_MIN, vec, N, 1); }
+t_real ext_max(const t_real *vec, t_int N) { return reduce(REDUCE_MAX, vec, N, 1); }
+t_real ext_mean(const t_real *vec, t_int N) { return reduce(REDUCE_MEAN, vec, N, 1); }
+t_int ext_argmin(const t_real *vec, t_int N) { return (t_int)reduce(REDUCE_ARGMIN, vec, N, 1); }
+t_int ext_argmax(const t_real *vec, t_int N) { return (t_int)reduce(REDUCE_ARGMAX, vec, N, 1); }
+
+
+t_int ext_sum_axis(const t_real *M, t_int ROWS, t_int COLS, t_int axis, t_real *vec, t_int N)
+{
+	return reduce_axis(REDUCE_SUM, M, ROWS, COLS, axis, vec, N);
+}
+
+
+t_int ext_prod_axis(const t_real *M, t_int ROWS, t_int COLS, t_int axis, t_real *vec, t_int N)
+{
+	return reduce_axis(REDUCE_PROD, M, ROWS, COLS, axis, vec, N);
+}
+
+
+t_int ext_min_axis(const t_real *M, t_int ROWS, t_int COLS, t_int axis, t_real *vec, t_int N)
+{
+	return reduce_axis(REDUCE_MIN, M, ROWS, COLS, axis, vec, N);
+}
+
+
+t_int ext_max_axis(const t_real *M, t_int ROWS, t_int COLS, t_int axis, t_real *vec, t_int N)
+{
+	return reduce_axis(REDUCE_MAX, M, ROWS, COLS, axis, vec, N);
+}
+
+
+t_int ext_mean_axis(const t_real *M, t_int ROWS, t_int COLS, t_int axis, t_real *vec, t_int N)
+{
+	return reduce_axis(REDUCE_MEAN, M, ROWS, COLS, axis, vec, N);
+}
+
+
+t_int ext_argmin_axis(const t_real *M, t_int ROWS, t_int COLS, t_int axis, t_real *vec, t_int N)
+{
+	return reduce_axis(REDUCE_ARGMIN, M, ROWS, COLS, axis, vec, N);
+}
+
+
+t_int ext_argmax_axis(const t_real *M, t_int ROWS, t_int COLS, t_int axis, t_real *vec, t_int N)
+{
+	return reduce_axis(REDUCE_ARGMAX, M, ROWS, COLS, axis, vec, N);
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// vector and matrix files
+// ----------------------------------------------------------------------------
+
+// raw array files: header followed by little-endian doubles in row-major order
+struct t_arr_header
+{
+	char magic[8];
+	uint64_t rank;
+	uint64_t dims[2];
+};
+
+static const char g_arr_magic[8] = { 'M', 'C', 'A', 'L', 'C', 'A', 'R', 'R' };
+
+// numpy files, see: https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+static const char g_npy_magic[] = "\x93NUMPY";
+#define NPY_MAGIC_LEN 6
+#define NPY_ALIGN 64
+
+
+// description of the array data in a file
+struct t_arr_info
+{
+	uint64_t rank;
+	uint64_t dims[2];
+	size_t offs;           // start of the data in the file
+	size_t elem_size;      // 8: double, 4: float
+	int8_t fortran_order;  // column-major data
+};
+
+
+static int8_t is_npy_file(const char *filename)
+{
+	size_t len = strlen(filename);
+	return len >= 4 && strcmp(filename + len - 4, ".npy") == 0;
+}
+
+
+/**
+ * parse the header of a raw array file
+ */
+static int8_t parse_arr_header(const uint8_t *data, size_t size, struct t_arr_info *info)
+{
+	struct t_arr_header hdr;
+	if(size < sizeof(hdr))
+		return 0;
+
+	memcpy(&hdr, data, sizeof(hdr));
+	if(memcmp(hdr.magic, g_arr_magic, sizeof(g_arr_magic)) != 0)
+		return 0;
+	if(hdr.rank < 1 || hdr.rank > 2)
+		return 0;
+
+	info->rank = hdr.rank;
+	info->dims[0] = hdr.dims[0];
+	info->dims[1] = hdr.rank == 2 ? hdr.dims[1] : 1;
+	info->offs = sizeof(hdr);
+	info->elem_size = sizeof(double);
+	info->fortran_order = 0;
+	return 1;
+}
+
+
+/**
+ * get the value belonging to a key in the python dictionary of an npy header
+ */
+static const char* get_npy_value(const char *dict, const char *key)
+{
+	const char *val = strstr(dict, key);
+	if(!val)
+		return 0;
+
+	val = strchr(val + strlen(key), ':');
+	if(!val)
+		return 0;
+
+	++val;
+	while(*val == ' ')
+		++val;
+	return val;
+}
+
+
+/**
+ * parse the header of an npy file
+ */
+static int8_t parse_npy_header(const uint8_t *data, size_t size, struct t_arr_info *info)
+{
+	if(size < NPY_MAGIC_LEN + 4 || memcmp(data, g_npy_magic, NPY_MAGIC_LEN) != 0)
+		return 0;
+
+	// header length
+	size_t hdr_len = 0;
+	const uint8_t major = data[NPY_MAGIC_LEN];
+	if(major == 1)
+	{
+		uint16_t len;
+		memcpy(&len, data + NPY_MAGIC_LEN + 2, sizeof(len));
+		hdr_len = len;
+		info->offs = NPY_MAGIC_LEN + 2 + sizeof(len);
+	}
+	else if((major == 2 || major == 3) && size >= NPY_MAGIC_LEN + 6)
+	{
+		uint32_t len;
+		memcpy(&len, data + NPY_MAGIC_LEN + 2, sizeof(len));
+		hdr_len = len;
+		info->offs = NPY_MAGIC_LEN + 2 + sizeof(len);
+	}
+	else
+	{
+		return 0;
+	}
+
+	if(size < info->offs + hdr_len)
+		return 0;
+
+	// null-terminated copy of the dictionary
+	char *dict = (char*)calloc(hdr_len + 1, 1);
+	if(!dict)
+		return 0;
+	memcpy(dict, data + info->offs, hdr_len);
+	info->offs += hdr_len;
+
+	int8_t ok = 0;
+	info->rank = 0;
+	info->dims[0] = info->dims[1] = 1;
+
+	// element type, only little-endian floating point numbers are supported
+	const char *descr = get_npy_value(dict, "'descr'");
+	const char *order = get_npy_value(dict, "'fortran_order'");
+	const char *shape = get_npy_value(dict, "'shape'");
+
+	if(descr && order && shape && *shape == '(')
+	{
+		ok = 1;
+		if(strncmp(descr, "'<f8'", 5) == 0)
+			info->elem_size = sizeof(double);
+		else if(strncmp(descr, "'<f4'", 5) == 0)
+			info->elem_size = sizeof(float);
+		else
+			ok = 0;
+
+		info->fortran_order = (strncmp(order, "True", 4) == 0);
+
+		// shape tuple
+		for(++shape; ok && *shape && *shape != ')';)
+		{
+			if(*shape == ' ' || *shape == ',')
+			{
+				++shape;
+				continue;
+			}
+
+			char *end = 0;
+			uint64_t dim = strtoull(shape, &end, 10);
+			if(end == shape || info->rank >= 2)
+				ok = 0;
+			else
+				info->dims[info->rank++] = dim;
+			shape = end;
+		}
+
+		// a scalar is treated as a vector with one element
+		if(info->rank == 0)
+			info->rank = 1;
+	}
+
+	free(dict);
+	return ok;
+}
+
+
+/**
+ * load a file into a vector or matrix with the given dimensions
+ */
+static t_int load_arr(const char *filename, t_real *arr, t_int rows, t_int cols, int8_t is_mat)
+{
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0)
+		return -1;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	size_t size = (size_t)st.st_size;
+	void *mem = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mem == MAP_FAILED)
+		return -1;
+
+	const uint8_t *data = (const uint8_t*)mem;
+	struct t_arr_info info = { 0 };
+	int8_t ok = is_npy_file(filename)
+		? parse_npy_header(data, size, &info)
+		: parse_arr_header(data, size, &info);
+
+	// a vector can be loaded from any file with the same number of
+	// elements, a matrix needs a matrix with the same dimensions
+	const uint64_t num_elems = (uint64_t)(rows * cols);
+	if(ok && !is_mat && info.dims[0]*info.dims[1] != num_elems)
+		ok = 0;
+	if(ok && is_mat && (info.rank != 2 || info.dims[0] != (uint64_t)rows || info.dims[1] != (uint64_t)cols))
+		ok = 0;
+	if(ok && size < info.offs + num_elems*info.elem_size)
+		ok = 0;
+
+	if(ok)
+	{
+		data += info.offs;
+		const int8_t transpose = info.fortran_order && is_mat;
+
+		if(info.elem_size == sizeof(t_real) && !transpose && sizeof(t_real) == sizeof(double))
+		{
+			// copy the data directly if it has the same layout
+			memcpy(arr, data, num_elems*sizeof(t_real));
+		}
+		else
+		{
+			for(t_int row=0; row<rows; ++row)
+			{
+				for(t_int col=0; col<cols; ++col)
+				{
+					size_t idx = transpose ? col*rows + row : row*cols + col;
+
+					if(info.elem_size == sizeof(double))
+					{
+						double val;
+						memcpy(&val, data + idx*sizeof(val), sizeof(val));
+						arr[row*cols + col] = (t_real)val;
+					}
+					else
+					{
+						float val;
+						memcpy(&val, data + idx*sizeof(val), sizeof(val));
+						arr[row*cols + col] = (t_real)val;
+					}
+				}
+			}
+		}
+	}
+
+	munmap(mem, size);
+
+	if(g_debug && !ok)
+		printf("%s: cannot load \"%s\".\n", __func__, filename);
+	return ok ? 0 : -1;
+}
+
+
+/**
+ * save a vector or matrix with the given dimensions
+ */
+static t_int save_arr(const char *filename, const t_real *arr, t_int rows, t_int cols, int8_t is_mat)
+{
+	FILE *file = fopen(filename, "wb");
+	if(!file)
+		return -1;
+
+	// header
+	if(is_npy_file(filename))
+	{
+		char dict[256];
+		int len;
+		if(is_mat)
+		{
+			len = snprintf(dict, sizeof(dict), "{'descr': '<f8', 'fortran_order': False, 'shape': (%lld, %lld), }",
+				(long long)rows, (long long)cols);
+		}
+		else
+		{
+			len = snprintf(dict, sizeof(dict), "{'descr': '<f8', 'fortran_order': False, 'shape': (%lld,), }",
+				(long long)rows);
+		}
+
+		// pad the header, so that the data is aligned
+		int pad = (NPY_ALIGN - (NPY_MAGIC_LEN + 4 + len + 1) % NPY_ALIGN) % NPY_ALIGN;
+		uint16_t dict_len = (uint16_t)(len + pad + 1);
+
+		fwrite(g_npy_magic, 1, NPY_MAGIC_LEN, file);
+		fputc(1, file);
+		fputc(0, file);
+		fwrite(&dict_len, sizeof(dict_len), 1, file);
+		fwrite(dict, 1, len, file);
+		for(int i=0; i<pad; ++i)
+			fputc(' ', file);
+		fputc('\n', file);
+	}
+	else
+	{
+		struct t_arr_header hdr;
+		memcpy(hdr.magic, g_arr_magic, sizeof(g_arr_magic));
+		hdr.rank = is_mat ? 2 : 1;
+		hdr.dims[0] = (uint64_t)rows;
+		hdr.dims[1] = (uint64_t)cols;
+		fwrite(&hdr, sizeof(hdr), 1, file);
+	}
+
+	// data
+	for(t_int idx=0; idx<rows*cols; ++idx)
+	{
+		double val = (double)arr[idx];
+		fwrite(&val, sizeof(val), 1, file);
+	}
+
+	int8_t ok = !ferror(file);
+	if(fclose(file) != 0)
+		ok = 0;
+
+	if(g_debug && !ok)
+		printf("%s: cannot save \"%s\".\n", __func__, filename);
+	return ok ? 0 : -1;
+}
+
+
+t_int ext_load_vec(const char *filename, t_real *vec, t_int N)
+{
+	return load_arr(filename, vec, N, 1, 0);
+}
+
+
+t_int ext_load_mat(const char *filename, t_real *mat, t_int ROWS, t_int COLS)
+{
+	return load_arr(filename, mat, ROWS, COLS, 1);
+}
+
+
+t_int ext_save_vec(const char *filename, const t_real *vec, t_int N)
+{
+	return save_arr(filename, vec, N, 1, 0);
+}
+
+
+t_int ext_save_mat(const char *filename, const t_real *mat, t_int ROWS, t_int COLS)
+{
+	return save_arr(filename, mat, ROWS, COLS, 1);
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// streaming csv files
+// ----------------------------------------------------------------------------
+
+// memory-mapped csv file
+struct t_csv_file
+{
+	const char *data;
+	size_t size;
+	size_t pos;       // start of the next line
+	char *line;       // null-terminated copy of the current line for strtod
+	size_t line_size;
+};
+
+static struct t_csv_file **g_csv_files = 0;
+static t_int g_num_csv_files = 0;
+static pthread_mutex_t mtx_csv = PTHREAD_MUTEX_INITIALIZER;
+
+
+static int8_t is_csv_separator(char c)
+{
+	return c == ',' || c == ';' || c == '\t' || c == ' ' || c == '\r';
+}
+
+
+/**
+ * parse the fields of a line, returns 0 if it is not a data line
+ * (empty, comment or header line)
+ */
+static int8_t csv_parse_line(const char *line, t_real *row, t_int num_cols)
+{
+	t_int col = 0;
+	const char *pos = line;
+
+	while(*pos && col < num_cols)
+	{
+		while(*pos && is_csv_separator(*pos))
+			++pos;
+		if(!*pos)
+			break;
+
+		if(col == 0 && *pos == '#')
+			return 0;
+
+		char *num_end = 0;
+		t_real val = (t_real)strtod(pos, &num_end);
+		if(num_end == pos)
+		{
+			// header or comment line
+			if(col == 0)
+				return 0;
+
+			// skip an invalid field
+			val = 0.;
+		}
+
+		row[col++] = val;
+		pos = num_end;
+
+		// skip the rest of the field
+		while(*pos && !is_csv_separator(*pos))
+			++pos;
+	}
+
+	// empty line
+	if(col == 0)
+		return 0;
+
+	for(; col<num_cols; ++col)
+		row[col] = 0.;
+	return 1;
+}
+
+
+/**
+ * open a csv file and return its handle, or -1 on failure
+ */
+t_int ext_csv_open(const char *filename)
+{
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0)
+		return -1;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	struct t_csv_file *file = (struct t_csv_file*)calloc(1, sizeof(struct t_csv_file));
+	file->size = (size_t)st.st_size;
+	if(file->size)
+	{
+		void *mem = mmap(0, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mem == MAP_FAILED)
+		{
+			close(fd);
+			free(file);
+			return -1;
+		}
+
+		madvise(mem, file->size, MADV_SEQUENTIAL);
+		file->data = (const char*)mem;
+	}
+	close(fd);
+
+	pthread_mutex_lock(&mtx_csv);
+	t_int handle = g_num_csv_files++;
+	g_csv_files = (struct t_csv_file**)realloc(g_csv_files,
+		g_num_csv_files * sizeof(struct t_csv_file*));
+	g_csv_files[handle] = file;
+	pthread_mutex_unlock(&mtx_csv);
+
+	return handle;
+}
+
+
+/**
+ * read the next rows of a csv file into a matrix,
+ * returns the number of rows, or -1 on failure
+ */
+t_int ext_csv_next_rows(t_int handle, t_real *mat, t_int ROWS, t_int COLS)
+{
+	pthread_mutex_lock(&mtx_csv);
+
+	struct t_csv_file *file = 0;
+	if(handle >= 0 && handle < g_num_csv_files)
+		file = g_csv_files[handle];
+	if(!file)
+	{
+		pthread_mutex_unlock(&mtx_csv);
+		return -1;
+	}
+
+	t_int row = 0;
+	while(row < ROWS && file->pos < file->size)
+	{
+		const char *line_begin = file->data + file->pos;
+		const char *line_end = (const char*)memchr(line_begin, '\n', file->size - file->pos);
+		size_t line_len = line_end ? (size_t)(line_end - line_begin) : file->size - file->pos;
+		file->pos += line_len + 1;
+
+		// strtod needs a null-terminated string
+		if(line_len + 1 > file->line_size)
+		{
+			file->line_size = line_len + 1;
+			file->line = (char*)realloc(file->line, file->line_size);
+		}
+		memcpy(file->line, line_begin, line_len);
+		file->line[line_len] = 0;
+
+		if(csv_parse_line(file->line, mat + row*COLS, COLS))
+			++row;
+	}
+
+	pthread_mutex_unlock(&mtx_csv);
+
+	// zero the remaining rows
+	for(t_int idx=row*COLS; idx<ROWS*COLS; ++idx)
+		mat[idx] = 0.;
+
+	return row;
+}
+
+
+/**
+ * close a csv file, returns -1 for an invalid handle
+ */
+t_int ext_csv_close(t_int handle)
+{
+	pthread_mutex_lock(&mtx_csv);
+
+	struct t_csv_file *file = 0;
+	if(handle >= 0 && handle < g_num_csv_files)
+	{
+		file = g_csv_files[handle];
+		g_csv_files[handle] = 0;
+	}
+
+	pthread_mutex_unlock(&mtx_csv);
+
+	if(!file)
+		return -1;
+
+	if(file->data)
+		munmap((void*)file->data, file->size);
+	free(file->line);
+	free(file);
+	return 0;
 }
 // ----------------------------------------------------------------------------
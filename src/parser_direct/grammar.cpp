@@ -32,12 +32,18 @@ void MatrixCalcGrammar::CreateGrammar()
 
 	// terminals
 	op_assign = std::make_shared<lalr1::Terminal>('=', "=");
+	op_add_assign = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::ADD_ASSIGN), "+=");
+	op_sub_assign = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::SUB_ASSIGN), "-=");
+	op_mul_assign = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::MUL_ASSIGN), "*=");
+	op_div_assign = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::DIV_ASSIGN), "/=");
 	op_plus = std::make_shared<lalr1::Terminal>('+', "+");
 	op_minus = std::make_shared<lalr1::Terminal>('-', "-");
 	op_mult = std::make_shared<lalr1::Terminal>('*', "*");
 	op_div = std::make_shared<lalr1::Terminal>('/', "/");
 	op_mod = std::make_shared<lalr1::Terminal>('%', "%");
 	op_pow = std::make_shared<lalr1::Terminal>('^', "^");
+	op_elem_mult = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::EMUL), ".*");
+	op_elem_div = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::EDIV), "./");
 	op_norm = std::make_shared<lalr1::Terminal>('|', "|");
 	op_trans = std::make_shared<lalr1::Terminal>('\'', "'");
 
@@ -81,8 +87,11 @@ void MatrixCalcGrammar::CreateGrammar()
 	keyword_do = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::DO), "do");
 	keyword_func = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::FUNC), "func");
 	keyword_ret = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::RET), "ret");
+	keyword_map = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::MAP), "map");
 	keyword_next = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::NEXT), "next");
 	keyword_break = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::BREAK), "break");
+	keyword_parfor = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::PARFOR), "parfor");
+	keyword_reduce = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::REDUCE), "reduce");
 	keyword_assign = std::make_shared<lalr1::Terminal>(static_cast<std::size_t>(Token::ASSIGN), "assign");
 
 
@@ -90,6 +99,10 @@ void MatrixCalcGrammar::CreateGrammar()
 	// see: https://en.wikipedia.org/wiki/Order_of_operations
 	comma->SetPrecedence(5, 'l');
 	op_assign->SetPrecedence(10, 'r');
+	op_add_assign->SetPrecedence(10, 'r');
+	op_sub_assign->SetPrecedence(10, 'r');
+	op_mul_assign->SetPrecedence(10, 'r');
+	op_div_assign->SetPrecedence(10, 'r');
 
 	op_xor->SetPrecedence(20, 'l');
 	op_or->SetPrecedence(21, 'l');
@@ -110,6 +123,8 @@ void MatrixCalcGrammar::CreateGrammar()
 	op_mult->SetPrecedence(60, 'l');
 	op_div->SetPrecedence(60, 'l');
 	op_mod->SetPrecedence(60, 'l');
+	op_elem_mult->SetPrecedence(60, 'l');
+	op_elem_div->SetPrecedence(60, 'l');
 
 	op_not->SetPrecedence(70, 'l');
 	// TODO: unary_ops->SetPrecedence(75, 'r');
@@ -1883,5 +1898,205 @@ void MatrixCalcGrammar::CreateGrammar()
 	}));
 #endif
 	++semanticindex;
+
+	// rule 79: in-place addition assignment
+#ifdef CREATE_PRODUCTION_RULES
+	expression->AddRule({ ident, op_add_assign, expression }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto identnode = std::dynamic_pointer_cast<ASTStrConst>(args[0]);
+		const t_str& ident = identnode->GetVal();
+
+		auto term = std::dynamic_pointer_cast<AST>(args[2]);
+		return std::make_shared<ASTCompoundAssign>(ident, term, ASTCompoundAssign::ADD);
+	}));
+#endif
+	++semanticindex;
+
+	// rule 80: in-place subtraction assignment
+#ifdef CREATE_PRODUCTION_RULES
+	expression->AddRule({ ident, op_sub_assign, expression }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto identnode = std::dynamic_pointer_cast<ASTStrConst>(args[0]);
+		const t_str& ident = identnode->GetVal();
+
+		auto term = std::dynamic_pointer_cast<AST>(args[2]);
+		return std::make_shared<ASTCompoundAssign>(ident, term, ASTCompoundAssign::SUB);
+	}));
+#endif
+	++semanticindex;
+
+	// rule 81: in-place multiplication assignment
+#ifdef CREATE_PRODUCTION_RULES
+	expression->AddRule({ ident, op_mul_assign, expression }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto identnode = std::dynamic_pointer_cast<ASTStrConst>(args[0]);
+		const t_str& ident = identnode->GetVal();
+
+		auto term = std::dynamic_pointer_cast<AST>(args[2]);
+		return std::make_shared<ASTCompoundAssign>(ident, term, ASTCompoundAssign::MUL);
+	}));
+#endif
+	++semanticindex;
+
+	// rule 82: in-place division assignment
+#ifdef CREATE_PRODUCTION_RULES
+	expression->AddRule({ ident, op_div_assign, expression }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto identnode = std::dynamic_pointer_cast<ASTStrConst>(args[0]);
+		const t_str& ident = identnode->GetVal();
+
+		auto term = std::dynamic_pointer_cast<AST>(args[2]);
+		return std::make_shared<ASTCompoundAssign>(ident, term, ASTCompoundAssign::DIV);
+	}));
+#endif
+	++semanticindex;
+	// --------------------------------------------------------------------------------
+
+	// --------------------------------------------------------------------------------
+	// parallel loops
+	// --------------------------------------------------------------------------------
+	// rule 83: parallel loop, the iterations may only assign the variables declared
+	// in the loop body, the loop variable, the accumulators and disjoint
+	// elements of shared arrays, e.g. indexed by the loop variable
+#ifdef CREATE_PRODUCTION_RULES
+	statement->AddRule({ keyword_parfor, ident, op_assign, expression, range, expression,
+		keyword_do, statement }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto identnode = std::dynamic_pointer_cast<ASTStrConst>(args[1]);
+		auto begin = std::dynamic_pointer_cast<AST>(args[3]);
+		auto end = std::dynamic_pointer_cast<AST>(args[5]);
+		auto stmt = std::dynamic_pointer_cast<AST>(args[7]);
+		return std::make_shared<ASTParLoop>(identnode->GetVal(), begin, end, stmt);
+	}));
+#endif
+	++semanticindex;
+
+	// rule 84: parallel loop with accumulators
+#ifdef CREATE_PRODUCTION_RULES
+	statement->AddRule({ keyword_parfor, ident, op_assign, expression, range, expression,
+		keyword_reduce, identlist, keyword_do, statement }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto identnode = std::dynamic_pointer_cast<ASTStrConst>(args[1]);
+		auto begin = std::dynamic_pointer_cast<AST>(args[3]);
+		auto end = std::dynamic_pointer_cast<AST>(args[5]);
+		auto accs = std::dynamic_pointer_cast<ASTArgNames>(args[7]);
+		auto stmt = std::dynamic_pointer_cast<AST>(args[9]);
+		return std::make_shared<ASTParLoop>(identnode->GetVal(), begin, end, stmt,
+			accs->GetArgIdents());
+	}));
+#endif
+	++semanticindex;
+	// --------------------------------------------------------------------------------
+
+	// --------------------------------------------------------------------------------
+	// array functions
+	// --------------------------------------------------------------------------------
+	// rule 85: apply a function to each array element
+#ifdef CREATE_PRODUCTION_RULES
+	expression->AddRule({ keyword_map, bracket_open, ident, comma, expression, bracket_close }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[this](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto identnode = std::dynamic_pointer_cast<ASTStrConst>(args[2]);
+		const t_str& funcname = identnode->GetVal();
+		const Symbol* sym = m_context.GetSymbols().FindSymbol(funcname);
+
+		if(sym && sym->ty == SymbolType::FUNC)
+			++sym->refcnt;
+		else
+			std::cerr << "Cannot find function \"" << funcname << "\"." << std::endl;
+
+		auto term = std::dynamic_pointer_cast<AST>(args[4]);
+		return std::make_shared<ASTMap>(funcname, term);
+	}));
+#endif
+	++semanticindex;
+	// --------------------------------------------------------------------------------
+
+	// --------------------------------------------------------------------------------
+	// element-wise operators
+	// --------------------------------------------------------------------------------
+	// rule 86: expression -> expression .* expression
+#ifdef CREATE_PRODUCTION_RULES
+	expression->AddRule({ expression, op_elem_mult, expression }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto expr1 = std::dynamic_pointer_cast<AST>(args[0]);
+		auto expr2 = std::dynamic_pointer_cast<AST>(args[2]);
+		return std::make_shared<ASTElemMult>(expr1, expr2, 0);
+	}));
+#endif
+	++semanticindex;
+
+	// rule 87: expression -> expression ./ expression
+#ifdef CREATE_PRODUCTION_RULES
+	expression->AddRule({ expression, op_elem_div, expression }, semanticindex);
+#endif
+#ifdef CREATE_SEMANTIC_RULES
+	rules.emplace(std::make_pair(semanticindex,
+	[](bool full_match, const lalr1::t_semanticargs& args, [[maybe_unused]] lalr1::t_astbaseptr retval) -> lalr1::t_astbaseptr
+	{
+		if(!full_match)
+			return nullptr;
+
+		auto expr1 = std::dynamic_pointer_cast<AST>(args[0]);
+		auto expr2 = std::dynamic_pointer_cast<AST>(args[2]);
+		return std::make_shared<ASTElemMult>(expr1, expr2, 1);
+	}));
+#endif
+	++semanticindex;
 	// --------------------------------------------------------------------------------
 }
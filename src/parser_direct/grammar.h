@@ -88,8 +88,11 @@ private:
 		opt_assign{};
 
 	// terminals
-	lalr1::TerminalPtr op_assign{}, op_plus{}, op_minus{},
+	lalr1::TerminalPtr op_assign{}, op_add_assign{}, op_sub_assign{},
+		op_mul_assign{}, op_div_assign{};
+	lalr1::TerminalPtr op_plus{}, op_minus{},
 		op_mult{}, op_div{}, op_mod{}, op_pow{},
+		op_elem_mult{}, op_elem_div{},
 		op_norm{}, op_trans{};
 	lalr1::TerminalPtr op_and{}, op_or{}, op_not{}, op_xor{},
 		op_equ{}, op_neq{},
@@ -100,7 +103,8 @@ private:
 	lalr1::TerminalPtr keyword_if{}, keyword_then{}, keyword_else{};
 	lalr1::TerminalPtr keyword_loop{}, keyword_do{},
 		keyword_break{}, keyword_next{};
-	lalr1::TerminalPtr keyword_func{}, keyword_ret{};
+	lalr1::TerminalPtr keyword_parfor{}, keyword_reduce{};
+	lalr1::TerminalPtr keyword_func{}, keyword_ret{}, keyword_map{};
 	lalr1::TerminalPtr keyword_assign{};
 	lalr1::TerminalPtr comma{}, stmt_end{};
 	lalr1::TerminalPtr sym_real{}, sym_int{}, sym_str{}, ident{};
@@ -113,6 +113,16 @@ Lexer::GetMatchingTokens(const std::string& str, std::size_t line)
 			matches.emplace_back(std::make_tuple(
 				static_cast<t_symbol_id>(Token::LOOP), str, line));
 		}
+		else if(str == "parfor")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::PARFOR), str, line));
+		}
+		else if(str == "reduce")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::REDUCE), str, line));
+		}
 		else if(str == "break")
 		{
 			matches.emplace_back(std::make_tuple(
@@ -138,6 +148,11 @@ Lexer::GetMatchingTokens(const std::string& str, std::size_t line)
 			matches.emplace_back(std::make_tuple(
 				static_cast<t_symbol_id>(Token::RET), str, line));
 		}
+		else if(str == "map")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::MAP), str, line));
+		}
 		else if(str == "assign")
 		{
 			matches.emplace_back(std::make_tuple(
@@ -226,6 +241,42 @@ Lexer::GetMatchingTokens(const std::string& str, std::size_t line)
 			matches.emplace_back(std::make_tuple(
 				static_cast<t_symbol_id>(Token::RANGE), str, line));
 		}
+		else if(str == "+=")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::ADD_ASSIGN), str, line));
+		}
+		else if(str == "-=")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::SUB_ASSIGN), str, line));
+		}
+		else if(str == "*=")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::MUL_ASSIGN), str, line));
+		}
+		else if(str == "/=")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::DIV_ASSIGN), str, line));
+		}
+		else if(str == ".*")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::EMUL), str, line));
+		}
+		else if(str == "./")
+		{
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(Token::EDIV), str, line));
+		}
+		else if(str == ".")
+		{
+			// dummy match to continue searching for the element-wise operators
+			matches.emplace_back(std::make_tuple(
+				static_cast<t_symbol_id>(str[0]), std::nullopt, line));
+		}
 
 		// tokens represented by themselves
 		else if(str == "+" || str == "-" || str == "*" || str == "/" ||
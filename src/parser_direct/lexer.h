@@ -50,6 +50,12 @@ enum class Token : lalr1::t_symbol_id
 
 	ASSIGN      = 4000,
 	RANGE       = 4001,
+	ADD_ASSIGN  = 4002,
+	SUB_ASSIGN  = 4003,
+	MUL_ASSIGN  = 4004,
+	DIV_ASSIGN  = 4005,
+	EMUL        = 4006,
+	EDIV        = 4007,
 
 	// conditionals
 	IF          = 5000,
@@ -61,10 +67,13 @@ enum class Token : lalr1::t_symbol_id
 	DO          = 6001,
 	BREAK       = 6002,
 	NEXT        = 6003,
+	PARFOR      = 6004,
+	REDUCE      = 6005,
 
 	// functions
 	FUNC        = 7000,
 	RET         = 7001,
+	MAP         = 7002,
 
 	END         = lalr1::END_IDENT,
 };
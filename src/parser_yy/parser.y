@@ -63,10 +63,13 @@
 %token<t_real> REAL
 %token<t_int> INT
 %token<t_str> STRING
-%token FUNC RET ASSIGN
+%token FUNC RET MAP ASSIGN
+%token ADD_ASSIGN SUB_ASSIGN MUL_ASSIGN DIV_ASSIGN
+%token EMUL EDIV
 %token SCALARDECL VECTORDECL MATRIXDECL STRINGDECL INTDECL
 %token IF THEN ELSE
 %token LOOP DO BREAK NEXT
+%token PARFOR REDUCE
 %token EQU NEQ GT LT GEQ LEQ
 %token AND XOR OR NOT
 %token RANGE
@@ -92,14 +95,14 @@
 // see: https://en.wikipedia.org/wiki/Order_of_operations
 %nonassoc RET
 %left ','
-%right '='
+%right '=' ADD_ASSIGN SUB_ASSIGN MUL_ASSIGN DIV_ASSIGN
 %left XOR
 %left OR
 %left AND
 %left GT LT GEQ LEQ
 %left EQU NEQ
 %left '+' '-'
-%left '*' '/' '%'
+%left '*' '/' '%' EMUL EDIV
 %right NOT
 %right UNARY_OP
 %right '^' '\''
@@ -128,7 +131,11 @@ program
  * a list of statements
  */
 statements[res]
-	: statement[stmt] statements[lst]       { $lst->AddStatement($stmt); $res = $lst; }
+	: statement[stmt] {
+			if($stmt)
+				$stmt->SetLine(context.GetCurLine());
+		}
+		statements[lst]                     { $lst->AddStatement($stmt); $res = $lst; }
 	| %empty                                { $res = std::make_shared<ASTStmts>(); }
 	;
 
@@ -230,6 +237,18 @@ statement[res]
 	| LOOP expression[cond] DO statement[stmt] {
 		$res = std::make_shared<ASTLoop>($cond, $stmt); }
 
+	// parallel loop, the iterations may only assign the variables declared
+	// in the loop body, the loop variable, the accumulators and disjoint
+	// elements of shared arrays, e.g. indexed by the loop variable
+	| PARFOR IDENT[ident] '=' expression[begin] RANGE expression[end] DO statement[stmt] {
+		$res = std::make_shared<ASTParLoop>($ident, $begin, $end, $stmt); }
+
+	// parallel loop with accumulators
+	| PARFOR IDENT[ident] '=' expression[begin] RANGE expression[end]
+		REDUCE identlist[accs] DO statement[stmt] {
+		$res = std::make_shared<ASTParLoop>($ident, $begin, $end, $stmt,
+			$accs->GetArgIdents()); }
+
 	// break multiple loops
 	| BREAK INT[num] ';' {
 		$res = std::make_shared<ASTLoopBreak>($num);
@@ -482,6 +501,8 @@ expression[res]
 	| expression[term1] '*' expression[term2]    { $res = std::make_shared<ASTMult>($term1, $term2, 0); }
 	| expression[term1] '/' expression[term2]    { $res = std::make_shared<ASTMult>($term1, $term2, 1); }
 	| expression[term1] '%' expression[term2]    { $res = std::make_shared<ASTMod>($term1, $term2); }
+	| expression[term1] EMUL expression[term2]   { $res = std::make_shared<ASTElemMult>($term1, $term2, 0); }
+	| expression[term1] EDIV expression[term2]   { $res = std::make_shared<ASTElemMult>($term1, $term2, 1); }
 	| expression[term1] '^' expression[term2]    { $res = std::make_shared<ASTPow>($term1, $term2); }
 
 	// binary boolean expressions
@@ -656,6 +677,17 @@ expression[res]
 		$res = std::make_shared<ASTCall>($ident, $args);
 	}
 
+	// apply a function to each array element
+	| MAP '(' IDENT[ident] ',' expression[term] ')' {
+		const Symbol* sym = context.GetSymbols().FindSymbol($ident);
+		if(sym && sym->ty == SymbolType::FUNC)
+			++sym->refcnt;
+		else
+			error("Cannot find function \"" + $ident + "\".");
+
+		$res = std::make_shared<ASTMap>($ident, $term);
+	}
+
 	// (multiple) assignments
 	| IDENT[ident] '=' expression[term] %prec '=' {
 		$res = std::make_shared<ASTAssign>($ident, $term);
@@ -663,6 +695,20 @@ expression[res]
 	| ASSIGN identlist[idents] '=' expression[term] %prec '=' {
 		$res = std::make_shared<ASTAssign>($idents->GetArgIdents(), $term);
 	}
+
+	// in-place assignments
+	| IDENT[ident] ADD_ASSIGN expression[term] %prec '=' {
+		$res = std::make_shared<ASTCompoundAssign>($ident, $term, ASTCompoundAssign::ADD);
+	}
+	| IDENT[ident] SUB_ASSIGN expression[term] %prec '=' {
+		$res = std::make_shared<ASTCompoundAssign>($ident, $term, ASTCompoundAssign::SUB);
+	}
+	| IDENT[ident] MUL_ASSIGN expression[term] %prec '=' {
+		$res = std::make_shared<ASTCompoundAssign>($ident, $term, ASTCompoundAssign::MUL);
+	}
+	| IDENT[ident] DIV_ASSIGN expression[term] %prec '=' {
+		$res = std::make_shared<ASTCompoundAssign>($ident, $term, ASTCompoundAssign::DIV);
+	}
 	;
 
 
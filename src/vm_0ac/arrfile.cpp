@@ -0,0 +1,404 @@
+/**
+ * zero-address code vm, vector and matrix files
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * Arrays are stored as little-endian doubles in row-major order following
+ * a header with their rank and dimensions. Files with the extension ".npy"
+ * use the numpy format instead, see:
+ *	https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+ *
+ * The files are memory-mapped and copied directly into the variable.
+ */
+
+#include "vm.h"
+#include "mapfile.h"
+
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+
+// ----------------------------------------------------------------------------
+// file formats
+// ----------------------------------------------------------------------------
+/**
+ * header of the raw array files
+ */
+struct ArrHeader
+{
+	char magic[8]{ 'M', 'C', 'A', 'L', 'C', 'A', 'R', 'R' };
+	std::uint64_t rank{};
+	std::uint64_t dims[2]{ 1, 1 };
+};
+
+
+/**
+ * description of the array data in a file
+ */
+struct ArrInfo
+{
+	std::uint64_t rank{};
+	std::uint64_t dims[2]{ 1, 1 };
+	std::size_t offs{};              // start of the data in the file
+	std::size_t elem_size{};         // 8: double, 4: float
+	bool fortran_order{false};       // column-major data
+};
+
+
+static const char g_npy_magic[] = "\x93NUMPY";
+static constexpr const std::size_t g_npy_magic_len = 6;
+static constexpr const std::size_t g_npy_align = 64;
+
+
+static bool is_npy_file(const std::string& filename)
+{
+	return filename.ends_with(".npy");
+}
+
+
+/**
+ * parse the header of a raw array file
+ */
+static std::optional<ArrInfo> parse_arr_header(const VM::t_byte* data, std::size_t size)
+{
+	const ArrHeader hdr_ref{};
+	ArrHeader hdr{};
+	if(size < sizeof(hdr))
+		return std::nullopt;
+
+	std::memcpy(&hdr, data, sizeof(hdr));
+	if(std::memcmp(hdr.magic, hdr_ref.magic, sizeof(hdr.magic)) != 0)
+		return std::nullopt;
+	if(hdr.rank < 1 || hdr.rank > 2)
+		return std::nullopt;
+
+	ArrInfo info{};
+	info.rank = hdr.rank;
+	info.dims[0] = hdr.dims[0];
+	info.dims[1] = hdr.rank == 2 ? hdr.dims[1] : 1;
+	info.offs = sizeof(hdr);
+	info.elem_size = sizeof(double);
+	return info;
+}
+
+
+/**
+ * get the value belonging to a key in the python dictionary of an npy header
+ */
+static std::optional<std::string_view> get_npy_value(std::string_view dict, std::string_view key)
+{
+	std::size_t pos = dict.find(key);
+	if(pos == std::string_view::npos)
+		return std::nullopt;
+
+	pos = dict.find(':', pos + key.length());
+	if(pos == std::string_view::npos)
+		return std::nullopt;
+
+	dict.remove_prefix(pos + 1);
+	while(dict.size() && dict.front() == ' ')
+		dict.remove_prefix(1);
+	return dict;
+}
+
+
+/**
+ * parse the header of an npy file
+ */
+static std::optional<ArrInfo> parse_npy_header(const VM::t_byte* data, std::size_t size)
+{
+	if(size < g_npy_magic_len + 4 || std::memcmp(data, g_npy_magic, g_npy_magic_len) != 0)
+		return std::nullopt;
+
+	ArrInfo info{};
+
+	// header length
+	std::size_t hdr_len = 0;
+	const VM::t_byte major = data[g_npy_magic_len];
+	if(major == 1)
+	{
+		std::uint16_t len{};
+		std::memcpy(&len, data + g_npy_magic_len + 2, sizeof(len));
+		hdr_len = len;
+		info.offs = g_npy_magic_len + 2 + sizeof(len);
+	}
+	else if((major == 2 || major == 3) && size >= g_npy_magic_len + 6)
+	{
+		std::uint32_t len{};
+		std::memcpy(&len, data + g_npy_magic_len + 2, sizeof(len));
+		hdr_len = len;
+		info.offs = g_npy_magic_len + 2 + sizeof(len);
+	}
+	else
+	{
+		return std::nullopt;
+	}
+
+	if(size < info.offs + hdr_len)
+		return std::nullopt;
+	std::string_view dict{reinterpret_cast<const char*>(data + info.offs), hdr_len};
+	info.offs += hdr_len;
+
+	// element type, only little-endian floating point numbers are supported
+	auto descr = get_npy_value(dict, "'descr'");
+	if(!descr)
+		return std::nullopt;
+	if(descr->starts_with("'<f8'"))
+		info.elem_size = sizeof(double);
+	else if(descr->starts_with("'<f4'"))
+		info.elem_size = sizeof(float);
+	else
+		return std::nullopt;
+
+	// data order
+	auto order = get_npy_value(dict, "'fortran_order'");
+	if(!order)
+		return std::nullopt;
+	info.fortran_order = order->starts_with("True");
+
+	// shape tuple
+	auto shape = get_npy_value(dict, "'shape'");
+	if(!shape || !shape->starts_with("("))
+		return std::nullopt;
+	std::size_t shape_end = shape->find(')');
+	if(shape_end == std::string_view::npos)
+		return std::nullopt;
+	std::string_view dims = shape->substr(1, shape_end - 1);
+
+	while(dims.size())
+	{
+		while(dims.size() && (dims.front() == ' ' || dims.front() == ','))
+			dims.remove_prefix(1);
+		if(dims.empty())
+			break;
+		if(info.rank >= 2)
+			return std::nullopt;
+
+		std::uint64_t dim{};
+		auto [ptr, err] = std::from_chars(dims.data(), dims.data() + dims.size(), dim);
+		if(err != std::errc{})
+			return std::nullopt;
+
+		info.dims[info.rank++] = dim;
+		dims.remove_prefix(ptr - dims.data());
+	}
+
+	// a scalar is treated as a vector with one element
+	if(info.rank == 0)
+		info.rank = 1;
+	return info;
+}
+
+
+/**
+ * create the header of an npy file
+ */
+static std::string make_npy_header(std::uint64_t rank, std::uint64_t rows, std::uint64_t cols)
+{
+	std::ostringstream ostr_dict;
+	ostr_dict << "{'descr': '<f8', 'fortran_order': False, 'shape': (" << rows;
+	if(rank == 2)
+		ostr_dict << ", " << cols << "), }";
+	else
+		ostr_dict << ",), }";
+	std::string dict = ostr_dict.str();
+
+	// pad the header, so that the data is aligned
+	std::size_t len = g_npy_magic_len + 4 + dict.length() + 1;
+	dict.append((g_npy_align - len % g_npy_align) % g_npy_align, ' ');
+	dict += '\n';
+
+	std::string hdr{g_npy_magic, g_npy_magic_len};
+	hdr += '\x01';
+	hdr += '\x00';
+	std::uint16_t dict_len = static_cast<std::uint16_t>(dict.length());
+	hdr.append(reinterpret_cast<const char*>(&dict_len), sizeof(dict_len));
+	hdr += dict;
+	return hdr;
+}
+
+
+/**
+ * read an element of a possibly unaligned array
+ */
+template<class t_val>
+static t_val read_elem(const VM::t_byte* data, std::size_t idx)
+{
+	t_val val{};
+	std::memcpy(&val, data + idx*sizeof(t_val), sizeof(t_val));
+	return val;
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// loading and saving
+// ----------------------------------------------------------------------------
+/**
+ * load a file into the vector or matrix variable at the given address,
+ * the dimensions of the file have to match the ones of the variable
+ */
+VM::t_int VM::LoadArray(const t_str& filename, t_addr addr)
+{
+	// variable dimensions
+	VMType ty = ReadMemType(addr);
+	addr += m_bytesize;
+	if(ty != VMType::VEC && ty != VMType::MAT)
+		throw std::runtime_error("Arrays can only be loaded into vector or matrix variables.");
+
+	const t_addr rows = ReadMemRaw<t_addr>(addr);
+	addr += m_addrsize;
+	t_addr cols = 1;
+	if(ty == VMType::MAT)
+	{
+		cols = ReadMemRaw<t_addr>(addr);
+		addr += m_addrsize;
+	}
+
+	const std::size_t num_elems = static_cast<std::size_t>(rows * cols);
+	CheckMemoryBounds(addr, num_elems*m_realsize, true);
+	t_real *dst = reinterpret_cast<t_real*>(m_mem.get() + addr);
+
+	auto fail = [this, &filename](const char* msg) -> t_int
+	{
+		if(m_debug)
+			std::cout << "Cannot load \"" << filename << "\": " << msg << std::endl;
+		return -1;
+	};
+
+	MappedFile file(filename);
+	if(!file.IsOk())
+		return fail("File not found.");
+
+	const t_byte *data = file.GetData();
+	const std::size_t size = file.GetSize();
+
+	std::optional<ArrInfo> info = is_npy_file(filename)
+		? parse_npy_header(data, size) : parse_arr_header(data, size);
+	if(!info)
+		return fail("Invalid file header.");
+
+	// the file's dimensions have to be addressable by the vm
+	const std::uint64_t max_dim = static_cast<std::uint64_t>(std::numeric_limits<t_addr>::max());
+	if(info->dims[0] > max_dim || info->dims[1] > max_dim ||
+		(info->dims[1] && info->dims[0] > max_dim / info->dims[1]))
+		return fail("Dimension mismatch.");
+	const t_addr file_rows = static_cast<t_addr>(info->dims[0]);
+	const t_addr file_cols = static_cast<t_addr>(info->dims[1]);
+
+	// a vector can be loaded from any file with the same number of
+	// elements, a matrix needs a matrix with the same dimensions
+	if(ty == VMType::VEC && file_rows*file_cols != rows)
+		return fail("Dimension mismatch.");
+	if(ty == VMType::MAT && (info->rank != 2 || file_rows != rows || file_cols != cols))
+		return fail("Dimension mismatch.");
+	if(size < info->offs + num_elems*info->elem_size)
+		return fail("File is truncated.");
+
+	data += info->offs;
+	const bool transpose = info->fortran_order && ty == VMType::MAT;
+
+	// copy the data directly if it has the vm's layout
+	if(info->elem_size == sizeof(t_real) && !transpose && std::is_same_v<t_real, double>)
+	{
+		std::memcpy(dst, data, num_elems*sizeof(t_real));
+	}
+	else
+	{
+		for(t_addr row=0; row<rows; ++row)
+		{
+			for(t_addr col=0; col<cols; ++col)
+			{
+				std::size_t idx = transpose ? col*rows + row : row*cols + col;
+
+				if(info->elem_size == sizeof(double))
+					dst[row*cols + col] = static_cast<t_real>(read_elem<double>(data, idx));
+				else
+					dst[row*cols + col] = static_cast<t_real>(read_elem<float>(data, idx));
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * save the vector or matrix variable at the given address
+ */
+VM::t_int VM::SaveArray(const t_str& filename, t_addr addr)
+{
+	// variable dimensions
+	VMType ty = ReadMemType(addr);
+	addr += m_bytesize;
+	if(ty != VMType::VEC && ty != VMType::MAT)
+		throw std::runtime_error("Only vector or matrix variables can be saved as arrays.");
+
+	const t_addr rows = ReadMemRaw<t_addr>(addr);
+	addr += m_addrsize;
+	t_addr cols = 1;
+	if(ty == VMType::MAT)
+	{
+		cols = ReadMemRaw<t_addr>(addr);
+		addr += m_addrsize;
+	}
+
+	const std::size_t num_elems = static_cast<std::size_t>(rows * cols);
+	CheckMemoryBounds(addr, num_elems*m_realsize);
+	const t_real *src = reinterpret_cast<const t_real*>(m_mem.get() + addr);
+
+	std::ofstream ofstr(filename, std::ios_base::binary);
+	if(!ofstr)
+	{
+		if(m_debug)
+			std::cout << "Cannot open \"" << filename << "\" for writing." << std::endl;
+		return -1;
+	}
+
+	// header
+	const std::uint64_t rank = (ty == VMType::MAT ? 2 : 1);
+	if(is_npy_file(filename))
+	{
+		const std::string hdr = make_npy_header(rank, rows, cols);
+		ofstr.write(hdr.data(), hdr.size());
+	}
+	else
+	{
+		ArrHeader hdr{};
+		hdr.rank = rank;
+		hdr.dims[0] = rows;
+		hdr.dims[1] = cols;
+		ofstr.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+	}
+
+	// data
+	if constexpr(std::is_same_v<t_real, double>)
+	{
+		ofstr.write(reinterpret_cast<const char*>(src), num_elems*sizeof(t_real));
+	}
+	else
+	{
+		for(std::size_t idx=0; idx<num_elems; ++idx)
+		{
+			double val = static_cast<double>(src[idx]);
+			ofstr.write(reinterpret_cast<const char*>(&val), sizeof(val));
+		}
+	}
+
+	ofstr.flush();
+	if(!ofstr)
+	{
+		if(m_debug)
+			std::cout << "Cannot write \"" << filename << "\"." << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
+// ----------------------------------------------------------------------------
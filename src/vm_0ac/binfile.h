@@ -0,0 +1,189 @@
+/**
+ * sectioned binary container format for compiled 0ac programs
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * File layout:
+ *	[ header ][ section table ][ padding ][ code ][ constants ][ symbols ][ lines ]
+ *
+ * The code section starts at a page-aligned file offset and the
+ * constants follow it directly, so that file offsets and vm load
+ * addresses are congruent modulo the page size and both sections
+ * can be mapped into vm memory in one go.
+ *
+ * Symbol section entries: [addr][number of args][name length][name chars]
+ * Line section entries:   [addr][line]
+ * (all numbers of type t_vm_addr)
+ *
+ * Snapshots of a running vm use the same layout, but instead of the code
+ * and constants they have a state section with the registers and settings
+ * and a page-aligned memory section holding the entire vm memory.
+ */
+
+#ifndef __0ACVM_BINFILE_H__
+#define __0ACVM_BINFILE_H__
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "types.h"
+
+
+// file identifier and version
+constexpr const char g_bin_magic[4] = { '0', 'A', 'C', 'B' };
+constexpr const std::uint16_t g_bin_version = 1;
+
+// file alignment of the loadable sections
+constexpr const std::uint64_t g_bin_align = 0x1000;
+
+
+/**
+ * encoding of the real type
+ */
+enum class BinRealType : std::uint8_t
+{
+	UNKNOWN     = 0x00,
+	FLOAT32     = 0x01,   // ieee 754 binary32
+	FLOAT64     = 0x02,   // ieee 754 binary64
+	FLOAT_EXT   = 0x03,   // extended precision
+};
+
+
+/**
+ * section types
+ */
+enum class BinSectionType : std::uint32_t
+{
+	CODE        = 0x01,   // executable code
+	CONSTS      = 0x02,   // constants table
+	SYMBOLS     = 0x03,   // function names and addresses
+	LINES       = 0x04,   // code addresses and source lines
+	PURE        = 0x05,   // functions without side effects
+	STATE       = 0x06,   // registers and settings of a vm snapshot
+	MEMORY      = 0x07,   // memory image of a vm snapshot
+};
+
+
+/**
+ * section flags
+ */
+enum BinSectionFlags : std::uint32_t
+{
+	BIN_SECT_LOAD = (1 << 0), // section is loaded into vm memory
+	BIN_SECT_EXEC = (1 << 1), // section contains executable code
+};
+
+
+/**
+ * file header
+ */
+struct BinHeader
+{
+	char magic[4]{};
+	std::uint16_t version{};
+	std::uint8_t addr_size{};       // size of t_vm_addr
+	std::uint8_t int_size{};        // size of t_vm_int
+	std::uint8_t real_size{};       // size of t_vm_real
+	BinRealType real_type{};        // encoding of t_vm_real
+	std::uint16_t num_sections{};   // number of entries in the section table
+	std::uint32_t entry{};          // address of the start-up code
+	std::uint32_t reserved[2]{};
+};
+
+
+/**
+ * entry in the section table
+ */
+struct BinSection
+{
+	BinSectionType type{};
+	std::uint32_t flags{};
+	std::uint64_t offset{};         // offset in the file
+	std::uint64_t size{};           // size in bytes
+	std::uint64_t addr{};           // load address in vm memory
+};
+
+
+/**
+ * vm state in a snapshot
+ */
+struct BinState
+{
+	std::uint64_t mem_size{};       // size of the memory section
+	std::int64_t sp{}, bp{};        // registers, the ip is the header's entry
+	std::int64_t entry{};           // start address of the program
+	std::int64_t code_range[2]{};
+	std::int64_t prog_range[2]{};
+	std::int64_t stack_limit{};
+	std::int64_t prec{};
+	t_vm_real eps{};
+	std::int64_t timer_ticks{};     // timer interval in ms, negative if stopped
+	std::int64_t isrs[16]{};        // interrupt service routines, negative if unset
+};
+
+
+static_assert(sizeof(BinHeader) == 24, "Unexpected binary header size.");
+static_assert(sizeof(BinSection) == 32, "Unexpected binary section size.");
+
+
+/**
+ * get the encoding of a real type
+ */
+template<class t_real>
+constexpr BinRealType get_bin_real_type()
+{
+	if constexpr(std::is_same_v<std::decay_t<t_real>, float>)
+		return BinRealType::FLOAT32;
+	else if constexpr(std::is_same_v<std::decay_t<t_real>, double>)
+		return BinRealType::FLOAT64;
+	else if constexpr(std::is_same_v<std::decay_t<t_real>, long double>)
+		return BinRealType::FLOAT_EXT;
+	else
+		return BinRealType::UNKNOWN;
+}
+
+
+/**
+ * create a header describing the current vm data types
+ */
+inline BinHeader make_bin_header(std::uint16_t num_sections, std::uint32_t entry = 0)
+{
+	BinHeader hdr{};
+	std::memcpy(hdr.magic, g_bin_magic, sizeof(g_bin_magic));
+	hdr.version = g_bin_version;
+	hdr.addr_size = sizeof(t_vm_addr);
+	hdr.int_size = sizeof(t_vm_int);
+	hdr.real_size = sizeof(t_vm_real);
+	hdr.real_type = get_bin_real_type<t_vm_real>();
+	hdr.num_sections = num_sections;
+	hdr.entry = entry;
+	return hdr;
+}
+
+
+/**
+ * does the header match the current vm data types?
+ */
+inline bool is_bin_header_compatible(const BinHeader& hdr)
+{
+	return hdr.version == g_bin_version &&
+		hdr.addr_size == sizeof(t_vm_addr) &&
+		hdr.int_size == sizeof(t_vm_int) &&
+		hdr.real_size == sizeof(t_vm_real) &&
+		hdr.real_type == get_bin_real_type<t_vm_real>();
+}
+
+
+/**
+ * does the memory start with the file identifier?
+ */
+inline bool has_bin_magic(const void* mem, std::size_t size)
+{
+	return size >= sizeof(BinHeader) &&
+		std::memcmp(mem, g_bin_magic, sizeof(g_bin_magic)) == 0;
+}
+
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * number and string conversions without streams
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#ifndef __0ACVM_CONV_H__
+#define __0ACVM_CONV_H__
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <array>
+#include <limits>
+#include <cctype>
+#include <stdexcept>
+
+
+/**
+ * append a real number to a string in the same format as an ostream
+ * with the given precision, i.e. in printf's "%g" format
+ */
+template<class t_real, class t_str = std::string>
+void append_real(t_str& str, t_real val, int prec)
+{
+	if(prec < 0)
+		prec = 6;
+
+	// "%g" needs at most the significant digits, sign, point and exponent
+	const std::size_t len = str.size();
+	str.resize(len + static_cast<std::size_t>(prec) + 32);
+
+	auto [end, err] = std::to_chars(str.data() + len, str.data() + str.size(),
+		val, std::chars_format::general, prec);
+	if(err != std::errc{})
+		throw std::runtime_error("Cannot convert real number to string.");
+
+	str.resize(static_cast<std::size_t>(end - str.data()));
+}
+
+
+/**
+ * append an integer to a string
+ */
+template<class t_int, class t_str = std::string>
+void append_int(t_str& str, t_int val)
+{
+	std::array<char, std::numeric_limits<t_int>::digits10 + 3> buf;
+
+	auto [end, err] = std::to_chars(buf.data(), buf.data() + buf.size(), val);
+	if(err != std::errc{})
+		throw std::runtime_error("Cannot convert integer to string.");
+
+	str.append(buf.data(), end);
+}
+
+
+/**
+ * parse a number like an istream would, i.e. skipping leading white space,
+ * unparsable strings yield zero
+ */
+template<class t_val>
+t_val parse_number(std::string_view str)
+{
+	std::size_t pos = 0;
+	while(pos < str.size() && std::isspace(static_cast<unsigned char>(str[pos])))
+		++pos;
+	if(pos + 1 < str.size() && str[pos] == '+' && str[pos + 1] != '-')
+		++pos;
+
+	t_val val{};
+	if(std::from_chars(str.data() + pos, str.data() + str.size(), val).ec != std::errc{})
+		val = t_val{};
+
+	return val;
+}
+
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * streaming reader for numeric csv files
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "csv.h"
+
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+
+
+static bool is_csv_separator(char c)
+{
+	return c == ',' || c == ';' || c == '\t' || c == ' ' || c == '\r';
+}
+
+
+
+// ----------------------------------------------------------------------------
+// reader
+// ----------------------------------------------------------------------------
+CsvReader::CsvReader(const std::string& filename) : m_file{filename}
+{
+}
+
+
+/**
+ * parse the fields of a line, returns false if it is not a data line
+ */
+bool CsvReader::ParseLine(std::string_view line, t_real* row, std::size_t num_cols) const
+{
+	std::size_t col = 0;
+	const char *pos = line.data();
+	const char *end = line.data() + line.size();
+
+	while(pos < end && col < num_cols)
+	{
+		while(pos < end && is_csv_separator(*pos))
+			++pos;
+		if(pos >= end)
+			break;
+
+		if(col == 0 && *pos == '#')
+			return false;
+
+		// from_chars does not accept a leading plus sign
+		if(*pos == '+' && pos + 1 < end)
+			++pos;
+
+		t_real val{};
+		auto [num_end, err] = std::from_chars(pos, end, val);
+		if(err != std::errc{})
+		{
+			// header or comment line
+			if(col == 0)
+				return false;
+
+			// skip an invalid field
+			val = t_real{};
+			num_end = std::find_if(pos, end, is_csv_separator);
+		}
+
+		row[col++] = val;
+		pos = num_end;
+
+		// skip the rest of the field
+		while(pos < end && !is_csv_separator(*pos))
+			++pos;
+	}
+
+	// empty line
+	if(col == 0)
+		return false;
+
+	std::fill(row + col, row + num_cols, t_real{});
+	return true;
+}
+
+
+/**
+ * read the next rows into a row-major array and return their number
+ */
+std::size_t CsvReader::NextRows(t_real* rows, std::size_t num_rows, std::size_t num_cols)
+{
+	const char *data = reinterpret_cast<const char*>(m_file.GetData());
+	const std::size_t size = m_file.GetSize();
+
+	std::size_t row = 0;
+	while(row < num_rows && m_pos < size)
+	{
+		const char *line_end = static_cast<const char*>(
+			std::memchr(data + m_pos, '\n', size - m_pos));
+		std::size_t line_len = line_end ? line_end - (data + m_pos) : size - m_pos;
+
+		std::string_view line{data + m_pos, line_len};
+		m_pos += line_len + 1;
+
+		if(ParseLine(line, rows + row*num_cols, num_cols))
+			++row;
+	}
+
+	std::fill(rows + row*num_cols, rows + num_rows*num_cols, t_real{});
+	return row;
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// external functions
+// ----------------------------------------------------------------------------
+/**
+ * open a csv file and return its handle, or -1 on failure
+ */
+VM::t_int VM::CsvOpen(const t_str& filename)
+{
+	if(m_par_worker)
+		throw std::runtime_error("Cannot open a csv file in a parallel loop.");
+
+	auto reader = std::make_shared<CsvReader>(filename);
+	if(!reader->IsOk())
+	{
+		if(m_debug)
+			std::cout << "Cannot open csv file \"" << filename << "\"." << std::endl;
+		return -1;
+	}
+
+	t_int handle = m_csv_next_handle++;
+	m_csv_files.emplace(handle, reader);
+	return handle;
+}
+
+
+/**
+ * read the next rows of a csv file into the vector or matrix variable
+ * at the given address, returns the number of rows, or -1 on failure
+ */
+VM::t_int VM::CsvNextRows(t_int handle, t_addr addr)
+{
+	if(m_par_worker)
+		throw std::runtime_error("Cannot read a csv file in a parallel loop.");
+
+	// a vector is filled with one row
+	VMType ty = ReadMemType(addr);
+	addr += m_bytesize;
+	if(ty != VMType::VEC && ty != VMType::MAT)
+		throw std::runtime_error("Csv rows can only be read into vector or matrix variables.");
+
+	t_addr rows = 1;
+	t_addr cols = ReadMemRaw<t_addr>(addr);
+	addr += m_addrsize;
+	if(ty == VMType::MAT)
+	{
+		rows = cols;
+		cols = ReadMemRaw<t_addr>(addr);
+		addr += m_addrsize;
+	}
+
+	auto iter = m_csv_files.find(handle);
+	if(iter == m_csv_files.end())
+		return -1;
+
+	CheckMemoryBounds(addr, rows*cols*m_realsize, true);
+	t_real *dst = reinterpret_cast<t_real*>(m_mem.get() + addr);
+
+	return static_cast<t_int>(iter->second->NextRows(dst,
+		static_cast<std::size_t>(rows), static_cast<std::size_t>(cols)));
+}
+
+
+/**
+ * close a csv file, returns -1 for an invalid handle
+ */
+VM::t_int VM::CsvClose(t_int handle)
+{
+	if(m_par_worker)
+		throw std::runtime_error("Cannot close a csv file in a parallel loop.");
+
+	return m_csv_files.erase(handle) ? 0 : -1;
+}
+// ----------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+/**
+ * streaming reader for numeric csv files
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * The file is memory-mapped and read in chunks of rows, so that files
+ * larger than the vm's memory can be processed. The fields can be
+ * separated by commas, semicolons, tabs or spaces. Empty lines, comment
+ * lines starting with '#' and lines not starting with a number (e.g.
+ * column headers) are skipped.
+ */
+
+#ifndef __0ACVM_CSV_H__
+#define __0ACVM_CSV_H__
+
+#include "vm.h"
+#include "mapfile.h"
+
+
+class CsvReader
+{
+public:
+	using t_real = VM::t_real;
+
+	CsvReader(const std::string& filename);
+
+	CsvReader(const CsvReader&) = delete;
+	const CsvReader& operator=(const CsvReader&) = delete;
+
+	bool IsOk() const { return m_file.IsOk(); }
+
+	// read the next rows into a row-major array and return their number,
+	// missing fields and rows are set to zero
+	std::size_t NextRows(t_real* rows, std::size_t num_rows, std::size_t num_cols);
+
+
+private:
+	bool ParseLine(std::string_view line, t_real* row, std::size_t num_cols) const;
+
+
+private:
+	MappedFile m_file;
+	std::size_t m_pos{0};              // start of the next line
+};
+
+
+#endif
@@ -49,8 +49,12 @@ VM::t_data VM::CallExternal(const t_str& func_name)
 		}
 		else if(dat.index() == m_matidx)
 		{	// determinant for matrices
-			const t_mat arg = std::get<m_matidx>(dat);
-			t_real det = m::det<t_mat, t_vec>(arg);
+			// the cofactor expansion is only used for small matrices
+			const t_mat& arg = std::get<m_matidx>(dat);
+			t_real det = arg.size1() <= 3
+				? m::det<t_mat, t_vec>(arg)
+				: lu_det<t_mat, t_real>(arg, m_eps,
+					GetPool(arg.size1()*arg.size1(), g_par_min_elems));
 
 			retval = t_data{std::in_place_index<m_realidx>, det};
 		}
@@ -60,51 +64,35 @@ VM::t_data VM::CallExternal(const t_str& func_name)
 			retval = dat;
 		}
 	}
-	else if(func_name == "sqrt")
+	else if(func_name == "sqrt" || func_name == "exp" ||
+		func_name == "sin" || func_name == "cos" || func_name == "tan")
 	{
-		OpCast<m_realidx>();
-		t_real arg = std::get<m_realidx>(PopData());
-
-		retval = t_data{std::in_place_index<m_realidx>, std::sqrt(arg)};
+		const t_data arg = PopData();
+		retval = ElementwiseMath(func_name, arg);
 	}
 	else if(func_name == "pow")
 	{
-		OpCast<m_realidx>();
-		t_real arg1 = std::get<m_realidx>(PopData());
-		OpCast<m_realidx>();
-		t_real arg2 = std::get<m_realidx>(PopData());
-
-		retval = t_data{std::in_place_index<m_realidx>, std::pow(arg1, arg2)};
-	}
-	else if(func_name == "sin")
-	{
-		OpCast<m_realidx>();
-		t_real arg = std::get<m_realidx>(PopData());
-
-		retval = t_data{std::in_place_index<m_realidx>, std::sin(arg)};
-	}
-	else if(func_name == "cos")
-	{
-		OpCast<m_realidx>();
-		t_real arg = std::get<m_realidx>(PopData());
-
-		retval = t_data{std::in_place_index<m_realidx>, std::cos(arg)};
-	}
-	else if(func_name == "tan")
-	{
-		OpCast<m_realidx>();
-		t_real arg = std::get<m_realidx>(PopData());
-
-		retval = t_data{std::in_place_index<m_realidx>, std::tan(arg)};
+		const t_data base = PopData();
+		const t_data exp = PopData();
+		retval = ElementwisePow(base, exp);
 	}
 	else if(func_name == "transpose")
 	{
 		t_data dat = PopData();
 		if(dat.index() == m_matidx)
 		{
-			// transpose matrix
-			const t_mat arg = std::get<m_matidx>(dat);
-			t_mat transposed = m::trans(arg);
+			// transpose matrix, large ones by rows on several threads
+			const t_mat& arg = std::get<m_matidx>(dat);
+			const std::size_t rows = arg.size1(), cols = arg.size2();
+			t_mat transposed = m::create<t_mat>(cols, rows);
+
+			par_for(GetPool(rows*cols, g_par_min_elems), rows*cols, g_par_min_elems,
+				0, static_cast<t_int>(rows), [&arg, &transposed, cols](t_int begin, t_int end)
+			{
+				for(t_int i=begin; i<end; ++i)
+					for(std::size_t j=0; j<cols; ++j)
+						transposed(j, i) = arg(i, j);
+			});
 
 			retval = t_data{std::in_place_index<m_matidx>, transposed};
 		}
@@ -114,16 +102,36 @@ VM::t_data VM::CallExternal(const t_str& func_name)
 			retval = dat;
 		}
 	}
+	else if(func_name == "sum" || func_name == "prod" ||
+		func_name == "min" || func_name == "max" || func_name == "mean" ||
+		func_name == "argmin" || func_name == "argmax")
+	{
+		const t_data arr = PopData();
+		retval = Reduce(func_name, arr);
+	}
+	else if(func_name == "sum_axis" || func_name == "prod_axis" ||
+		func_name == "min_axis" || func_name == "max_axis" || func_name == "mean_axis" ||
+		func_name == "argmin_axis" || func_name == "argmax_axis")
+	{
+		const t_data arr = PopData();
+		OpCast<m_intidx>();
+		t_int axis = std::get<m_intidx>(PopData());
+		t_addr addr = PopAddress();
+
+		retval = t_data{std::in_place_index<m_intidx>, ReduceAxis(func_name, arr, axis, addr)};
+	}
 	else if(func_name == "set_eps")
 	{
 		OpCast<m_realidx>();
 		m_eps = std::get<m_realidx>(PopData());
+		ClearMemo();
 	}
 	else if(func_name == "set_prec")
 	{
 		OpCast<m_intidx>();
 		m_prec = std::get<m_intidx>(PopData());
 		std::cout.precision(m_prec);
+		ClearMemo();
 	}
 	else if(func_name == "get_eps")
 	{
@@ -135,16 +143,22 @@ VM::t_data VM::CallExternal(const t_str& func_name)
 	}
 	else if(func_name == "putstr" || func_name == "putflt" || func_name == "putint")
 	{
-		OpCast<m_stridx>();
-		const t_str/*&*/ arg = std::get<m_stridx>(PopData());
-		std::cout << arg << std::endl;
+		const t_data arg = PopData();
+		m_output->Put(ToString(arg), true);
+
+		// keep the order with the debug messages
+		if(m_debug)
+			m_output->Flush();
+	}
+	else if(func_name == "flush")
+	{
+		m_output->Flush();
 	}
 	else if(func_name == "getflt")
 	{
-		OpCast<m_stridx>();
-		const t_str/*&*/ arg = std::get<m_stridx>(PopData());
-		std::cout << arg;
-		std::cout.flush();
+		const t_data arg = PopData();
+		m_output->Put(ToString(arg));
+		m_output->Flush();
 
 		t_real val{};
 		std::cin >> val;
@@ -153,16 +167,104 @@ VM::t_data VM::CallExternal(const t_str& func_name)
 	}
 	else if(func_name == "getint")
 	{
-		OpCast<m_stridx>();
-		const t_str/*&*/ arg = std::get<m_stridx>(PopData());
-		std::cout << arg;
-		std::cout.flush();
+		const t_data arg = PopData();
+		m_output->Put(ToString(arg));
+		m_output->Flush();
 
 		t_int val{};
 		std::cin >> val;
 
 		retval = t_data{std::in_place_index<m_intidx>, val};
 	}
+	else if(func_name == "load_vec" || func_name == "load_mat")
+	{
+		OpCast<m_stridx>();
+		const t_str filename = std::get<m_stridx>(PopData());
+		t_addr addr = PopAddress();
+
+		retval = t_data{std::in_place_index<m_intidx>, LoadArray(filename, addr)};
+	}
+	else if(func_name == "save_vec" || func_name == "save_mat")
+	{
+		OpCast<m_stridx>();
+		const t_str filename = std::get<m_stridx>(PopData());
+		t_addr addr = PopAddress();
+
+		retval = t_data{std::in_place_index<m_intidx>, SaveArray(filename, addr)};
+	}
+	else if(func_name == "csv_open")
+	{
+		OpCast<m_stridx>();
+		const t_str filename = std::get<m_stridx>(PopData());
+
+		retval = t_data{std::in_place_index<m_intidx>, CsvOpen(filename)};
+	}
+	else if(func_name == "csv_next_rows")
+	{
+		OpCast<m_intidx>();
+		t_int handle = std::get<m_intidx>(PopData());
+		t_addr addr = PopAddress();
+
+		retval = t_data{std::in_place_index<m_intidx>, CsvNextRows(handle, addr)};
+	}
+	else if(func_name == "csv_close")
+	{
+		OpCast<m_intidx>();
+		t_int handle = std::get<m_intidx>(PopData());
+
+		retval = t_data{std::in_place_index<m_intidx>, CsvClose(handle)};
+	}
+	else if(func_name == "solve")
+	{
+		const t_data lhs = PopData();
+		const t_data rhs = PopData();
+
+		retval = Solve(lhs, rhs);
+	}
+	else if(func_name == "inv_mult")
+	{
+		// A^(-1) * x emitted by the compiler, the operands are in evaluation order
+		t_data rhs = PopData();
+		const t_data lhs = PopData();
+
+		if(lhs.index() == m_matidx && (rhs.index() == m_vecidx || rhs.index() == m_matidx))
+		{
+			retval = Solve(lhs, rhs);
+		}
+		else
+		{
+			// invert explicitly for a scalar right-hand side
+			if(rhs.index() == m_intidx)
+				rhs = t_data{std::in_place_index<m_realidx>, t_real(std::get<m_intidx>(rhs))};
+
+			const t_data inv = OpArithmetic<'^'>(lhs,
+				t_data{std::in_place_index<m_realidx>, t_real(-1)});
+			retval = OpArithmetic<'*'>(inv, rhs);
+		}
+	}
+	else if(func_name == "factor")
+	{
+		const t_data mat = PopData();
+
+		retval = t_data{std::in_place_index<m_intidx>, Factor(mat)};
+	}
+	else if(func_name == "factor_free")
+	{
+		OpCast<m_intidx>();
+		t_int handle = std::get<m_intidx>(PopData());
+
+		retval = t_data{std::in_place_index<m_intidx>, FactorFree(handle)};
+	}
+	else if(func_name == "qr" || func_name == "chol" || func_name == "eig_sym")
+	{
+		const t_data mat = PopData();
+		std::vector<t_data> rets = MatrixDecomposition(func_name, mat);
+
+		// like a function's ret, the first value ends up on top of the stack
+		for(std::size_t i=rets.size()-1; i>0; --i)
+			PushData(rets[i], VMType::UNKNOWN, false);
+		retval = rets[0];
+	}
 	else if(func_name == "set_isr")
 	{
 		OpCast<m_intidx>();
@@ -194,6 +296,18 @@ VM::t_data VM::CallExternal(const t_str& func_name)
 			StartTimer();
 		}
 	}
+	else if(func_name == "snapshot")
+	{
+		OpCast<m_stridx>();
+		const t_str filename = std::get<m_stridx>(PopData());
+
+		// the resumed program finds 1 as return value on the stack
+		PushData(t_data{std::in_place_index<m_intidx>, t_int(1)});
+		SaveSnapshot(filename);
+		PopData();
+
+		retval = t_data{std::in_place_index<m_intidx>, t_int(0)};
+	}
 	else if(func_name == "set_debug")
 	{
 		OpCast<m_intidx>();
@@ -202,3 +316,91 @@ VM::t_data VM::CallExternal(const t_str& func_name)
 
 	return retval;
 }
+
+
+/**
+ * sqrt, exp, sin, cos or tan of a scalar, or of all elements of a vector or matrix
+ */
+VM::t_data VM::ElementwiseMath(const t_str& func_name, const t_data& arg)
+{
+	VecMathFunc func = VecMathFunc::SQRT;
+	if(func_name == "exp")
+		func = VecMathFunc::EXP;
+	else if(func_name == "sin")
+		func = VecMathFunc::SIN;
+	else if(func_name == "cos")
+		func = VecMathFunc::COS;
+	else if(func_name == "tan")
+		func = VecMathFunc::TAN;
+
+	if(arg.index() == m_vecidx || arg.index() == m_matidx)
+	{
+		// evaluate in-place on a copy of the array
+		t_data result = arg;
+		t_real *elems = nullptr;
+		std::size_t N = 0;
+
+		if(result.index() == m_vecidx)
+		{
+			t_vec& vec = std::get<m_vecidx>(result);
+			elems = vec.data();
+			N = vec.size();
+		}
+		else
+		{
+			t_mat& mat = std::get<m_matidx>(result);
+			elems = mat.data();
+			N = mat.size1() * mat.size2();
+		}
+
+		vec_math(func, elems, elems, N, GetPool(N, g_par_min_elems));
+		return result;
+	}
+
+	t_real val = std::get<m_realidx>(OpCast<m_realidx>(arg));
+	switch(func)
+	{
+		case VecMathFunc::SIN: val = std::sin(val); break;
+		case VecMathFunc::COS: val = std::cos(val); break;
+		case VecMathFunc::TAN: val = std::tan(val); break;
+		case VecMathFunc::EXP: val = std::exp(val); break;
+		case VecMathFunc::SQRT: val = std::sqrt(val); break;
+	}
+
+	return t_data{std::in_place_index<m_realidx>, val};
+}
+
+
+/**
+ * power of a scalar, or element-wise power of a vector or matrix with a scalar exponent
+ */
+VM::t_data VM::ElementwisePow(const t_data& base, const t_data& exp)
+{
+	const t_real exp_val = std::get<m_realidx>(OpCast<m_realidx>(exp));
+
+	if(base.index() == m_vecidx || base.index() == m_matidx)
+	{
+		t_data result = base;
+		t_real *elems = nullptr;
+		std::size_t N = 0;
+
+		if(result.index() == m_vecidx)
+		{
+			t_vec& vec = std::get<m_vecidx>(result);
+			elems = vec.data();
+			N = vec.size();
+		}
+		else
+		{
+			t_mat& mat = std::get<m_matidx>(result);
+			elems = mat.data();
+			N = mat.size1() * mat.size2();
+		}
+
+		vec_pow(elems, exp_val, elems, N, GetPool(N, g_par_min_elems));
+		return result;
+	}
+
+	return t_data{std::in_place_index<m_realidx>, std::pow(
+		std::get<m_realidx>(OpCast<m_realidx>(base)), exp_val)};
+}
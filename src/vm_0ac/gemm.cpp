@@ -0,0 +1,237 @@
+/**
+ * matrix product kernels for the vm
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "gemm.h"
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	#include <immintrin.h>
+	#define __0ACVM_GEMM_AVX2__
+#endif
+
+
+using t_real = ::t_vm_real;
+
+// register tile and cache block sizes
+constexpr const std::size_t g_mr = 4;
+constexpr const std::size_t g_nr = 8;
+constexpr const std::size_t g_mc = 64;
+constexpr const std::size_t g_kc = 256;
+constexpr const std::size_t g_nc = 512;
+
+using t_kernel = void(*)(std::size_t kc, const t_real* A, std::size_t lda,
+	const t_real* Bpack, t_real* C, std::size_t ldc, std::size_t mr, std::size_t nr);
+
+
+/**
+ * C += A*B for a tile of at most mr x nr elements, B is packed nr-wide
+ */
+static void gemm_kernel_scalar(std::size_t kc, const t_real* A, std::size_t lda,
+	const t_real* Bpack, t_real* C, std::size_t ldc, std::size_t mr, std::size_t nr)
+{
+	t_real acc[g_mr][g_nr]{};
+
+	for(std::size_t k=0; k<kc; ++k)
+	{
+		const t_real* b = Bpack + k*g_nr;
+		for(std::size_t i=0; i<mr; ++i)
+		{
+			const t_real a = A[i*lda + k];
+			for(std::size_t j=0; j<g_nr; ++j)
+				acc[i][j] += a * b[j];
+		}
+	}
+
+	for(std::size_t i=0; i<mr; ++i)
+		for(std::size_t j=0; j<nr; ++j)
+			C[i*ldc + j] += acc[i][j];
+}
+
+
+#ifdef __0ACVM_GEMM_AVX2__
+/**
+ * avx2/fma micro-kernel for full 4x8 tiles
+ */
+__attribute__((target("avx2,fma")))
+static void gemm_kernel_avx2(std::size_t kc, const t_real* A, std::size_t lda,
+	const t_real* Bpack, t_real* C, std::size_t ldc, std::size_t mr, std::size_t nr)
+{
+	if constexpr(!std::is_same_v<t_real, double>)
+	{
+		gemm_kernel_scalar(kc, A, lda, Bpack, C, ldc, mr, nr);
+	}
+	else
+	{
+		if(mr != g_mr || nr != g_nr)
+		{
+			gemm_kernel_scalar(kc, A, lda, Bpack, C, ldc, mr, nr);
+			return;
+		}
+
+		__m256d c[g_mr][2];
+		for(std::size_t i=0; i<g_mr; ++i)
+			c[i][0] = c[i][1] = _mm256_setzero_pd();
+
+		for(std::size_t k=0; k<kc; ++k)
+		{
+			const __m256d b0 = _mm256_loadu_pd(Bpack + k*g_nr);
+			const __m256d b1 = _mm256_loadu_pd(Bpack + k*g_nr + 4);
+
+			for(std::size_t i=0; i<g_mr; ++i)
+			{
+				const __m256d a = _mm256_broadcast_sd(A + i*lda + k);
+				c[i][0] = _mm256_fmadd_pd(a, b0, c[i][0]);
+				c[i][1] = _mm256_fmadd_pd(a, b1, c[i][1]);
+			}
+		}
+
+		for(std::size_t i=0; i<g_mr; ++i)
+		{
+			t_real* row = C + i*ldc;
+			_mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), c[i][0]));
+			_mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), c[i][1]));
+		}
+	}
+}
+#endif
+
+
+/**
+ * selects the micro-kernel for the cpu the vm runs on
+ */
+static t_kernel get_kernel()
+{
+	static const t_kernel kernel = []() -> t_kernel
+	{
+#ifdef __0ACVM_GEMM_AVX2__
+		__builtin_cpu_init();
+		if(std::is_same_v<t_real, double> &&
+			__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+			return gemm_kernel_avx2;
+#endif
+		return gemm_kernel_scalar;
+	}();
+
+	return kernel;
+}
+
+
+/**
+ * packs kc rows and nc columns of B into nr-wide slivers, padded with zeros
+ */
+static void pack_b(const t_real* B, std::size_t ldb, std::size_t kc, std::size_t nc, t_real* Bpack)
+{
+	for(std::size_t jr=0; jr<nc; jr+=g_nr)
+	{
+		const std::size_t nr = std::min(g_nr, nc - jr);
+
+		for(std::size_t k=0; k<kc; ++k)
+		{
+			for(std::size_t j=0; j<nr; ++j)
+				Bpack[k*g_nr + j] = B[k*ldb + jr + j];
+			for(std::size_t j=nr; j<g_nr; ++j)
+				Bpack[k*g_nr + j] = t_real(0);
+		}
+
+		Bpack += kc*g_nr;
+	}
+}
+
+
+/**
+ * matrix-matrix product for the rows [row_begin, row_end) of A and C
+ */
+static void gemm_rows(const t_real* A, const t_real* B, t_real* C,
+	std::size_t row_begin, std::size_t row_end, std::size_t J, std::size_t K)
+{
+	const t_kernel kernel = get_kernel();
+	const std::size_t nc_max = (std::min(J, g_nc) + g_nr - 1) / g_nr * g_nr;
+	std::vector<t_real> Bpack(std::min(K, g_kc) * nc_max);
+
+	for(std::size_t jc=0; jc<J; jc+=g_nc)
+	{
+		const std::size_t nc = std::min(g_nc, J - jc);
+
+		for(std::size_t pc=0; pc<K; pc+=g_kc)
+		{
+			const std::size_t kc = std::min(g_kc, K - pc);
+			pack_b(B + pc*J + jc, J, kc, nc, Bpack.data());
+
+			for(std::size_t ic=row_begin; ic<row_end; ic+=g_mc)
+			{
+				const std::size_t mc = std::min(g_mc, row_end - ic);
+
+				for(std::size_t jr=0; jr<nc; jr+=g_nr)
+				{
+					const std::size_t nr = std::min(g_nr, nc - jr);
+					const t_real* b = Bpack.data() + (jr/g_nr)*kc*g_nr;
+
+					for(std::size_t ir=0; ir<mc; ir+=g_mr)
+					{
+						const std::size_t mr = std::min(g_mr, mc - ir);
+						kernel(kc, A + (ic + ir)*K + pc, K, b,
+							C + (ic + ir)*J + jc + jr, J, mr, nr);
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void gemm(const t_real* A, const t_real* B, t_real* C,
+	std::size_t I, std::size_t J, std::size_t K, ThreadPool* pool)
+{
+	std::fill(C, C + I*J, t_real(0));
+	if(!I || !J || !K)
+		return;
+
+	// select the micro-kernel before starting the threads
+	get_kernel();
+
+	// each block of rows packs its own panels of B
+	using t_int = ThreadPool::t_int;
+	const t_int num_blocks = static_cast<t_int>((I + g_mc - 1) / g_mc);
+	par_for(pool, I*J*K, g_par_min_flops, 0, num_blocks,
+		[A, B, C, I, J, K](t_int begin, t_int end)
+	{
+		gemm_rows(A, B, C, static_cast<std::size_t>(begin)*g_mc,
+			std::min(static_cast<std::size_t>(end)*g_mc, I), J, K);
+	});
+}
+
+
+void gemv(const t_real* A, const t_real* x, t_real* y,
+	std::size_t I, std::size_t K, ThreadPool* pool)
+{
+	using t_int = ThreadPool::t_int;
+	par_for(pool, I*K, g_par_min_flops, 0, static_cast<t_int>(I),
+		[A, x, y, K](t_int begin, t_int end)
+	{
+		for(std::size_t i=static_cast<std::size_t>(begin); i<static_cast<std::size_t>(end); ++i)
+		{
+			const t_real* row = A + i*K;
+
+			// independent accumulators, lets the compiler vectorise the loop
+			t_real acc[g_nr]{};
+			std::size_t k = 0;
+			for(; k + g_nr <= K; k += g_nr)
+				for(std::size_t lane=0; lane<g_nr; ++lane)
+					acc[lane] += row[k + lane] * x[k + lane];
+
+			t_real sum{};
+			for(std::size_t lane=0; lane<g_nr; ++lane)
+				sum += acc[lane];
+			for(; k<K; ++k)
+				sum += row[k] * x[k];
+			y[i] = sum;
+		}
+	});
+}
@@ -0,0 +1,37 @@
+/**
+ * matrix product kernels for the vm
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * The matrix-matrix product is blocked for the caches: a panel of the
+ * right-hand matrix is packed into contiguous slivers and a register-tiled
+ * micro-kernel computes 4x8 tiles of the result. An avx2/fma micro-kernel
+ * is selected at run time if the cpu supports it.
+ * Large products are split by rows across the threads of the given pool.
+ */
+
+#ifndef __0ACVM_GEMM_H__
+#define __0ACVM_GEMM_H__
+
+#include <cstddef>
+
+#include "types.h"
+#include "pool.h"
+
+
+/**
+ * matrix-matrix product of row-major matrices: C^i_j = A^i_k B^k_j
+ */
+extern void gemm(const t_vm_real* A, const t_vm_real* B, t_vm_real* C,
+	std::size_t I, std::size_t J, std::size_t K, ThreadPool* pool = nullptr);
+
+
+/**
+ * matrix-vector product: y^i = A^i_k x^k
+ */
+extern void gemv(const t_vm_real* A, const t_vm_real* x, t_vm_real* y,
+	std::size_t I, std::size_t K, ThreadPool* pool = nullptr);
+
+
+#endif
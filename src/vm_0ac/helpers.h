@@ -22,15 +22,28 @@ t_val pow(t_val val1, t_val val2)
 	}
 	else if constexpr(std::is_integral_v<t_val>)
 	{
-		if(val2 == 0)
-			return 1;
-		else if(val2 < 0)
+		// only 1 and -1 have integer inverses
+		if(val2 < 0)
+		{
+			if(val1 == 1)
+				return 1;
+			else if(val1 == -1)
+				return (val2 % 2) ? -1 : 1;
 			return 0;
+		}
 
-		t_val result = val1;
-		for(t_val i=1; i<val2; ++i)
-			result *= val1;
-		return result;
+		// repeated squaring in unsigned arithmetic, overflows wrap around
+		using t_uval = std::make_unsigned_t<t_val>;
+		t_uval result = 1, base = static_cast<t_uval>(val1);
+		while(val2)
+		{
+			if(val2 & 1)
+				result *= base;
+			val2 >>= 1;
+			if(val2)
+				base *= base;
+		}
+		return static_cast<t_val>(result);
 	}
 }
 
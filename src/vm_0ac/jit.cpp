@@ -0,0 +1,1065 @@
+/**
+ * zero-address code vm, compilation of the register-based ir to x86-64 code
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * References:
+ *	- Intel 64 and IA-32 Architectures Software Developer's Manual, Vol. 2
+ *	- System V AMD64 ABI
+ */
+
+#include "vm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+#ifdef __VM_USE_JIT__
+	#include <sys/mman.h>
+#endif
+
+
+
+// ----------------------------------------------------------------------------
+// executable memory
+// ----------------------------------------------------------------------------
+JitCode::JitCode([[maybe_unused]] const std::vector<std::uint8_t>& code)
+{
+#ifdef __VM_USE_JIT__
+	m_size = code.size();
+	void *mem = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(mem == MAP_FAILED)
+		throw std::runtime_error("Cannot allocate memory for native code.");
+
+	std::memcpy(mem, code.data(), m_size);
+	if(::mprotect(mem, m_size, PROT_READ | PROT_EXEC) != 0)
+	{
+		::munmap(mem, m_size);
+		throw std::runtime_error("Cannot make native code executable.");
+	}
+
+	m_mem = mem;
+#else
+	throw std::runtime_error("Native code is not supported.");
+#endif
+}
+
+
+JitCode::~JitCode()
+{
+#ifdef __VM_USE_JIT__
+	if(m_mem)
+		::munmap(m_mem, m_size);
+#endif
+}
+// ----------------------------------------------------------------------------
+
+
+
+#ifdef __VM_USE_JIT__
+// ----------------------------------------------------------------------------
+// x86-64 machine code
+// ----------------------------------------------------------------------------
+namespace {
+
+// general purpose registers
+enum Reg : int
+{
+	RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+	R8 = 8, R9 = 9, R10 = 10, R11 = 11, R12 = 12, R13 = 13, R14 = 14, R15 = 15,
+};
+
+
+// sse registers
+enum XReg : int
+{
+	XMM0 = 0, XMM1 = 1,
+};
+
+
+// condition codes
+enum Cond : std::uint8_t
+{
+	CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5,
+	CC_BE = 0x6, CC_A = 0x7, CC_L = 0xc, CC_GE = 0xd,
+	CC_LE = 0xe, CC_G = 0xf,
+};
+
+
+// the opposite condition only differs in the lowest bit
+constexpr Cond invert_cond(Cond cc)
+{
+	return static_cast<Cond>(cc ^ 1);
+}
+
+
+/**
+ * machine code buffer with labels
+ */
+class JitAsm
+{
+public:
+	using t_label = std::size_t;
+
+
+	t_label NewLabel()
+	{
+		m_labels.push_back(std::nullopt);
+		return m_labels.size() - 1;
+	}
+
+
+	void Bind(t_label label)
+	{
+		m_labels[label] = m_code.size();
+	}
+
+
+	void Byte(std::uint8_t b)
+	{
+		m_code.push_back(b);
+	}
+
+
+	void Imm32(std::int32_t imm)
+	{
+		for(int i=0; i<4; ++i)
+			Byte(static_cast<std::uint8_t>((static_cast<std::uint32_t>(imm) >> (i*8)) & 0xff));
+	}
+
+
+	void Imm64(std::uint64_t imm)
+	{
+		for(int i=0; i<8; ++i)
+			Byte(static_cast<std::uint8_t>((imm >> (i*8)) & 0xff));
+	}
+
+
+	void Align(std::size_t align)
+	{
+		while(m_code.size() % align)
+			Byte(0xcc);  // int3
+	}
+
+
+	// rex prefix for the register field and the r/m base
+	void Rex(bool w, int reg, int base)
+	{
+		std::uint8_t rex = 0x40 | (w ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((base & 8) ? 0x01 : 0);
+		if(rex != 0x40)
+			Byte(rex);
+	}
+
+
+	// modrm byte for [base + disp32]
+	void Mem(int reg, int base, std::int32_t disp)
+	{
+		Byte(0x80 | ((reg & 7) << 3) | (base & 7));
+		if((base & 7) == RSP)
+			Byte(0x24);  // sib byte for rsp or r12 base
+		Imm32(disp);
+	}
+
+
+	// modrm byte for register operands
+	void RegReg(int reg, int rm)
+	{
+		Byte(0xc0 | ((reg & 7) << 3) | (rm & 7));
+	}
+
+
+	// relative 32-bit jump offset to a label
+	void Rel32(t_label label)
+	{
+		m_fixups.emplace_back(m_code.size(), label);
+		Imm32(0);
+	}
+
+
+	void Push(int r) { Rex(false, 0, r); Byte(0x50 + (r & 7)); }
+	void Pop(int r) { Rex(false, 0, r); Byte(0x58 + (r & 7)); }
+	void Ret() { Byte(0xc3); }
+
+	// mov r, imm64
+	void MovImm(int r, std::uint64_t imm) { Rex(true, 0, r); Byte(0xb8 + (r & 7)); Imm64(imm); }
+	// mov dst, src
+	void Mov(int dst, int src) { Rex(true, src, dst); Byte(0x89); RegReg(src, dst); }
+	// mov r, [base + disp]
+	void Load(int r, int base, std::int32_t disp) { Rex(true, r, base); Byte(0x8b); Mem(r, base, disp); }
+	// mov [base + disp], r
+	void Store(int base, std::int32_t disp, int r) { Rex(true, r, base); Byte(0x89); Mem(r, base, disp); }
+	// mov dword [base + disp], r
+	void StoreInt32(int base, std::int32_t disp, int r) { Rex(false, r, base); Byte(0x89); Mem(r, base, disp); }
+	// movsxd r, dword [base + disp]
+	void LoadInt32(int r, int base, std::int32_t disp) { Rex(true, r, base); Byte(0x63); Mem(r, base, disp); }
+	// mov byte [base + disp], imm8
+	void StoreByte(int base, std::int32_t disp, std::uint8_t imm) { Rex(false, 0, base); Byte(0xc6); Mem(0, base, disp); Byte(imm); }
+	// cmp byte [base + disp], imm8
+	void CmpByte(int base, std::int32_t disp, std::uint8_t imm) { Rex(false, 0, base); Byte(0x80); Mem(7, base, disp); Byte(imm); }
+	// inc qword [base + disp]
+	void IncQword(int base, std::int32_t disp) { Rex(true, 0, base); Byte(0xff); Mem(0, base, disp); }
+	// cmp qword [base + disp], 0
+	void CmpQwordZero(int base, std::int32_t disp) { Rex(true, 0, base); Byte(0x83); Mem(7, base, disp); Byte(0); }
+
+	void Add(int dst, int src) { Rex(true, src, dst); Byte(0x01); RegReg(src, dst); }
+	void Sub(int dst, int src) { Rex(true, src, dst); Byte(0x29); RegReg(src, dst); }
+	void Cmp(int dst, int src) { Rex(true, src, dst); Byte(0x39); RegReg(src, dst); }
+	void IMul(int dst, int src) { Rex(true, dst, src); Byte(0x0f); Byte(0xaf); RegReg(dst, src); }
+	void AddImm(int r, std::int32_t imm) { Rex(true, 0, r); Byte(0x81); RegReg(0, r); Imm32(imm); }
+	void SubImm(int r, std::int32_t imm) { Rex(true, 0, r); Byte(0x81); RegReg(5, r); Imm32(imm); }
+	void CmpImm(int r, std::int32_t imm) { Rex(true, 0, r); Byte(0x81); RegReg(7, r); Imm32(imm); }
+
+	void Call(int r) { Rex(false, 0, r); Byte(0xff); RegReg(2, r); }
+	void JmpReg(int r) { Rex(false, 0, r); Byte(0xff); RegReg(4, r); }
+	void Jmp(t_label label) { Byte(0xe9); Rel32(label); }
+	void Jcc(Cond cc, t_label label) { Byte(0x0f); Byte(0x80 | cc); Rel32(label); }
+
+	// lea r, [rip + label]
+	void LeaRip(int r, t_label label) { Rex(true, r, 0); Byte(0x8d); Byte(0x05 | ((r & 7) << 3)); Rel32(label); }
+	// movsxd rax, dword [rcx + rdi*4]
+	void LoadTableEntry() { Byte(0x48); Byte(0x63); Byte(0x04); Byte(0xb9); }
+
+	// movsd x, [base + disp]
+	void MovsdLoad(int x, int base, std::int32_t disp) { Byte(0xf2); Rex(false, x, base); Byte(0x0f); Byte(0x10); Mem(x, base, disp); }
+	// movq x, r
+	void MovqToXmm(int x, int r) { Byte(0x66); Rex(true, x, r); Byte(0x0f); Byte(0x6e); RegReg(x, r); }
+	// movq r, x
+	void MovqFromXmm(int r, int x) { Byte(0x66); Rex(true, x, r); Byte(0x0f); Byte(0x7e); RegReg(x, r); }
+	// addsd (0x58), mulsd (0x59), subsd (0x5c), divsd (0x5e)
+	void SseArith(std::uint8_t opc, int xdst, int xsrc) { Byte(0xf2); Rex(false, xdst, xsrc); Byte(0x0f); Byte(opc); RegReg(xdst, xsrc); }
+	void Ucomisd(int x1, int x2) { Byte(0x66); Rex(false, x1, x2); Byte(0x0f); Byte(0x2e); RegReg(x1, x2); }
+	void Cvttsd2si(int r, int x) { Byte(0xf2); Rex(true, r, x); Byte(0x0f); Byte(0x2c); RegReg(r, x); }
+	void Cvtsi2sd(int x, int r) { Byte(0xf2); Rex(true, x, r); Byte(0x0f); Byte(0x2a); RegReg(x, r); }
+
+
+	// offset of a label relative to a table label
+	void TableEntry(t_label table, t_label label)
+	{
+		m_table_fixups.emplace_back(m_code.size(), table, label);
+		Imm32(0);
+	}
+
+
+	// resolve the label references
+	std::vector<std::uint8_t> Finish()
+	{
+		auto patch = [this](std::size_t pos, std::int64_t val)
+		{
+			std::int32_t val32 = static_cast<std::int32_t>(val);
+			std::memcpy(m_code.data() + pos, &val32, sizeof(val32));
+		};
+
+		for(const auto& [pos, label] : m_fixups)
+			patch(pos, static_cast<std::int64_t>(*m_labels[label]) - static_cast<std::int64_t>(pos + 4));
+
+		for(const auto& [pos, table, label] : m_table_fixups)
+			patch(pos, static_cast<std::int64_t>(*m_labels[label]) - static_cast<std::int64_t>(*m_labels[table]));
+
+		return m_code;
+	}
+
+
+private:
+	std::vector<std::uint8_t> m_code{};
+	std::vector<std::optional<std::size_t>> m_labels{};
+	std::vector<std::tuple<std::size_t, t_label>> m_fixups{};
+	std::vector<std::tuple<std::size_t, t_label, t_label>> m_table_fixups{};
+};
+
+
+/**
+ * ir operand that can be accessed by native code
+ */
+struct JitOperand
+{
+	bool is_const{false};
+	bool is_stack{false};
+
+	// constant
+	VMType ty{VMType::UNKNOWN};
+	std::uint64_t bits{};
+
+	// typed value in memory at [base + disp]
+	int base{RBX};
+	std::int32_t disp{};
+
+
+	bool CanBe(VMType _ty) const
+	{
+		return !is_const || ty == _ty;
+	}
+};
+
+}   // namespace
+// ----------------------------------------------------------------------------
+#endif
+
+
+
+// ----------------------------------------------------------------------------
+// functions and tiers
+// ----------------------------------------------------------------------------
+/**
+ * split the ir code into functions
+ */
+void VM::InitFunctions()
+{
+	m_jit_funcs.clear();
+	m_jit_func_index.clear();
+
+	const std::size_t num_instrs = m_ir.size();
+	if(!num_instrs)
+		return;
+
+	// function entry points
+	std::vector<std::size_t> entries{ 0 };
+	if(auto idx = GetIRIndex(m_ip); idx)
+		entries.push_back(*idx);
+	for(const IRInstr& instr : m_ir)
+	{
+		if(instr.op == IROp::CALL)
+			entries.push_back(instr.target);
+	}
+	for(const auto& [addr, name] : m_funcnames)
+	{
+		if(auto idx = GetIRIndex(addr); idx && *idx < num_instrs)
+			entries.push_back(*idx);
+	}
+
+	std::sort(entries.begin(), entries.end());
+	entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+	m_jit_func_index.resize(num_instrs);
+	for(std::size_t i=0; i<entries.size(); ++i)
+	{
+		JitFunction func{ .begin = entries[i],
+			.end = (i + 1 < entries.size() ? entries[i + 1] : num_instrs) };
+
+		std::fill(m_jit_func_index.begin() + func.begin,
+			m_jit_func_index.begin() + func.end, m_jit_funcs.size());
+		m_jit_funcs.emplace_back(std::move(func));
+	}
+}
+
+
+/**
+ * count the invocation of the function at the given ir index
+ */
+void VM::CountCall(std::size_t target)
+{
+	if(target < m_jit_func_index.size())
+		++m_jit_funcs[m_jit_func_index[target]].num_calls;
+}
+
+
+/**
+ * count a backward branch of the function containing the given ir index
+ */
+void VM::CountLoop(std::size_t pc, std::size_t target)
+{
+	if(target <= pc && pc < m_jit_func_index.size())
+		++m_jit_funcs[m_jit_func_index[pc]].num_loops;
+}
+
+
+/**
+ * get the compiled function containing the given ir index,
+ * functions are compiled once they get hot
+ */
+JitFunction* VM::GetJITFunction(std::size_t pc)
+{
+	if(pc >= m_jit_func_index.size())
+		return nullptr;
+
+	JitFunction& func = m_jit_funcs[m_jit_func_index[pc]];
+	if(!func.compiled)
+	{
+		if(func.num_calls + func.num_loops < m_hot_threshold)
+			return nullptr;
+
+		func.compiled = true;
+		CompileJIT(func);
+	}
+
+	if(!func.code)
+		return nullptr;
+	return &func;
+}
+
+
+/**
+ * print the usage counters and execution tiers of the functions
+ */
+void VM::PrintStats(std::ostream& ostr) const
+{
+	ostr << "Function statistics:\n";
+	ostr << std::left << std::setw(24) << "function" << " "
+		<< std::right << std::setw(12) << "calls" << " "
+		<< std::setw(12) << "loops" << "  "
+		<< std::left << "tier" << "\n";
+
+	// the bytecode is run directly if it has not been translated
+	if(m_jit_funcs.empty())
+	{
+		for(const auto& [addr, name] : m_funcnames)
+		{
+			ostr << std::left << std::setw(24) << name << " "
+				<< std::right << std::setw(12) << "-" << " "
+				<< std::setw(12) << "-" << "  "
+				<< std::left << get_exec_tier_name(ExecTier::BYTECODE) << "\n";
+		}
+	}
+
+	for(const JitFunction& func : m_jit_funcs)
+	{
+		t_addr addr = m_ir[func.begin].addr;
+		std::string name;
+		if(auto iter = m_funcnames.find(addr); iter != m_funcnames.end())
+			name = iter->second;
+		else
+			name = "<" + std::to_string(addr) + ">";
+
+		ostr << std::left << std::setw(24) << name << " "
+			<< std::right << std::setw(12) << func.num_calls << " "
+			<< std::setw(12) << func.num_loops << "  "
+			<< std::left << get_exec_tier_name(func.GetTier()) << "\n";
+	}
+
+	PrintMemoStats(ostr);
+	ostr.flush();
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// compilation
+// ----------------------------------------------------------------------------
+
+
+/**
+ * compile the ir instructions of a function into native code
+ */
+bool VM::CompileJIT([[maybe_unused]] JitFunction& func)
+{
+#ifdef __VM_USE_JIT__
+	static_assert(sizeof(t_int) == 8 && sizeof(t_real) == 8 && sizeof(t_addr) == 4,
+		"Native code expects 64-bit int and real and 32-bit address types.");
+	static_assert(sizeof(std::atomic_bool) == 1, "Unexpected size of interrupt flags.");
+
+	const std::size_t begin = func.begin, end = func.end;
+	if(end > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+		return false;
+
+	JitAsm as;
+	std::size_t num_native = 0;
+
+	// labels for every instruction and for leaving the function
+	std::vector<JitAsm::t_label> labels;
+	for(std::size_t pc=begin; pc<=end; ++pc)
+		labels.push_back(as.NewLabel());
+	JitAsm::t_label lbl_exit = as.NewLabel();
+	JitAsm::t_label lbl_table = as.NewLabel();
+
+	auto label_of = [&labels, begin](std::size_t pc) -> JitAsm::t_label
+	{
+		return labels[pc - begin];
+	};
+
+	auto in_func = [begin, end](std::size_t pc) -> bool
+	{
+		return pc >= begin && pc < end;
+	};
+
+	// rbx = frame base address, r12 = memory, r13 = &m_bp, r14 = vm, r15 = &m_sp
+	auto load_frame = [&as]()
+	{
+		as.LoadInt32(RBX, R13, 0);
+		as.Add(RBX, R12);
+	};
+
+	// get the location of an operand
+	auto get_operand = [this](const IROperand& opd, bool write) -> std::optional<JitOperand>
+	{
+		switch(opd.type)
+		{
+			// the address of stack values is set by the instruction
+			case IROperandType::STACK:
+				if(m_zeropoppedvals)
+					return std::nullopt;
+				return JitOperand{ .is_stack = true, .base = RDX };
+
+			case IROperandType::FRAME:
+				return JitOperand{ .base = RBX, .disp = opd.addr };
+
+			case IROperandType::MEM:
+			{
+				// only static addresses outside the read-only memory
+				if(opd.addr < 0 || opd.addr + m_bytesize + m_realsize > m_memsize)
+					return std::nullopt;
+				if(write && m_rom_range[0] >= 0 && m_rom_range[1] >= 0 &&
+					opd.addr < m_rom_range[1] && opd.addr + m_bytesize + m_realsize > m_rom_range[0])
+					return std::nullopt;
+				return JitOperand{ .base = R12, .disp = opd.addr };
+			}
+
+			case IROperandType::CONST:
+			{
+				if(write)
+					return std::nullopt;
+
+				const t_data& val = std::get<1>(m_ir_consts[opd.addr]);
+				JitOperand jitopd{ .is_const = true };
+				if(val.index() == m_intidx)
+				{
+					jitopd.ty = VMType::INT;
+					std::memcpy(&jitopd.bits, &std::get<m_intidx>(val), sizeof(t_int));
+				}
+				else if(val.index() == m_realidx)
+				{
+					jitopd.ty = VMType::REAL;
+					std::memcpy(&jitopd.bits, &std::get<m_realidx>(val), sizeof(t_real));
+				}
+				else
+				{
+					return std::nullopt;
+				}
+				return jitopd;
+			}
+
+			default:
+				return std::nullopt;
+		}
+	};
+
+	// check the type descriptor of an operand
+	auto emit_guard = [&as](const JitOperand& opd, VMType ty, JitAsm::t_label fail)
+	{
+		if(opd.is_const)
+		{
+			if(opd.ty != ty)
+				as.Jmp(fail);
+			return;
+		}
+
+		as.CmpByte(opd.base, opd.disp, static_cast<std::uint8_t>(ty));
+		as.Jcc(CC_NE, fail);
+	};
+
+	auto emit_load_int = [&as](int r, const JitOperand& opd)
+	{
+		if(opd.is_const)
+			as.MovImm(r, opd.bits);
+		else
+			as.Load(r, opd.base, opd.disp + m_bytesize);
+	};
+
+	auto emit_load_real = [&as](int x, const JitOperand& opd)
+	{
+		if(opd.is_const)
+		{
+			as.MovImm(R8, opd.bits);
+			as.MovqToXmm(x, R8);
+		}
+		else
+		{
+			as.MovsdLoad(x, opd.base, opd.disp + m_bytesize);
+		}
+	};
+
+	// convert and store an int result in rax or a real result in xmm0
+	auto emit_store = [&as](const JitOperand& dst, VMType ty, OpCode cast)
+	{
+		if(ty == VMType::INT && cast == OpCode::TOF)
+		{
+			as.Cvtsi2sd(XMM0, RAX);
+			ty = VMType::REAL;
+		}
+		else if(ty == VMType::REAL && cast == OpCode::TOI)
+		{
+			as.Cvttsd2si(RAX, XMM0);
+			ty = VMType::INT;
+		}
+
+		if(ty == VMType::REAL)
+			as.MovqFromXmm(RAX, XMM0);
+
+		as.StoreByte(dst.base, dst.disp, static_cast<std::uint8_t>(ty));
+		as.Store(dst.base, dst.disp + m_bytesize, RAX);
+	};
+
+	// assign the stack positions of the operands of an instruction,
+	// the values of int and real type each take a descriptor byte and 8 bytes
+	constexpr const std::int32_t stack_slot = m_bytesize + m_realsize;
+	static_assert(m_realsize == m_intsize, "Unexpected stack value sizes.");
+
+	auto assign_stack = [](JitOperand* dst, std::initializer_list<JitOperand*> srcs) -> std::int32_t
+	{
+		// the last operand is on top of the stack
+		std::int32_t num_pops = 0;
+		for(auto iter = std::rbegin(srcs); iter != std::rend(srcs); ++iter)
+		{
+			if((*iter)->is_stack)
+				(*iter)->disp = (num_pops++) * stack_slot;
+		}
+
+		if(dst && dst->is_stack)
+		{
+			dst->disp = (num_pops - 1) * stack_slot;
+			return (num_pops - 1) * stack_slot;
+		}
+		return num_pops * stack_slot;
+	};
+
+	// load the stack pointer into rsi and its address into rdx
+	auto emit_stack_begin = [&](std::int32_t sp_delta, JitAsm::t_label fail)
+	{
+		as.LoadInt32(RSI, R15, 0);
+		if(sp_delta < 0)
+		{
+			// stack overflow
+			as.CmpImm(RSI, m_stack_limit - sp_delta);
+			as.Jcc(CC_L, fail);
+		}
+
+		as.Mov(RDX, RSI);
+		as.Add(RDX, R12);
+	};
+
+	// pop or push the operands
+	auto emit_stack_end = [&as](std::int32_t sp_delta)
+	{
+		if(!sp_delta)
+			return;
+
+		as.AddImm(RSI, sp_delta);
+		as.StoreInt32(R15, 0, RSI);
+	};
+
+	// continue at another ir instruction
+	auto emit_goto = [&](std::size_t target, std::size_t pc)
+	{
+		if(!in_func(target))
+		{
+			as.MovImm(RAX, target);
+			as.Jmp(lbl_exit);
+			return;
+		}
+
+		// leave backward loops when an interrupt is requested
+		if(target <= pc)
+		{
+			JitAsm::t_label lbl_irq = as.NewLabel();
+
+			as.MovImm(RAX, reinterpret_cast<std::uint64_t>(&func.num_loops));
+			as.IncQword(RAX, 0);
+
+			as.MovImm(RAX, reinterpret_cast<std::uint64_t>(m_irqs.data()));
+			std::size_t irq_bytes = m_irqs.size() * sizeof(std::atomic_bool);
+			std::size_t offs = 0;
+			for(; offs + 8 <= irq_bytes; offs += 8)
+			{
+				as.CmpQwordZero(RAX, static_cast<std::int32_t>(offs));
+				as.Jcc(CC_NE, lbl_irq);
+			}
+			for(; offs < irq_bytes; ++offs)
+			{
+				as.CmpByte(RAX, static_cast<std::int32_t>(offs), 0);
+				as.Jcc(CC_NE, lbl_irq);
+			}
+			as.Jmp(label_of(target));
+
+			as.Bind(lbl_irq);
+			as.MovImm(RAX, target);
+			as.Jmp(lbl_exit);
+			return;
+		}
+
+		as.Jmp(label_of(target));
+	};
+
+	// run the instruction in the ir interpreter
+	auto emit_slow = [&](std::size_t pc, const IRInstr& instr)
+	{
+		as.Mov(RDI, R14);
+		as.MovImm(RSI, pc);
+		as.MovImm(RAX, reinterpret_cast<std::uint64_t>(&VM::JitStep));
+		as.Call(RAX);
+		load_frame();
+
+		// continue natively if the next instruction is in this function
+		as.CmpImm(RAX, static_cast<std::int32_t>(pc + 1));
+		as.Jcc(CC_E, label_of(pc + 1));
+
+		bool has_target = (instr.op == IROp::JMP || instr.op == IROp::JMPCND ||
+			instr.op == IROp::CMPJMP);
+		if(has_target && in_func(instr.target))
+		{
+			as.CmpImm(RAX, static_cast<std::int32_t>(instr.target));
+			as.Jcc(CC_E, label_of(instr.target));
+		}
+
+		as.Jmp(lbl_exit);
+	};
+
+	// prologue
+	as.Push(RBX);
+	as.Push(R12);
+	as.Push(R13);
+	as.Push(R14);
+	as.Push(R15);
+	as.MovImm(R12, reinterpret_cast<std::uint64_t>(m_mem.get()));
+	as.MovImm(R13, reinterpret_cast<std::uint64_t>(&m_bp));
+	as.MovImm(R14, reinterpret_cast<std::uint64_t>(this));
+	as.MovImm(R15, reinterpret_cast<std::uint64_t>(&m_sp));
+	load_frame();
+
+	// jump to the requested instruction
+	as.SubImm(RDI, static_cast<std::int32_t>(begin));
+	as.LeaRip(RCX, lbl_table);
+	as.LoadTableEntry();
+	as.Add(RAX, RCX);
+	as.JmpReg(RAX);
+
+	for(std::size_t pc=begin; pc<end; ++pc)
+	{
+		const IRInstr& instr = m_ir[pc];
+		as.Bind(label_of(pc));
+
+		JitAsm::t_label lbl_slow = as.NewLabel();
+		bool native = false;
+
+		switch(instr.op)
+		{
+			case IROp::MOV:
+			{
+				std::optional<JitOperand> src = get_operand(instr.src1, false);
+				std::optional<JitOperand> dst = get_operand(instr.dst, true);
+				if(!src || !dst || (instr.cast != OpCode::NOP &&
+					instr.cast != OpCode::TOI && instr.cast != OpCode::TOF))
+					break;
+
+				native = true;
+				JitAsm::t_label lbl_real = as.NewLabel();
+
+				std::int32_t sp_delta = assign_stack(&*dst, { &*src });
+				if(src->is_stack || dst->is_stack)
+					emit_stack_begin(sp_delta, lbl_slow);
+
+				if(src->CanBe(VMType::INT))
+				{
+					emit_guard(*src, VMType::INT, lbl_real);
+					emit_load_int(RAX, *src);
+					emit_stack_end(sp_delta);
+					emit_store(*dst, VMType::INT, instr.cast);
+					as.Jmp(label_of(pc + 1));
+				}
+
+				as.Bind(lbl_real);
+				if(src->CanBe(VMType::REAL))
+				{
+					emit_guard(*src, VMType::REAL, lbl_slow);
+					emit_load_real(XMM0, *src);
+					emit_stack_end(sp_delta);
+					emit_store(*dst, VMType::REAL, instr.cast);
+					as.Jmp(label_of(pc + 1));
+				}
+				else
+				{
+					as.Jmp(lbl_slow);
+				}
+				break;
+			}
+
+			case IROp::ARITH:
+			{
+				std::optional<JitOperand> src1 = get_operand(instr.src1, false);
+				std::optional<JitOperand> src2 = get_operand(instr.src2, false);
+				std::optional<JitOperand> dst = get_operand(instr.dst, true);
+				if(!src1 || !src2 || !dst || (instr.cast != OpCode::NOP &&
+					instr.cast != OpCode::TOI && instr.cast != OpCode::TOF))
+					break;
+
+				bool int_op = (instr.opcode == OpCode::ADD ||
+					instr.opcode == OpCode::SUB || instr.opcode == OpCode::MUL) &&
+					src1->CanBe(VMType::INT) && src2->CanBe(VMType::INT);
+				bool real_op = (instr.opcode == OpCode::ADD || instr.opcode == OpCode::SUB ||
+					instr.opcode == OpCode::MUL || instr.opcode == OpCode::DIV) &&
+					src1->CanBe(VMType::REAL) && src2->CanBe(VMType::REAL);
+				if(!int_op && !real_op)
+					break;
+
+				native = true;
+				JitAsm::t_label lbl_real = as.NewLabel();
+
+				std::int32_t sp_delta = assign_stack(&*dst, { &*src1, &*src2 });
+				if(src1->is_stack || src2->is_stack || dst->is_stack)
+					emit_stack_begin(sp_delta, lbl_slow);
+
+				if(int_op)
+				{
+					emit_guard(*src1, VMType::INT, lbl_real);
+					emit_guard(*src2, VMType::INT, lbl_real);
+					emit_load_int(RAX, *src1);
+					emit_load_int(RCX, *src2);
+					emit_stack_end(sp_delta);
+
+					switch(instr.opcode)
+					{
+						case OpCode::ADD: as.Add(RAX, RCX); break;
+						case OpCode::SUB: as.Sub(RAX, RCX); break;
+						default: as.IMul(RAX, RCX); break;
+					}
+
+					emit_store(*dst, VMType::INT, instr.cast);
+					as.Jmp(label_of(pc + 1));
+				}
+
+				as.Bind(lbl_real);
+				if(real_op)
+				{
+					emit_guard(*src1, VMType::REAL, lbl_slow);
+					emit_guard(*src2, VMType::REAL, lbl_slow);
+					emit_load_real(XMM0, *src1);
+					emit_load_real(XMM1, *src2);
+					emit_stack_end(sp_delta);
+
+					switch(instr.opcode)
+					{
+						case OpCode::ADD: as.SseArith(0x58, XMM0, XMM1); break;
+						case OpCode::SUB: as.SseArith(0x5c, XMM0, XMM1); break;
+						case OpCode::MUL: as.SseArith(0x59, XMM0, XMM1); break;
+						default: as.SseArith(0x5e, XMM0, XMM1); break;
+					}
+
+					emit_store(*dst, VMType::REAL, instr.cast);
+					as.Jmp(label_of(pc + 1));
+				}
+				else
+				{
+					as.Jmp(lbl_slow);
+				}
+				break;
+			}
+
+			case IROp::CMPJMP:
+			{
+				std::optional<JitOperand> src1 = get_operand(instr.src1, false);
+				std::optional<JitOperand> src2 = get_operand(instr.src2, false);
+				if(!src1 || !src2)
+					break;
+
+				bool int_op = src1->CanBe(VMType::INT) && src2->CanBe(VMType::INT);
+				// real equality is tested with an epsilon by the interpreter
+				bool real_op = (instr.opcode != OpCode::EQU && instr.opcode != OpCode::NEQU) &&
+					src1->CanBe(VMType::REAL) && src2->CanBe(VMType::REAL);
+				if(!int_op && !real_op)
+					break;
+
+				native = true;
+				JitAsm::t_label lbl_real = as.NewLabel();
+				JitAsm::t_label lbl_taken = as.NewLabel();
+
+				std::int32_t sp_delta = assign_stack(nullptr, { &*src1, &*src2 });
+				if(src1->is_stack || src2->is_stack)
+					emit_stack_begin(sp_delta, lbl_slow);
+
+				if(int_op)
+				{
+					emit_guard(*src1, VMType::INT, lbl_real);
+					emit_guard(*src2, VMType::INT, lbl_real);
+					emit_load_int(RAX, *src1);
+					emit_load_int(RCX, *src2);
+					emit_stack_end(sp_delta);
+					as.Cmp(RAX, RCX);
+
+					Cond cc = CC_E;
+					switch(instr.opcode)
+					{
+						case OpCode::GT: cc = CC_G; break;
+						case OpCode::LT: cc = CC_L; break;
+						case OpCode::GEQU: cc = CC_GE; break;
+						case OpCode::LEQU: cc = CC_LE; break;
+						case OpCode::NEQU: cc = CC_NE; break;
+						default: cc = CC_E; break;
+					}
+
+					as.Jcc(instr.negate ? invert_cond(cc) : cc, lbl_taken);
+					as.Jmp(label_of(pc + 1));
+				}
+
+				as.Bind(lbl_real);
+				if(real_op)
+				{
+					emit_guard(*src1, VMType::REAL, lbl_slow);
+					emit_guard(*src2, VMType::REAL, lbl_slow);
+					emit_load_real(XMM0, *src1);
+					emit_load_real(XMM1, *src2);
+					emit_stack_end(sp_delta);
+
+					// unordered comparisons (nan) set the carry and zero flags
+					Cond cc = CC_A;
+					switch(instr.opcode)
+					{
+						case OpCode::GT: as.Ucomisd(XMM0, XMM1); cc = CC_A; break;
+						case OpCode::GEQU: as.Ucomisd(XMM0, XMM1); cc = CC_AE; break;
+						case OpCode::LT: as.Ucomisd(XMM1, XMM0); cc = CC_A; break;
+						default: as.Ucomisd(XMM1, XMM0); cc = CC_AE; break;
+					}
+
+					as.Jcc(instr.negate ? invert_cond(cc) : cc, lbl_taken);
+					as.Jmp(label_of(pc + 1));
+				}
+				else
+				{
+					as.Jmp(lbl_slow);
+				}
+
+				as.Bind(lbl_taken);
+				emit_goto(instr.target, pc);
+				break;
+			}
+
+			case IROp::JMP:
+			{
+				native = true;
+				emit_goto(instr.target, pc);
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+
+		if(native)
+			++num_native;
+
+		as.Bind(lbl_slow);
+		emit_slow(pc, instr);
+	}
+
+	// end of the function
+	as.Bind(label_of(end));
+	as.MovImm(RAX, end);
+
+	// epilogue
+	as.Bind(lbl_exit);
+	as.Pop(R15);
+	as.Pop(R14);
+	as.Pop(R13);
+	as.Pop(R12);
+	as.Pop(RBX);
+	as.Ret();
+
+	// entry points
+	as.Align(4);
+	as.Bind(lbl_table);
+	for(std::size_t pc=begin; pc<end; ++pc)
+		as.TableEntry(lbl_table, label_of(pc));
+
+	// keep interpreting functions without any native instructions
+	if(!num_native)
+		return false;
+
+	try
+	{
+		func.code = std::make_unique<JitCode>(as.Finish());
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "Warning: " << ex.what() << std::endl;
+		return false;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// execution
+// ----------------------------------------------------------------------------
+/**
+ * run an ir instruction on behalf of native code
+ */
+std::size_t VM::JitStep(VM* vm, std::size_t pc)
+{
+	// exceptions must not be thrown through native code
+	try
+	{
+		IRStatus status = vm->StepIR(pc);
+		if(status == IRStatus::OK)
+			return pc;
+
+		vm->m_jit_status = status;
+	}
+	catch(...)
+	{
+		vm->m_jit_exception = std::current_exception();
+	}
+
+	return g_jit_exit;
+}
+
+
+/**
+ * run the native code of compiled functions and interpret the rest
+ */
+bool VM::RunJIT()
+{
+	std::optional<std::size_t> start = GetIRIndex(m_ip);
+	if(!start)
+		return RunBytecode();
+
+	auto irq_pending = [this]() -> bool
+	{
+		return std::any_of(m_irqs.begin(), m_irqs.end(),
+			[](const std::atomic_bool& irq) -> bool { return irq; });
+	};
+
+	std::size_t pc = *start;
+	while(true)
+	{
+		// interrupts are handled by the interpreter
+		JitFunction *func = irq_pending() ? nullptr : GetJITFunction(pc);
+
+		IRStatus status = IRStatus::OK;
+		if(func)
+		{
+			m_jit_status = IRStatus::OK;
+			pc = func->code->GetEntry()(pc);
+			if(pc != g_jit_exit)
+				continue;
+
+			if(m_jit_exception)
+			{
+				std::exception_ptr ex = m_jit_exception;
+				m_jit_exception = nullptr;
+				std::rethrow_exception(ex);
+			}
+
+			status = m_jit_status;
+		}
+		else
+		{
+			status = StepIR(pc);
+		}
+
+		switch(status)
+		{
+			case IRStatus::OK: break;
+			case IRStatus::HALT: return true;
+			case IRStatus::ERROR: return false;
+			case IRStatus::FALLBACK: return RunBytecode();
+		}
+	}
+}
+// ----------------------------------------------------------------------------
@@ -0,0 +1,105 @@
+/**
+ * native x86-64 code for the register-based ir
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * Functions are compiled once they get hot, i.e. once their number of calls
+ * and backward branches reaches a threshold. They are compiled as a whole
+ * into native code that has an entry point for every ir instruction. Scalar (int and real) moves, arithmetic,
+ * comparisons and jumps on frame variables and constants are run natively,
+ * guarded by checks of the type descriptors in memory. Everything else,
+ * and every failed type guard, calls back into the ir interpreter.
+ */
+
+#ifndef __0ACVM_JIT_H__
+#define __0ACVM_JIT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <limits>
+
+#if defined(__x86_64__) && __has_include(<sys/mman.h>)
+	#define __VM_USE_JIT__
+#endif
+
+
+// returned by native code to leave the vm
+constexpr const std::size_t g_jit_exit = std::numeric_limits<std::size_t>::max();
+
+
+// entry point of native code: takes the ir index to start at and
+// returns the ir index to continue at or g_jit_exit
+using t_jit_entry = std::size_t (*)(std::size_t pc);
+
+
+/**
+ * executable memory holding native code
+ */
+class JitCode
+{
+public:
+	JitCode(const std::vector<std::uint8_t>& code);
+	~JitCode();
+
+	JitCode(const JitCode&) = delete;
+	const JitCode& operator=(const JitCode&) = delete;
+
+	t_jit_entry GetEntry() const { return reinterpret_cast<t_jit_entry>(m_mem); }
+
+
+private:
+	void *m_mem{nullptr};
+	std::size_t m_size{0};
+};
+
+
+/**
+ * execution tiers of a function
+ */
+enum class ExecTier : std::uint8_t
+{
+	BYTECODE,   // stack-based bytecode interpreter
+	IR,         // register-based ir interpreter
+	NATIVE,     // native code
+};
+
+
+constexpr const char* get_exec_tier_name(ExecTier tier)
+{
+	switch(tier)
+	{
+		case ExecTier::BYTECODE: return "bytecode";
+		case ExecTier::IR: return "ir";
+		case ExecTier::NATIVE: return "native";
+	}
+
+	return "<unknown>";
+}
+
+
+/**
+ * range of ir instructions belonging to a function, its usage counters
+ * and its native code
+ */
+struct JitFunction
+{
+	std::size_t begin{}, end{};     // ir index range
+	bool compiled{false};           // compilation has been attempted
+
+	std::uint64_t num_calls{0};     // number of invocations
+	std::uint64_t num_loops{0};     // number of backward branches
+
+	std::unique_ptr<JitCode> code{};
+
+
+	ExecTier GetTier() const
+	{
+		return code ? ExecTier::NATIVE : ExecTier::IR;
+	}
+};
+
+
+#endif
@@ -0,0 +1,729 @@
+/**
+ * linear algebra kernels for the vm
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#ifndef __0ACVM_LINALG_H__
+#define __0ACVM_LINALG_H__
+
+
+#include <vector>
+#include <tuple>
+#include <type_traits>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+
+#include "pool.h"
+#include "gemm.h"
+
+
+/**
+ * lu decomposition with partial pivoting, P*M = L*U, done in-place:
+ * the strict lower triangle holds L (with unit diagonal), the upper triangle U,
+ * perm[i] is the original row of row i,
+ * returns false for a singular matrix
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+bool lu_decomp(t_mat& lu, std::vector<std::size_t>& perm, t_real& sign, t_real eps,
+	ThreadPool* pool = nullptr)
+{
+	const std::size_t N = lu.size1();
+	perm.resize(N);
+	for(std::size_t i=0; i<N; ++i)
+		perm[i] = i;
+	sign = t_real(1);
+
+	for(std::size_t k=0; k<N; ++k)
+	{
+		// find the pivot row with the largest element in the column
+		std::size_t pivot = k;
+		t_real pivot_val = std::abs(lu(k, k));
+		for(std::size_t i=k+1; i<N; ++i)
+		{
+			if(t_real val = std::abs(lu(i, k)); val > pivot_val)
+			{
+				pivot = i;
+				pivot_val = val;
+			}
+		}
+
+		if(pivot_val <= eps)
+			return false;
+
+		if(pivot != k)
+		{
+			for(std::size_t j=0; j<N; ++j)
+				std::swap(lu(k, j), lu(pivot, j));
+			std::swap(perm[k], perm[pivot]);
+			sign = -sign;
+		}
+
+		// eliminate the column below the pivot
+		using t_int = ThreadPool::t_int;
+		const t_real diag = lu(k, k);
+		par_for(pool, (N - k)*(N - k), g_par_min_elems,
+			static_cast<t_int>(k + 1), static_cast<t_int>(N),
+			[&lu, k, N, diag](t_int begin, t_int end)
+		{
+			for(std::size_t i=static_cast<std::size_t>(begin); i<static_cast<std::size_t>(end); ++i)
+			{
+				const t_real factor = lu(i, k) / diag;
+				lu(i, k) = factor;
+				for(std::size_t j=k+1; j<N; ++j)
+					lu(i, j) -= factor * lu(k, j);
+			}
+		});
+	}
+
+	return true;
+}
+
+
+/**
+ * solves L*U*x = P*b for an lu-decomposed matrix, b is overwritten with x
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+void lu_solve(const t_mat& lu, const std::vector<std::size_t>& perm, t_real* b, std::size_t stride = 1)
+{
+	const std::size_t N = lu.size1();
+
+	std::vector<t_real> x(N);
+	for(std::size_t i=0; i<N; ++i)
+		x[i] = b[perm[i]*stride];
+
+	// forward substitution with the unit lower triangle
+	for(std::size_t i=0; i<N; ++i)
+		for(std::size_t j=0; j<i; ++j)
+			x[i] -= lu(i, j) * x[j];
+
+	// backward substitution with the upper triangle
+	for(std::size_t _i=0; _i<N; ++_i)
+	{
+		const std::size_t i = N - _i - 1;
+		for(std::size_t j=i+1; j<N; ++j)
+			x[i] -= lu(i, j) * x[j];
+		x[i] /= lu(i, i);
+	}
+
+	for(std::size_t i=0; i<N; ++i)
+		b[i*stride] = x[i];
+}
+
+
+/**
+ * solves for all columns of the row-major N x cols matrix B, B is overwritten with X
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+void lu_solve_cols(const t_mat& lu, const std::vector<std::size_t>& perm, t_real* B, std::size_t cols,
+	ThreadPool* pool = nullptr)
+{
+	const std::size_t N = lu.size1();
+
+	// the columns are independent
+	using t_int = ThreadPool::t_int;
+	par_for(pool, N*N*cols, g_par_min_flops, 0, static_cast<t_int>(cols),
+		[&lu, &perm, B, cols](t_int begin, t_int end)
+	{
+		for(t_int j=begin; j<end; ++j)
+			lu_solve(lu, perm, B + j, cols);
+	});
+}
+
+
+/**
+ * determinant via lu decomposition
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+t_real lu_det(const t_mat& mat, t_real eps, ThreadPool* pool = nullptr)
+{
+	if(mat.size1() != mat.size2())
+		return t_real(0);
+
+	t_mat lu = mat;
+	std::vector<std::size_t> perm;
+	t_real det{};
+	if(!lu_decomp(lu, perm, det, eps, pool))
+		return t_real(0);
+
+	for(std::size_t i=0; i<lu.size1(); ++i)
+		det *= lu(i, i);
+	return det;
+}
+
+
+/**
+ * inverse via lu decomposition, solving for each column of the unit matrix
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+std::tuple<t_mat, bool> lu_inv(const t_mat& mat, t_real eps, ThreadPool* pool = nullptr)
+{
+	const std::size_t N = mat.size1();
+	t_mat inv = mat;
+	if(N != mat.size2())
+		return std::make_tuple(inv, false);
+
+	t_mat lu = mat;
+	std::vector<std::size_t> perm;
+	t_real sign{};
+	if(!lu_decomp(lu, perm, sign, eps, pool))
+		return std::make_tuple(inv, false);
+
+	// the columns are independent
+	using t_int = ThreadPool::t_int;
+	par_for(pool, N*N*N, g_par_min_flops, 0, static_cast<t_int>(N),
+		[&lu, &perm, &inv, N](t_int begin, t_int end)
+	{
+		std::vector<t_real> col(N);
+		for(std::size_t j=static_cast<std::size_t>(begin); j<static_cast<std::size_t>(end); ++j)
+		{
+			for(std::size_t i=0; i<N; ++i)
+				col[i] = (i == j ? t_real(1) : t_real(0));
+
+			lu_solve(lu, perm, col.data());
+
+			for(std::size_t i=0; i<N; ++i)
+				inv(i, j) = col[i];
+		}
+	});
+
+	return std::make_tuple(inv, true);
+}
+
+
+/**
+ * matrix power by repeated squaring using ping-pong buffers,
+ * negative powers invert the matrix once
+ */
+template<class t_mat, class t_int, class t_real = typename t_mat::value_type>
+std::tuple<t_mat, bool> mat_pow(const t_mat& mat, t_int pow, t_real eps, ThreadPool* pool = nullptr)
+{
+	const std::size_t N = mat.size1();
+	if(N != mat.size2())
+		return std::make_tuple(mat, false);
+
+	// magnitude of the power, negated in unsigned arithmetic to also
+	// work for the minimum integer
+	using t_uint = std::make_unsigned_t<t_int>;
+	t_uint upow = static_cast<t_uint>(pow);
+
+	t_mat base = mat;
+	if(pow < 0)
+	{
+		bool ok = false;
+		std::tie(base, ok) = lu_inv<t_mat, t_real>(mat, eps, pool);
+		if(!ok)
+			return std::make_tuple(mat, false);
+		upow = t_uint(0) - upow;
+	}
+
+	// the result is the unit matrix until the first factor is multiplied
+	t_mat result = mat, tmp = mat;
+	bool result_unit = true;
+
+	while(upow)
+	{
+		if(upow & 1)
+		{
+			if(result_unit)
+			{
+				result = base;
+				result_unit = false;
+			}
+			else
+			{
+				gemm(result.data(), base.data(), tmp.data(), N, N, N, pool);
+				std::swap(result, tmp);
+			}
+		}
+
+		upow >>= 1;
+		if(upow)
+		{
+			gemm(base.data(), base.data(), tmp.data(), N, N, N, pool);
+			std::swap(base, tmp);
+		}
+	}
+
+	if(result_unit)
+	{
+		for(std::size_t i=0; i<N; ++i)
+			for(std::size_t j=0; j<N; ++j)
+				result(i, j) = (i == j ? t_real(1) : t_real(0));
+	}
+
+	return std::make_tuple(result, true);
+}
+
+
+/**
+ * householder reflector for the column j of mat below row j: the reflector's
+ * vector (with an implicit 1 at row j) is stored below the diagonal,
+ * the diagonal receives beta, returns tau with H = I - tau*v*v^T
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+t_real householder_vec(t_mat& mat, std::size_t j)
+{
+	const std::size_t rows = mat.size1();
+
+	t_real norm2{};
+	for(std::size_t r=j+1; r<rows; ++r)
+		norm2 += mat(r, j) * mat(r, j);
+	if(norm2 == t_real(0))
+		return t_real(0);
+
+	const t_real x0 = mat(j, j);
+	const t_real beta = -std::copysign(std::sqrt(x0*x0 + norm2), x0);
+	const t_real scale = t_real(1) / (x0 - beta);
+
+	for(std::size_t r=j+1; r<rows; ++r)
+		mat(r, j) *= scale;
+	mat(j, j) = beta;
+
+	return (beta - x0) / beta;
+}
+
+
+/**
+ * applies the block reflector I - V*T*V^T (or its transpose) of the
+ * householder vectors stored in the columns [p, p+nb) of refl
+ * to the columns [begin, end) of mat, starting at row p
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+void householder_apply_block(const t_mat& refl, const std::vector<t_real>& T,
+	std::size_t p, std::size_t nb, t_mat& mat, std::size_t begin, std::size_t end, bool trans)
+{
+	const std::size_t rows = mat.size1();
+	auto V = [&refl, p](std::size_t r, std::size_t i) -> t_real
+	{
+		if(r == p + i)
+			return t_real(1);
+		return r < p + i ? t_real(0) : refl(r, p + i);
+	};
+
+	std::vector<t_real> w(nb), tw(nb);
+	for(std::size_t c=begin; c<end; ++c)
+	{
+		// w = V^T * c
+		for(std::size_t i=0; i<nb; ++i)
+		{
+			w[i] = t_real(0);
+			for(std::size_t r=p+i; r<rows; ++r)
+				w[i] += V(r, i) * mat(r, c);
+		}
+
+		// w = T*w or T^T*w for the upper triangular T
+		for(std::size_t i=0; i<nb; ++i)
+		{
+			tw[i] = t_real(0);
+			if(trans)
+			{
+				for(std::size_t s=0; s<=i; ++s)
+					tw[i] += T[s*nb + i] * w[s];
+			}
+			else
+			{
+				for(std::size_t s=i; s<nb; ++s)
+					tw[i] += T[i*nb + s] * w[s];
+			}
+		}
+
+		// c -= V * w
+		for(std::size_t i=0; i<nb; ++i)
+			for(std::size_t r=p+i; r<rows; ++r)
+				mat(r, c) -= V(r, i) * tw[i];
+	}
+}
+
+
+/**
+ * blocked householder qr decomposition, M = Q*R with an orthogonal rows x rows
+ * matrix Q and an upper triangular rows x cols matrix R: the reflectors of each
+ * panel are combined into a block reflector I - V*T*V^T, which then updates
+ * the trailing columns (and builds Q) column-parallel in one sweep
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+void householder_qr(const t_mat& mat, t_mat& Q, t_mat& R,
+	ThreadPool* pool = nullptr, std::size_t block = 32)
+{
+	using t_int = ThreadPool::t_int;
+	const std::size_t rows = mat.size1(), cols = mat.size2();
+	const std::size_t K = std::min(rows, cols);
+
+	// R holds the reflectors below its diagonal until the end
+	R = mat;
+	std::vector<std::vector<t_real>> Ts;
+
+	for(std::size_t p=0; p<K; p+=block)
+	{
+		const std::size_t nb = std::min(block, K - p);
+		std::vector<t_real> taus(nb);
+
+		// factorise the panel column by column
+		for(std::size_t i=0; i<nb; ++i)
+		{
+			const std::size_t j = p + i;
+			const t_real tau = taus[i] = householder_vec(R, j);
+			if(tau == t_real(0))
+				continue;
+
+			for(std::size_t c=j+1; c<p+nb; ++c)
+			{
+				t_real w = R(j, c);
+				for(std::size_t r=j+1; r<rows; ++r)
+					w += R(r, j) * R(r, c);
+				w *= tau;
+
+				R(j, c) -= w;
+				for(std::size_t r=j+1; r<rows; ++r)
+					R(r, c) -= w * R(r, j);
+			}
+		}
+
+		// upper triangular factor, H_p*...*H_(p+nb-1) = I - V*T*V^T
+		std::vector<t_real> T(nb*nb, t_real(0));
+		std::vector<t_real> t(nb);
+		for(std::size_t i=0; i<nb; ++i)
+		{
+			for(std::size_t s=0; s<i; ++s)
+			{
+				// V(:, s)^T * V(:, i)
+				t_real dot = R(p + i, p + s);
+				for(std::size_t r=p+i+1; r<rows; ++r)
+					dot += R(r, p + s) * R(r, p + i);
+				t[s] = -taus[i] * dot;
+			}
+
+			for(std::size_t s=0; s<i; ++s)
+			{
+				T[s*nb + i] = t_real(0);
+				for(std::size_t u=s; u<i; ++u)
+					T[s*nb + i] += T[s*nb + u] * t[u];
+			}
+			T[i*nb + i] = taus[i];
+		}
+
+		// apply the transposed block reflector to the trailing columns
+		const std::size_t trail = p + nb;
+		par_for(pool, (rows - p)*(cols - trail)*nb, g_par_min_flops,
+			static_cast<t_int>(trail), static_cast<t_int>(cols),
+			[&R, &T, p, nb](t_int begin, t_int end)
+		{
+			householder_apply_block(R, T, p, nb, R,
+				static_cast<std::size_t>(begin), static_cast<std::size_t>(end), true);
+		});
+
+		Ts.emplace_back(std::move(T));
+	}
+
+	// accumulate Q = H_0*...*H_(K-1) backwards, the block reflector
+	// starting at row p leaves the unit columns before p unchanged
+	Q = m::create<t_mat>(rows, rows);
+	for(std::size_t i=0; i<rows; ++i)
+		for(std::size_t j=0; j<rows; ++j)
+			Q(i, j) = (i == j ? t_real(1) : t_real(0));
+
+	for(std::size_t _b=0; _b<Ts.size(); ++_b)
+	{
+		const std::size_t b = Ts.size() - _b - 1;
+		const std::size_t p = b*block;
+		const std::size_t nb = std::min(block, K - p);
+		const std::vector<t_real>& T = Ts[b];
+
+		par_for(pool, (rows - p)*(rows - p)*nb, g_par_min_flops,
+			static_cast<t_int>(p), static_cast<t_int>(rows),
+			[&R, &T, &Q, p, nb](t_int begin, t_int end)
+		{
+			householder_apply_block(R, T, p, nb, Q,
+				static_cast<std::size_t>(begin), static_cast<std::size_t>(end), false);
+		});
+	}
+
+	for(std::size_t i=1; i<rows; ++i)
+		for(std::size_t j=0; j<std::min(i, cols); ++j)
+			R(i, j) = t_real(0);
+}
+
+
+/**
+ * cholesky decomposition M = L*L^T of a symmetric matrix using its lower triangle,
+ * returns false (and a zero L) if the matrix is not positive definite
+ */
+template<class t_mat, class t_real = typename t_mat::value_type>
+bool cholesky(const t_mat& mat, t_mat& L, ThreadPool* pool = nullptr)
+{
+	using t_int = ThreadPool::t_int;
+	const std::size_t N = mat.size1();
+	L = m::zero<t_mat>(N, N);
+
+	for(std::size_t j=0; j<N; ++j)
+	{
+		t_real diag = mat(j, j);
+		for(std::size_t k=0; k<j; ++k)
+			diag -= L(j, k) * L(j, k);
+
+		// also catches nan
+		if(!(diag > t_real(0)))
+		{
+			L = m::zero<t_mat>(N, N);
+			return false;
+		}
+		L(j, j) = std::sqrt(diag);
+
+		// the rows below the diagonal are independent
+		par_for(pool, (N - j)*j, g_par_min_flops,
+			static_cast<t_int>(j + 1), static_cast<t_int>(N),
+			[&mat, &L, j](t_int begin, t_int end)
+		{
+			for(std::size_t i=static_cast<std::size_t>(begin); i<static_cast<std::size_t>(end); ++i)
+			{
+				t_real val = mat(i, j);
+				for(std::size_t k=0; k<j; ++k)
+					val -= L(i, k) * L(j, k);
+				L(i, j) = val / L(j, j);
+			}
+		});
+	}
+
+	return true;
+}
+
+
+/**
+ * eigenvalues and eigenvectors of a symmetric matrix using its lower triangle:
+ * householder reduction to tridiagonal form and implicit ql iterations,
+ * the ascending eigenvalues are written to evals and the corresponding
+ * eigenvectors to the columns of evecs, returns false if the iteration does not converge
+ * @see the tred2 and tql2 algorithms of the eispack library
+ */
+template<class t_mat, class t_vec, class t_real = typename t_mat::value_type>
+bool eig_sym(const t_mat& mat, t_vec& evals, t_mat& evecs, ThreadPool* pool = nullptr)
+{
+	using t_int = ThreadPool::t_int;
+	const std::size_t N = mat.size1();
+	evecs = mat;
+	evals = m::create<t_vec>(N);
+	if(N == 0)
+		return true;
+
+	t_mat& V = evecs;
+	t_vec& d = evals;
+	std::vector<t_real> e(N);
+
+	// householder reduction to tridiagonal form
+	for(std::size_t j=0; j<N; ++j)
+		d[j] = V(N - 1, j);
+
+	for(std::size_t i=N-1; i>0; --i)
+	{
+		t_real scale{}, h{};
+		for(std::size_t k=0; k<i; ++k)
+			scale += std::abs(d[k]);
+
+		if(scale == t_real(0))
+		{
+			e[i] = d[i - 1];
+			for(std::size_t j=0; j<i; ++j)
+			{
+				d[j] = V(i - 1, j);
+				V(i, j) = V(j, i) = t_real(0);
+			}
+		}
+		else
+		{
+			for(std::size_t k=0; k<i; ++k)
+			{
+				d[k] /= scale;
+				h += d[k] * d[k];
+			}
+
+			t_real f = d[i - 1];
+			t_real g = std::sqrt(h);
+			if(f > t_real(0))
+				g = -g;
+			e[i] = scale * g;
+			h -= f * g;
+			d[i - 1] = f - g;
+
+			for(std::size_t j=0; j<i; ++j)
+				e[j] = t_real(0);
+
+			for(std::size_t j=0; j<i; ++j)
+			{
+				f = d[j];
+				V(j, i) = f;
+				g = e[j] + V(j, j) * f;
+				for(std::size_t k=j+1; k<i; ++k)
+				{
+					g += V(k, j) * d[k];
+					e[k] += V(k, j) * f;
+				}
+				e[j] = g;
+			}
+
+			f = t_real(0);
+			for(std::size_t j=0; j<i; ++j)
+			{
+				e[j] /= h;
+				f += e[j] * d[j];
+			}
+
+			const t_real hh = f / (h + h);
+			for(std::size_t j=0; j<i; ++j)
+				e[j] -= hh * d[j];
+
+			for(std::size_t j=0; j<i; ++j)
+			{
+				f = d[j];
+				g = e[j];
+				for(std::size_t k=j; k<i; ++k)
+					V(k, j) -= (f * e[k] + g * d[k]);
+				d[j] = V(i - 1, j);
+				V(i, j) = t_real(0);
+			}
+		}
+
+		d[i] = h;
+	}
+
+	// accumulate the transformations, the columns are independent
+	for(std::size_t i=0; i<N-1; ++i)
+	{
+		V(N - 1, i) = V(i, i);
+		V(i, i) = t_real(1);
+
+		if(const t_real h = d[i + 1]; h != t_real(0))
+		{
+			for(std::size_t k=0; k<=i; ++k)
+				d[k] = V(k, i + 1) / h;
+
+			par_for(pool, (i + 1)*(i + 1), g_par_min_elems,
+				0, static_cast<t_int>(i + 1), [&V, &d, i](t_int begin, t_int end)
+			{
+				for(std::size_t j=static_cast<std::size_t>(begin); j<static_cast<std::size_t>(end); ++j)
+				{
+					t_real g{};
+					for(std::size_t k=0; k<=i; ++k)
+						g += V(k, i + 1) * V(k, j);
+					for(std::size_t k=0; k<=i; ++k)
+						V(k, j) -= g * d[k];
+				}
+			});
+		}
+
+		for(std::size_t k=0; k<=i; ++k)
+			V(k, i + 1) = t_real(0);
+	}
+
+	for(std::size_t j=0; j<N; ++j)
+	{
+		d[j] = V(N - 1, j);
+		V(N - 1, j) = t_real(0);
+	}
+	V(N - 1, N - 1) = t_real(1);
+	e[0] = t_real(0);
+
+	// implicit ql iterations on the tridiagonal matrix
+	for(std::size_t i=1; i<N; ++i)
+		e[i - 1] = e[i];
+	e[N - 1] = t_real(0);
+
+	const t_real eps = std::numeric_limits<t_real>::epsilon();
+	const std::size_t max_iter = 30*N;
+	t_real f{}, tst1{};
+
+	for(std::size_t l=0; l<N; ++l)
+	{
+		// find a small sub-diagonal element
+		tst1 = std::max(tst1, std::abs(d[l]) + std::abs(e[l]));
+		std::size_t m = l;
+		while(m < N - 1 && std::abs(e[m]) > eps*tst1)
+			++m;
+
+		std::size_t iter = 0;
+		while(m > l)
+		{
+			if(++iter > max_iter)
+				return false;
+
+			// implicit shift
+			t_real g = d[l];
+			t_real p = (d[l + 1] - g) / (t_real(2) * e[l]);
+			t_real r = std::hypot(p, t_real(1));
+			if(p < t_real(0))
+				r = -r;
+
+			d[l] = e[l] / (p + r);
+			d[l + 1] = e[l] * (p + r);
+			const t_real dl1 = d[l + 1];
+			t_real h = g - d[l];
+			for(std::size_t i=l+2; i<N; ++i)
+				d[i] -= h;
+			f += h;
+
+			// ql transformation
+			p = d[m];
+			t_real c = 1, c2 = 1, c3 = 1;
+			t_real s = 0, s2 = 0;
+			const t_real el1 = e[l + 1];
+
+			for(std::size_t _i=m; _i>l; --_i)
+			{
+				const std::size_t i = _i - 1;
+				c3 = c2;
+				c2 = c;
+				s2 = s;
+				g = c * e[i];
+				h = c * p;
+				r = std::hypot(p, e[i]);
+				e[i + 1] = s * r;
+				s = e[i] / r;
+				c = p / r;
+				p = c * d[i] - s * g;
+				d[i + 1] = h + s * (c * g + s * d[i]);
+
+				// accumulate the rotation
+				for(std::size_t k=0; k<N; ++k)
+				{
+					h = V(k, i + 1);
+					V(k, i + 1) = s * V(k, i) + c * h;
+					V(k, i) = c * V(k, i) - s * h;
+				}
+			}
+
+			p = -s * s2 * c3 * el1 * e[l] / dl1;
+			e[l] = s * p;
+			d[l] = c * p;
+
+			if(std::abs(e[l]) <= eps*tst1)
+				break;
+		}
+
+		d[l] += f;
+		e[l] = t_real(0);
+	}
+
+	// sort the eigenvalues and eigenvectors
+	for(std::size_t i=0; i<N-1; ++i)
+	{
+		std::size_t k = i;
+		for(std::size_t j=i+1; j<N; ++j)
+			if(d[j] < d[k])
+				k = j;
+
+		if(k != i)
+		{
+			std::swap(d[k], d[i]);
+			for(std::size_t j=0; j<N; ++j)
+				std::swap(V(j, i), V(j, k));
+		}
+	}
+
+	return true;
+}
+
+
+#endif
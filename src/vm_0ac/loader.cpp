@@ -0,0 +1,406 @@
+/**
+ * zero-address code vm, memory allocation and program loading
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "vm.h"
+#include "binfile.h"
+#include "mapfile.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+
+
+
+// ----------------------------------------------------------------------------
+// memory allocation
+// ----------------------------------------------------------------------------
+void VM::MemDeleter::operator()(t_byte* mem) const
+{
+	if(!mem || shared)
+		return;
+
+#ifdef __VM_USE_MMAP__
+	::munmap(mem, size);
+#else
+	delete[] mem;
+#endif
+}
+
+
+/**
+ * allocates the vm memory
+ * (page-aligned, so that program files can be mapped into it)
+ */
+void VM::AllocMem()
+{
+	std::size_t size = static_cast<std::size_t>(m_memsize) * m_bytesize;
+
+#ifdef __VM_USE_MMAP__
+	void *mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(mem == MAP_FAILED)
+		throw std::runtime_error("Cannot allocate vm memory.");
+
+	m_mem = std::unique_ptr<t_byte[], MemDeleter>(
+		reinterpret_cast<t_byte*>(mem), MemDeleter{size, false});
+#else
+	m_mem = std::unique_ptr<t_byte[], MemDeleter>(
+		new t_byte[size], MemDeleter{size, false});
+#endif
+}
+
+
+/**
+ * maps a page-aligned part of a file read-only or copy-on-write into vm memory
+ */
+void VM::MapMem([[maybe_unused]] t_addr addr, [[maybe_unused]] int fd,
+	[[maybe_unused]] std::size_t offs, [[maybe_unused]] std::size_t size,
+	[[maybe_unused]] bool writable)
+{
+#ifdef __VM_USE_MMAP__
+	void *mem = ::mmap(m_mem.get() + addr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+		MAP_PRIVATE | MAP_FIXED, fd, static_cast<off_t>(offs));
+	if(mem == MAP_FAILED)
+		throw std::runtime_error("Cannot map program into vm memory.");
+
+	// written pages are private copies
+	if(writable)
+		return;
+
+	if(m_rom_range[0] < 0 || m_rom_range[1] < 0)
+	{
+		m_rom_range[0] = addr;
+		m_rom_range[1] = addr + static_cast<t_addr>(size);
+	}
+	else
+	{
+		m_rom_range[0] = std::min(m_rom_range[0], addr);
+		m_rom_range[1] = std::max(m_rom_range[1], addr + static_cast<t_addr>(size));
+	}
+#else
+	throw std::runtime_error("Memory mapping is not supported.");
+#endif
+}
+
+
+/**
+ * replaces the mapped program file with writable memory
+ */
+void VM::UnmapMem()
+{
+	if(m_rom_range[0] < 0 || m_rom_range[1] < 0)
+		return;
+
+#ifdef __VM_USE_MMAP__
+	::mmap(m_mem.get() + m_rom_range[0], m_rom_range[1] - m_rom_range[0],
+		PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+#endif
+
+	m_rom_range[0] = m_rom_range[1] = -1;
+}
+// ----------------------------------------------------------------------------
+
+
+
+// ----------------------------------------------------------------------------
+// program loading
+// ----------------------------------------------------------------------------
+/**
+ * loads a compiled program, either in the sectioned binary format
+ * or as raw code starting at address 0, or resumes a snapshot
+ */
+bool VM::Load(const std::string& filename)
+{
+	MappedFile file(filename);
+	if(!file.IsOk())
+		return false;
+
+	const t_byte *data = file.GetData();
+	std::size_t size = file.GetSize();
+
+	// raw code without header
+	if(!has_bin_magic(data, size))
+	{
+		SetMem(0, data, size, true);
+		m_prog_range[0] = 0;
+		m_prog_range[1] = static_cast<t_addr>(size);
+		m_ip = m_entry = 0;
+		TranslateIR();
+		InitMemo();
+		return true;
+	}
+
+	BinHeader hdr{};
+	std::memcpy(&hdr, data, sizeof(hdr));
+	if(!is_bin_header_compatible(hdr))
+	{
+		std::ostringstream msg;
+		msg << "Program \"" << filename << "\" was compiled for"
+			<< " version " << hdr.version << " with"
+			<< " address size " << int(hdr.addr_size) << ","
+			<< " int size " << int(hdr.int_size) << ","
+			<< " real size " << int(hdr.real_size) << ".";
+		throw std::runtime_error(msg.str());
+	}
+
+	if(sizeof(BinHeader) + hdr.num_sections*sizeof(BinSection) > size)
+		throw std::runtime_error("Invalid section table.");
+
+	std::vector<BinSection> sections(hdr.num_sections);
+	std::memcpy(sections.data(), data + sizeof(BinHeader),
+		hdr.num_sections*sizeof(BinSection));
+
+	// loadable memory region consisting of adjacent sections
+	std::optional<BinSection> region{};
+
+	// state of a snapshot
+	std::optional<BinState> state{};
+
+	// map or copy a loadable region into memory
+	auto load_region = [this, &file, data](const BinSection& sect)
+	{
+		std::size_t begin = sect.addr, end = sect.addr + sect.size;
+
+#ifdef __VM_USE_MMAP__
+		// file offset and address have to be congruent modulo the page size
+		std::size_t pagesize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		if(file.GetFd() >= 0 && pagesize && (sect.offset - sect.addr) % pagesize == 0)
+		{
+			// only map full pages, copy the rest
+			std::size_t map_begin = (sect.addr + pagesize - 1) / pagesize * pagesize;
+			std::size_t map_end = (sect.addr + sect.size) / pagesize * pagesize;
+
+			if(map_end > map_begin)
+			{
+				MapMem(static_cast<t_addr>(map_begin), file.GetFd(),
+					sect.offset + (map_begin - sect.addr), map_end - map_begin);
+
+				SetMem(static_cast<t_addr>(begin), data + sect.offset,
+					map_begin - begin, false);
+				SetMem(static_cast<t_addr>(map_end), data + sect.offset + (map_end - begin),
+					end - map_end, false);
+				return;
+			}
+		}
+#endif
+
+		SetMem(static_cast<t_addr>(begin), data + sect.offset, sect.size, false);
+	};
+
+	for(const BinSection& sect : sections)
+	{
+		if(sect.offset + sect.size > size)
+			throw std::runtime_error("Invalid section size.");
+
+		// code and constants
+		if(sect.flags & BIN_SECT_LOAD)
+		{
+			if(sect.addr + sect.size > static_cast<std::uint64_t>(m_memsize))
+				throw std::runtime_error("Program does not fit into memory.");
+
+			t_addr begin = static_cast<t_addr>(sect.addr);
+			t_addr end = static_cast<t_addr>(sect.addr + sect.size);
+			if(m_prog_range[0] < 0 || m_prog_range[1] < 0)
+			{
+				m_prog_range[0] = begin;
+				m_prog_range[1] = end;
+			}
+			else
+			{
+				m_prog_range[0] = std::min(m_prog_range[0], begin);
+				m_prog_range[1] = std::max(m_prog_range[1], end);
+			}
+
+			if(sect.flags & BIN_SECT_EXEC)
+			{
+				UpdateCodeRange(begin, end);
+			}
+
+			// sections that are adjacent in the file and in memory are loaded together
+			if(region && region->offset + region->size == sect.offset &&
+				region->addr + region->size == sect.addr)
+			{
+				region->size += sect.size;
+			}
+			else
+			{
+				if(region)
+					load_region(*region);
+				region = sect;
+			}
+		}
+
+		// registers and settings of a snapshot
+		else if(sect.type == BinSectionType::STATE)
+		{
+			if(sect.size != sizeof(BinState))
+				throw std::runtime_error("Invalid snapshot state.");
+
+			state = BinState{};
+			std::memcpy(&*state, data + sect.offset, sizeof(BinState));
+
+			// the memory has the size it had when the snapshot was taken
+			if(state->mem_size != static_cast<std::uint64_t>(m_memsize))
+			{
+				m_memsize = static_cast<t_addr>(state->mem_size);
+				m_rom_range[0] = m_rom_range[1] = -1;
+				AllocMem();
+			}
+		}
+
+		// memory image of a snapshot
+		else if(sect.type == BinSectionType::MEMORY)
+		{
+			if(!state || sect.size != state->mem_size)
+				throw std::runtime_error("Invalid snapshot memory.");
+
+			std::size_t mapped = 0;
+
+#ifdef __VM_USE_MMAP__
+			// map the full pages copy-on-write, so that only the modified ones are copied
+			std::size_t pagesize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+			if(file.GetFd() >= 0 && pagesize && sect.offset % pagesize == 0)
+			{
+				mapped = sect.size / pagesize * pagesize;
+				if(mapped)
+					MapMem(0, file.GetFd(), sect.offset, mapped, true);
+			}
+#endif
+
+			std::memcpy(m_mem.get() + mapped, data + sect.offset + mapped, sect.size - mapped);
+		}
+
+		// function names
+		else if(sect.type == BinSectionType::SYMBOLS)
+		{
+			const t_byte *ptr = data + sect.offset;
+			const t_byte *end = ptr + sect.size;
+
+			while(ptr + 3*m_addrsize <= end)
+			{
+				t_addr addr, num_args, len;
+				std::memcpy(&addr, ptr, m_addrsize);
+				std::memcpy(&num_args, ptr + m_addrsize, m_addrsize);
+				std::memcpy(&len, ptr + 2*m_addrsize, m_addrsize);
+				ptr += 3*m_addrsize;
+
+				if(len < 0 || ptr + len > end)
+					throw std::runtime_error("Invalid symbol table.");
+
+				m_funcnames.emplace(addr, t_str(
+					reinterpret_cast<const t_char*>(ptr), len));
+				ptr += len;
+			}
+		}
+
+		// functions without side effects
+		else if(sect.type == BinSectionType::PURE)
+		{
+			const t_byte *ptr = data + sect.offset;
+			const t_byte *end = ptr + sect.size;
+
+			while(ptr + 2*m_addrsize <= end)
+			{
+				t_addr addr, num_args;
+				std::memcpy(&addr, ptr, m_addrsize);
+				std::memcpy(&num_args, ptr + m_addrsize, m_addrsize);
+				ptr += 2*m_addrsize;
+
+				if(num_args < 0)
+					throw std::runtime_error("Invalid pure function table.");
+
+				m_memo_funcs[addr].num_args = num_args;
+			}
+		}
+
+		// source lines
+		else if(sect.type == BinSectionType::LINES)
+		{
+			const t_byte *ptr = data + sect.offset;
+			const t_byte *end = ptr + sect.size;
+
+			while(ptr + 2*m_addrsize <= end)
+			{
+				t_addr addr, line;
+				std::memcpy(&addr, ptr, m_addrsize);
+				std::memcpy(&line, ptr + m_addrsize, m_addrsize);
+				ptr += 2*m_addrsize;
+
+				m_lines.emplace(addr, line);
+			}
+		}
+	}
+
+	if(region)
+		load_region(*region);
+
+	m_ip = m_entry = static_cast<t_addr>(hdr.entry);
+
+	// continue where the snapshot was taken
+	if(state)
+	{
+		m_entry = static_cast<t_addr>(state->entry);
+		m_sp = static_cast<t_addr>(state->sp);
+		m_bp = static_cast<t_addr>(state->bp);
+		for(int i=0; i<2; ++i)
+		{
+			m_code_range[i] = static_cast<t_addr>(state->code_range[i]);
+			m_prog_range[i] = static_cast<t_addr>(state->prog_range[i]);
+		}
+		m_stack_limit = static_cast<t_addr>(state->stack_limit);
+
+		m_eps = state->eps;
+		m_prec = state->prec;
+		std::cout.precision(m_prec);
+
+		for(t_addr irq=0; irq<m_num_interrupts; ++irq)
+		{
+			if(state->isrs[irq] >= 0)
+				m_isrs[irq] = static_cast<t_addr>(state->isrs[irq]);
+			else
+				m_isrs[irq] = std::nullopt;
+		}
+
+		if(state->timer_ticks >= 0)
+		{
+			m_timer_ticks = std::chrono::milliseconds{state->timer_ticks};
+			StartTimer();
+		}
+	}
+
+	TranslateIR();
+	InitMemo();
+	return true;
+}
+
+
+/**
+ * get the name of the function containing the given code address
+ */
+std::optional<VM::t_str> VM::GetFunctionName(t_addr addr) const
+{
+	auto iter = m_funcnames.upper_bound(addr);
+	if(iter == m_funcnames.begin())
+		return std::nullopt;
+
+	return std::prev(iter)->second;
+}
+
+
+/**
+ * get the source line of the statement at the given code address
+ */
+std::optional<VM::t_addr> VM::GetSourceLine(t_addr addr) const
+{
+	auto iter = m_lines.upper_bound(addr);
+	if(iter == m_lines.begin())
+		return std::nullopt;
+
+	return std::prev(iter)->second;
+}
+// ----------------------------------------------------------------------------
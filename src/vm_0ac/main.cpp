@@ -11,7 +11,9 @@
 
 #include <vector>
 #include <iostream>
-#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
 
 #if __has_include(<filesystem>)
 	#include <filesystem>
@@ -32,6 +34,19 @@ struct VMOptions
 	bool zero_mem { false };
 	bool enable_memimages { false };
 	bool enable_checks { true };
+	bool verify { false };
+	bool enable_ir { true };
+	bool enable_jit { false };
+	std::uint64_t hot_threshold { 1000 };
+	bool print_stats { false };
+	bool memoise { false };
+	std::vector<std::string> memo_funcs {};
+	std::size_t memo_size { 1024 };
+	std::size_t outbuf_size { 0x10000 };
+	bool async_output { false };
+	std::string checkpoint_file {};
+	std::uint64_t checkpoint_interval { 60000 };
+	std::size_t num_threads { 0 };
 };
 
 
@@ -40,27 +55,67 @@ static bool run_vm(const fs::path& prog, const VMOptions& opts)
 {
 	using namespace m_ops;
 
-	std::size_t filesize = fs::file_size(prog);
-	std::ifstream ifstr(prog, std::ios_base::binary);
-	if(!ifstr)
-		return false;
-
-	std::vector<VM::t_byte> bytes;
-	bytes.resize(filesize);
-
-	ifstr.read(reinterpret_cast<char*>(bytes.data()), filesize);
-	if(ifstr.fail())
-		return false;
-
 	VM vm(opts.mem_size);
-	VM::t_addr sp_initial = vm.GetSP();
 
 	vm.SetDebug(opts.enable_debug);
 	vm.SetChecks(opts.enable_checks);
 	vm.SetZeroPoppedVals(opts.zero_mem);
 	vm.SetDrawMemImages(opts.enable_memimages);
-	vm.SetMem(0, bytes.data(), filesize, true);
-	vm.Run();
+	vm.SetUseIR(opts.enable_ir);
+	vm.SetUseJIT(opts.enable_jit);
+	vm.SetHotThreshold(opts.hot_threshold);
+	vm.SetMemoise(opts.memoise);
+	vm.SetMemoSize(opts.memo_size);
+	for(const std::string& func : opts.memo_funcs)
+		vm.SetMemoiseFunction(func);
+	vm.SetOutputBuffer(opts.outbuf_size);
+	vm.SetAsyncOutput(opts.async_output);
+	vm.SetNumThreads(opts.num_threads);
+	if(!vm.Load(prog.string()))
+		return false;
+	// a resumed snapshot already has data on the stack
+	VM::t_addr sp_initial = vm.GetStackBase();
+	vm.SetCheckpoint(opts.checkpoint_file,
+		std::chrono::milliseconds{opts.checkpoint_interval});
+	// native code needs the guarantees of the verifier
+	if(opts.verify)
+	{
+		vm.Verify();
+	}
+	else if(opts.enable_jit)
+	{
+		// without an explicit --verify the program is still
+		// interpreted if it cannot be verified
+		try
+		{
+			vm.Verify();
+		}
+		catch(const std::exception& err)
+		{
+			std::cerr << "Warning: " << err.what()
+				<< " Native code is disabled." << std::endl;
+		}
+	}
+
+	try
+	{
+		vm.Run();
+	}
+	catch(const std::exception& err)
+	{
+		// add the position in the source code to the error message
+		std::ostringstream msg;
+		msg << err.what();
+		if(auto func = vm.GetFunctionName(vm.GetIP()); func)
+			msg << " In function \"" << *func << "\"";
+		if(auto line = vm.GetSourceLine(vm.GetIP()); line)
+			msg << " near line " << *line;
+		msg << " (ip = " << vm.GetIP() << ").";
+		throw std::runtime_error(msg.str());
+	}
+
+	if(opts.print_stats)
+		vm.PrintStats(std::cerr);
 
 	// print remaining stack
 	std::size_t stack_idx = 0;
@@ -104,7 +159,24 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 			.zero_mem = false,
 			.enable_memimages = false,
 			.enable_checks = true,
+			.verify = false,
+			.enable_ir = true,
+			.enable_jit = false,
+			.hot_threshold = 1000,
+			.print_stats = false,
+			.memoise = false,
+			.memo_funcs = {},
+			.memo_size = 1024,
+			.outbuf_size = 0x10000,
+			.async_output = false,
+			.checkpoint_file = "",
+			.checkpoint_interval = 60000,
+			.num_threads = 0,
 		};
+
+		// default number of threads from the environment, as for compiled programs
+		if(const char* threads = std::getenv("MCALC_THREADS"); threads)
+			vmopts.num_threads = static_cast<std::size_t>(std::max(std::atol(threads), 0l));
 		bool enable_timer = false;
 
 		args::options_description arg_descr("Virtual machine arguments");
@@ -116,8 +188,21 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 			("memimages,i", args::bool_switch(&vmopts.enable_memimages), "write memory images")
 #endif
 			("checks,c", args::value<bool>(&vmopts.enable_checks), "enable memory checks")
+			("verify,v", args::bool_switch(&vmopts.verify), "verify the program and skip redundant runtime checks")
+			("ir,r", args::value<bool>(&vmopts.enable_ir), "translate the code into a register-based ir")
+			("jit", args::bool_switch(&vmopts.enable_jit), "compile functions to native code if the program can be verified")
+			("hot", args::value<decltype(vmopts.hot_threshold)>(&vmopts.hot_threshold), "number of calls and loop iterations after which a function is compiled")
+			("stats,s", args::bool_switch(&vmopts.print_stats), "print function call counts and execution tiers")
+			("memo", args::bool_switch(&vmopts.memoise), "cache the results of all pure functions")
+			("memo-func", args::value<decltype(vmopts.memo_funcs)>(&vmopts.memo_funcs), "cache the results of the given pure function")
+			("memo-size", args::value<decltype(vmopts.memo_size)>(&vmopts.memo_size), "maximum number of cached results per function")
+			("outbuf", args::value<decltype(vmopts.outbuf_size)>(&vmopts.outbuf_size), "size of the output buffer in bytes, 0: unbuffered")
+			("async-output", args::bool_switch(&vmopts.async_output), "write the output in a separate thread")
+			("checkpoint", args::value<decltype(vmopts.checkpoint_file)>(&vmopts.checkpoint_file), "periodically save the vm state to the given file, it can be resumed like a program")
+			("checkpoint-interval", args::value<decltype(vmopts.checkpoint_interval)>(&vmopts.checkpoint_interval), "time between the checkpoints in ms")
+			("threads,j", args::value<decltype(vmopts.num_threads)>(&vmopts.num_threads), "number of threads for parallel loops and large array operations, 0: number of cores")
 			("mem,m", args::value<decltype(vmopts.mem_size)>(&vmopts.mem_size), "set memory size")
-			("prog", args::value<decltype(progs)>(&progs), "input program to run");
+			("prog", args::value<decltype(progs)>(&progs), "input program or snapshot to run");
 
 		args::positional_options_description posarg_descr;
 		posarg_descr.add("prog", -1);
@@ -0,0 +1,107 @@
+/**
+ * read-only, memory-mapped files
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#ifndef __0ACVM_MAPFILE_H__
+#define __0ACVM_MAPFILE_H__
+
+#include "vm.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>) && __has_include(<fcntl.h>)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#include <fcntl.h>
+
+	#define __VM_USE_MMAP__
+#endif
+
+
+/**
+ * read-only view of a file, memory-mapped if possible
+ */
+class MappedFile
+{
+public:
+	MappedFile(const std::string& filename)
+	{
+#ifdef __VM_USE_MMAP__
+		m_fd = ::open(filename.c_str(), O_RDONLY);
+		if(m_fd < 0)
+			return;
+
+		struct stat st{};
+		if(::fstat(m_fd, &st) != 0)
+			return;
+		m_size = static_cast<std::size_t>(st.st_size);
+
+		if(m_size)
+		{
+			void *mem = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+			if(mem != MAP_FAILED)
+			{
+				m_data = reinterpret_cast<const VM::t_byte*>(mem);
+				m_mapped = true;
+				return;
+			}
+		}
+#endif
+
+		// fall back to reading the file
+		std::ifstream ifstr(filename, std::ios_base::binary | std::ios_base::ate);
+		if(!ifstr)
+			return;
+
+		m_size = static_cast<std::size_t>(ifstr.tellg());
+		ifstr.seekg(0, std::ios_base::beg);
+
+		m_bytes.resize(m_size);
+		ifstr.read(reinterpret_cast<char*>(m_bytes.data()), m_size);
+		if(ifstr.fail())
+			return;
+		m_data = m_bytes.data();
+	}
+
+
+	~MappedFile()
+	{
+#ifdef __VM_USE_MMAP__
+		if(m_mapped)
+			::munmap(const_cast<VM::t_byte*>(m_data), m_size);
+		if(m_fd >= 0)
+			::close(m_fd);
+#endif
+	}
+
+
+	MappedFile(const MappedFile&) = delete;
+	const MappedFile& operator=(const MappedFile&) = delete;
+
+
+	bool IsOk() const { return m_data != nullptr || (m_size == 0 && m_fd >= 0); }
+	bool IsMapped() const { return m_mapped; }
+
+	const VM::t_byte* GetData() const { return m_data; }
+	std::size_t GetSize() const { return m_size; }
+	int GetFd() const { return m_fd; }
+
+
+private:
+	int m_fd{-1};
+	bool m_mapped{false};
+
+	const VM::t_byte *m_data{nullptr};
+	std::size_t m_size{0};
+
+	std::vector<VM::t_byte> m_bytes{};
+};
+
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * zero-address code vm, result caches of pure functions
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "vm.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+
+/**
+ * enable the result caches of the requested pure functions
+ */
+void VM::InitMemo()
+{
+	m_memo_calls.clear();
+	m_memo_active = false;
+
+	for(auto& [addr, func] : m_memo_funcs)
+	{
+		func.enabled = m_memo_all;
+
+		if(auto iter = m_funcnames.find(addr); iter != m_funcnames.end() &&
+			std::find(m_memo_names.begin(), m_memo_names.end(), iter->second) != m_memo_names.end())
+			func.enabled = true;
+
+		if(func.enabled)
+			m_memo_active = true;
+	}
+
+	// warn about requested functions that cannot be cached
+	for(const t_str& name : m_memo_names)
+	{
+		bool found = false;
+		for(const auto& [addr, func] : m_memo_funcs)
+		{
+			if(auto iter = m_funcnames.find(addr); iter != m_funcnames.end() && iter->second == name)
+			{
+				found = true;
+				break;
+			}
+		}
+
+		if(!found)
+		{
+			std::cerr << "Warning: Function \"" << name
+				<< "\" is unknown or not pure, its results are not cached."
+				<< std::endl;
+		}
+	}
+}
+
+
+/**
+ * invalidate all cached results, e.g. if the comparison epsilon changes
+ */
+void VM::ClearMemo()
+{
+	for(auto& [addr, func] : m_memo_funcs)
+	{
+		func.results.clear();
+		func.order.clear();
+	}
+}
+
+
+/**
+ * get the size of the typed value at the given address
+ */
+VM::t_addr VM::GetMemDataSize(t_addr addr)
+{
+	switch(ReadMemType(addr))
+	{
+		case VMType::REAL:
+			return m_bytesize + m_realsize;
+		case VMType::INT:
+			return m_bytesize + m_intsize;
+		case VMType::BOOLEAN:
+			return m_bytesize + m_boolsize;
+		case VMType::ADDR_MEM:
+		case VMType::ADDR_IP:
+		case VMType::ADDR_SP:
+		case VMType::ADDR_BP:
+			return m_bytesize + m_addrsize;
+		case VMType::STR:
+			return m_bytesize + m_addrsize +
+				ReadMemRaw<t_addr>(addr + m_bytesize)*m_charsize;
+		case VMType::VEC:
+			return m_bytesize + m_addrsize +
+				ReadMemRaw<t_addr>(addr + m_bytesize)*m_realsize;
+		case VMType::MAT:
+			return m_bytesize + 2*m_addrsize +
+				ReadMemRaw<t_addr>(addr + m_bytesize) *
+				ReadMemRaw<t_addr>(addr + m_bytesize + m_addrsize) *
+				m_realsize;
+		default:
+			throw std::runtime_error("Cannot determine the size of a function argument.");
+	}
+}
+
+
+/**
+ * look up the arguments on the stack in the cache of the called function,
+ * on a hit the arguments are replaced by the cached return values
+ */
+bool VM::MemoLookup(t_addr funcaddr, MemoCall& call)
+{
+	auto func_iter = m_memo_funcs.find(funcaddr);
+	if(func_iter == m_memo_funcs.end() || !func_iter->second.enabled)
+		return false;
+	MemoFunction& func = func_iter->second;
+
+	// the raw bytes of the arguments form the key
+	t_addr args_end = m_sp;
+	for(t_addr arg=0; arg<func.num_args; ++arg)
+		args_end += GetMemDataSize(args_end);
+	CheckMemoryBounds(m_sp, args_end - m_sp);
+
+	std::string key(reinterpret_cast<const char*>(m_mem.get() + m_sp),
+		static_cast<std::size_t>(args_end - m_sp));
+
+	auto result_iter = func.results.find(key);
+	if(result_iter == func.results.end())
+	{
+		// remember the call to cache its result on return
+		++func.num_misses;
+		call.func = &func;
+		call.key = std::move(key);
+		call.args_end = args_end;
+		return false;
+	}
+
+	++func.num_hits;
+	const std::string& result = result_iter->second;
+
+	// replace the arguments with the return values
+	m_sp = args_end - static_cast<t_addr>(result.size());
+	if(m_verified)
+		CheckStackBounds();
+	CheckMemoryBounds(m_sp, static_cast<t_addr>(result.size()), true);
+	std::memcpy(m_mem.get() + m_sp, result.data(), result.size());
+
+	if(m_debug)
+	{
+		std::cout << "using cached result of function "
+			<< funcaddr;
+		if(auto name = GetFunctionName(funcaddr); name)
+			std::cout << " (" << *name << ")";
+		std::cout << "." << std::endl;
+	}
+
+	return true;
+}
+
+
+/**
+ * cache the return values of a pure function
+ */
+void VM::MemoStore(const MemoCall& call)
+{
+	if(m_memo_size == 0)
+		return;
+	MemoFunction& func = *call.func;
+
+	// evict the oldest result if the cache is full
+	if(func.results.size() >= m_memo_size && !func.order.empty())
+	{
+		func.results.erase(func.order.front());
+		func.order.pop_front();
+	}
+
+	std::string result(reinterpret_cast<const char*>(m_mem.get() + m_sp),
+		static_cast<std::size_t>(call.args_end - m_sp));
+
+	if(func.results.emplace(call.key, std::move(result)).second)
+		func.order.push_back(call.key);
+}
+
+
+/**
+ * print the usage of the result caches
+ */
+void VM::PrintMemoStats(std::ostream& ostr) const
+{
+	if(!m_memo_active)
+		return;
+
+	ostr << "\nCached function results:\n";
+	ostr << std::left << std::setw(24) << "function" << " "
+		<< std::right << std::setw(12) << "hits" << " "
+		<< std::setw(12) << "misses" << " "
+		<< std::setw(12) << "entries" << "\n";
+
+	for(const auto& [addr, func] : m_memo_funcs)
+	{
+		if(!func.enabled)
+			continue;
+
+		std::string name;
+		if(auto iter = m_funcnames.find(addr); iter != m_funcnames.end())
+			name = iter->second;
+		else
+			name = "<" + std::to_string(addr) + ">";
+
+		ostr << std::left << std::setw(24) << name << " "
+			<< std::right << std::setw(12) << func.num_hits << " "
+			<< std::setw(12) << func.num_misses << " "
+			<< std::setw(12) << func.results.size() << "\n";
+	}
+}
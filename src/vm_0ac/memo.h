@@ -0,0 +1,56 @@
+/**
+ * result caches of pure functions
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * The compiler marks the functions that do not (directly or indirectly)
+ * call an external function with side effects. The results of such
+ * functions only depend on their arguments, so the vm can cache them
+ * keyed by the raw bytes of the arguments on the stack. A cache hit
+ * skips the call and pushes the cached raw bytes of the return values.
+ */
+
+#ifndef __0ACVM_MEMO_H__
+#define __0ACVM_MEMO_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <unordered_map>
+
+#include "types.h"
+
+
+/**
+ * cached results of a pure function
+ */
+struct MemoFunction
+{
+	t_vm_addr num_args{};
+	bool enabled{false};            // results are cached
+
+	// raw argument bytes -> raw return value bytes
+	std::unordered_map<std::string, std::string> results{};
+	std::deque<std::string> order{};  // insertion order for eviction
+
+	std::uint64_t num_hits{0};
+	std::uint64_t num_misses{0};
+};
+
+
+/**
+ * running call of a pure function whose result is not yet cached
+ */
+struct MemoCall
+{
+	MemoFunction* func{nullptr};
+	std::string key{};              // raw argument bytes
+
+	t_vm_addr bp{};                 // base pointer of the function's frame
+	t_vm_addr args_end{};           // stack address above the arguments
+};
+
+
+#endif
@@ -10,6 +10,9 @@
 
 #include "types.h"
 
+#include <algorithm>
+#include <optional>
+#include <utility>
 
 
 enum class OpCode : t_vm_byte
@@ -22,6 +25,12 @@ enum class OpCode : t_vm_byte
 	PUSH     = 0x10,  // push direct data
 	WRMEM    = 0x11,  // write memory
 	RDMEM    = 0x12,  // read memory
+	ADDMEM   = 0x13,  // in-place += on memory
+	SUBMEM   = 0x14,  // in-place -= on memory
+	MULMEM   = 0x15,  // in-place *= on memory
+	DIVMEM   = 0x16,  // in-place /= on memory
+	FUSEDMEM = 0x17,  // fused element-wise expression written to memory
+	POP      = 0x18,  // discard the data on top of the stack
 
 	// arithmetic operations
 	USUB     = 0x20,  // unary -
@@ -31,6 +40,9 @@ enum class OpCode : t_vm_byte
 	DIV      = 0x24,  // /
 	MOD      = 0x25,  // %
 	POW      = 0x26,  // ^
+	EMUL     = 0x27,  // .*
+	EDIV     = 0x28,  // ./
+	FUSED    = 0x29,  // fused element-wise expression
 
 	// conversions
 	TOI      = 0x30,  // cast to int
@@ -42,6 +54,7 @@ enum class OpCode : t_vm_byte
 	// jumps
 	JMP      = 0x40,  // unconditional jump
 	JMPCND   = 0x41,  // conditional jump
+	PARLOOP  = 0x42,  // run the following loop body in parallel
 
 	// logical operations
 	AND      = 0x50,  // &&
@@ -61,6 +74,7 @@ enum class OpCode : t_vm_byte
 	CALL     = 0x70,  // call function
 	RET      = 0x71,  // return from function
 	EXTCALL  = 0x72,  // call system function
+	MAP      = 0x73,  // call function for each array element
 
 	// binary operations
 	BINAND   = 0x80,  // &
@@ -104,6 +118,12 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 		case OpCode::PUSH:      return "push";
 		case OpCode::WRMEM:     return "wrmem";
 		case OpCode::RDMEM:     return "rdmem";
+		case OpCode::ADDMEM:    return "addmem";
+		case OpCode::SUBMEM:    return "submem";
+		case OpCode::MULMEM:    return "mulmem";
+		case OpCode::DIVMEM:    return "divmem";
+		case OpCode::FUSEDMEM:  return "fusedmem";
+		case OpCode::POP:       return "pop";
 		case OpCode::USUB:      return "usub";
 		case OpCode::ADD:       return "add";
 		case OpCode::SUB:       return "sub";
@@ -111,6 +131,9 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 		case OpCode::DIV:       return "div";
 		case OpCode::MOD:       return "mod";
 		case OpCode::POW:       return "pow";
+		case OpCode::EMUL:      return "emul";
+		case OpCode::EDIV:      return "ediv";
+		case OpCode::FUSED:     return "fused";
 		case OpCode::TOI:       return "toi";
 		case OpCode::TOF:       return "tof";
 		case OpCode::TOS:       return "tos";
@@ -118,6 +141,7 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 		case OpCode::TOM:       return "tom";
 		case OpCode::JMP:       return "jmp";
 		case OpCode::JMPCND:    return "jmpcnd";
+		case OpCode::PARLOOP:   return "parloop";
 		case OpCode::AND:       return "and";
 		case OpCode::OR:        return "or";
 		case OpCode::XOR:       return "xor";
@@ -131,6 +155,7 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 		case OpCode::CALL:      return "call";
 		case OpCode::RET:       return "ret";
 		case OpCode::EXTCALL:   return "extcall";
+		case OpCode::MAP:       return "map";
 		case OpCode::BINAND:    return "binand";
 		case OpCode::BINOR:     return "binor";
 		case OpCode::BINXOR:    return "binxor";
@@ -154,4 +179,62 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 }
 
 
+/**
+ * instructions of the postfix program of a FUSED or FUSEDMEM operation,
+ * the program is a string constant on top of the operands, for FUSEDMEM
+ * the address of the variable receiving the result lies in between,
+ * array operands are either values or addresses of variables read in place
+ */
+enum class FusedOp : t_vm_byte
+{
+	LOAD     = 'x',   // push the next operand
+	NEG      = '~',   // unary -
+	ADD      = '+',   // +
+	SUB      = '-',   // -
+	MUL      = '*',   // element-wise *
+	DIV      = '/',   // element-wise /
+};
+
+
+/**
+ * checks the program of a FUSED operation
+ * @returns [ number of operands, maximum depth of the evaluation stack ]
+ */
+template<class t_str>
+std::optional<std::pair<std::size_t, std::size_t>> check_fused_prog(const t_str& prog)
+{
+	std::size_t num_operands = 0;
+	std::size_t depth = 0, max_depth = 0;
+
+	for(auto ch : prog)
+	{
+		switch(static_cast<FusedOp>(ch))
+		{
+			case FusedOp::LOAD:
+				++num_operands;
+				max_depth = std::max(max_depth, ++depth);
+				break;
+			case FusedOp::NEG:
+				if(depth < 1)
+					return std::nullopt;
+				break;
+			case FusedOp::ADD: case FusedOp::SUB:
+			case FusedOp::MUL: case FusedOp::DIV:
+				if(depth < 2)
+					return std::nullopt;
+				--depth;
+				break;
+			default:
+				return std::nullopt;
+		}
+	}
+
+	// the program has to leave exactly one result
+	if(depth != 1)
+		return std::nullopt;
+
+	return std::make_pair(num_operands, max_depth);
+}
+
+
 #endif
@@ -0,0 +1,154 @@
+/**
+ * buffered output of the vm
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "output.h"
+
+
+OutputBuffer::OutputBuffer(std::ostream* ostr, std::size_t size)
+	: m_ostr{ostr}, m_size{size}
+{
+	m_buf.reserve(m_size);
+}
+
+
+OutputBuffer::~OutputBuffer()
+{
+	SetAsync(false);
+	Flush();
+}
+
+
+/**
+ * buffer size, 0: write every string directly
+ */
+void OutputBuffer::SetSize(std::size_t size)
+{
+	Flush();
+
+	std::lock_guard<std::mutex> lock{m_mtx};
+	m_size = size;
+	m_buf.reserve(m_size);
+}
+
+
+/**
+ * write full buffers in a separate thread
+ */
+void OutputBuffer::SetAsync(bool async)
+{
+	if(async == m_async)
+		return;
+
+	// write the remaining output before switching
+	Flush();
+
+	if(async)
+	{
+		m_quit = false;
+		m_async = true;
+		m_writer = std::thread(&OutputBuffer::WriterFunc, this);
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock{m_mtx};
+			m_quit = true;
+		}
+		m_ready.notify_all();
+
+		if(m_writer.joinable())
+			m_writer.join();
+		m_async = false;
+	}
+}
+
+
+/**
+ * append a string, optionally followed by a new line
+ */
+void OutputBuffer::Put(const std::string& str, bool newline)
+{
+	std::unique_lock<std::mutex> lock{m_mtx};
+
+	m_buf += str;
+	if(newline)
+		m_buf += '\n';
+
+	if(m_buf.size() >= m_size)
+		Write(lock, m_size == 0);
+}
+
+
+/**
+ * write the buffered output
+ */
+void OutputBuffer::Flush()
+{
+	std::unique_lock<std::mutex> lock{m_mtx};
+	Write(lock, true);
+}
+
+
+/**
+ * write the buffer or hand it over to the writer thread
+ */
+void OutputBuffer::Write(std::unique_lock<std::mutex>& lock, bool flush)
+{
+	if(m_async)
+	{
+		// wait until the previous buffer has been written
+		m_written.wait(lock, [this]() -> bool { return !m_writing && m_pending.empty(); });
+
+		if(m_buf.size())
+		{
+			std::swap(m_buf, m_pending);
+			m_ready.notify_one();
+		}
+
+		if(flush)
+			m_written.wait(lock, [this]() -> bool { return !m_writing && m_pending.empty(); });
+	}
+	else
+	{
+		if(m_buf.size())
+		{
+			m_ostr->write(m_buf.data(), static_cast<std::streamsize>(m_buf.size()));
+			m_buf.clear();
+		}
+
+		if(flush)
+			m_ostr->flush();
+	}
+}
+
+
+/**
+ * function for writer thread
+ */
+void OutputBuffer::WriterFunc()
+{
+	std::unique_lock<std::mutex> lock{m_mtx};
+
+	while(true)
+	{
+		m_ready.wait(lock, [this]() -> bool { return m_quit || m_pending.size(); });
+		if(m_pending.empty())
+			break;
+
+		// write without blocking the program
+		m_writing = true;
+		lock.unlock();
+
+		m_ostr->write(m_pending.data(), static_cast<std::streamsize>(m_pending.size()));
+		m_ostr->flush();
+
+		lock.lock();
+		m_pending.clear();
+		m_writing = false;
+		m_written.notify_all();
+	}
+}
@@ -0,0 +1,67 @@
+/**
+ * buffered output of the vm
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * The output is collected in a buffer which is written when it is full or
+ * when it is flushed. Optionally a writer thread takes over full buffers,
+ * so that the program can continue while the previous buffer is written.
+ */
+
+#ifndef __0ACVM_OUTPUT_H__
+#define __0ACVM_OUTPUT_H__
+
+#include <cstddef>
+#include <string>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+class OutputBuffer
+{
+public:
+	OutputBuffer(std::ostream* ostr = &std::cout, std::size_t size = 0x10000);
+	~OutputBuffer();
+
+	OutputBuffer(const OutputBuffer&) = delete;
+	const OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	// buffer size, 0: write every string directly
+	void SetSize(std::size_t size);
+
+	// write full buffers in a separate thread
+	void SetAsync(bool async);
+
+	// append a string, optionally followed by a new line
+	void Put(const std::string& str, bool newline = false);
+
+	// write the buffered output
+	void Flush();
+
+
+private:
+	void Write(std::unique_lock<std::mutex>& lock, bool flush);
+	void WriterFunc();
+
+
+private:
+	std::ostream* m_ostr{&std::cout};
+	std::size_t m_size{0x10000};
+
+	std::mutex m_mtx{};
+	std::string m_buf{};               // output being collected
+
+	// writer thread
+	bool m_async{false};
+	bool m_quit{false};
+	bool m_writing{false};             // the writer is busy with m_pending
+	std::string m_pending{};           // output being written by the thread
+	std::condition_variable m_ready{}, m_written{};
+	std::thread m_writer{};
+};
+
+
+#endif
@@ -0,0 +1,253 @@
+/**
+ * zero-address code vm, parallel loops
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * The iterations of a parallel loop are distributed on the thread pool.
+ * Every thread runs the loop body in its own worker vm, which shares the
+ * memory with the main vm, but has a private stack below the main stack.
+ * The loop variable, the variables declared in the loop body and the
+ * accumulators are also private to each worker, the accumulators are
+ * added to the shared variables when all iterations have finished.
+ * Nested parallel loops run sequentially in the worker, with a private
+ * loop variable.
+ */
+
+#include "vm.h"
+
+#include <algorithm>
+
+
+/**
+ * create a worker for a parallel loop sharing the memory of its parent
+ */
+VM::VM(const VM& parent, t_addr sp, t_addr stack_limit)
+	: m_checks{parent.m_checks}, m_verified{parent.m_verified},
+		m_zeropoppedvals{parent.m_zeropoppedvals},
+		m_eps{parent.m_eps}, m_prec{parent.m_prec},
+		m_output{parent.m_output},
+		m_factors{parent.m_factors},
+		m_mem{parent.m_mem.get(), MemDeleter{parent.m_mem.get_deleter().size, true}},
+		m_stack_limit{stack_limit},
+		m_use_ir{false},
+		m_par_worker{true}, m_par_bp{parent.m_bp},
+		m_sp{sp}, m_bp{parent.m_bp},
+		m_memsize{parent.m_memsize}
+{
+	for(int i=0; i<2; ++i)
+	{
+		m_code_range[i] = parent.m_code_range[i];
+		m_rom_range[i] = parent.m_rom_range[i];
+		m_prog_range[i] = parent.m_prog_range[i];
+	}
+}
+
+
+/**
+ * is the address in one of the worker's private copies of the variables?
+ */
+bool VM::IsParPrivate(t_addr addr) const
+{
+	for(const ParPrivate& priv : m_par_privs)
+	{
+		if(addr >= priv.target && addr < priv.target + (priv.end - priv.begin))
+			return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * run one iteration of a parallel loop's body
+ */
+void VM::RunParBody(t_addr begin, t_addr end)
+{
+	bool running = true;
+	m_ip = begin;
+
+	while(m_ip != end)
+	{
+		// the workers' stacks lie next to each other
+		CheckStackBounds();
+		if(!m_verified)
+			CheckPointerBounds();
+
+		OpCode op = static_cast<OpCode>(m_mem[m_ip++]);
+		if(!Exec(op, running))
+			throw std::runtime_error("Invalid instruction in parallel loop.");
+		if(!running)
+			throw std::runtime_error("Program halted in parallel loop.");
+	}
+}
+
+
+/**
+ * parallel loop over the code up to body_end
+ *
+ * stack layout:
+ *	begin and end of the (inclusive) iteration range,
+ *	address and size of the variables declared in the loop body,
+ *	accumulator addresses and their number,
+ *	address of the loop variable
+ */
+void VM::OpParLoop(t_addr body_end)
+{
+	const t_addr body_begin = m_ip;
+
+	t_addr loopvar = PopAddress();
+	t_int num_accs = std::get<m_intidx>(PopData());
+	std::vector<t_addr> accs;
+	accs.reserve(num_accs);
+	for(t_int acc=0; acc<num_accs; ++acc)
+		accs.push_back(PopAddress());
+
+	t_int block_size = std::get<m_intidx>(PopData());
+	t_addr block = PopAddress();
+
+	t_int end = std::get<m_intidx>(PopData());
+	t_int begin = std::get<m_intidx>(PopData());
+
+	// size of a worker's private variables
+	const t_addr loopvar_size = m_bytesize + m_intsize;
+	t_addr privs_size = block_size + loopvar_size;
+	for(t_addr acc : accs)
+		privs_size += GetMemDataSize(acc);
+
+	// lowest address usable for the workers' stacks
+	const t_addr stack_begin = std::max({ m_stack_limit,
+		m_code_range[1], m_prog_range[1], t_addr(0) });
+
+	std::size_t num_workers = 1;
+	if(!m_par_worker && end > begin && m_sp > stack_begin)
+	{
+		num_workers = std::min<std::size_t>({ GetPool()->GetNumThreads(),
+			static_cast<std::size_t>(end - begin + 1),
+			static_cast<std::size_t>((m_sp - stack_begin) / (privs_size + m_par_stack_size)) });
+	}
+
+	// run the loop sequentially in a worker or if there is only one thread
+	if(num_workers <= 1)
+	{
+		// a nested loop's variable declared outside the enclosing parallel
+		// loop would be shared by all workers, give it a slot on the worker's stack
+		const t_addr sp_before = m_sp;
+		t_addr loopvar_priv = loopvar;
+		if(m_par_worker && m_bp == m_par_bp && !IsParPrivate(loopvar))
+		{
+			m_sp -= loopvar_size;
+			CheckStackBounds();
+			loopvar_priv = m_sp;
+			m_par_privs.emplace_back(ParPrivate{ loopvar, loopvar + loopvar_size, loopvar_priv });
+		}
+
+		for(t_int idx=begin; idx<=end; ++idx)
+		{
+			WriteMemData(loopvar_priv, t_data{std::in_place_index<m_intidx>, idx});
+			RunParBody(body_begin, body_end);
+		}
+
+		if(loopvar_priv != loopvar)
+		{
+			m_par_privs.pop_back();
+			m_sp = sp_before;
+		}
+
+		m_ip = body_end;
+		return;
+	}
+
+	// set up the workers and their private variables
+	const t_addr slice = (m_sp - stack_begin) / static_cast<t_addr>(num_workers);
+	std::vector<std::unique_ptr<VM>> workers;
+	std::vector<t_addr> loopvars, acc_privs;
+	workers.reserve(num_workers);
+	loopvars.reserve(num_workers);
+
+	for(std::size_t worker_idx=0; worker_idx<num_workers; ++worker_idx)
+	{
+		t_addr top = m_sp - static_cast<t_addr>(worker_idx)*slice;
+		t_addr priv = top - privs_size;
+
+		std::unique_ptr<VM> worker{new VM(*this, priv, top - slice)};
+
+		// accumulators start at zero
+		for(t_addr acc : accs)
+		{
+			t_addr size = GetMemDataSize(acc);
+			t_data val = std::get<1>(ReadMemData(acc));
+
+			switch(val.index())
+			{
+				case m_realidx:
+					val = t_data{std::in_place_index<m_realidx>, t_real(0)};
+					break;
+				case m_intidx:
+					val = t_data{std::in_place_index<m_intidx>, t_int(0)};
+					break;
+				case m_vecidx:
+					val = t_data{std::in_place_index<m_vecidx>,
+						m::zero<t_vec>(std::get<m_vecidx>(val).size())};
+					break;
+				case m_matidx:
+					val = t_data{std::in_place_index<m_matidx>,
+						m::zero<t_mat>(std::get<m_matidx>(val).size1(),
+							std::get<m_matidx>(val).size2())};
+					break;
+				default:
+					throw std::runtime_error("Invalid accumulator type in parallel loop.");
+			}
+
+			WriteMemData(priv, val);
+			worker->m_par_privs.emplace_back(ParPrivate{ acc, acc + size, priv });
+			acc_privs.push_back(priv);
+			priv += size;
+		}
+
+		// loop variable
+		worker->m_par_privs.emplace_back(ParPrivate{ loopvar, loopvar + loopvar_size, priv });
+		loopvars.push_back(priv);
+		priv += loopvar_size;
+
+		// variables declared in the loop body
+		if(block_size > 0)
+		{
+			CheckMemoryBounds(block, block_size);
+			CheckMemoryBounds(priv, block_size, true);
+			std::memcpy(m_mem.get() + priv, m_mem.get() + block, block_size*m_bytesize);
+
+			worker->m_par_privs.emplace_back(ParPrivate{ block, block + static_cast<t_addr>(block_size), priv });
+		}
+
+		workers.emplace_back(std::move(worker));
+	}
+
+	// run the iterations
+	m_pool->ParallelFor(begin, end + 1,
+		[&workers, &loopvars, body_begin, body_end](std::size_t thread, t_int chunk_begin, t_int chunk_end)
+	{
+		VM& worker = *workers[thread];
+
+		for(t_int idx=chunk_begin; idx<chunk_end; ++idx)
+		{
+			worker.WriteMemData(loopvars[thread], t_data{std::in_place_index<m_intidx>, idx});
+			worker.RunParBody(body_begin, body_end);
+		}
+	}, num_workers);
+
+	// add the workers' accumulators to the shared variables
+	for(std::size_t worker_idx=0; worker_idx<num_workers; ++worker_idx)
+	{
+		for(std::size_t acc=0; acc<accs.size(); ++acc)
+		{
+			t_data val = std::get<1>(ReadMemData(acc_privs[worker_idx*accs.size() + acc]));
+			t_data sum = std::get<1>(ReadMemData(accs[acc]));
+			WriteMemData(accs[acc], OpArithmetic<'+'>(sum, val));
+		}
+	}
+
+	// the loop variable holds the last index, as after a sequential loop
+	WriteMemData(loopvar, t_data{std::in_place_index<m_intidx>, end});
+	m_ip = body_end;
+}
@@ -0,0 +1,234 @@
+/**
+ * work-stealing thread pool
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "pool.h"
+
+#include <algorithm>
+
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+	: m_num_threads{num_threads}
+{
+	if(m_num_threads == 0)
+		m_num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+	m_ranges = std::make_unique<Range[]>(m_num_threads);
+
+	// the calling thread is thread 0
+	for(std::size_t thread=1; thread<m_num_threads; ++thread)
+		m_threads.emplace_back(&ThreadPool::ThreadFunc, this, thread);
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{m_mtx};
+		m_quit = true;
+	}
+	m_start.notify_all();
+
+	for(std::thread& thread : m_threads)
+		thread.join();
+}
+
+
+/**
+ * run the iterations [begin, end) on at most max_threads threads
+ */
+void ThreadPool::ParallelFor(t_int begin, t_int end, const t_func& func,
+	std::size_t max_threads, t_int grain)
+{
+	if(end <= begin)
+		return;
+
+	const t_int num_iter = end - begin;
+	std::size_t num_threads = m_num_threads;
+	if(max_threads && max_threads < num_threads)
+		num_threads = max_threads;
+	if(static_cast<t_int>(num_threads) > num_iter)
+		num_threads = static_cast<std::size_t>(num_iter);
+
+	if(num_threads <= 1)
+	{
+		func(0, begin, end);
+		return;
+	}
+
+	// several chunks per thread leave some work to steal
+	if(grain <= 0)
+		grain = std::max<t_int>(num_iter / static_cast<t_int>(num_threads * 8), 1);
+
+	// split the range evenly
+	for(std::size_t thread=0; thread<m_num_threads; ++thread)
+	{
+		Range& range = m_ranges[thread];
+		std::lock_guard<std::mutex> lock{range.mtx};
+
+		if(thread < num_threads)
+		{
+			const t_int threads = static_cast<t_int>(num_threads);
+			range.begin = begin + num_iter*static_cast<t_int>(thread) / threads;
+			range.end = begin + num_iter*static_cast<t_int>(thread + 1) / threads;
+		}
+		else
+		{
+			range.begin = range.end = end;
+		}
+	}
+
+	// start the job
+	{
+		std::lock_guard<std::mutex> lock{m_mtx};
+		m_func = &func;
+		m_grain = grain;
+		m_exception = nullptr;
+		m_cancel = false;
+		m_job_threads = num_threads;
+		m_active = num_threads - 1;
+		++m_job;
+	}
+	m_start.notify_all();
+
+	Work(0);
+
+	// wait for the other threads
+	std::exception_ptr exception{};
+	{
+		std::unique_lock<std::mutex> lock{m_mtx};
+		m_done.wait(lock, [this]() -> bool { return m_active == 0; });
+
+		m_func = nullptr;
+		std::swap(exception, m_exception);
+	}
+
+	if(exception)
+		std::rethrow_exception(exception);
+}
+
+
+/**
+ * pool thread waiting for jobs
+ */
+void ThreadPool::ThreadFunc(std::size_t thread)
+{
+	std::uint64_t job = 0;
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock{m_mtx};
+			m_start.wait(lock, [this, job]() -> bool { return m_quit || m_job != job; });
+
+			if(m_quit)
+				break;
+			job = m_job;
+
+			// not needed for this job
+			if(thread >= m_job_threads)
+				continue;
+		}
+
+		Work(thread);
+
+		std::lock_guard<std::mutex> lock{m_mtx};
+		if(--m_active == 0)
+			m_done.notify_all();
+	}
+}
+
+
+/**
+ * run chunks of the thread's own range, then steal from the others
+ */
+void ThreadPool::Work(std::size_t thread)
+{
+	Range& range = m_ranges[thread];
+
+	while(!m_cancel)
+	{
+		t_int begin = 0, end = 0;
+		{
+			std::lock_guard<std::mutex> lock{range.mtx};
+			if(range.begin < range.end)
+			{
+				begin = range.begin;
+				end = std::min(range.end, begin + m_grain);
+				range.begin = end;
+			}
+		}
+
+		if(begin >= end)
+		{
+			if(!Steal(thread))
+				break;
+			continue;
+		}
+
+		try
+		{
+			(*m_func)(thread, begin, end);
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lock{m_mtx};
+			if(!m_exception)
+				m_exception = std::current_exception();
+			m_cancel = true;
+		}
+	}
+}
+
+
+/**
+ * steal the back half of the largest remaining range,
+ * returns false if there is no work left
+ */
+bool ThreadPool::Steal(std::size_t thread)
+{
+	std::size_t victim = thread;
+	t_int most = 0;
+
+	for(std::size_t other=0; other<m_job_threads; ++other)
+	{
+		if(other == thread)
+			continue;
+
+		Range& range = m_ranges[other];
+		std::lock_guard<std::mutex> lock{range.mtx};
+		if(range.end - range.begin > most)
+		{
+			most = range.end - range.begin;
+			victim = other;
+		}
+	}
+
+	if(most <= 0)
+		return false;
+
+	t_int begin = 0, end = 0;
+	{
+		Range& range = m_ranges[victim];
+		std::lock_guard<std::mutex> lock{range.mtx};
+
+		// the victim might have taken the remaining iterations in the meantime
+		t_int remaining = range.end - range.begin;
+		if(remaining <= 0)
+			return true;
+
+		begin = range.end - (remaining + 1)/2;
+		end = range.end;
+		range.end = begin;
+	}
+
+	Range& range = m_ranges[thread];
+	std::lock_guard<std::mutex> lock{range.mtx};
+	range.begin = begin;
+	range.end = end;
+
+	return true;
+}
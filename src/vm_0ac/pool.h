@@ -0,0 +1,112 @@
+/**
+ * work-stealing thread pool
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * The index range of a parallel loop is split evenly between the threads.
+ * Each thread takes chunks from the front of its own range, once it is
+ * exhausted the thread steals the back half of the largest remaining range
+ * of another thread. The calling thread takes part as thread 0.
+ */
+
+#ifndef __0ACVM_POOL_H__
+#define __0ACVM_POOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+#include "types.h"
+
+
+class ThreadPool
+{
+public:
+	using t_int = ::t_vm_int;
+
+	// function running the iterations [begin, end) on the given thread
+	using t_func = std::function<void(std::size_t thread, t_int begin, t_int end)>;
+
+	ThreadPool(std::size_t num_threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	const ThreadPool& operator=(const ThreadPool&) = delete;
+
+	std::size_t GetNumThreads() const { return m_num_threads; }
+
+	// run the iterations [begin, end) on at most max_threads threads,
+	// rethrows the first exception of a thread
+	void ParallelFor(t_int begin, t_int end, const t_func& func,
+		std::size_t max_threads = 0, t_int grain = 0);
+
+
+private:
+	// remaining iterations of a thread
+	struct Range
+	{
+		std::mutex mtx{};
+		t_int begin{}, end{};
+	};
+
+	void ThreadFunc(std::size_t thread);
+	void Work(std::size_t thread);
+	bool Steal(std::size_t thread);
+
+
+private:
+	std::size_t m_num_threads{1};
+	std::vector<std::thread> m_threads{};
+	std::unique_ptr<Range[]> m_ranges{};
+
+	// current job
+	std::mutex m_mtx{};
+	std::condition_variable m_start{}, m_done{};
+	std::uint64_t m_job{0};            // job counter
+	std::size_t m_job_threads{0};      // threads working on the job
+	std::size_t m_active{0};           // pool threads still working
+	t_int m_grain{1};                  // iterations per chunk
+	const t_func* m_func{nullptr};
+	std::exception_ptr m_exception{};
+	std::atomic_bool m_cancel{false};  // stop after an exception
+	bool m_quit{false};
+};
+
+
+// minimum work (elements or multiply-adds) for which the array operations use several threads
+constexpr const std::size_t g_par_min_elems = 1 << 16;
+constexpr const std::size_t g_par_min_flops = 1 << 20;
+
+
+/**
+ * run func(begin, end) on the pool if there is one and the work is large enough,
+ * small operands stay on the calling thread
+ */
+template<class t_func>
+void par_for(ThreadPool* pool, std::size_t work, std::size_t min_work,
+	ThreadPool::t_int begin, ThreadPool::t_int end, t_func&& func)
+{
+	if(pool && work >= min_work && end - begin > 1)
+	{
+		pool->ParallelFor(begin, end,
+			[&func](std::size_t, ThreadPool::t_int begin, ThreadPool::t_int end)
+		{
+			func(begin, end);
+		});
+	}
+	else
+	{
+		func(begin, end);
+	}
+}
+
+
+#endif
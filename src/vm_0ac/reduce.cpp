@@ -0,0 +1,118 @@
+/**
+ * reductions of vectors and matrices
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "vm.h"
+#include "reduce.h"
+
+
+/**
+ * reduce all elements of a vector or matrix,
+ * the arg functions return the (flattened) index
+ */
+VM::t_data VM::Reduce(const t_str& func_name, const t_data& arr)
+{
+	std::optional<ReduceOp> op = get_reduce_op(func_name);
+	if(!op)
+		throw std::runtime_error("Unknown reduction \"" + func_name + "\".");
+
+	const t_real *elems = nullptr;
+	std::size_t num_elems = 0;
+
+	if(arr.index() == m_vecidx)
+	{
+		const t_vec& vec = std::get<m_vecidx>(arr);
+		elems = vec.data();
+		num_elems = vec.size();
+	}
+	else if(arr.index() == m_matidx)
+	{
+		const t_mat& mat = std::get<m_matidx>(arr);
+		elems = mat.data();
+		num_elems = mat.size1() * mat.size2();
+	}
+	else if(arr.index() == m_realidx || arr.index() == m_intidx)
+	{
+		// a scalar is its own reduction
+		if(*op == ReduceOp::ARGMIN || *op == ReduceOp::ARGMAX)
+			return t_data{std::in_place_index<m_intidx>, t_int(0)};
+		if(arr.index() == m_intidx)
+			return t_data{std::in_place_index<m_realidx>, static_cast<t_real>(std::get<m_intidx>(arr))};
+		return arr;
+	}
+	else
+	{
+		throw std::runtime_error("Reduction \"" + func_name + "\" needs a vector or matrix argument.");
+	}
+
+	t_real result = reduce_par<t_real>(*op, elems, num_elems,
+		GetPool(num_elems, g_par_min_elems));
+	if(*op == ReduceOp::ARGMIN || *op == ReduceOp::ARGMAX)
+		return t_data{std::in_place_index<m_intidx>, static_cast<t_int>(result)};
+	return t_data{std::in_place_index<m_realidx>, result};
+}
+
+
+/**
+ * reduce the columns (axis 0) or rows (axis 1) of a matrix into the vector variable at the given address,
+ * returns the number of written elements or -1 if the dimensions do not match
+ */
+VM::t_int VM::ReduceAxis(const t_str& func_name, const t_data& arr, t_int axis, t_addr addr)
+{
+	std::optional<ReduceOp> op = get_reduce_op(func_name, true);
+	if(!op)
+		throw std::runtime_error("Unknown reduction \"" + func_name + "\".");
+	if(arr.index() != m_matidx)
+		throw std::runtime_error("Reduction \"" + func_name + "\" needs a matrix argument.");
+
+	VMType ty = ReadMemType(addr);
+	addr += m_bytesize;
+	if(ty != VMType::VEC)
+		throw std::runtime_error("Reductions along an axis can only be written into vector variables.");
+	const t_addr size = ReadMemRaw<t_addr>(addr);
+	addr += m_addrsize;
+
+	const t_mat& mat = std::get<m_matidx>(arr);
+	const std::size_t rows = mat.size1();
+	const std::size_t cols = mat.size2();
+
+	// reduce along the rows for each column or vice versa
+	std::size_t num_results = 0, num_elems = 0, elem_stride = 0, result_stride = 0;
+	if(axis == 0)
+	{
+		num_results = cols;
+		num_elems = rows;
+		elem_stride = cols;
+		result_stride = 1;
+	}
+	else if(axis == 1)
+	{
+		num_results = rows;
+		num_elems = cols;
+		elem_stride = 1;
+		result_stride = cols;
+	}
+	else
+	{
+		return -1;
+	}
+
+	if(static_cast<std::size_t>(size) != num_results)
+		return -1;
+
+	CheckMemoryBounds(addr, size*m_realsize, true);
+	t_real *dst = reinterpret_cast<t_real*>(m_mem.get() + addr);
+
+	par_for(GetPool(rows*cols, g_par_min_elems), rows*cols, g_par_min_elems,
+		0, static_cast<t_int>(num_results),
+		[&mat, &op, dst, num_elems, elem_stride, result_stride](t_int begin, t_int end)
+	{
+		for(t_int idx=begin; idx<end; ++idx)
+			dst[idx] = reduce<t_real>(*op, mat.data() + idx*result_stride, num_elems, elem_stride);
+	});
+
+	return static_cast<t_int>(num_results);
+}
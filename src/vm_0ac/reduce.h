@@ -0,0 +1,262 @@
+/**
+ * reduction kernels for vectors and matrices
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#ifndef __0ACVM_REDUCE_H__
+#define __0ACVM_REDUCE_H__
+
+
+#include <string>
+#include <optional>
+#include <cstddef>
+#include <array>
+
+#include "pool.h"
+
+
+enum class ReduceOp
+{
+	SUM, PROD,
+	MIN, MAX,
+	MEAN,
+	ARGMIN, ARGMAX,
+};
+
+
+/**
+ * get the reduction for a function name, e.g. "sum" or "sum_axis"
+ */
+inline std::optional<ReduceOp> get_reduce_op(const std::string& name, bool axis = false)
+{
+	std::string op = name;
+	if(axis)
+	{
+		if(!op.ends_with("_axis"))
+			return std::nullopt;
+		op.resize(op.size() - 5);
+	}
+
+	if(op == "sum")
+		return ReduceOp::SUM;
+	else if(op == "prod")
+		return ReduceOp::PROD;
+	else if(op == "min")
+		return ReduceOp::MIN;
+	else if(op == "max")
+		return ReduceOp::MAX;
+	else if(op == "mean")
+		return ReduceOp::MEAN;
+	else if(op == "argmin")
+		return ReduceOp::ARGMIN;
+	else if(op == "argmax")
+		return ReduceOp::ARGMAX;
+
+	return std::nullopt;
+}
+
+
+/**
+ * number of independent accumulators, lets the compiler vectorise the loops
+ */
+constexpr const std::size_t g_reduce_lanes = 8;
+
+
+/**
+ * pairwise summation, the rounding error grows with log(n) instead of n
+ */
+template<class t_real>
+t_real pairwise_sum(const t_real* x, std::size_t n, std::size_t stride = 1)
+{
+	constexpr const std::size_t block = 128;
+
+	if(n > block)
+	{
+		// split at a multiple of the lanes
+		std::size_t half = (n / 2) / g_reduce_lanes * g_reduce_lanes;
+		return pairwise_sum(x, half, stride) +
+			pairwise_sum(x + half*stride, n - half, stride);
+	}
+
+	t_real lanes[g_reduce_lanes]{};
+	std::size_t i = 0;
+	for(; i + g_reduce_lanes <= n; i += g_reduce_lanes)
+		for(std::size_t lane=0; lane<g_reduce_lanes; ++lane)
+			lanes[lane] += x[(i + lane)*stride];
+
+	t_real sum{};
+	for(std::size_t lane=0; lane<g_reduce_lanes; ++lane)
+		sum += lanes[lane];
+	for(; i<n; ++i)
+		sum += x[i*stride];
+
+	return sum;
+}
+
+
+template<class t_real>
+t_real lanes_prod(const t_real* x, std::size_t n, std::size_t stride = 1)
+{
+	t_real lanes[g_reduce_lanes];
+	for(std::size_t lane=0; lane<g_reduce_lanes; ++lane)
+		lanes[lane] = t_real(1);
+
+	std::size_t i = 0;
+	for(; i + g_reduce_lanes <= n; i += g_reduce_lanes)
+		for(std::size_t lane=0; lane<g_reduce_lanes; ++lane)
+			lanes[lane] *= x[(i + lane)*stride];
+
+	t_real prod = t_real(1);
+	for(std::size_t lane=0; lane<g_reduce_lanes; ++lane)
+		prod *= lanes[lane];
+	for(; i<n; ++i)
+		prod *= x[i*stride];
+
+	return prod;
+}
+
+
+/**
+ * minimum or maximum of a non-empty range
+ */
+template<bool is_max, class t_real>
+t_real lanes_extremum(const t_real* x, std::size_t n, std::size_t stride = 1)
+{
+	auto better = [](t_real a, t_real b) -> t_real
+	{
+		if constexpr(is_max)
+			return b > a ? b : a;
+		else
+			return b < a ? b : a;
+	};
+
+	t_real lanes[g_reduce_lanes];
+	for(std::size_t lane=0; lane<g_reduce_lanes; ++lane)
+		lanes[lane] = x[0];
+
+	std::size_t i = 0;
+	for(; i + g_reduce_lanes <= n; i += g_reduce_lanes)
+		for(std::size_t lane=0; lane<g_reduce_lanes; ++lane)
+			lanes[lane] = better(lanes[lane], x[(i + lane)*stride]);
+
+	t_real result = lanes[0];
+	for(std::size_t lane=1; lane<g_reduce_lanes; ++lane)
+		result = better(result, lanes[lane]);
+	for(; i<n; ++i)
+		result = better(result, x[i*stride]);
+
+	return result;
+}
+
+
+/**
+ * index of the first minimum or maximum of a non-empty range
+ */
+template<bool is_max, class t_real>
+std::size_t arg_extremum(const t_real* x, std::size_t n, std::size_t stride = 1)
+{
+	std::size_t idx = 0;
+	for(std::size_t i=1; i<n; ++i)
+	{
+		if constexpr(is_max)
+		{
+			if(x[i*stride] > x[idx*stride])
+				idx = i;
+		}
+		else
+		{
+			if(x[i*stride] < x[idx*stride])
+				idx = i;
+		}
+	}
+
+	return idx;
+}
+
+
+/**
+ * reduces n elements with the given stride,
+ * the arg functions return the index and -1 for an empty range
+ */
+template<class t_real>
+t_real reduce(ReduceOp op, const t_real* x, std::size_t n, std::size_t stride = 1)
+{
+	switch(op)
+	{
+		case ReduceOp::SUM:
+			return pairwise_sum(x, n, stride);
+		case ReduceOp::PROD:
+			return lanes_prod(x, n, stride);
+		case ReduceOp::MEAN:
+			return n ? pairwise_sum(x, n, stride) / t_real(n) : t_real(0);
+		case ReduceOp::MIN:
+			return n ? lanes_extremum<false>(x, n, stride) : t_real(0);
+		case ReduceOp::MAX:
+			return n ? lanes_extremum<true>(x, n, stride) : t_real(0);
+		case ReduceOp::ARGMIN:
+			return n ? t_real(arg_extremum<false>(x, n, stride)) : t_real(-1);
+		case ReduceOp::ARGMAX:
+			return n ? t_real(arg_extremum<true>(x, n, stride)) : t_real(-1);
+	}
+
+	return t_real(0);
+}
+
+
+// a large range is split into a fixed number of blocks,
+// so that the result does not depend on the number of threads
+constexpr const std::size_t g_reduce_par_blocks = 64;
+
+
+/**
+ * reduces a range on the threads of the pool if it is large enough
+ */
+template<class t_real>
+t_real reduce_par(ReduceOp op, const t_real* x, std::size_t n, ThreadPool* pool)
+{
+	if(!pool || n < g_par_min_elems)
+		return reduce(op, x, n);
+
+	const bool is_arg = (op == ReduceOp::ARGMIN || op == ReduceOp::ARGMAX);
+	const ReduceOp block_op = (op == ReduceOp::MEAN ? ReduceOp::SUM : op);
+
+	std::array<t_real, g_reduce_par_blocks> partial{};
+	using t_int = ThreadPool::t_int;
+	par_for(pool, n, g_par_min_elems, 0, static_cast<t_int>(g_reduce_par_blocks),
+		[&partial, x, n, block_op, is_arg](t_int begin, t_int end)
+	{
+		for(t_int block=begin; block<end; ++block)
+		{
+			const std::size_t first = n*block / g_reduce_par_blocks;
+			const std::size_t last = n*(block + 1) / g_reduce_par_blocks;
+
+			t_real result = reduce(block_op, x + first, last - first);
+			if(is_arg)
+				result += t_real(first);
+			partial[block] = result;
+		}
+	});
+
+	if(is_arg)
+	{
+		// first block with the extremum
+		std::size_t idx = static_cast<std::size_t>(partial[0]);
+		for(std::size_t block=1; block<g_reduce_par_blocks; ++block)
+		{
+			const std::size_t cur = static_cast<std::size_t>(partial[block]);
+			if(op == ReduceOp::ARGMIN ? x[cur] < x[idx] : x[cur] > x[idx])
+				idx = cur;
+		}
+		return t_real(idx);
+	}
+
+	t_real result = reduce(block_op, partial.data(), partial.size());
+	if(op == ReduceOp::MEAN)
+		result /= t_real(n);
+	return result;
+}
+
+
+#endif
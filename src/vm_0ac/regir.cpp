@@ -0,0 +1,505 @@
+/**
+ * zero-address code vm, translation into the register-based ir
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "vm.h"
+
+#include <limits>
+
+
+static constexpr const std::size_t g_no_ir_index = std::numeric_limits<std::size_t>::max();
+
+
+/**
+ * decoded bytecode instruction
+ */
+struct IRDecoded
+{
+	VM::t_addr addr{}, next{};
+	OpCode op{OpCode::NOP};
+
+	// data of push instructions
+	VMType ty{VMType::UNKNOWN};
+	VM::t_data val{};
+
+	bool is_target{false};  // instruction is a jump target
+};
+
+
+static bool is_arith_op(OpCode op)
+{
+	return op == OpCode::ADD || op == OpCode::SUB ||
+		op == OpCode::MUL || op == OpCode::DIV ||
+		op == OpCode::MOD || op == OpCode::POW ||
+		op == OpCode::EMUL || op == OpCode::EDIV;
+}
+
+
+static bool is_cmp_op(OpCode op)
+{
+	return op == OpCode::GT || op == OpCode::LT ||
+		op == OpCode::GEQU || op == OpCode::LEQU ||
+		op == OpCode::EQU || op == OpCode::NEQU;
+}
+
+
+static bool is_cast_op(OpCode op)
+{
+	return op == OpCode::TOI || op == OpCode::TOF || op == OpCode::TOS;
+}
+
+
+static bool is_addr_type(VMType ty)
+{
+	return ty == VMType::ADDR_MEM || ty == VMType::ADDR_IP ||
+		ty == VMType::ADDR_SP || ty == VMType::ADDR_BP;
+}
+
+
+/**
+ * get the ir index of a code address
+ */
+std::optional<std::size_t> VM::GetIRIndex(t_addr addr) const
+{
+	if(addr < m_ir_base || addr - m_ir_base >= static_cast<t_addr>(m_ir_index.size()))
+		return std::nullopt;
+
+	std::size_t idx = m_ir_index[addr - m_ir_base];
+	if(idx == g_no_ir_index)
+		return std::nullopt;
+	return idx;
+}
+
+
+/**
+ * translate the loaded bytecode into the register-based ir
+ */
+bool VM::TranslateIR()
+{
+	m_ir.clear();
+	m_ir_consts.clear();
+	m_ir_index.clear();
+	m_jit_funcs.clear();
+	m_jit_func_index.clear();
+
+	if(!m_use_ir || m_debug || m_code_range[0] < 0 || m_code_range[1] < 0)
+		return false;
+
+	const t_addr code_begin = m_code_range[0];
+	const t_addr code_end = m_code_range[1];
+
+	// --------------------------------------------------------------------
+	// decode the bytecode
+	// --------------------------------------------------------------------
+	std::vector<IRDecoded> decoded;
+	std::vector<std::size_t> dec_index(code_end - code_begin, g_no_ir_index);
+
+	for(t_addr addr = code_begin; addr < code_end;)
+	{
+		IRDecoded instr{ .addr = addr, .op = static_cast<OpCode>(m_mem[addr]) };
+		addr += m_bytesize;
+
+		if(instr.op == OpCode::PUSH)
+		{
+			try
+			{
+				std::tie(instr.ty, instr.val) = ReadMemData(addr);
+			}
+			catch(const std::exception&)
+			{
+				// no valid code beyond this point, e.g. constants
+				break;
+			}
+
+			addr += GetDataSize(instr.val) + m_bytesize;
+			if(addr > code_end)
+				break;
+		}
+
+		instr.next = addr;
+		dec_index[instr.addr - code_begin] = decoded.size();
+		decoded.emplace_back(std::move(instr));
+	}
+
+	const std::size_t num_decoded = decoded.size();
+	if(!num_decoded)
+		return false;
+
+	auto get_dec_index = [&dec_index, code_begin, code_end](t_addr addr) -> std::optional<std::size_t>
+	{
+		if(addr < code_begin || addr >= code_end)
+			return std::nullopt;
+		std::size_t idx = dec_index[addr - code_begin];
+		if(idx == g_no_ir_index)
+			return std::nullopt;
+		return idx;
+	};
+
+	// get the constant address a jump or call instruction refers to
+	auto get_target = [&decoded](std::size_t idx) -> std::optional<t_addr>
+	{
+		if(idx == 0)
+			return std::nullopt;
+
+		const IRDecoded& push = decoded[idx - 1];
+		if(push.op != OpCode::PUSH)
+			return std::nullopt;
+
+		if(push.ty == VMType::ADDR_IP)
+			return decoded[idx].next + std::get<m_addridx>(push.val);
+		else if(push.ty == VMType::ADDR_MEM)
+			return std::get<m_addridx>(push.val);
+		return std::nullopt;
+	};
+
+	// find the jump targets, these start new ir instructions
+	if(auto idx = get_dec_index(m_ip); idx)
+		decoded[*idx].is_target = true;
+
+	for(std::size_t idx=0; idx<num_decoded; ++idx)
+	{
+		OpCode op = decoded[idx].op;
+		if(op != OpCode::JMP && op != OpCode::JMPCND &&
+			op != OpCode::CALL && op != OpCode::MAP &&
+			op != OpCode::PARLOOP)
+			continue;
+
+		if(auto target = get_target(idx); target)
+		{
+			if(auto target_idx = get_dec_index(*target); target_idx)
+				decoded[*target_idx].is_target = true;
+		}
+
+		// return address
+		if(op == OpCode::CALL && idx + 1 < num_decoded)
+			decoded[idx + 1].is_target = true;
+	}
+	// --------------------------------------------------------------------
+
+	// --------------------------------------------------------------------
+	// translate into ir instructions
+	// --------------------------------------------------------------------
+	m_ir_base = code_begin;
+	m_ir_index.resize(code_end - code_begin, g_no_ir_index);
+
+	// get the next instruction, skipping nops, but not jump targets
+	auto next_of = [&decoded, num_decoded](std::optional<std::size_t> idx) -> std::optional<std::size_t>
+	{
+		if(!idx)
+			return std::nullopt;
+
+		for(std::size_t i = *idx + 1; i < num_decoded; ++i)
+		{
+			if(decoded[i].is_target)
+				return std::nullopt;
+			if(decoded[i].op != OpCode::NOP)
+				return i;
+		}
+		return std::nullopt;
+	};
+
+	auto is_op = [&decoded](std::optional<std::size_t> idx, OpCode op) -> bool
+	{
+		return idx && decoded[*idx].op == op;
+	};
+
+	auto add_const = [this](VMType ty, const t_data& val) -> IROperand
+	{
+		m_ir_consts.emplace_back(std::make_tuple(ty, val));
+		return IROperand{ .type = IROperandType::CONST,
+			.addr = static_cast<t_addr>(m_ir_consts.size() - 1) };
+	};
+
+	// is the address in the program's read-only constants?
+	auto is_const_addr = [this, code_begin, code_end](t_addr addr) -> bool
+	{
+		return addr >= m_prog_range[0] && addr < m_prog_range[1] &&
+			(addr < code_begin || addr >= code_end);
+	};
+
+	// instructions producing a value: push constant or push address and read memory
+	auto get_producer = [&](std::optional<std::size_t> idx)
+		-> std::optional<std::tuple<IROperand, std::size_t>>
+	{
+		if(!is_op(idx, OpCode::PUSH))
+			return std::nullopt;
+
+		const IRDecoded& push = decoded[*idx];
+		if(!is_addr_type(push.ty))
+			return std::make_tuple(add_const(push.ty, push.val), *idx);
+
+		std::optional<std::size_t> rdmem = next_of(idx);
+		if(!is_op(rdmem, OpCode::RDMEM))
+			return std::nullopt;
+
+		t_addr addr = std::get<m_addridx>(push.val);
+		switch(push.ty)
+		{
+			case VMType::ADDR_BP:
+				return std::make_tuple(IROperand{ .type = IROperandType::FRAME, .addr = addr }, *rdmem);
+
+			case VMType::ADDR_IP:
+				addr += decoded[*rdmem].next;
+				[[fallthrough]];
+			case VMType::ADDR_MEM:
+				if(is_const_addr(addr))
+				{
+					try
+					{
+						auto [ty, val] = ReadMemData(addr);
+						return std::make_tuple(add_const(ty, val), *rdmem);
+					}
+					catch(const std::exception&)
+					{
+					}
+				}
+				return std::make_tuple(IROperand{ .type = IROperandType::MEM, .addr = addr }, *rdmem);
+
+			default:
+				return std::nullopt;
+		}
+	};
+
+	// instructions consuming a value: push address and write memory
+	auto get_consumer = [&](std::optional<std::size_t> idx)
+		-> std::optional<std::tuple<IROperand, std::size_t>>
+	{
+		if(!is_op(idx, OpCode::PUSH))
+			return std::nullopt;
+
+		const IRDecoded& push = decoded[*idx];
+		std::optional<std::size_t> wrmem = next_of(idx);
+		if(!is_op(wrmem, OpCode::WRMEM))
+			return std::nullopt;
+
+		t_addr addr = std::get<m_addridx>(push.val);
+		if(push.ty == VMType::ADDR_BP)
+			return std::make_tuple(IROperand{ .type = IROperandType::FRAME, .addr = addr }, *wrmem);
+		else if(push.ty == VMType::ADDR_MEM)
+			return std::make_tuple(IROperand{ .type = IROperandType::MEM, .addr = addr }, *wrmem);
+		return std::nullopt;
+	};
+
+	// optional cast and memory write following a value-producing instruction
+	auto add_result_tail = [&](IRInstr& instr, std::size_t& last)
+	{
+		std::optional<std::size_t> idx = next_of(last);
+		if(idx && is_cast_op(decoded[*idx].op))
+		{
+			instr.cast = decoded[*idx].op;
+			last = *idx;
+			idx = next_of(idx);
+		}
+
+		if(auto consumer = get_consumer(idx); consumer)
+			std::tie(instr.dst, last) = *consumer;
+	};
+
+	for(std::size_t idx=0; idx<num_decoded;)
+	{
+		const IRDecoded& cur = decoded[idx];
+
+		// nops are skipped and continue at the next ir instruction
+		if(cur.op == OpCode::NOP)
+		{
+			m_ir_index[cur.addr - code_begin] = m_ir.size();
+			++idx;
+			continue;
+		}
+
+		IRInstr instr{ .addr = cur.addr };
+		std::size_t last = idx;
+
+		std::optional<std::size_t> idx2 = next_of(idx);
+		std::optional<std::size_t> idx3 = next_of(idx2);
+
+		// function call
+		if(cur.op == OpCode::PUSH && cur.ty == VMType::INT &&
+			is_op(idx3, OpCode::CALL) && *idx3 == *idx2 + 1 && get_target(*idx3))
+		{
+			instr.op = IROp::CALL;
+			instr.framesize = std::get<m_intidx>(cur.val);
+			instr.target_addr = *get_target(*idx3);
+			last = *idx3;
+		}
+
+		// return from function
+		else if(cur.op == OpCode::PUSH && cur.ty == VMType::INT &&
+			is_op(idx2, OpCode::PUSH) && decoded[*idx2].ty == VMType::INT &&
+			is_op(idx3, OpCode::RET))
+		{
+			instr.op = IROp::RET;
+			instr.framesize = std::get<m_intidx>(cur.val);
+			instr.num_args = std::get<m_intidx>(decoded[*idx2].val);
+			last = *idx3;
+		}
+
+		// jumps
+		else if(cur.op == OpCode::PUSH && (is_op(idx2, OpCode::JMP) ||
+			is_op(idx2, OpCode::JMPCND)) && get_target(*idx2) && *idx2 == idx + 1)
+		{
+			instr.op = (decoded[*idx2].op == OpCode::JMP ? IROp::JMP : IROp::JMPCND);
+			instr.target_addr = *get_target(*idx2);
+			last = *idx2;
+		}
+		else if(cur.op == OpCode::NOT && is_op(idx3, OpCode::JMPCND) &&
+			get_target(*idx3) && *idx3 == *idx2 + 1)
+		{
+			instr.op = IROp::JMPCND;
+			instr.negate = true;
+			instr.target_addr = *get_target(*idx3);
+			last = *idx3;
+		}
+
+		// operations on constants and variables
+		else if(auto producer1 = get_producer(idx); producer1)
+		{
+			auto [src1, last1] = *producer1;
+			std::optional<std::size_t> next1 = next_of(last1);
+			auto producer2 = get_producer(next1);
+			std::optional<std::size_t> next2 = producer2 ? next_of(std::get<1>(*producer2)) : std::nullopt;
+
+			// binary operation with both operands given directly
+			if(producer2 && next2 && (is_arith_op(decoded[*next2].op) || is_cmp_op(decoded[*next2].op)))
+			{
+				instr.op = is_arith_op(decoded[*next2].op) ? IROp::ARITH : IROp::CMP;
+				instr.opcode = decoded[*next2].op;
+				instr.src1 = src1;
+				instr.src2 = std::get<0>(*producer2);
+				last = *next2;
+			}
+
+			// binary operation with the first operand on the stack
+			else if(next1 && (is_arith_op(decoded[*next1].op) || is_cmp_op(decoded[*next1].op)))
+			{
+				instr.op = is_arith_op(decoded[*next1].op) ? IROp::ARITH : IROp::CMP;
+				instr.opcode = decoded[*next1].op;
+				instr.src2 = src1;
+				last = *next1;
+			}
+
+			// external function call with a constant name
+			else if(is_op(next1, OpCode::EXTCALL) && src1.type == IROperandType::CONST &&
+				std::get<1>(m_ir_consts[src1.addr]).index() == m_stridx)
+			{
+				instr.op = IROp::EXTCALL;
+				instr.src1 = src1;
+				last = *next1;
+			}
+
+			// copy value
+			else
+			{
+				instr.op = IROp::MOV;
+				instr.src1 = src1;
+				last = last1;
+			}
+		}
+
+		// binary operation with both operands on the stack
+		else if(is_arith_op(cur.op) || is_cmp_op(cur.op))
+		{
+			instr.op = is_arith_op(cur.op) ? IROp::ARITH : IROp::CMP;
+			instr.opcode = cur.op;
+		}
+
+		// write value from the stack to memory
+		else if(auto consumer = get_consumer(idx); consumer)
+		{
+			instr.op = IROp::MOV;
+			std::tie(instr.dst, last) = *consumer;
+		}
+		else if(is_cast_op(cur.op) && get_consumer(idx2))
+		{
+			instr.op = IROp::MOV;
+			instr.cast = cur.op;
+			std::tie(instr.dst, last) = *get_consumer(idx2);
+		}
+
+		// push other data, e.g. addresses
+		else if(cur.op == OpCode::PUSH)
+		{
+			instr.op = IROp::MOV;
+			instr.src1 = add_const(cur.ty, cur.val);
+		}
+
+		// run any other instruction directly
+		else
+		{
+			instr.op = IROp::EXEC;
+			instr.opcode = cur.op;
+		}
+
+		// conversion and storing of results
+		if(instr.op == IROp::ARITH || (instr.op == IROp::MOV &&
+			instr.src1.type != IROperandType::STACK && instr.cast == OpCode::NOP &&
+			!(cur.op == OpCode::PUSH && is_addr_type(cur.ty))))
+		{
+			add_result_tail(instr, last);
+		}
+
+		// conditional jump depending on a comparison
+		else if(instr.op == IROp::CMP)
+		{
+			std::optional<std::size_t> next = next_of(last);
+			bool negate = false;
+			if(is_op(next, OpCode::NOT))
+			{
+				negate = true;
+				next = next_of(next);
+			}
+
+			std::optional<std::size_t> jmp = next_of(next);
+			if(is_op(next, OpCode::PUSH) && is_op(jmp, OpCode::JMPCND) &&
+				*jmp == *next + 1 && get_target(*jmp))
+			{
+				instr.op = IROp::CMPJMP;
+				instr.negate = negate;
+				instr.target_addr = *get_target(*jmp);
+				last = *jmp;
+			}
+		}
+
+		instr.next = decoded[last].next;
+		m_ir_index[cur.addr - code_begin] = m_ir.size();
+		m_ir.emplace_back(std::move(instr));
+		idx = last + 1;
+	}
+	// --------------------------------------------------------------------
+
+	// --------------------------------------------------------------------
+	// resolve jump and call targets
+	// --------------------------------------------------------------------
+	for(IRInstr& instr : m_ir)
+	{
+		if(instr.op != IROp::JMP && instr.op != IROp::JMPCND &&
+			instr.op != IROp::CMPJMP && instr.op != IROp::CALL)
+			continue;
+
+		std::optional<std::size_t> target = GetIRIndex(instr.target_addr);
+		if(target)
+		{
+			instr.target = *target;
+		}
+		else
+		{
+			// let the bytecode interpreter handle unknown targets
+			instr.op = IROp::EXEC;
+			instr.opcode = OpCode::INVALID;
+		}
+	}
+	// --------------------------------------------------------------------
+
+	InitFunctions();
+
+	if(m_debug)
+	{
+		std::cout << "Translated " << num_decoded << " bytecode instructions into "
+			<< m_ir.size() << " ir instructions." << std::endl;
+	}
+
+	return true;
+}
@@ -0,0 +1,89 @@
+/**
+ * register-based intermediate representation of the 0ac code
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * At load time the stack-based bytecode is translated into three-address
+ * instructions whose operands directly refer to the variables in the
+ * stack frame (the virtual registers), to constants or to the stack.
+ * E.g. the bytecode sequence
+ *	PUSH bp-9; RDMEM; PUSH 1; ADD; TOI; PUSH bp-9; WRMEM
+ * becomes the single instruction
+ *	ARITH [bp-9] <- [bp-9] + const(1), cast: TOI
+ */
+
+#ifndef __0ACVM_REGIR_H__
+#define __0ACVM_REGIR_H__
+
+#include <cstddef>
+
+#include "opcodes.h"
+
+
+/**
+ * ir instructions
+ */
+enum class IROp : t_vm_byte
+{
+	EXEC,       // run the original bytecode instruction
+	MOV,        // dst <- src1
+	ARITH,      // dst <- src1 op src2
+	CMP,        // push (src1 op src2)
+	CMPJMP,     // jump if (src1 op src2)
+	JMP,        // unconditional jump
+	JMPCND,     // jump if the boolean on the stack is set
+	CALL,       // call function
+	RET,        // return from function
+	EXTCALL,    // call system function
+};
+
+
+/**
+ * kinds of ir operands
+ */
+enum class IROperandType : t_vm_byte
+{
+	STACK,      // value on the stack
+	FRAME,      // variable in the current stack frame
+	MEM,        // variable at an absolute address
+	CONST,      // pre-decoded constant
+};
+
+
+/**
+ * ir operand
+ */
+struct IROperand
+{
+	IROperandType type{IROperandType::STACK};
+
+	// frame offset, absolute address or index into the constants table
+	t_vm_addr addr{};
+};
+
+
+/**
+ * ir instruction
+ */
+struct IRInstr
+{
+	IROp op{IROp::EXEC};
+	OpCode opcode{OpCode::NOP};     // operation or original instruction
+	OpCode cast{OpCode::NOP};       // TOI, TOF or TOS conversion of the result
+	bool negate{false};             // negate the jump condition
+
+	IROperand dst{}, src1{}, src2{};
+
+	t_vm_addr addr{};               // address of the first bytecode instruction
+	t_vm_addr next{};               // address of the following bytecode instruction
+
+	t_vm_addr target_addr{};        // code address of a jump or call target
+	std::size_t target{};           // ir index of a jump or call target
+
+	t_vm_int num_args{};            // for calls and returns
+	t_vm_int framesize{};
+};
+
+
+#endif
@@ -9,12 +9,58 @@
 #include <iostream>
 
 
+/**
+ * run the program, using its register-based translation or native code if available
+ */
 bool VM::Run()
+{
+	// write the buffered output when the program halts or fails
+	bool ok = false;
+	try
+	{
+		ok = RunTiers();
+	}
+	catch(...)
+	{
+		m_output->Flush();
+		throw;
+	}
+
+	m_output->Flush();
+	return ok;
+}
+
+
+/**
+ * run the program on the fastest available execution tier
+ */
+bool VM::RunTiers()
+{
+	if(m_ir.size() && !m_debug && !m_drawmemimages)
+	{
+		// native code is only run for verified programs
+		if(m_use_jit && m_verified)
+			return RunJIT();
+		return RunIR();
+	}
+
+	return RunBytecode();
+}
+
+
+/**
+ * interpret the stack-based bytecode
+ */
+bool VM::RunBytecode()
 {
 	bool running = true;
 	while(running)
 	{
-		CheckPointerBounds();
+		// the instruction and base pointers of verified programs are safe
+		if(m_verified)
+			CheckStackBounds();
+		else
+			CheckPointerBounds();
 		if(m_drawmemimages)
 			DrawMemoryImage();
 
@@ -28,6 +74,14 @@ bool VM::Run()
 				continue;
 
 			m_irqs[irq] = false;
+
+			// periodic snapshot of the vm state
+			if(irq == m_checkpoint_interrupt && m_checkpoint_file != "")
+			{
+				SaveSnapshot(m_checkpoint_file);
+				continue;
+			}
+
 			if(!m_isrs[irq])
 				continue;
 
@@ -60,911 +114,1248 @@ bool VM::Run()
 		}
 
 		// run instruction
-		switch(op)
+		if(!Exec(op, running))
+			return false;
+
+		// wrap around
+		if(m_ip > m_memsize)
+			m_ip %= m_memsize;
+	}
+
+	return true;
+}
+
+
+/**
+ * run a single instruction
+ */
+bool VM::Exec(OpCode op, bool& running)
+{
+	switch(op)
+	{
+		case OpCode::HALT:
+		{
+			running = false;
+			break;
+		}
+
+		case OpCode::NOP:
+		{
+			break;
+		}
+
+		// push direct data onto stack
+		case OpCode::PUSH:
+		{
+			auto [ty, val] = ReadMemData(m_ip);
+			m_ip += GetDataSize(val) + m_bytesize;
+			PushData(val, ty);
+			break;
+		}
+
+		case OpCode::WRMEM:
+		{
+			// variable address
+			t_addr addr = PopAddress();
+
+			// pop data and write it to memory
+			t_data val = PopData();
+			WriteMemData(addr, val);
+			break;
+		}
+
+		case OpCode::RDMEM:
+		{
+			// variable address
+			t_addr addr = PopAddress();
+
+			// read and push data from memory
+			auto [ty, val] = ReadMemData(addr);
+			PushData(val, ty);
+			break;
+		}
+
+		case OpCode::ADDMEM:
+		{
+			OpArithmeticMem<'+'>();
+			break;
+		}
+
+		case OpCode::SUBMEM:
+		{
+			OpArithmeticMem<'-'>();
+			break;
+		}
+
+		case OpCode::MULMEM:
+		{
+			OpArithmeticMem<'*'>();
+			break;
+		}
+
+		case OpCode::DIVMEM:
+		{
+			OpArithmeticMem<'/'>();
+			break;
+		}
+
+		case OpCode::FUSEDMEM:
+		{
+			OpFused(true);
+			break;
+		}
+
+		// discard unused data, e.g. the result of a call
+		case OpCode::POP:
+		{
+			PopData();
+			break;
+		}
+
+		case OpCode::RDARR1D:
 		{
-			case OpCode::HALT:
+			t_int idx = std::get<m_intidx>(PopData());
+			t_data arr = PopData();
+
+			if(arr.index() == m_vecidx)
 			{
-				running = false;
-				break;
+				// gets vector element
+				const t_vec& vec = std::get<m_vecidx>(arr);
+				idx = safe_array_index<t_int>(idx, vec.size());
+
+				PushData(t_data{std::in_place_index<m_realidx>, vec[idx]});
 			}
+			else if(arr.index() == m_stridx)
+			{
+				// gets string element as substring
+				const t_str& str = std::get<m_stridx>(arr);
+				idx = safe_array_index<t_int>(idx, str.length());
 
-			case OpCode::NOP:
+				t_str newstr;
+				newstr += str[idx];
+				PushData(t_data{std::in_place_index<m_stridx>, newstr});
+			}
+			else if(arr.index() == m_matidx)
 			{
-				break;
+				// gets matrix column
+				const t_mat& mat = std::get<m_matidx>(arr);
+				idx = safe_array_index<t_int>(idx, mat.size2());
+
+				t_vec col = m::zero<t_vec>(mat.size1());
+				for(std::size_t i=0; i<mat.size1(); ++i)
+					col[i] = mat(i, idx);
+				PushData(t_data{std::in_place_index<m_vecidx>, col});
 			}
-
-			// push direct data onto stack
-			case OpCode::PUSH:
+			else
 			{
-				auto [ty, val] = ReadMemData(m_ip);
-				m_ip += GetDataSize(val) + m_bytesize;
-				PushData(val, ty);
-				break;
+				throw std::runtime_error("Cannot index non-array type.");
 			}
 
-			case OpCode::WRMEM:
+			break;
+		}
+
+		case OpCode::RDARR1DR:
+		{
+			t_int idx2 = std::get<m_intidx>(PopData());
+			t_int idx1 = std::get<m_intidx>(PopData());
+			t_data arr = PopData();
+
+			if(arr.index() == m_vecidx)
+			{
+				// gets vector range
+				const t_vec& vec = std::get<m_vecidx>(arr);
+				idx1 = safe_array_index<t_int>(idx1, vec.size());
+				idx2 = safe_array_index<t_int>(idx2, vec.size());
+
+				t_int delta = (idx2 >= idx1 ? 1 : -1);
+				idx2 += delta;
+
+				t_vec newvec = m::zero<t_vec>(std::abs(idx2 - idx1));
+				t_int new_idx = 0;
+				for(t_int idx=idx1; idx!=idx2; idx+=delta)
+					newvec[new_idx++] = vec[idx];
+				PushData(t_data{std::in_place_index<m_vecidx>, newvec});
+			}
+			else if(arr.index() == m_stridx)
 			{
-				// variable address
-				t_addr addr = PopAddress();
+				// gets string element as substring
+				const t_str& str = std::get<m_stridx>(arr);
+				idx1 = safe_array_index<t_int>(idx1, str.length());
+				idx2 = safe_array_index<t_int>(idx2, str.length());
+
+				t_int delta = (idx2 >= idx1 ? 1 : -1);
+				idx2 += delta;
 
-				// pop data and write it to memory
-				t_data val = PopData();
-				WriteMemData(addr, val);
-				break;
+				t_str newstr;
+				for(t_int idx=idx1; idx!=idx2; idx+=delta)
+					newstr += str[idx];
+				PushData(t_data{std::in_place_index<m_stridx>, newstr});
+			}
+			else if(arr.index() == m_matidx)
+			{
+				// gets matrix columns
+				const t_mat& mat = std::get<m_matidx>(arr);
+				idx1 = safe_array_index<t_int>(idx1, mat.size2());
+				idx2 = safe_array_index<t_int>(idx2, mat.size2());
+
+				t_int delta = (idx2 >= idx1 ? 1 : -1);
+				idx2 += delta;
+
+				t_mat cols = m::zero<t_mat>(mat.size1(), std::size_t(idx2 - idx1));
+				for(t_int idx=idx1; idx!=idx2; idx += delta)
+					for(std::size_t i=0; i<mat.size1(); i += delta)
+						cols(i, idx) = mat(i, idx);
+				PushData(t_data{std::in_place_index<m_matidx>, cols});
+			}
+			else
+			{
+				throw std::runtime_error("Cannot index non-array type.");
 			}
 
-			case OpCode::RDMEM:
+			break;
+		}
+
+		case OpCode::RDARR2D:
+		{
+			t_int idx2 = std::get<m_intidx>(PopData());
+			t_int idx1 = std::get<m_intidx>(PopData());
+			t_data arr = PopData();
+
+			if(arr.index() == m_matidx)
 			{
-				// variable address
-				t_addr addr = PopAddress();
+				// gets matrix element
+				const t_mat& mat = std::get<m_matidx>(arr);
+				idx1 = safe_array_index<t_int>(idx1, mat.size1());
+				idx2 = safe_array_index<t_int>(idx2, mat.size2());
 
-				// read and push data from memory
-				auto [ty, val] = ReadMemData(addr);
-				PushData(val, ty);
-				break;
+				PushData(t_data{std::in_place_index<m_realidx>, mat(idx1, idx2)});
+			}
+			else
+			{
+				throw std::runtime_error("Cannot double-index non-matrix type.");
 			}
 
-			case OpCode::RDARR1D:
+			break;
+		}
+
+		case OpCode::RDARR2DR:
+		{
+			t_int idx4 = std::get<m_intidx>(PopData());
+			t_int idx3 = std::get<m_intidx>(PopData());
+			t_int idx2 = std::get<m_intidx>(PopData());
+			t_int idx1 = std::get<m_intidx>(PopData());
+			t_data arr = PopData();
+
+			if(arr.index() == m_matidx)
 			{
-				t_int idx = std::get<m_intidx>(PopData());
-				t_data arr = PopData();
+				// gets matrix range
+				const t_mat& mat = std::get<m_matidx>(arr);
+				idx1 = safe_array_index<t_int>(idx1, mat.size1());
+				idx2 = safe_array_index<t_int>(idx2, mat.size1());
+				idx3 = safe_array_index<t_int>(idx3, mat.size2());
+				idx4 = safe_array_index<t_int>(idx4, mat.size2());
 
-				if(arr.index() == m_vecidx)
-				{
-					// gets vector element
-					const t_vec& vec = std::get<m_vecidx>(arr);
-					idx = safe_array_index<t_int>(idx, vec.size());
+				t_int delta1 = (idx2 >= idx1 ? 1 : -1);
+				t_int delta2 = (idx4 >= idx3 ? 1 : -1);
 
-					PushData(t_data{std::in_place_index<m_realidx>, vec[idx]});
-				}
-				else if(arr.index() == m_stridx)
-				{
-					// gets string element as substring
-					const t_str& str = std::get<m_stridx>(arr);
-					idx = safe_array_index<t_int>(idx, str.length());
+				idx2 += delta1;
+				idx4 += delta2;
 
-					t_str newstr;
-					newstr += str[idx];
-					PushData(t_data{std::in_place_index<m_stridx>, newstr});
-				}
-				else if(arr.index() == m_matidx)
-				{
-					// gets matrix column
-					const t_mat& mat = std::get<m_matidx>(arr);
-					idx = safe_array_index<t_int>(idx, mat.size2());
-
-					t_vec col = m::zero<t_vec>(mat.size1());
-					for(std::size_t i=0; i<mat.size1(); ++i)
-						col[i] = mat(i, idx);
-					PushData(t_data{std::in_place_index<m_vecidx>, col});
-				}
-				else
+				t_mat newmat = m::create<t_mat>(
+					std::abs(idx2-idx1), std::abs(idx4-idx3));
+
+				t_int new_i = 0;
+				for(t_int i=idx1; i!=idx2; i+=delta1)
 				{
-					throw std::runtime_error("Cannot index non-array type.");
+					t_int new_j = 0;
+					for(t_int j=idx3; j!=idx4; j+=delta2)
+						newmat(new_i, new_j++) = mat(i, j);
+					++new_i;
 				}
 
-				break;
+				PushData(t_data{std::in_place_index<m_matidx>, newmat});
 			}
-
-			case OpCode::RDARR1DR:
+			else
 			{
-				t_int idx2 = std::get<m_intidx>(PopData());
-				t_int idx1 = std::get<m_intidx>(PopData());
-				t_data arr = PopData();
+				throw std::runtime_error("Cannot double-index non-matrix type.");
+			}
 
-				if(arr.index() == m_vecidx)
-				{
-					// gets vector range
-					const t_vec& vec = std::get<m_vecidx>(arr);
-					idx1 = safe_array_index<t_int>(idx1, vec.size());
-					idx2 = safe_array_index<t_int>(idx2, vec.size());
-
-					t_int delta = (idx2 >= idx1 ? 1 : -1);
-					idx2 += delta;
-
-					t_vec newvec = m::zero<t_vec>(std::abs(idx2 - idx1));
-					t_int new_idx = 0;
-					for(t_int idx=idx1; idx!=idx2; idx+=delta)
-						newvec[new_idx++] = vec[idx];
-					PushData(t_data{std::in_place_index<m_vecidx>, newvec});
-				}
-				else if(arr.index() == m_stridx)
-				{
-					// gets string element as substring
-					const t_str& str = std::get<m_stridx>(arr);
-					idx1 = safe_array_index<t_int>(idx1, str.length());
-					idx2 = safe_array_index<t_int>(idx2, str.length());
-
-					t_int delta = (idx2 >= idx1 ? 1 : -1);
-					idx2 += delta;
-
-					t_str newstr;
-					for(t_int idx=idx1; idx!=idx2; idx+=delta)
-						newstr += str[idx];
-					PushData(t_data{std::in_place_index<m_stridx>, newstr});
-				}
-				else if(arr.index() == m_matidx)
-				{
-					// gets matrix columns
-					const t_mat& mat = std::get<m_matidx>(arr);
-					idx1 = safe_array_index<t_int>(idx1, mat.size2());
-					idx2 = safe_array_index<t_int>(idx2, mat.size2());
-
-					t_int delta = (idx2 >= idx1 ? 1 : -1);
-					idx2 += delta;
-
-					t_mat cols = m::zero<t_mat>(mat.size1(), std::size_t(idx2 - idx1));
-					for(t_int idx=idx1; idx!=idx2; idx += delta)
-						for(std::size_t i=0; i<mat.size1(); i += delta)
-							cols(i, idx) = mat(i, idx);
-					PushData(t_data{std::in_place_index<m_matidx>, cols});
-				}
-				else
+			break;
+		}
+
+		case OpCode::WRARR1D:
+		{
+			t_int idx = std::get<m_intidx>(PopData());
+
+			t_data data = PopData();
+			t_addr addr = PopAddress();
+
+			// get variable data type
+			VMType ty = ReadMemType(addr);
+			// skip type descriptor byte
+			addr += m_bytesize;
+
+			if(ty == VMType::VEC)
+			{
+				if(data.index() != m_realidx)
 				{
-					throw std::runtime_error("Cannot index non-array type.");
+					throw std::runtime_error(
+						"Vector element has to be of scalar type.");
 				}
 
-				break;
-			}
+				// get vector length indicator
+				t_addr veclen = ReadMemRaw<t_addr>(addr);
+				addr += m_addrsize;
+
+				idx = safe_array_index<t_addr>(idx, veclen);
 
-			case OpCode::RDARR2D:
+				// skip to element and overwrite it
+				addr += idx * m_realsize;
+				WriteMemRaw(addr, std::get<m_realidx>(data));
+			}
+			else
 			{
-				t_int idx2 = std::get<m_intidx>(PopData());
-				t_int idx1 = std::get<m_intidx>(PopData());
-				t_data arr = PopData();
+				throw std::runtime_error("Cannot index non-array type.");
+			}
 
-				if(arr.index() == m_matidx)
-				{
-					// gets matrix element
-					const t_mat& mat = std::get<m_matidx>(arr);
-					idx1 = safe_array_index<t_int>(idx1, mat.size2());
-					idx2 = safe_array_index<t_int>(idx2, mat.size2()) + 1;
+			break;
+		}
 
-					PushData(t_data{std::in_place_index<m_realidx>, mat(idx1, idx2)});
-				}
-				else
+		case OpCode::WRARR2D:
+		{
+			t_int idx2 = std::get<m_intidx>(PopData());
+			t_int idx1 = std::get<m_intidx>(PopData());
+
+			t_data data = PopData();
+			t_addr addr = PopAddress();
+
+			// get variable data type
+			VMType ty = ReadMemType(addr);
+			// skip type descriptor byte
+			addr += m_bytesize;
+
+			if(ty == VMType::MAT)
+			{
+				if(data.index() != m_realidx)
 				{
-					throw std::runtime_error("Cannot double-index non-matrix type.");
+					throw std::runtime_error(
+						"Matrix element has to be of scalar type.");
 				}
 
-				break;
-			}
+				// get matrix length indicators
+				t_addr num_rows = ReadMemRaw<t_addr>(addr);
+				addr += m_addrsize;
+				t_addr num_cols = ReadMemRaw<t_addr>(addr);
+				addr += m_addrsize;
 
-			case OpCode::RDARR2DR:
+				idx1 = safe_array_index<t_addr>(idx1, num_rows);
+				idx2 = safe_array_index<t_addr>(idx2, num_cols);
+
+				// skip to element and overwrite it
+				addr += (idx1*num_cols + idx2) * m_realsize;
+				//std::cout << ReadMemRaw<t_real>(addr) << std::endl;
+				WriteMemRaw(addr, std::get<m_realidx>(data));
+			}
+			else
 			{
-				t_int idx4 = std::get<m_intidx>(PopData());
-				t_int idx3 = std::get<m_intidx>(PopData());
-				t_int idx2 = std::get<m_intidx>(PopData());
-				t_int idx1 = std::get<m_intidx>(PopData());
-				t_data arr = PopData();
+				throw std::runtime_error("Cannot double-index non-matrix type.");
+			}
 
-				if(arr.index() == m_matidx)
-				{
-					// gets matrix range
-					const t_mat& mat = std::get<m_matidx>(arr);
-					idx1 = safe_array_index<t_int>(idx1, mat.size1());
-					idx2 = safe_array_index<t_int>(idx2, mat.size1());
-					idx3 = safe_array_index<t_int>(idx3, mat.size2());
-					idx4 = safe_array_index<t_int>(idx4, mat.size2());
+			break;
+		}
 
-					t_int delta1 = (idx2 >= idx1 ? 1 : -1);
-					t_int delta2 = (idx4 >= idx3 ? 1 : -1);
+		case OpCode::WRARR1DR:
+		{
+			t_int idx2 = std::get<m_intidx>(PopData());
+			t_int idx1 = std::get<m_intidx>(PopData());
 
-					idx2 += delta1;
-					idx4 += delta2;
+			t_data data = PopData();
+			t_addr addr = PopAddress();
 
-					t_mat newmat = m::create<t_mat>(
-						std::abs(idx2-idx1), std::abs(idx4-idx3));
+			// get variable data type
+			VMType ty = ReadMemType(addr);
+			// skip type descriptor byte
+			addr += m_bytesize;
 
-					t_int new_i = 0;
-					for(t_int i=idx1; i!=idx2; i+=delta1)
-					{
-						t_int new_j = 0;
-						for(t_int j=idx3; j!=idx4; j+=delta2)
-							newmat(new_i, new_j++) = mat(i, j);
-						++new_i;
-					}
+			// lhs variable is a vector
+			if(ty == VMType::VEC)
+			{
+				const t_vec* rhsvec = nullptr;
+				const t_real* rhsreal = nullptr;
 
-					PushData(t_data{std::in_place_index<m_matidx>, newmat});
+				// rhs is a vector
+				if(data.index() == m_vecidx)
+				{
+					rhsvec = &std::get<m_vecidx>(data);
+				}
+				// rhs is a scalar
+				else if(data.index() == m_realidx)
+				{
+					rhsreal = &std::get<m_realidx>(data);
 				}
 				else
 				{
-					throw std::runtime_error("Cannot double-index non-matrix type.");
+					throw std::runtime_error(
+						"Vector range has to be of vector or scalar type.");
 				}
 
-				break;
-			}
+				// get vector length indicator
+				t_addr veclen = ReadMemRaw<t_addr>(addr);
+				addr += m_addrsize;
 
-			case OpCode::WRARR1D:
-			{
-				t_int idx = std::get<m_intidx>(PopData());
+				idx1 = safe_array_index<t_addr>(idx1, veclen);
+				idx2 = safe_array_index<t_addr>(idx2, veclen);
+				t_int delta = (idx2 >= idx1 ? 1 : -1);
+				idx2 += delta;
 
-				t_data data = PopData();
-				t_addr addr = PopAddress();
+				// skip to element range and overwrite it
+				addr += idx1 * m_realsize;
+				t_int cur_idx = 0;
+				for(t_int idx=idx1; idx!=idx2; idx+=delta)
+				{
+					t_real elem{};
 
-				// get variable data type
-				VMType ty = ReadMemType(addr);
-				// skip type descriptor byte
-				addr += m_bytesize;
+					if(rhsvec)
+					{
+						if(std::size_t(cur_idx) >= rhsvec->size())
+						{
+							throw std::runtime_error(
+								"Vector index out of bounds.");
+						}
 
-				if(ty == VMType::VEC)
-				{
-					if(data.index() != m_realidx)
+						elem = (*rhsvec)[cur_idx++];
+					}
+					else if(rhsreal)
 					{
-						throw std::runtime_error(
-							"Vector element has to be of scalar type.");
+						elem = *rhsreal;
 					}
 
-					// get vector length indicator
-					t_addr veclen = ReadMemRaw<t_addr>(addr);
-					addr += m_addrsize;
-
-					idx = safe_array_index<t_addr>(idx, veclen);
-
-					// skip to element and overwrite it
-					addr += idx * m_realsize;
-					WriteMemRaw(addr, std::get<m_realidx>(data));
+					WriteMemRaw(addr, elem);
+					addr += m_realsize * delta;
 				}
-				else
-				{
-					throw std::runtime_error("Cannot index non-array type.");
-				}
-
-				break;
 			}
 
-			case OpCode::WRARR2D:
+			// lhs variable is a string
+			else if(ty == VMType::STR)
 			{
-				t_int idx2 = std::get<m_intidx>(PopData());
-				t_int idx1 = std::get<m_intidx>(PopData());
+				if(data.index() != m_stridx)
+				{
+					throw std::runtime_error(
+						"String range has to be of string type.");
+				}
+
+				const t_str& rhsstr = std::get<m_stridx>(data);;
 
-				t_data data = PopData();
-				t_addr addr = PopAddress();
+				// get vector length indicator
+				t_addr strlen = ReadMemRaw<t_addr>(addr);
+				addr += m_addrsize;
 
-				// get variable data type
-				VMType ty = ReadMemType(addr);
-				// skip type descriptor byte
-				addr += m_bytesize;
+				idx1 = safe_array_index<t_addr>(idx1, strlen);
+				idx2 = safe_array_index<t_addr>(idx2, strlen);
+				t_int delta = (idx2 >= idx1 ? 1 : -1);
+				idx2 += delta;
 
-				if(ty == VMType::MAT)
+				// skip to element range and overwrite it
+				addr += idx1 * m_charsize;
+				t_int cur_idx = 0;
+				for(t_int idx=idx1; idx!=idx2; idx+=delta)
 				{
-					if(data.index() != m_realidx)
+					t_char elem{};
+
+					if(std::size_t(cur_idx) >= rhsstr.length())
 					{
 						throw std::runtime_error(
-							"Matrix element has to be of scalar type.");
+							"String index out of bounds.");
 					}
 
-					// get matrix length indicators
-					t_addr num_rows = ReadMemRaw<t_addr>(addr);
-					addr += m_addrsize;
-					t_addr num_cols = ReadMemRaw<t_addr>(addr);
-					addr += m_addrsize;
-
-					idx1 = safe_array_index<t_addr>(idx1, num_rows);
-					idx2 = safe_array_index<t_addr>(idx2, num_cols);
+					elem = rhsstr[cur_idx++];
 
-					// skip to element and overwrite it
-					addr += (idx1*num_cols + idx2) * m_realsize;
-					//std::cout << ReadMemRaw<t_real>(addr) << std::endl;
-					WriteMemRaw(addr, std::get<m_realidx>(data));
-				}
-				else
-				{
-					throw std::runtime_error("Cannot double-index non-matrix type.");
+					WriteMemRaw(addr, elem);
+					addr += m_charsize * delta;
 				}
-
-				break;
 			}
+			else
+			{
+				throw std::runtime_error("Cannot index non-array type.");
+			}
+
+			break;
+		}
+
+		case OpCode::WRARR2DR:
+		{
+			t_int idx4 = std::get<m_intidx>(PopData());
+			t_int idx3 = std::get<m_intidx>(PopData());
+			t_int idx2 = std::get<m_intidx>(PopData());
+			t_int idx1 = std::get<m_intidx>(PopData());
+
+			t_data rhsdata = PopData();
+			t_addr addr = PopAddress();
 
-			case OpCode::WRARR1DR:
+			// get variable data type
+			VMType ty = ReadMemType(addr);
+			// skip type descriptor byte
+			addr += m_bytesize;
+
+			// assign to matrix
+			if(ty == VMType::MAT)
 			{
-				t_int idx2 = std::get<m_intidx>(PopData());
-				t_int idx1 = std::get<m_intidx>(PopData());
+				// get matrix length indicators
+				t_addr num_rows = ReadMemRaw<t_addr>(addr);
+				addr += m_addrsize;
+				t_addr num_cols = ReadMemRaw<t_addr>(addr);
+				addr += m_addrsize;
 
-				t_data data = PopData();
-				t_addr addr = PopAddress();
+				idx1 = safe_array_index<t_addr>(idx1, num_rows);
+				idx2 = safe_array_index<t_addr>(idx2, num_rows);
+				idx3 = safe_array_index<t_addr>(idx3, num_cols);
+				idx4 = safe_array_index<t_addr>(idx4, num_cols);
 
-				// get variable data type
-				VMType ty = ReadMemType(addr);
-				// skip type descriptor byte
-				addr += m_bytesize;
+				t_int delta1 = (idx2 >= idx1 ? 1 : -1);
+				t_int delta2 = (idx4 >= idx3 ? 1 : -1);
 
-				// lhs variable is a vector
-				if(ty == VMType::VEC)
-				{
-					const t_vec* rhsvec = nullptr;
-					const t_real* rhsreal = nullptr;
+				idx2 += delta1;
+				idx4 += delta2;
 
-					// rhs is a vector
-					if(data.index() == m_vecidx)
-					{
-						rhsvec = &std::get<m_vecidx>(data);
-					}
-					// rhs is a scalar
-					else if(data.index() == m_realidx)
-					{
-						rhsreal = &std::get<m_realidx>(data);
-					}
-					else
+				// assign from scalar
+				if(rhsdata.index() == m_realidx)
+				{
+					t_real rhsreal = std::get<m_realidx>(rhsdata);
+					for(t_int i=idx1; i!=idx2; i+=delta1)
 					{
-						throw std::runtime_error(
-							"Vector range has to be of vector or scalar type.");
+						for(t_int j=idx3; j!=idx4; j+=delta2)
+						{
+							t_int elem_idx = i*num_cols + j;
+							WriteMemRaw(addr + elem_idx*m_realsize, rhsreal);
+						}
 					}
+				}
 
-					// get vector length indicator
-					t_addr veclen = ReadMemRaw<t_addr>(addr);
-					addr += m_addrsize;
-
-					idx1 = safe_array_index<t_addr>(idx1, veclen);
-					idx2 = safe_array_index<t_addr>(idx2, veclen);
-					t_int delta = (idx2 >= idx1 ? 1 : -1);
-					idx2 += delta;
+				// assign from vector
+				else if(rhsdata.index() == m_vecidx)
+				{
+					const t_vec& rhsvec = std::get<m_vecidx>(rhsdata);
 
-					// skip to element range and overwrite it
-					addr += idx1 * m_realsize;
-					t_int cur_idx = 0;
-					for(t_int idx=idx1; idx!=idx2; idx+=delta)
+					t_addr vecidx = 0;
+					for(t_int i=idx1; i!=idx2; i+=delta1)
 					{
-						t_real elem{};
-
-						if(rhsvec)
+						for(t_int j=idx3; j!=idx4; j+=delta2)
 						{
-							if(std::size_t(cur_idx) >= rhsvec->size())
+							if(std::size_t(vecidx) >= rhsvec.size())
 							{
 								throw std::runtime_error(
 									"Vector index out of bounds.");
 							}
 
-							elem = (*rhsvec)[cur_idx++];
+							t_int elem_idx = i*num_cols + j;
+							t_real elem = rhsvec[vecidx++];
+							WriteMemRaw(addr + elem_idx*m_realsize, elem);
 						}
-						else if(rhsreal)
-						{
-							elem = *rhsreal;
-						}
-
-						WriteMemRaw(addr, elem);
-						addr += m_realsize * delta;
 					}
 				}
 
-				// lhs variable is a string
-				else if(ty == VMType::STR)
+				// assign from matrix
+				else if(rhsdata.index() == m_matidx)
 				{
-					if(data.index() != m_stridx)
-					{
-						throw std::runtime_error(
-							"String range has to be of string type.");
-					}
-
-					const t_str& rhsstr = std::get<m_stridx>(data);;
-
-					// get vector length indicator
-					t_addr strlen = ReadMemRaw<t_addr>(addr);
-					addr += m_addrsize;
+					const t_mat& rhsmat = std::get<m_matidx>(rhsdata);
 
-					idx1 = safe_array_index<t_addr>(idx1, strlen);
-					idx2 = safe_array_index<t_addr>(idx2, strlen);
-					t_int delta = (idx2 >= idx1 ? 1 : -1);
-					idx2 += delta;
-
-					// skip to element range and overwrite it
-					addr += idx1 * m_charsize;
-					t_int cur_idx = 0;
-					for(t_int idx=idx1; idx!=idx2; idx+=delta)
+					t_int i_rhs = 0;
+					for(t_int i=idx1; i!=idx2; i+=delta1)
 					{
-						t_char elem{};
-
-						if(std::size_t(cur_idx) >= rhsstr.length())
+						t_int j_rhs = 0;
+						for(t_int j=idx3; j!=idx4; j+=delta2)
 						{
-							throw std::runtime_error(
-								"String index out of bounds.");
-						}
-
-						elem = rhsstr[cur_idx++];
+							if(std::size_t(i_rhs) >= rhsmat.size1() ||
+								std::size_t(j_rhs) >= rhsmat.size2())
+							{
+								throw std::runtime_error(
+									"Matrix index out of bounds.");
+							}
 
-						WriteMemRaw(addr, elem);
-						addr += m_charsize * delta;
+							t_int elem_idx = i*num_cols + j;
+							t_real elem = rhsmat(i_rhs, j_rhs);
+							WriteMemRaw(addr + elem_idx*m_realsize, elem);
+							++j_rhs;
+						}
+						++i_rhs;
 					}
 				}
+
 				else
 				{
-					throw std::runtime_error("Cannot index non-array type.");
+					throw std::runtime_error(
+						"Invalid matrix range assignment.");
 				}
-
-				break;
 			}
-
-			case OpCode::WRARR2DR:
+			else
 			{
-				t_int idx4 = std::get<m_intidx>(PopData());
-				t_int idx3 = std::get<m_intidx>(PopData());
-				t_int idx2 = std::get<m_intidx>(PopData());
-				t_int idx1 = std::get<m_intidx>(PopData());
+				throw std::runtime_error("Cannot index non-array type.");
+			}
 
-				t_data rhsdata = PopData();
-				t_addr addr = PopAddress();
+			break;
+		}
 
-				// get variable data type
-				VMType ty = ReadMemType(addr);
-				// skip type descriptor byte
-				addr += m_bytesize;
+		case OpCode::USUB:
+		{
+			t_data val = PopData();
+			t_data result;
 
-				// assign to matrix
-				if(ty == VMType::MAT)
-				{
-					// get matrix length indicators
-					t_addr num_rows = ReadMemRaw<t_addr>(addr);
-					addr += m_addrsize;
-					t_addr num_cols = ReadMemRaw<t_addr>(addr);
-					addr += m_addrsize;
+			if(val.index() == m_realidx)
+			{
+				result = t_data{std::in_place_index<m_realidx>,
+					-std::get<m_realidx>(val)};
+			}
+			else if(val.index() == m_intidx)
+			{
+				result = t_data{std::in_place_index<m_intidx>,
+					-std::get<m_intidx>(val)};
+			}
+			else if(val.index() == m_vecidx)
+			{
+				using namespace m_ops;
+				result = t_data{std::in_place_index<m_vecidx>,
+					-std::get<m_vecidx>(val)};
+			}
+			else if(val.index() == m_matidx)
+			{
+				using namespace m_ops;
+				result = t_data{std::in_place_index<m_matidx>,
+					-std::get<m_matidx>(val)};
+			}
+			else
+			{
+				throw std::runtime_error(
+					"Type mismatch in arithmetic operation.");
+			}
 
-					idx1 = safe_array_index<t_addr>(idx1, num_rows);
-					idx2 = safe_array_index<t_addr>(idx2, num_rows);
-					idx3 = safe_array_index<t_addr>(idx3, num_cols);
-					idx4 = safe_array_index<t_addr>(idx4, num_cols);
+			PushData(result);
+			break;
+		}
 
-					t_int delta1 = (idx2 >= idx1 ? 1 : -1);
-					t_int delta2 = (idx4 >= idx3 ? 1 : -1);
+		case OpCode::ADD:
+		{
+			OpArithmetic<'+'>();
+			break;
+		}
 
-					idx2 += delta1;
-					idx4 += delta2;
+		case OpCode::SUB:
+		{
+			OpArithmetic<'-'>();
+			break;
+		}
 
-					// assign from scalar
-					if(rhsdata.index() == m_realidx)
-					{
-						t_real rhsreal = std::get<m_realidx>(rhsdata);
-						for(t_int i=idx1; i!=idx2; i+=delta1)
-						{
-							for(t_int j=idx3; j!=idx4; j+=delta2)
-							{
-								t_int elem_idx = i*num_cols + j;
-								WriteMemRaw(addr + elem_idx*m_realsize, rhsreal);
-							}
-						}
-					}
+		case OpCode::MUL:
+		{
+			OpArithmetic<'*'>();
+			break;
+		}
 
-					// assign from vector
-					else if(rhsdata.index() == m_vecidx)
-					{
-						const t_vec& rhsvec = std::get<m_vecidx>(rhsdata);
+		case OpCode::DIV:
+		{
+			OpArithmetic<'/'>();
+			break;
+		}
 
-						t_addr vecidx = 0;
-						for(t_int i=idx1; i!=idx2; i+=delta1)
-						{
-							for(t_int j=idx3; j!=idx4; j+=delta2)
-							{
-								if(std::size_t(vecidx) >= rhsvec.size())
-								{
-									throw std::runtime_error(
-										"Vector index out of bounds.");
-								}
-
-								t_int elem_idx = i*num_cols + j;
-								t_real elem = rhsvec[vecidx++];
-								WriteMemRaw(addr + elem_idx*m_realsize, elem);
-							}
-						}
-					}
+		case OpCode::MOD:
+		{
+			OpArithmetic<'%'>();
+			break;
+		}
 
-					// assign from matrix
-					else if(rhsdata.index() == m_matidx)
-					{
-						const t_mat& rhsmat = std::get<m_matidx>(rhsdata);
+		case OpCode::POW:
+		{
+			OpArithmetic<'^'>();
+			break;
+		}
 
-						t_int i_rhs = 0;
-						for(t_int i=idx1; i!=idx2; i+=delta1)
-						{
-							t_int j_rhs = 0;
-							for(t_int j=idx3; j!=idx4; j+=delta2)
-							{
-								if(std::size_t(i_rhs) >= rhsmat.size1() ||
-									std::size_t(j_rhs) >= rhsmat.size2())
-								{
-									throw std::runtime_error(
-										"Matrix index out of bounds.");
-								}
-
-								t_int elem_idx = i*num_cols + j;
-								t_real elem = rhsmat(i_rhs, j_rhs);
-								WriteMemRaw(addr + elem_idx*m_realsize, elem);
-								++j_rhs;
-							}
-							++i_rhs;
-						}
-					}
+		case OpCode::EMUL:
+		{
+			OpElementwise<'*'>();
+			break;
+		}
 
-					else
-					{
-						throw std::runtime_error(
-							"Invalid matrix range assignment.");
-					}
-				}
-				else
-				{
-					throw std::runtime_error("Cannot index non-array type.");
-				}
+		case OpCode::EDIV:
+		{
+			OpElementwise<'/'>();
+			break;
+		}
 
-				break;
-			}
+		case OpCode::FUSED:
+		{
+			OpFused(false);
+			break;
+		}
 
-			case OpCode::USUB:
-			{
-				t_data val = PopData();
-				t_data result;
+		case OpCode::AND:
+		{
+			OpLogical<'&'>();
+			break;
+		}
 
-				if(val.index() == m_realidx)
-				{
-					result = t_data{std::in_place_index<m_realidx>,
-						-std::get<m_realidx>(val)};
-				}
-				else if(val.index() == m_intidx)
-				{
-					result = t_data{std::in_place_index<m_intidx>,
-						-std::get<m_intidx>(val)};
-				}
-				else if(val.index() == m_vecidx)
-				{
-					using namespace m_ops;
-					result = t_data{std::in_place_index<m_vecidx>,
-						-std::get<m_vecidx>(val)};
-				}
-				else if(val.index() == m_matidx)
-				{
-					using namespace m_ops;
-					result = t_data{std::in_place_index<m_matidx>,
-						-std::get<m_matidx>(val)};
-				}
-				else
-				{
-					throw std::runtime_error(
-						"Type mismatch in arithmetic operation.");
-				}
+		case OpCode::OR:
+		{
+			OpLogical<'|'>();
+			break;
+		}
 
-				PushData(result);
-				break;
-			}
+		case OpCode::XOR:
+		{
+			OpLogical<'^'>();
+			break;
+		}
 
-			case OpCode::ADD:
-			{
-				OpArithmetic<'+'>();
-				break;
-			}
+		case OpCode::NOT:
+		{
+			// might also use PopData and PushData in case ints
+			// should also be allowed in boolean expressions
+			t_bool val = PopRaw<t_bool, m_boolsize>();
+			PushRaw<t_bool, m_boolsize>(!val);
+			break;
+		}
 
-			case OpCode::SUB:
-			{
-				OpArithmetic<'-'>();
-				break;
-			}
+		case OpCode::BINAND:
+		{
+			OpBinary<'&'>();
+			break;
+		}
 
-			case OpCode::MUL:
-			{
-				OpArithmetic<'*'>();
-				break;
-			}
+		case OpCode::BINOR:
+		{
+			OpBinary<'|'>();
+			break;
+		}
 
-			case OpCode::DIV:
-			{
-				OpArithmetic<'/'>();
-				break;
-			}
+		case OpCode::BINXOR:
+		{
+			OpBinary<'^'>();
+			break;
+		}
 
-			case OpCode::MOD:
+		case OpCode::BINNOT:
+		{
+			t_data val = PopData();
+			if(val.index() == m_intidx)
 			{
-				OpArithmetic<'%'>();
-				break;
+				t_int newval = ~std::get<m_intidx>(val);
+				PushData(t_data{std::in_place_index<m_intidx>, newval});
 			}
-
-			case OpCode::POW:
+			else
 			{
-				OpArithmetic<'^'>();
-				break;
+				throw std::runtime_error("Invalid data type for binary not.");
 			}
 
-			case OpCode::AND:
-			{
-				OpLogical<'&'>();
-				break;
-			}
+			break;
+		}
 
-			case OpCode::OR:
-			{
-				OpLogical<'|'>();
-				break;
-			}
+		case OpCode::SHL:
+		{
+			OpBinary<'<'>();
+			break;
+		}
 
-			case OpCode::XOR:
-			{
-				OpLogical<'^'>();
-				break;
-			}
+		case OpCode::SHR:
+		{
+			OpBinary<'>'>();
+			break;
+		}
 
-			case OpCode::NOT:
-			{
-				// might also use PopData and PushData in case ints
-				// should also be allowed in boolean expressions
-				t_bool val = PopRaw<t_bool, m_boolsize>();
-				PushRaw<t_bool, m_boolsize>(!val);
-				break;
-			}
+		case OpCode::ROTL:
+		{
+			OpBinary<'l'>();
+			break;
+		}
 
-			case OpCode::BINAND:
-			{
-				OpBinary<'&'>();
-				break;
-			}
+		case OpCode::ROTR:
+		{
+			OpBinary<'r'>();
+			break;
+		}
 
-			case OpCode::BINOR:
-			{
-				OpBinary<'|'>();
-				break;
-			}
+		case OpCode::GT:
+		{
+			OpComparison<OpCode::GT>();
+			break;
+		}
 
-			case OpCode::BINXOR:
-			{
-				OpBinary<'^'>();
-				break;
-			}
+		case OpCode::LT:
+		{
+			OpComparison<OpCode::LT>();
+			break;
+		}
 
-			case OpCode::BINNOT:
-			{
-				t_data val = PopData();
-				if(val.index() == m_intidx)
-				{
-					t_int newval = ~std::get<m_intidx>(val);
-					PushData(t_data{std::in_place_index<m_intidx>, newval});
-				}
-				else
-				{
-					throw std::runtime_error("Invalid data type for binary not.");
-				}
+		case OpCode::GEQU:
+		{
+			OpComparison<OpCode::GEQU>();
+			break;
+		}
 
-				break;
-			}
+		case OpCode::LEQU:
+		{
+			OpComparison<OpCode::LEQU>();
+			break;
+		}
 
-			case OpCode::SHL:
-			{
-				OpBinary<'<'>();
-				break;
-			}
+		case OpCode::EQU:
+		{
+			OpComparison<OpCode::EQU>();
+			break;
+		}
 
-			case OpCode::SHR:
-			{
-				OpBinary<'>'>();
-				break;
-			}
+		case OpCode::NEQU:
+		{
+			OpComparison<OpCode::NEQU>();
+			break;
+		}
 
-			case OpCode::ROTL:
-			{
-				OpBinary<'l'>();
-				break;
-			}
+		case OpCode::TOI: // converts value to t_int
+		{
+			OpCast<m_intidx>();
+			break;
+		}
 
-			case OpCode::ROTR:
-			{
-				OpBinary<'r'>();
-				break;
-			}
+		case OpCode::TOF: // converts value to t_real
+		{
+			OpCast<m_realidx>();
+			break;
+		}
 
-			case OpCode::GT:
-			{
-				OpComparison<OpCode::GT>();
-				break;
-			}
+		case OpCode::TOS: // converts value to t_str
+		{
+			OpCast<m_stridx>();
+			break;
+		}
 
-			case OpCode::LT:
-			{
-				OpComparison<OpCode::LT>();
-				break;
-			}
+		case OpCode::TOV: // converts value to t_vec
+		{
+			t_addr vec_size = PopAddress();
+			OpArrayCast<m_vecidx>(vec_size);
+			break;
+		}
 
-			case OpCode::GEQU:
-			{
-				OpComparison<OpCode::GEQU>();
-				break;
-			}
+		case OpCode::TOM: // converts value to t_mat
+		{
+			t_addr size1 = PopAddress();
+			t_addr size2 = PopAddress();
+			OpArrayCast<m_matidx>(size1, size2);
+			break;
+		}
 
-			case OpCode::LEQU:
-			{
-				OpComparison<OpCode::LEQU>();
-				break;
-			}
+		case OpCode::JMP: // jump to direct address
+		{
+			// get address from stack and set ip
+			m_ip = PopAddress();
+			break;
+		}
 
-			case OpCode::EQU:
-			{
-				OpComparison<OpCode::EQU>();
-				break;
-			}
+		case OpCode::JMPCND: // conditional jump to direct address
+		{
+			// get address from stack
+			t_addr addr = PopAddress();
 
-			case OpCode::NEQU:
-			{
-				OpComparison<OpCode::NEQU>();
-				break;
-			}
+			// get boolean condition result from stack
+			t_bool cond = PopRaw<t_bool, m_boolsize>();
 
-			case OpCode::TOI: // converts value to t_int
-			{
-				OpCast<m_intidx>();
-				break;
-			}
+			// set instruction pointer
+			if(cond)
+				m_ip = addr;
+			break;
+		}
 
-			case OpCode::TOF: // converts value to t_real
-			{
-				OpCast<m_realidx>();
-				break;
-			}
+		case OpCode::PARLOOP: // parallel loop over the following block
+		{
+			// get the address of the end of the loop body
+			t_addr body_end = PopAddress();
+			OpParLoop(body_end);
+			break;
+		}
 
-			case OpCode::TOS: // converts value to t_str
-			{
-				OpCast<m_stridx>();
-				break;
-			}
+		/**
+		 * stack frame for functions:
+		 *
+		 *  --------------------
+		 * |  local var n       |  <-- m_sp
+		 *  --------------------      |
+		 * |      ...           |     |
+		 *  --------------------      |
+		 * |  local var 2       |     |  framesize
+		 *  --------------------      |
+		 * |  local var 1       |     |
+		 *  --------------------      |
+		 * |  old m_bp          |  <-- m_bp (= previous m_sp)
+		 *  --------------------
+		 * |  old m_ip for ret  |
+		 *  --------------------
+		 * |  func. arg 1       |
+		 *  --------------------
+		 * |  func. arg 2       |
+		 *  --------------------
+		 * |  ...               |
+		 *  --------------------
+		 * |  func. arg n       |
+		 *  --------------------
+		 */
+		case OpCode::CALL: // function call
+		{
+			// get return address and frame size
+			t_addr funcaddr = PopAddress();
+			t_int framesize = std::get<m_intidx>(PopData());
 
-			case OpCode::TOV: // converts value to t_vec
-			{
-				t_addr vec_size = PopAddress();
-				OpArrayCast<m_vecidx>(vec_size);
-				break;
-			}
+			OpCall(funcaddr, framesize);
+			break;
+		}
 
-			case OpCode::TOM: // converts value to t_mat
-			{
-				t_addr size1 = PopAddress();
-				t_addr size2 = PopAddress();
-				OpArrayCast<m_matidx>(size1, size2);
-				break;
-			}
+		case OpCode::RET: // return from function
+		{
+			// get number of function arguments and frame size
+			t_int num_args = std::get<m_intidx>(PopData());
+			t_int framesize = std::get<m_intidx>(PopData());
 
-			case OpCode::JMP: // jump to direct address
-			{
-				// get address from stack and set ip
-				m_ip = PopAddress();
-				break;
-			}
+			OpRet(num_args, framesize);
+			break;
+		}
 
-			case OpCode::JMPCND: // conditional jump to direct address
-			{
-				// get address from stack
-				t_addr addr = PopAddress();
+		case OpCode::EXTCALL: // external function call
+		{
+			// get function name
+			const t_str/*&*/ funcname = std::get<m_stridx>(PopData());
 
-				// get boolean condition result from stack
-				t_bool cond = PopRaw<t_bool, m_boolsize>();
+			t_data retval = CallExternal(funcname);
+			PushData(retval, VMType::UNKNOWN, false);
+			break;
+		}
 
-				// set instruction pointer
-				if(cond)
-					m_ip = addr;
-				break;
-			}
+		case OpCode::MAP: // call function for each array element
+		{
+			// get function address and frame size
+			t_addr funcaddr = PopAddress();
+			t_int framesize = std::get<m_intidx>(PopData());
 
-			/**
-			 * stack frame for functions:
-			 *
-			 *  --------------------
-			 * |  local var n       |  <-- m_sp
-			 *  --------------------      |
-			 * |      ...           |     |
-			 *  --------------------      |
-			 * |  local var 2       |     |  framesize
-			 *  --------------------      |
-			 * |  local var 1       |     |
-			 *  --------------------      |
-			 * |  old m_bp          |  <-- m_bp (= previous m_sp)
-			 *  --------------------
-			 * |  old m_ip for ret  |
-			 *  --------------------
-			 * |  func. arg 1       |
-			 *  --------------------
-			 * |  func. arg 2       |
-			 *  --------------------
-			 * |  ...               |
-			 *  --------------------
-			 * |  func. arg n       |
-			 *  --------------------
-			 */
-			case OpCode::CALL: // function call
-			{
-				// get return address and frame size
-				t_addr funcaddr = PopAddress();
-				t_int framesize = std::get<m_intidx>(PopData());
+			OpMap(funcaddr, framesize);
+			break;
+		}
 
-				// save instruction and base pointer and
-				// set up the function's stack frame for local variables
-				PushAddress(m_ip, VMType::ADDR_MEM);
-				PushAddress(m_bp, VMType::ADDR_MEM);
+		case OpCode::MAKEVEC:
+		{
+			t_vec vec = PopVector(false);
+			PushData(t_data{std::in_place_index<m_vecidx>, vec});
+			break;
+		}
 
-				if(m_debug)
-				{
-					std::cout << "saved base pointer "
-						<< m_bp << "."
-						<< std::endl;
-				}
-				m_bp = m_sp;
-				m_sp -= framesize;
+		case OpCode::MAKEMAT:
+		{
+			t_mat mat = PopMatrix(false);
+			PushData(t_data{std::in_place_index<m_matidx>, mat});
+			break;
+		}
 
-				// jump to function
-				m_ip = funcaddr;
-				if(m_debug)
-				{
-					std::cout << "calling function "
-						<< funcaddr << "."
-						<< std::endl;
-				}
-				break;
-			}
+		default:
+		{
+			std::cerr << "Error: Invalid instruction " << std::hex
+				<< static_cast<t_addr>(op) << std::dec
+				<< std::endl;
+			return false;
+		}
+	}
 
-			case OpCode::RET: // return from function
-			{
-				// get number of function arguments and frame size
-				t_int num_args = std::get<m_intidx>(PopData());
-				t_int framesize = std::get<m_intidx>(PopData());
+	return true;
+}
 
-				// if there are still values on the stack, use then as return values
-				std::vector<t_data> retvals;
-				while(m_sp + framesize < m_bp)
-					retvals.push_back(PopData());
 
-				// zero the stack frame
-				if(m_zeropoppedvals)
-					std::memset(m_mem.get()+m_sp, 0, (m_bp-m_sp)*m_bytesize);
+/**
+ * call a function: save the instruction and base pointers and
+ * set up the function's stack frame for local variables
+ */
+bool VM::OpCall(t_addr funcaddr, t_int framesize)
+{
+	// take the results of pure functions from their caches
+	MemoCall memo{};
+	if(m_memo_active && MemoLookup(funcaddr, memo))
+		return false;
 
-				// remove the function's stack frame
-				m_sp = m_bp;
+	PushAddress(m_ip, VMType::ADDR_MEM);
+	PushAddress(m_bp, VMType::ADDR_MEM);
 
-				m_bp = PopAddress();
-				m_ip = PopAddress();  // jump back
+	if(m_debug)
+	{
+		std::cout << "saved base pointer "
+			<< m_bp << "."
+			<< std::endl;
+	}
+	m_bp = m_sp;
+	m_sp -= framesize;
 
-				if(m_debug)
-				{
-					std::cout << "restored base pointer "
-						<< m_bp << "."
-						<< std::endl;
-				}
+	if(memo.func)
+	{
+		memo.bp = m_bp;
+		m_memo_calls.emplace_back(std::move(memo));
+	}
 
-				// remove function arguments from stack
-				for(t_int arg=0; arg<num_args; ++arg)
-					PopData();
+	// jump to function
+	m_ip = funcaddr;
+	if(m_debug)
+	{
+		std::cout << "calling function "
+			<< funcaddr;
+		if(auto name = GetFunctionName(funcaddr); name)
+			std::cout << " (" << *name << ")";
+		std::cout << "." << std::endl;
+	}
 
-				for(const t_data& retval : retvals)
-					PushData(retval, VMType::UNKNOWN, false);
-				break;
-			}
+	return true;
+}
 
-			case OpCode::EXTCALL: // external function call
-			{
-				// get function name
-				const t_str/*&*/ funcname = std::get<m_stridx>(PopData());
 
-				t_data retval = CallExternal(funcname);
-				PushData(retval, VMType::UNKNOWN, false);
-				break;
-			}
+/**
+ * return from a function: remove its stack frame and arguments
+ */
+void VM::OpRet(t_int num_args, t_int framesize)
+{
+	// if there are still values on the stack, use then as return values
+	std::vector<t_data> retvals;
+	while(m_sp + framesize < m_bp)
+		retvals.push_back(PopData());
 
-			case OpCode::MAKEVEC:
-			{
-				t_vec vec = PopVector(false);
-				PushData(t_data{std::in_place_index<m_vecidx>, vec});
-				break;
-			}
+	// zero the stack frame
+	if(m_zeropoppedvals)
+		std::memset(m_mem.get()+m_sp, 0, (m_bp-m_sp)*m_bytesize);
 
-			case OpCode::MAKEMAT:
-			{
-				t_mat mat = PopMatrix(false);
-				PushData(t_data{std::in_place_index<m_matidx>, mat});
-				break;
-			}
+	// remove the function's stack frame
+	t_addr bp = m_bp;
+	m_sp = m_bp;
+
+	m_bp = PopAddress();
+	m_ip = PopAddress();  // jump back
+
+	if(m_debug)
+	{
+		std::cout << "restored base pointer "
+			<< m_bp << "."
+			<< std::endl;
+	}
+
+	// remove function arguments from stack
+	for(t_int arg=0; arg<num_args; ++arg)
+		PopData();
+
+	for(const t_data& retval : retvals)
+		PushData(retval, VMType::UNKNOWN, false);
+
+	// cache the results of pure functions
+	if(!m_memo_calls.empty() && m_memo_calls.back().bp == bp)
+	{
+		MemoStore(m_memo_calls.back());
+		m_memo_calls.pop_back();
+	}
+}
+
+
+/**
+ * call a script function for a single array element and return its result
+ */
+VM::t_real VM::MapElement(t_real elem, t_addr funcaddr, t_int framesize)
+{
+	const t_addr ret_ip = m_ip;
+	const t_addr caller_bp = m_bp;
+
+	PushData(t_data{std::in_place_index<m_realidx>, elem});
+
+	// run the function until it returns to the caller's frame,
+	// the frame is set up at the same stack position for every element
+	if(OpCall(funcaddr, framesize))
+	{
+		bool running = true;
+		while(m_ip != ret_ip || m_bp != caller_bp)
+		{
+			if(m_verified)
+				CheckStackBounds();
+			else
+				CheckPointerBounds();
+
+			OpCode op = static_cast<OpCode>(m_mem[m_ip++]);
+			if(!Exec(op, running))
+				throw std::runtime_error("Invalid instruction in mapped function.");
+			if(!running)
+				throw std::runtime_error("Program halted in mapped function.");
+		}
+	}
+
+	t_data retval = PopData();
+	if(retval.index() == m_realidx)
+		return std::get<m_realidx>(retval);
+	else if(retval.index() == m_intidx)
+		return static_cast<t_real>(std::get<m_intidx>(retval));
+
+	throw std::runtime_error("Mapped function has to return a scalar.");
+}
+
+
+/**
+ * call a script function for each element of the array on the stack,
+ * the results are written directly into the output array
+ */
+void VM::OpMap(t_addr funcaddr, t_int framesize)
+{
+	t_data arr = PopData();
+
+	if(arr.index() == m_vecidx)
+	{
+		t_vec vec = std::get<m_vecidx>(std::move(arr));
+		for(std::size_t i=0; i<vec.size(); ++i)
+			vec[i] = MapElement(vec[i], funcaddr, framesize);
+
+		PushData(t_data{std::in_place_index<m_vecidx>, std::move(vec)});
+	}
+	else if(arr.index() == m_matidx)
+	{
+		t_mat mat = std::get<m_matidx>(std::move(arr));
+		for(std::size_t i=0; i<mat.size1(); ++i)
+			for(std::size_t j=0; j<mat.size2(); ++j)
+				mat(i, j) = MapElement(mat(i, j), funcaddr, framesize);
+
+		PushData(t_data{std::in_place_index<m_matidx>, std::move(mat)});
+	}
+	else
+	{
+		throw std::runtime_error("Map needs a vector or matrix argument.");
+	}
+}
+
+
+/**
+ * evaluate the fused element-wise expression whose program is on top of the stack,
+ * all array operands need to have the same shape, scalars are combined with all elements,
+ * array variables given by their address are read in place
+ * @param to_mem write the result directly into the array variable below the program
+ */
+void VM::OpFused(bool to_mem)
+{
+	const t_str prog = std::get<m_stridx>(PopData());
+	const auto sizes = check_fused_prog(prog);
+	if(!sizes)
+		throw std::runtime_error("Invalid fused expression.");
+
+	std::optional<t_addr> dst_addr;
+	if(to_mem)
+		dst_addr = PopAddress();
+
+	std::vector<VecOperand> operands(sizes->first);
+	std::vector<t_data> vals(sizes->first);
+	std::vector<t_real> scalars(sizes->first);
+
+	// shape of the array operands
+	VMType arr_ty = VMType::UNKNOWN;
+	t_addr rows = 0, cols = 1;
 
-			default:
+	auto set_shape = [&arr_ty, &rows, &cols](VMType ty, t_addr rows_new, t_addr cols_new)
+	{
+		if(arr_ty == VMType::UNKNOWN)
+		{
+			arr_ty = ty;
+			rows = rows_new;
+			cols = cols_new;
+		}
+		else if(arr_ty != ty || rows != rows_new || cols != cols_new)
+		{
+			throw std::runtime_error("Array dimension mismatch in element-wise operation.");
+		}
+	};
+
+	// operands from last to first
+	for(std::size_t i=operands.size(); i-- > 0;)
+	{
+		const VMType ty = static_cast<VMType>(TopRaw<t_byte, m_bytesize>());
+
+		// array variable, read in place
+		if(ty == VMType::ADDR_MEM || ty == VMType::ADDR_IP ||
+			ty == VMType::ADDR_SP || ty == VMType::ADDR_BP)
+		{
+			t_addr addr = PopAddress();
+			const VMType memty = ReadMemType(addr);
+
+			if(memty == VMType::VEC || memty == VMType::MAT)
 			{
-				std::cerr << "Error: Invalid instruction " << std::hex
-					<< static_cast<t_addr>(op) << std::dec
-					<< std::endl;
-				return false;
+				const t_addr num_dims = (memty == VMType::MAT ? 2 : 1);
+				const t_addr dims_addr = addr + m_bytesize;
+				const t_addr var_rows = ReadMemRaw<t_addr>(dims_addr);
+				const t_addr var_cols = (memty == VMType::MAT
+					? ReadMemRaw<t_addr>(dims_addr + m_addrsize) : 1);
+				set_shape(memty, var_rows, var_cols);
+
+				const t_addr elems_addr = dims_addr + num_dims*m_addrsize;
+				CheckMemoryBounds(elems_addr, var_rows*var_cols*m_realsize);
+				operands[i].elems = reinterpret_cast<const t_real*>(m_mem.get() + elems_addr);
+				continue;
 			}
+
+			vals[i] = std::get<1>(ReadMemData(addr));
+		}
+		else
+		{
+			vals[i] = PopData();
 		}
 
-		// wrap around
-		if(m_ip > m_memsize)
-			m_ip %= m_memsize;
+		const t_data& val = vals[i];
+		if(val.index() == m_vecidx)
+		{
+			const t_vec& vec = std::get<m_vecidx>(val);
+			set_shape(VMType::VEC, static_cast<t_addr>(vec.size()), 1);
+			operands[i].elems = vec.data();
+		}
+		else if(val.index() == m_matidx)
+		{
+			const t_mat& mat = std::get<m_matidx>(val);
+			set_shape(VMType::MAT, static_cast<t_addr>(mat.size1()), static_cast<t_addr>(mat.size2()));
+			operands[i].elems = mat.data();
+		}
+		else
+		{
+			if(val.index() == m_realidx)
+				scalars[i] = std::get<m_realidx>(val);
+			else if(val.index() == m_intidx)
+				scalars[i] = static_cast<t_real>(std::get<m_intidx>(val));
+			else
+				throw std::runtime_error("Type mismatch in element-wise operation.");
+
+			operands[i] = VecOperand{ &scalars[i], 0 };
+		}
 	}
 
-	return true;
+	if(arr_ty == VMType::UNKNOWN)
+		throw std::runtime_error("Fused expression needs an array operand.");
+	const std::size_t num_elems = static_cast<std::size_t>(rows * cols);
+
+	// evaluate directly into the variable, which may also be an operand
+	if(dst_addr)
+	{
+		const t_addr num_dims = (arr_ty == VMType::MAT ? 2 : 1);
+		CheckMemoryBounds(*dst_addr, m_bytesize + num_dims*m_addrsize + num_elems*m_realsize, true);
+
+		t_addr addr = *dst_addr;
+		WriteMemRaw<t_byte>(addr, static_cast<t_byte>(arr_ty));
+		addr += m_bytesize;
+		WriteMemRaw<t_addr>(addr, rows);
+		addr += m_addrsize;
+		if(arr_ty == VMType::MAT)
+		{
+			WriteMemRaw<t_addr>(addr, cols);
+			addr += m_addrsize;
+		}
+
+		t_real* elems = reinterpret_cast<t_real*>(m_mem.get() + addr);
+		vec_fused(prog, operands, elems, num_elems, GetPool(num_elems, g_par_min_elems));
+		return;
+	}
+
+	t_data result;
+	if(arr_ty == VMType::VEC)
+		result = t_data{std::in_place_index<m_vecidx>, m::create<t_vec>(num_elems)};
+	else
+		result = t_data{std::in_place_index<m_matidx>, m::create<t_mat>(rows, cols)};
+
+	t_real* elems = result.index() == m_vecidx
+		? std::get<m_vecidx>(result).data()
+		: std::get<m_matidx>(result).data();
+	vec_fused(prog, operands, elems, num_elems, GetPool(num_elems, g_par_min_elems));
+
+	PushData(result);
 }
@@ -0,0 +1,311 @@
+/**
+ * zero-address code vm, register-based ir interpreter
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "vm.h"
+#include <iostream>
+
+
+/**
+ * interpret the register-based translation of the bytecode,
+ * code that has not been translated is passed on to the bytecode interpreter
+ */
+bool VM::RunIR()
+{
+	std::optional<std::size_t> start = GetIRIndex(m_ip);
+	if(!start)
+		return RunBytecode();
+
+	std::size_t pc = *start;
+	while(true)
+	{
+		switch(StepIR(pc))
+		{
+			case IRStatus::OK: break;
+			case IRStatus::HALT: return true;
+			case IRStatus::ERROR: return false;
+			case IRStatus::FALLBACK: return RunBytecode();
+		}
+	}
+}
+
+
+/**
+ * run the ir instruction at the given index and advance to the next one
+ */
+VM::IRStatus VM::StepIR(std::size_t& pc)
+{
+	// continue at the current instruction pointer
+	auto remap = [this, &pc]() -> IRStatus
+	{
+		std::optional<std::size_t> idx = GetIRIndex(m_ip);
+		if(!idx)
+			return IRStatus::FALLBACK;
+
+		pc = *idx;
+		return IRStatus::OK;
+	};
+
+	if(pc >= m_ir.size())
+		return IRStatus::FALLBACK;
+
+	const IRInstr& instr = m_ir[pc];
+	m_ip = instr.addr;
+
+	// the instruction and base pointers of verified programs are safe
+	if(m_verified)
+		CheckStackBounds();
+	else
+		CheckPointerBounds();
+
+	bool running = true;
+
+	// let the bytecode interpreter call the interrupt service routines
+	for(t_addr irq=0; irq<m_num_interrupts; ++irq)
+	{
+		if(!m_irqs[irq])
+			continue;
+
+		m_irqs[irq] = false;
+
+		// periodic snapshot of the vm state
+		if(irq == m_checkpoint_interrupt && m_checkpoint_file != "")
+		{
+			SaveSnapshot(m_checkpoint_file);
+			continue;
+		}
+
+		if(!m_isrs[irq])
+			continue;
+
+		PushAddress(*m_isrs[irq], VMType::ADDR_MEM);
+		if(!Exec(OpCode::CALL, running))
+			return IRStatus::ERROR;
+		return remap();
+	}
+
+	m_ip = instr.next;
+	++pc;
+
+	switch(instr.op)
+	{
+		case IROp::EXEC:
+		{
+			// untranslated jump target
+			if(instr.opcode == OpCode::INVALID)
+			{
+				m_ip = instr.addr;
+				return IRStatus::FALLBACK;
+			}
+
+			m_ip = instr.addr + m_bytesize;
+			if(!Exec(instr.opcode, running))
+				return IRStatus::ERROR;
+			if(!running)
+				return IRStatus::HALT;
+
+			// the instruction has changed the control flow
+			if(m_ip != instr.next)
+				return remap();
+			break;
+		}
+
+		case IROp::MOV:
+		{
+			auto [ty, val] = GetIROperand(instr.src1);
+			if(instr.cast != OpCode::NOP)
+			{
+				val = IRCast(instr.cast, val);
+				if(val.index() != m_addridx)
+					ty = VMType::UNKNOWN;
+			}
+
+			SetIROperand(instr.dst, val, ty);
+			break;
+		}
+
+		case IROp::ARITH:
+		{
+			t_data val2 = std::get<1>(GetIROperand(instr.src2));
+			t_data val1 = std::get<1>(GetIROperand(instr.src1));
+
+			t_data result = IRArithmetic(instr.opcode, val1, val2);
+			if(instr.cast != OpCode::NOP)
+				result = IRCast(instr.cast, result);
+
+			SetIROperand(instr.dst, result, VMType::UNKNOWN);
+			break;
+		}
+
+		case IROp::CMP:
+		{
+			t_data val2 = std::get<1>(GetIROperand(instr.src2));
+			t_data val1 = std::get<1>(GetIROperand(instr.src1));
+
+			PushRaw<t_bool, m_boolsize>(IRComparison(instr.opcode, val1, val2));
+			break;
+		}
+
+		case IROp::CMPJMP:
+		{
+			t_data val2 = std::get<1>(GetIROperand(instr.src2));
+			t_data val1 = std::get<1>(GetIROperand(instr.src1));
+
+			bool cond = IRComparison(instr.opcode, val1, val2) != 0;
+			if(cond != instr.negate)
+			{
+				CountLoop(pc - 1, instr.target);
+				m_ip = instr.target_addr;
+				pc = instr.target;
+			}
+			break;
+		}
+
+		case IROp::JMP:
+		{
+			CountLoop(pc - 1, instr.target);
+			m_ip = instr.target_addr;
+			pc = instr.target;
+			break;
+		}
+
+		case IROp::JMPCND:
+		{
+			bool cond = PopRaw<t_bool, m_boolsize>() != 0;
+			if(cond != instr.negate)
+			{
+				CountLoop(pc - 1, instr.target);
+				m_ip = instr.target_addr;
+				pc = instr.target;
+			}
+			break;
+		}
+
+		case IROp::CALL:
+		{
+			if(OpCall(instr.target_addr, instr.framesize))
+			{
+				CountCall(instr.target);
+				pc = instr.target;
+			}
+			break;
+		}
+
+		case IROp::RET:
+		{
+			OpRet(instr.num_args, instr.framesize);
+			return remap();
+		}
+
+		case IROp::EXTCALL:
+		{
+			const t_str& funcname = std::get<m_stridx>(
+				std::get<1>(m_ir_consts[instr.src1.addr]));
+
+			t_data retval = CallExternal(funcname);
+			PushData(retval, VMType::UNKNOWN, false);
+			break;
+		}
+	}
+
+	return IRStatus::OK;
+}
+
+
+/**
+ * get the value of an ir operand
+ */
+std::tuple<VMType, VM::t_data> VM::GetIROperand(const IROperand& opd)
+{
+	switch(opd.type)
+	{
+		case IROperandType::STACK:
+			return std::make_tuple(VMType::UNKNOWN, PopData());
+		case IROperandType::FRAME:
+			return ReadMemData(m_bp + opd.addr);
+		case IROperandType::MEM:
+			return ReadMemData(opd.addr);
+		case IROperandType::CONST:
+			return m_ir_consts[opd.addr];
+	}
+
+	throw std::runtime_error("Invalid ir operand.");
+}
+
+
+/**
+ * set the value of an ir operand
+ */
+void VM::SetIROperand(const IROperand& opd, const t_data& data, VMType ty)
+{
+	switch(opd.type)
+	{
+		case IROperandType::STACK:
+			PushData(data, ty);
+			break;
+		case IROperandType::FRAME:
+			WriteMemData(m_bp + opd.addr, data);
+			break;
+		case IROperandType::MEM:
+			WriteMemData(opd.addr, data);
+			break;
+		case IROperandType::CONST:
+			throw std::runtime_error("Cannot write to a constant.");
+	}
+}
+
+
+/**
+ * type conversion of an ir value
+ */
+VM::t_data VM::IRCast(OpCode op, const t_data& data)
+{
+	switch(op)
+	{
+		case OpCode::TOI: return OpCast<m_intidx>(data);
+		case OpCode::TOF: return OpCast<m_realidx>(data);
+		case OpCode::TOS: return OpCast<m_stridx>(data);
+		default: return data;
+	}
+}
+
+
+/**
+ * arithmetic operation on ir values
+ */
+VM::t_data VM::IRArithmetic(OpCode op, const t_data& val1, const t_data& val2)
+{
+	switch(op)
+	{
+		case OpCode::ADD: return OpArithmetic<'+'>(val1, val2);
+		case OpCode::SUB: return OpArithmetic<'-'>(val1, val2);
+		case OpCode::MUL: return OpArithmetic<'*'>(val1, val2);
+		case OpCode::DIV: return OpArithmetic<'/'>(val1, val2);
+		case OpCode::MOD: return OpArithmetic<'%'>(val1, val2);
+		case OpCode::POW: return OpArithmetic<'^'>(val1, val2);
+		case OpCode::EMUL: return OpElementwise<'*'>(val1, val2);
+		case OpCode::EDIV: return OpElementwise<'/'>(val1, val2);
+		default: throw std::runtime_error("Invalid ir arithmetic operation.");
+	}
+}
+
+
+/**
+ * comparison of ir values
+ */
+VM::t_bool VM::IRComparison(OpCode op, const t_data& val1, const t_data& val2)
+{
+	switch(op)
+	{
+		case OpCode::GT: return OpComparison<OpCode::GT>(val1, val2);
+		case OpCode::LT: return OpComparison<OpCode::LT>(val1, val2);
+		case OpCode::GEQU: return OpComparison<OpCode::GEQU>(val1, val2);
+		case OpCode::LEQU: return OpComparison<OpCode::LEQU>(val1, val2);
+		case OpCode::EQU: return OpComparison<OpCode::EQU>(val1, val2);
+		case OpCode::NEQU: return OpComparison<OpCode::NEQU>(val1, val2);
+		default: throw std::runtime_error("Invalid ir comparison.");
+	}
+}
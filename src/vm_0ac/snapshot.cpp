@@ -0,0 +1,189 @@
+/**
+ * zero-address code vm, snapshots of the vm state
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * A snapshot holds the memory, the registers, the interrupt and timer
+ * configuration and the precision settings of a vm. It is written in the
+ * sectioned binary format and resumed by VM::Load(), which maps the
+ * memory image copy-on-write, so that many vms can start from one image.
+ */
+
+#include "vm.h"
+#include "binfile.h"
+
+#include <fstream>
+#include <cstdio>
+
+
+static_assert(sizeof(BinState::isrs)/sizeof(BinState::isrs[0]) == VM::m_num_interrupts,
+	"Unexpected number of interrupts in snapshot.");
+
+
+/**
+ * save the vm state to a file from which it can be resumed using Load()
+ */
+void VM::SaveSnapshot(const std::string& filename)
+{
+	if(m_par_worker)
+		throw std::runtime_error("Cannot take a snapshot in a parallel loop.");
+
+	// registers and settings
+	BinState state{};
+	state.mem_size = static_cast<std::uint64_t>(m_memsize);
+	state.sp = m_sp;
+	state.bp = m_bp;
+	state.entry = m_entry;
+	for(int i=0; i<2; ++i)
+	{
+		state.code_range[i] = m_code_range[i];
+		state.prog_range[i] = m_prog_range[i];
+	}
+	state.stack_limit = m_stack_limit;
+	state.prec = m_prec;
+	state.eps = m_eps;
+	state.timer_ticks = m_timer_running ? m_timer_ticks.count() : -1;
+	for(t_addr irq=0; irq<m_num_interrupts; ++irq)
+		state.isrs[irq] = m_isrs[irq] ? *m_isrs[irq] : -1;
+
+	// function names, source lines and pure functions
+	std::ostringstream ostr_syms, ostr_lines, ostr_pure;
+	auto write_addr = [](std::ostream& ostr, t_addr val)
+	{
+		ostr.write(reinterpret_cast<const char*>(&val), sizeof(val));
+	};
+
+	for(const auto& [addr, name] : m_funcnames)
+	{
+		write_addr(ostr_syms, addr);
+		write_addr(ostr_syms, 0);
+		write_addr(ostr_syms, static_cast<t_addr>(name.length()));
+		ostr_syms.write(reinterpret_cast<const char*>(name.data()), name.length()*m_charsize);
+	}
+
+	for(const auto& [addr, line] : m_lines)
+	{
+		write_addr(ostr_lines, addr);
+		write_addr(ostr_lines, line);
+	}
+
+	for(const auto& [addr, func] : m_memo_funcs)
+	{
+		write_addr(ostr_pure, addr);
+		write_addr(ostr_pure, func.num_args);
+	}
+
+	const std::string syms = ostr_syms.str();
+	const std::string lines = ostr_lines.str();
+	const std::string pure = ostr_pure.str();
+
+	constexpr const std::uint16_t num_sections = 5;
+	BinHeader hdr = make_bin_header(num_sections, static_cast<std::uint32_t>(m_ip));
+
+	std::array<BinSection, num_sections> sections{};
+	sections[0].type = BinSectionType::STATE;
+	sections[0].offset = sizeof(BinHeader) + num_sections*sizeof(BinSection);
+	sections[0].size = sizeof(BinState);
+
+	sections[1].type = BinSectionType::SYMBOLS;
+	sections[1].offset = sections[0].offset + sections[0].size;
+	sections[1].size = syms.size();
+
+	sections[2].type = BinSectionType::LINES;
+	sections[2].offset = sections[1].offset + sections[1].size;
+	sections[2].size = lines.size();
+
+	sections[3].type = BinSectionType::PURE;
+	sections[3].offset = sections[2].offset + sections[2].size;
+	sections[3].size = pure.size();
+
+	// the memory image starts at an aligned file offset to be mappable
+	std::uint64_t mem_offs = sections[3].offset + sections[3].size;
+	mem_offs = (mem_offs + g_bin_align - 1) / g_bin_align * g_bin_align;
+
+	sections[4].type = BinSectionType::MEMORY;
+	sections[4].offset = mem_offs;
+	sections[4].size = state.mem_size;
+
+	// write to a temporary file first, so that an existing snapshot
+	// is only replaced by a complete one
+	const std::string tmpname = filename + ".tmp";
+	{
+		std::ofstream ofstr(tmpname, std::ios_base::binary);
+		if(!ofstr)
+			throw std::runtime_error("Cannot open snapshot file \"" + tmpname + "\".");
+
+		ofstr.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+		ofstr.write(reinterpret_cast<const char*>(sections.data()),
+			sections.size()*sizeof(BinSection));
+		ofstr.write(reinterpret_cast<const char*>(&state), sizeof(state));
+		ofstr.write(syms.data(), syms.size());
+		ofstr.write(lines.data(), lines.size());
+		ofstr.write(pure.data(), pure.size());
+
+		for(std::uint64_t pad = sections[3].offset + sections[3].size; pad < mem_offs; ++pad)
+			ofstr.put(0);
+		ofstr.write(reinterpret_cast<const char*>(m_mem.get()), m_memsize*m_bytesize);
+
+		ofstr.flush();
+		if(!ofstr)
+			throw std::runtime_error("Cannot write snapshot file \"" + tmpname + "\".");
+	}
+
+	if(std::rename(tmpname.c_str(), filename.c_str()) != 0)
+		throw std::runtime_error("Cannot write snapshot file \"" + filename + "\".");
+
+	if(m_debug)
+		std::cout << "Saved snapshot \"" << filename << "\" at ip = " << m_ip << "." << std::endl;
+}
+
+
+/**
+ * periodically save the vm state
+ */
+void VM::SetCheckpoint(const std::string& filename, std::chrono::milliseconds interval)
+{
+	StopCheckpoint();
+
+	m_checkpoint_file = filename;
+	m_checkpoint_interval = interval;
+
+	if(m_checkpoint_file != "" && m_checkpoint_interval.count() > 0)
+	{
+		m_checkpoint_running = true;
+		m_checkpoint_thread = std::thread(&VM::CheckpointFunc, this);
+	}
+}
+
+
+void VM::StopCheckpoint()
+{
+	{
+		std::lock_guard<std::mutex> lock{m_checkpoint_mtx};
+		m_checkpoint_running = false;
+	}
+	m_checkpoint_cv.notify_all();
+
+	if(m_checkpoint_thread.joinable())
+		m_checkpoint_thread.join();
+}
+
+
+/**
+ * function for checkpoint thread, the running program
+ * takes the snapshot at the next instruction
+ */
+void VM::CheckpointFunc()
+{
+	std::unique_lock<std::mutex> lock{m_checkpoint_mtx};
+
+	while(m_checkpoint_running)
+	{
+		if(m_checkpoint_cv.wait_for(lock, m_checkpoint_interval,
+			[this]() -> bool { return !m_checkpoint_running; }))
+			break;
+
+		RequestInterrupt(m_checkpoint_interrupt);
+	}
+}
@@ -0,0 +1,165 @@
+/**
+ * linear systems and matrix decompositions
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ */
+
+#include "vm.h"
+
+
+/**
+ * lu-decomposes a square matrix, returns nullptr for a singular or non-square matrix
+ */
+std::shared_ptr<const VM::LUFactor> VM::Decompose(const t_mat& mat)
+{
+	const std::size_t N = mat.size1();
+	if(N != mat.size2())
+		return nullptr;
+
+	auto factor = std::make_shared<LUFactor>();
+	factor->lu = mat;
+	t_real sign{};
+	if(!lu_decomp(factor->lu, factor->perm, sign, m_eps, GetPool(N*N, g_par_min_elems)))
+		return nullptr;
+
+	return factor;
+}
+
+
+/**
+ * solves M*x = b or M*X = B for a matrix or an lu decomposition handle,
+ * the result has the shape of the right-hand side
+ */
+VM::t_data VM::Solve(const t_data& lhs, const t_data& rhs)
+{
+	if(rhs.index() != m_vecidx && rhs.index() != m_matidx)
+		throw std::runtime_error("The right-hand side of a linear system has to be a vector or a matrix.");
+
+	std::shared_ptr<const LUFactor> factor;
+	if(lhs.index() == m_matidx)
+	{
+		factor = Decompose(std::get<m_matidx>(lhs));
+		if(!factor)
+			throw std::runtime_error("Linear system could not be solved, the matrix is singular or not square.");
+	}
+	else if(lhs.index() == m_intidx)
+	{
+		auto iter = m_factors.find(std::get<m_intidx>(lhs));
+		if(iter == m_factors.end())
+			throw std::runtime_error("Invalid lu decomposition handle.");
+		factor = iter->second;
+	}
+	else
+	{
+		throw std::runtime_error("Linear systems can only be solved for matrices or lu decomposition handles.");
+	}
+
+	const std::size_t N = factor->lu.size1();
+	t_data result = rhs;
+
+	if(result.index() == m_vecidx)
+	{
+		t_vec& x = std::get<m_vecidx>(result);
+		if(x.size() != N)
+			throw std::runtime_error("Dimension mismatch in linear system.");
+
+		lu_solve(factor->lu, factor->perm, x.data());
+	}
+	else
+	{
+		t_mat& X = std::get<m_matidx>(result);
+		if(X.size1() != N)
+			throw std::runtime_error("Dimension mismatch in linear system.");
+
+		lu_solve_cols(factor->lu, factor->perm, X.data(), X.size2(),
+			GetPool(N*N*X.size2(), g_par_min_flops));
+	}
+
+	return result;
+}
+
+
+/**
+ * lu-decomposes a square matrix and returns its handle,
+ * or -1 for a singular or non-square matrix
+ */
+VM::t_int VM::Factor(const t_data& mat)
+{
+	if(m_par_worker)
+		throw std::runtime_error("Cannot decompose a matrix in a parallel loop.");
+	if(mat.index() != m_matidx)
+		throw std::runtime_error("Only matrices can be lu-decomposed.");
+
+	auto factor = Decompose(std::get<m_matidx>(mat));
+	if(!factor)
+		return -1;
+
+	t_int handle = m_factor_next_handle++;
+	m_factors.emplace(handle, factor);
+	return handle;
+}
+
+
+/**
+ * frees an lu decomposition, returns -1 for an invalid handle
+ */
+VM::t_int VM::FactorFree(t_int handle)
+{
+	if(m_par_worker)
+		throw std::runtime_error("Cannot free an lu decomposition in a parallel loop.");
+
+	return m_factors.erase(handle) ? 0 : -1;
+}
+
+
+/**
+ * qr decomposition (returning Q and R), cholesky decomposition (returning L and
+ * 1, or a zero L and 0 if the matrix is not positive definite), or eigen decomposition
+ * of a symmetric matrix (returning the ascending eigenvalues and the eigenvectors as columns)
+ */
+std::vector<VM::t_data> VM::MatrixDecomposition(const t_str& func_name, const t_data& dat)
+{
+	if(dat.index() != m_matidx)
+		throw std::runtime_error("Only matrices can be decomposed by \"" + func_name + "\".");
+
+	const t_mat& mat = std::get<m_matidx>(dat);
+	const std::size_t rows = mat.size1(), cols = mat.size2();
+
+	if(func_name == "qr")
+	{
+		t_mat Q, R;
+		householder_qr(mat, Q, R, GetPool(rows*rows*cols, g_par_min_flops));
+
+		return {
+			t_data{std::in_place_index<m_matidx>, Q},
+			t_data{std::in_place_index<m_matidx>, R} };
+	}
+
+	if(rows != cols)
+		throw std::runtime_error("Only square matrices can be decomposed by \"" + func_name + "\".");
+
+	if(func_name == "chol")
+	{
+		t_mat L;
+		bool ok = cholesky(mat, L, GetPool(rows*rows*rows, g_par_min_flops));
+
+		return {
+			t_data{std::in_place_index<m_matidx>, L},
+			t_data{std::in_place_index<m_intidx>, t_int(ok ? 1 : 0)} };
+	}
+
+	if(func_name == "eig_sym")
+	{
+		t_vec evals;
+		t_mat evecs;
+		if(!eig_sym(mat, evals, evecs, GetPool(rows*rows*rows, g_par_min_flops)))
+			throw std::runtime_error("Eigen decomposition did not converge.");
+
+		return {
+			t_data{std::in_place_index<m_vecidx>, evals},
+			t_data{std::in_place_index<m_matidx>, evecs} };
+	}
+
+	throw std::runtime_error("Unknown matrix decomposition \"" + func_name + "\".");
+}
@@ -0,0 +1,670 @@
+/**
+ * element-wise math kernels for the vm
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * @see the cephes library for the approximations: https://www.netlib.org/cephes/
+ */
+
+#include "vecmath.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	#include <immintrin.h>
+	#define __0ACVM_VECMATH_AVX2__
+#endif
+
+
+using t_real = ::t_vm_real;
+using t_int = ThreadPool::t_int;
+
+// number of lanes evaluated at once
+constexpr const std::size_t g_lanes = 4;
+
+// number of elements per block of a fused expression
+constexpr const std::size_t g_fused_block = 256;
+
+using t_lanes = double __attribute__((vector_size(g_lanes*sizeof(double))));
+using t_ilanes = std::int64_t __attribute__((vector_size(g_lanes*sizeof(std::int64_t))));
+
+#define VECMATH_INLINE inline __attribute__((always_inline))
+
+// the kernels are always inlined, passing the lanes by value does not concern the abi
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// adding and subtracting 1.5 * 2^52 rounds to the nearest integer,
+// which is then also found in the low bits of the sum
+constexpr const double g_round = 0x1.8p52;
+
+// ranges of the approximations
+constexpr const double g_trig_range = 0x1p20;
+constexpr const double g_exp_range = 708.;
+
+// largest integer exponent multiplied out, the error grows with the number of products
+constexpr const std::int64_t g_pow_max_mult = 4;
+
+
+/**
+ * bitwise selection, lanes with a set mask get a, the others b
+ */
+static VECMATH_INLINE t_lanes select(t_ilanes mask, t_lanes a, t_lanes b)
+{
+	return __builtin_bit_cast(t_lanes,
+		(mask & __builtin_bit_cast(t_ilanes, a)) | (~mask & __builtin_bit_cast(t_ilanes, b)));
+}
+
+
+/**
+ * x = q*pi/2 + r with |r| <= pi/4, the quadrant q is in the low bits of quadrant
+ */
+static VECMATH_INLINE t_lanes reduce_pio2(t_lanes x, t_ilanes& quadrant)
+{
+	// pi/2 split into three parts for an exact product with q
+	constexpr const double pio2_1 = 1.57079625129699707031e0;
+	constexpr const double pio2_2 = 7.54978941586159635335e-8;
+	constexpr const double pio2_3 = 5.39030285815811905290e-15;
+
+	const t_lanes rounded = x*0.63661977236758134308 + g_round;
+	const t_lanes q = rounded - g_round;
+	quadrant = __builtin_bit_cast(t_ilanes, rounded);
+
+	return ((x - q*pio2_1) - q*pio2_2) - q*pio2_3;
+}
+
+
+/**
+ * sin(r) for |r| <= pi/4, zz = r^2
+ */
+static VECMATH_INLINE t_lanes sin_poly(t_lanes r, t_lanes zz)
+{
+	t_lanes p = zz*1.58962301576546568060e-10 - 2.50507477628578072866e-8;
+	p = p*zz + 2.75573136213857245213e-6;
+	p = p*zz - 1.98412698295895385996e-4;
+	p = p*zz + 8.33333333332211858878e-3;
+	p = p*zz - 1.66666666666666307295e-1;
+	return r + r*zz*p;
+}
+
+
+/**
+ * cos(r) for |r| <= pi/4, zz = r^2
+ */
+static VECMATH_INLINE t_lanes cos_poly(t_lanes zz)
+{
+	t_lanes p = zz*-1.13585365213876817300e-11 + 2.08757008419747316778e-9;
+	p = p*zz - 2.75573141792967388112e-7;
+	p = p*zz + 2.48015872888517045348e-5;
+	p = p*zz - 1.38888888888730564116e-3;
+	p = p*zz + 4.16666666666665929218e-2;
+	return 1. - zz*0.5 + zz*zz*p;
+}
+
+
+/**
+ * sin(x) or, shifted by a quadrant, cos(x)
+ */
+static VECMATH_INLINE t_lanes sin_lanes(t_lanes x, std::int64_t shift)
+{
+	t_ilanes quadrant;
+	const t_lanes r = reduce_pio2(x, quadrant);
+	const t_lanes zz = r*r;
+	quadrant += shift;
+
+	// odd quadrants use the cosine, the upper two negate the result
+	const t_ilanes use_cos = (quadrant & 1) != 0;
+	const t_ilanes sign = (quadrant & 2) << 62;
+	const t_lanes val = select(use_cos, cos_poly(zz), sin_poly(r, zz));
+	return __builtin_bit_cast(t_lanes, __builtin_bit_cast(t_ilanes, val) ^ sign);
+}
+
+
+/**
+ * tan(x) = sin(r)/cos(r), or -cos(r)/sin(r) in odd quadrants
+ */
+static VECMATH_INLINE t_lanes tan_lanes(t_lanes x)
+{
+	t_ilanes quadrant;
+	const t_lanes r = reduce_pio2(x, quadrant);
+	const t_lanes zz = r*r;
+	const t_lanes s = sin_poly(r, zz);
+	const t_lanes c = cos_poly(zz);
+
+	const t_ilanes odd = (quadrant & 1) != 0;
+	return select(odd, -c, s) / select(odd, s, c);
+}
+
+
+/**
+ * exp(x) = 2^n * exp(r) with |r| <= ln(2)/2 and a rational approximation for exp(r)
+ */
+static VECMATH_INLINE t_lanes exp_lanes(t_lanes x)
+{
+	// ln(2) split into two parts for an exact product with n
+	constexpr const double ln2_1 = 6.93145751953125e-1;
+	constexpr const double ln2_2 = 1.42860682030941723212e-6;
+
+	const t_lanes rounded = x*1.4426950408889634073599 + g_round;
+	const t_lanes n = rounded - g_round;
+	const t_lanes r = (x - n*ln2_1) - n*ln2_2;
+	const t_lanes rr = r*r;
+
+	const t_lanes p = r*((rr*1.26177193074810590878e-4 + 3.02994407707441961300e-2)*rr
+		+ 9.99999999999999999910e-1);
+	const t_lanes q = ((rr*3.00198505138664455042e-6 + 2.52448340349684104192e-3)*rr
+		+ 2.27265548208155028766e-1)*rr + 2.00000000000000000009e0;
+	const t_lanes e = 1. + 2.*(p / (q - p));
+
+	// 2^n from the exponent bits
+	const t_ilanes nbits = __builtin_bit_cast(t_ilanes, rounded)
+		- __builtin_bit_cast(std::int64_t, g_round);
+	return e * __builtin_bit_cast(t_lanes, (nbits + 1023) << 52);
+}
+
+
+/**
+ * x^exp for a small integer exponent 0 <= exp <= g_pow_max_mult by repeated squaring
+ */
+static VECMATH_INLINE t_lanes pow_lanes(t_lanes x, std::int64_t exp)
+{
+	t_lanes result = t_lanes{} + 1.;
+	while(exp)
+	{
+		if(exp & 1)
+			result *= x;
+		exp >>= 1;
+		if(exp)
+			x *= x;
+	}
+	return result;
+}
+
+
+/**
+ * reference function and range of an approximation
+ */
+template<VecMathFunc func>
+static VECMATH_INLINE t_real eval_scalar(t_real x)
+{
+	if constexpr(func == VecMathFunc::SIN)
+		return std::sin(x);
+	else if constexpr(func == VecMathFunc::COS)
+		return std::cos(x);
+	else if constexpr(func == VecMathFunc::TAN)
+		return std::tan(x);
+	else if constexpr(func == VecMathFunc::EXP)
+		return std::exp(x);
+	else
+		return std::sqrt(x);
+}
+
+
+template<VecMathFunc func>
+static VECMATH_INLINE bool in_range(t_real x)
+{
+	if constexpr(func == VecMathFunc::EXP)
+		return std::abs(x) <= g_exp_range;
+	else
+		return std::abs(x) <= g_trig_range;  // also false for nan
+}
+
+
+template<VecMathFunc func>
+static VECMATH_INLINE t_lanes eval_lanes(t_lanes x)
+{
+	if constexpr(func == VecMathFunc::SIN)
+		return sin_lanes(x, 0);
+	else if constexpr(func == VecMathFunc::COS)
+		return sin_lanes(x, 1);
+	else if constexpr(func == VecMathFunc::TAN)
+		return tan_lanes(x);
+	else
+		return exp_lanes(x);
+}
+
+
+/**
+ * evaluates the lanes in groups, the last group is padded with zeros
+ */
+template<VecMathFunc func>
+static VECMATH_INLINE void run_func(const t_real* x, t_real* y, std::size_t N)
+{
+	for(std::size_t i=0; i<N; i+=g_lanes)
+	{
+		const std::size_t num = std::min(g_lanes, N - i);
+
+		t_lanes in{};
+		std::memcpy(&in, x + i, num*sizeof(t_real));
+		t_lanes out = eval_lanes<func>(in);
+
+		// arguments outside the approximation's range
+		for(std::size_t lane=0; lane<num; ++lane)
+		{
+			if(!in_range<func>(in[lane]))
+				out[lane] = eval_scalar<func>(in[lane]);
+		}
+
+		std::memcpy(y + i, &out, num*sizeof(t_real));
+	}
+}
+
+
+static VECMATH_INLINE void run(VecMathFunc func, const t_real* x, t_real* y, std::size_t N)
+{
+	switch(func)
+	{
+		case VecMathFunc::SIN: run_func<VecMathFunc::SIN>(x, y, N); break;
+		case VecMathFunc::COS: run_func<VecMathFunc::COS>(x, y, N); break;
+		case VecMathFunc::TAN: run_func<VecMathFunc::TAN>(x, y, N); break;
+		case VecMathFunc::EXP: run_func<VecMathFunc::EXP>(x, y, N); break;
+		case VecMathFunc::SQRT:
+		{
+			for(std::size_t i=0; i<N; ++i)
+				y[i] = std::sqrt(x[i]);
+			break;
+		}
+	}
+}
+
+
+static void run_generic(VecMathFunc func, const t_real* x, t_real* y, std::size_t N)
+{
+	run(func, x, y, N);
+}
+
+
+#ifdef __0ACVM_VECMATH_AVX2__
+/**
+ * the same kernels compiled for avx2/fma
+ */
+__attribute__((target("avx2,fma")))
+static void run_avx2(VecMathFunc func, const t_real* x, t_real* y, std::size_t N)
+{
+	if(func != VecMathFunc::SQRT)
+	{
+		run(func, x, y, N);
+		return;
+	}
+
+	std::size_t i = 0;
+	for(; i+g_lanes<=N; i+=g_lanes)
+		_mm256_storeu_pd(y + i, _mm256_sqrt_pd(_mm256_loadu_pd(x + i)));
+	for(; i<N; ++i)
+		y[i] = std::sqrt(x[i]);
+}
+#endif
+
+
+/**
+ * element-wise arithmetic on all lanes
+ */
+template<VecArithOp op, class t_val>
+static VECMATH_INLINE t_val arith(t_val a, t_val b)
+{
+	if constexpr(op == VecArithOp::ADD)
+		return a + b;
+	else if constexpr(op == VecArithOp::SUB)
+		return a - b;
+	else if constexpr(op == VecArithOp::MUL)
+		return a * b;
+	else
+		return a / b;
+}
+
+
+/**
+ * evaluates the lanes in groups, broadcast operands are read only once
+ */
+template<VecArithOp op, bool x_bcast, bool y_bcast>
+static VECMATH_INLINE void run_arith_op(const t_real* x, const t_real* y, t_real* z, std::size_t N)
+{
+	t_lanes a{}, b{};
+	if constexpr(x_bcast)
+		a += *x;
+	if constexpr(y_bcast)
+		b += *y;
+
+	std::size_t i = 0;
+	for(; i+g_lanes<=N; i+=g_lanes)
+	{
+		if constexpr(!x_bcast)
+			std::memcpy(&a, x + i, sizeof(t_lanes));
+		if constexpr(!y_bcast)
+			std::memcpy(&b, y + i, sizeof(t_lanes));
+
+		const t_lanes c = arith<op>(a, b);
+		std::memcpy(z + i, &c, sizeof(t_lanes));
+	}
+
+	for(; i<N; ++i)
+		z[i] = arith<op>(x[x_bcast ? 0 : i], y[y_bcast ? 0 : i]);
+}
+
+
+template<VecArithOp op>
+static VECMATH_INLINE void run_arith_op(const t_real* x, std::size_t x_stride,
+	const t_real* y, std::size_t y_stride, t_real* z, std::size_t N)
+{
+	if(x_stride && y_stride)
+		run_arith_op<op, false, false>(x, y, z, N);
+	else if(y_stride)
+		run_arith_op<op, true, false>(x, y, z, N);
+	else if(x_stride)
+		run_arith_op<op, false, true>(x, y, z, N);
+	else
+		run_arith_op<op, true, true>(x, y, z, N);
+}
+
+
+static VECMATH_INLINE void run_arith(VecArithOp op, const t_real* x, std::size_t x_stride,
+	const t_real* y, std::size_t y_stride, t_real* z, std::size_t N)
+{
+	switch(op)
+	{
+		case VecArithOp::ADD: run_arith_op<VecArithOp::ADD>(x, x_stride, y, y_stride, z, N); break;
+		case VecArithOp::SUB: run_arith_op<VecArithOp::SUB>(x, x_stride, y, y_stride, z, N); break;
+		case VecArithOp::MUL: run_arith_op<VecArithOp::MUL>(x, x_stride, y, y_stride, z, N); break;
+		case VecArithOp::DIV: run_arith_op<VecArithOp::DIV>(x, x_stride, y, y_stride, z, N); break;
+	}
+}
+
+
+static void run_arith_generic(VecArithOp op, const t_real* x, std::size_t x_stride,
+	const t_real* y, std::size_t y_stride, t_real* z, std::size_t N)
+{
+	run_arith(op, x, x_stride, y, y_stride, z, N);
+}
+
+
+#ifdef __0ACVM_VECMATH_AVX2__
+__attribute__((target("avx2,fma")))
+static void run_arith_avx2(VecArithOp op, const t_real* x, std::size_t x_stride,
+	const t_real* y, std::size_t y_stride, t_real* z, std::size_t N)
+{
+	run_arith(op, x, x_stride, y, y_stride, z, N);
+}
+#endif
+
+
+/**
+ * element-wise arithmetic without lanes, for other real types
+ */
+static void run_arith_scalar(VecArithOp op, const t_real* x, std::size_t x_stride,
+	const t_real* y, std::size_t y_stride, t_real* z, std::size_t N)
+{
+	for(std::size_t i=0; i<N; ++i)
+	{
+		const t_real a = x[i*x_stride], b = y[i*y_stride];
+		switch(op)
+		{
+			case VecArithOp::ADD: z[i] = a + b; break;
+			case VecArithOp::SUB: z[i] = a - b; break;
+			case VecArithOp::MUL: z[i] = a * b; break;
+			case VecArithOp::DIV: z[i] = a / b; break;
+		}
+	}
+}
+
+
+/**
+ * evaluates a fused expression on blocks of elements, the intermediate
+ * results of a block are kept in buf, which has room for a block per stack level
+ */
+static VECMATH_INLINE void run_fused(const t_vm_str& prog, const VecOperand* operands,
+	t_real* z, std::size_t N, t_real* buf, VecOperand* stack)
+{
+	static const t_real zero{};
+
+	for(std::size_t blk=0; blk<N; blk+=g_fused_block)
+	{
+		const std::size_t num = std::min(g_fused_block, N - blk);
+		std::size_t sp = 0, opnd = 0;
+
+		for(std::size_t instr=0; instr<prog.size(); ++instr)
+		{
+			const FusedOp op = static_cast<FusedOp>(prog[instr]);
+			if(op == FusedOp::LOAD)
+			{
+				const VecOperand& operand = operands[opnd++];
+				stack[sp++] = VecOperand{ operand.elems + blk*operand.stride, operand.stride };
+				continue;
+			}
+
+			const bool unary = (op == FusedOp::NEG);
+			const VecOperand x = unary ? VecOperand{ &zero, 0 } : stack[sp - 2];
+			const VecOperand& y = stack[sp - 1];
+			if(!unary)
+				--sp;
+
+			// scalars stay scalars, the last instruction writes directly into the result
+			const bool scalar = (x.stride == 0 && y.stride == 0);
+			t_real* out = buf + (sp - 1)*g_fused_block;
+			if(!scalar && instr + 1 == prog.size())
+				out = z + blk;
+
+			VecArithOp arith_op = VecArithOp::SUB;
+			switch(op)
+			{
+				case FusedOp::ADD: arith_op = VecArithOp::ADD; break;
+				case FusedOp::MUL: arith_op = VecArithOp::MUL; break;
+				case FusedOp::DIV: arith_op = VecArithOp::DIV; break;
+				default: break;
+			}
+
+			if constexpr(std::is_same_v<t_real, double>)
+				run_arith(arith_op, x.elems, x.stride, y.elems, y.stride, out, scalar ? 1 : num);
+			else
+				run_arith_scalar(arith_op, x.elems, x.stride, y.elems, y.stride, out, scalar ? 1 : num);
+			stack[sp - 1] = VecOperand{ out, scalar ? std::size_t(0) : std::size_t(1) };
+		}
+
+		// copy or broadcast a result that has not been written yet
+		const VecOperand& result = stack[0];
+		if(result.elems != z + blk)
+		{
+			for(std::size_t i=0; i<num; ++i)
+				z[blk + i] = result.elems[i*result.stride];
+		}
+	}
+}
+
+
+static void run_fused_generic(const t_vm_str& prog, const VecOperand* operands,
+	t_real* z, std::size_t N, t_real* buf, VecOperand* stack)
+{
+	run_fused(prog, operands, z, N, buf, stack);
+}
+
+
+#ifdef __0ACVM_VECMATH_AVX2__
+__attribute__((target("avx2,fma")))
+static void run_fused_avx2(const t_vm_str& prog, const VecOperand* operands,
+	t_real* z, std::size_t N, t_real* buf, VecOperand* stack)
+{
+	run_fused(prog, operands, z, N, buf, stack);
+}
+#endif
+
+
+using t_runner = void(*)(VecMathFunc func, const t_real* x, t_real* y, std::size_t N);
+using t_arith_runner = void(*)(VecArithOp op, const t_real* x, std::size_t x_stride,
+	const t_real* y, std::size_t y_stride, t_real* z, std::size_t N);
+using t_fused_runner = void(*)(const t_vm_str& prog, const VecOperand* operands,
+	t_real* z, std::size_t N, t_real* buf, VecOperand* stack);
+
+
+/**
+ * checks if the cpu the vm runs on supports the avx2/fma kernels
+ */
+static bool has_avx2()
+{
+#ifdef __0ACVM_VECMATH_AVX2__
+	static const bool avx2 = []() -> bool
+	{
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	}();
+
+	return avx2;
+#else
+	return false;
+#endif
+}
+
+
+/**
+ * selects the kernels for the cpu the vm runs on
+ */
+static t_runner get_runner()
+{
+#ifdef __0ACVM_VECMATH_AVX2__
+	if(has_avx2())
+		return run_avx2;
+#endif
+	return run_generic;
+}
+
+
+static t_arith_runner get_arith_runner()
+{
+#ifdef __0ACVM_VECMATH_AVX2__
+	if(has_avx2())
+		return run_arith_avx2;
+#endif
+	return run_arith_generic;
+}
+
+
+static t_fused_runner get_fused_runner()
+{
+#ifdef __0ACVM_VECMATH_AVX2__
+	if(has_avx2())
+		return run_fused_avx2;
+#endif
+	return run_fused_generic;
+}
+
+
+void vec_math(VecMathFunc func, const t_real* x, t_real* y, std::size_t N, ThreadPool* pool)
+{
+	par_for(pool, N, g_par_min_elems, 0, static_cast<t_int>(N),
+		[func, x, y](t_int begin, t_int end)
+	{
+		if constexpr(std::is_same_v<t_real, double>)
+		{
+			get_runner()(func, x + begin, y + begin, static_cast<std::size_t>(end - begin));
+		}
+		else
+		{
+			for(t_int i=begin; i<end; ++i)
+			{
+				switch(func)
+				{
+					case VecMathFunc::SIN: y[i] = std::sin(x[i]); break;
+					case VecMathFunc::COS: y[i] = std::cos(x[i]); break;
+					case VecMathFunc::TAN: y[i] = std::tan(x[i]); break;
+					case VecMathFunc::EXP: y[i] = std::exp(x[i]); break;
+					case VecMathFunc::SQRT: y[i] = std::sqrt(x[i]); break;
+				}
+			}
+		}
+	});
+}
+
+
+void vec_pow(const t_real* x, t_real exp, t_real* y, std::size_t N, ThreadPool* pool)
+{
+	if(exp == t_real(0.5))
+	{
+		vec_math(VecMathFunc::SQRT, x, y, N, pool);
+		return;
+	}
+
+	const bool int_exp = std::abs(exp) <= t_real(g_pow_max_mult) && exp == std::trunc(exp);
+
+	par_for(pool, N, g_par_min_elems, 0, static_cast<t_int>(N),
+		[x, y, exp, int_exp](t_int begin, t_int end)
+	{
+		if constexpr(std::is_same_v<t_real, double>)
+		{
+			if(int_exp)
+			{
+				const std::int64_t iexp = static_cast<std::int64_t>(std::abs(exp));
+				const bool invert = exp < t_real(0);
+
+				for(t_int i=begin; i<end; i+=g_lanes)
+				{
+					const std::size_t num = std::min<std::size_t>(g_lanes, end - i);
+
+					t_lanes in{};
+					std::memcpy(&in, x + i, num*sizeof(t_real));
+					t_lanes out = pow_lanes(in, iexp);
+					if(invert)
+						out = 1. / out;
+					std::memcpy(y + i, &out, num*sizeof(t_real));
+				}
+				return;
+			}
+		}
+
+		for(t_int i=begin; i<end; ++i)
+			y[i] = std::pow(x[i], exp);
+	});
+}
+
+
+void vec_arith(VecArithOp op,
+	const t_real* x, std::size_t x_stride,
+	const t_real* y, std::size_t y_stride,
+	t_real* z, std::size_t N, ThreadPool* pool)
+{
+	par_for(pool, N, g_par_min_elems, 0, static_cast<t_int>(N),
+		[op, x, x_stride, y, y_stride, z](t_int begin, t_int end)
+	{
+		const t_real* x_begin = x + begin*x_stride;
+		const t_real* y_begin = y + begin*y_stride;
+
+		if constexpr(std::is_same_v<t_real, double>)
+		{
+			get_arith_runner()(op, x_begin, x_stride, y_begin, y_stride,
+				z + begin, static_cast<std::size_t>(end - begin));
+		}
+		else
+		{
+			run_arith_scalar(op, x_begin, x_stride, y_begin, y_stride,
+				z + begin, static_cast<std::size_t>(end - begin));
+		}
+	});
+}
+
+
+void vec_fused(const t_vm_str& prog, const std::vector<VecOperand>& operands,
+	t_real* z, std::size_t N, ThreadPool* pool)
+{
+	const auto sizes = check_fused_prog(prog);
+	if(!sizes || sizes->first != operands.size())
+		throw std::runtime_error("Invalid fused expression.");
+	const std::size_t depth = sizes->second;
+
+	par_for(pool, N, g_par_min_elems, 0, static_cast<t_int>(N),
+		[&prog, &operands, z, depth](t_int begin, t_int end)
+	{
+		std::vector<VecOperand> chunk_operands = operands;
+		for(VecOperand& operand : chunk_operands)
+			operand.elems += begin*operand.stride;
+
+		std::vector<t_real> buf(depth * g_fused_block);
+		std::vector<VecOperand> stack(depth);
+
+		get_fused_runner()(prog, chunk_operands.data(), z + begin,
+			static_cast<std::size_t>(end - begin), buf.data(), stack.data());
+	});
+}
@@ -0,0 +1,89 @@
+/**
+ * element-wise math kernels for the vm
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * sin, cos, tan and exp are evaluated on groups of four lanes using the
+ * polynomial and rational approximations of the cephes library after a
+ * cody-waite argument reduction. Compared to the correctly rounded values,
+ * the maximum errors are 2 ulp for sin, cos and exp and 4 ulp for tan in
+ * the approximations' ranges |x| <= 2^20 (sin, cos, tan) and |x| <= 708 (exp).
+ * Other arguments, infinities and nans are passed on to the c library.
+ * sqrt is correctly rounded. Integer powers with |n| <= 4 are multiplied out
+ * with errors up to 2 ulp (4 ulp for negative n), all other powers use the
+ * c library, as for scalars.
+ * Element-wise arithmetic between arrays, or between an array and a scalar,
+ * is also evaluated on groups of lanes. Fused expressions are evaluated
+ * block-wise, keeping only one block of each intermediate result.
+ * An avx2/fma variant of the kernels is selected at run time if the cpu supports it.
+ * Large arrays are split across the threads of the given pool.
+ */
+
+#ifndef __0ACVM_VECMATH_H__
+#define __0ACVM_VECMATH_H__
+
+#include <cstddef>
+
+#include "types.h"
+#include "opcodes.h"
+#include "pool.h"
+
+
+enum class VecMathFunc
+{
+	SIN, COS, TAN, EXP, SQRT,
+};
+
+
+enum class VecArithOp
+{
+	ADD, SUB, MUL, DIV,
+};
+
+
+/**
+ * operand of a fused expression, a stride of 0 marks a scalar
+ */
+struct VecOperand
+{
+	const t_vm_real* elems{nullptr};
+	std::size_t stride{1};
+};
+
+
+/**
+ * y_i = func(x_i), x and y may be the same array
+ */
+extern void vec_math(VecMathFunc func, const t_vm_real* x, t_vm_real* y,
+	std::size_t N, ThreadPool* pool = nullptr);
+
+
+/**
+ * y_i = x_i^exp, x and y may be the same array
+ */
+extern void vec_pow(const t_vm_real* x, t_vm_real exp, t_vm_real* y,
+	std::size_t N, ThreadPool* pool = nullptr);
+
+
+
+/**
+ * z_i = x_i op y_i, an operand with stride 0 is a scalar which is combined
+ * with all elements, z may be the same array as x or y
+ */
+extern void vec_arith(VecArithOp op,
+	const t_vm_real* x, std::size_t x_stride,
+	const t_vm_real* y, std::size_t y_stride,
+	t_vm_real* z, std::size_t N, ThreadPool* pool = nullptr);
+
+
+/**
+ * evaluates the postfix program of a FUSED operation in one pass over the
+ * operands, without intermediate arrays, see check_fused_prog(),
+ * z may be the same array as an operand
+ */
+extern void vec_fused(const t_vm_str& prog, const std::vector<VecOperand>& operands,
+	t_vm_real* z, std::size_t N, ThreadPool* pool = nullptr);
+
+
+#endif
@@ -0,0 +1,1264 @@
+/**
+ * zero-address code vm, load-time bytecode verifier
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE.GPL' file
+ *
+ * The verifier follows all reachable code paths starting at the entry point
+ * and keeps track of the depth and the value types of the stack for every
+ * instruction (relative to the stack frame of the enclosing function).
+ * It checks that:
+ *	- all instructions are valid and lie within the code range,
+ *	- jumps and calls go to constant addresses at instruction boundaries,
+ *	- the stack never underflows and has the same layout at join points,
+ *	- operands have matching types, as far as they are statically known,
+ *	- memory is only accessed at constant addresses in the current stack
+ *	  frame, the function arguments or the program's constants,
+ *	- the frame sizes and argument counts of calls and returns agree,
+ *	- only known external functions are called.
+ */
+
+#include "vm.h"
+
+#include <map>
+#include <set>
+#include <deque>
+
+
+namespace {
+
+using t_addr = VM::t_addr;
+using t_int = VM::t_int;
+using t_str = VM::t_str;
+
+
+/**
+ * kinds of values on the abstract stack
+ */
+enum class VerKind : t_vm_byte
+{
+	BOOL,       // raw boolean without type descriptor
+	REAL,
+	INT,
+	STR,
+	VEC,
+	MAT,
+	DATA,       // typed value of unknown type
+	ADDR,
+};
+
+
+/**
+ * value on the abstract stack
+ */
+struct VerValue
+{
+	VerKind kind{VerKind::DATA};
+	VMType reg{VMType::UNKNOWN};     // base register of an address
+	std::optional<t_int> val{};      // known integer value or address offset
+	std::optional<t_str> str{};      // known string value
+
+	bool operator==(const VerValue&) const = default;
+};
+
+
+using t_verstack = std::vector<VerValue>;
+
+
+/**
+ * state of the abstract interpretation at an instruction
+ */
+struct VerState
+{
+	t_addr func{};                   // entry address of the enclosing function
+	t_verstack stack{};
+};
+
+
+/**
+ * function summary
+ */
+struct VerFunc
+{
+	bool toplevel{false};            // start-up code, not called
+	t_int framesize{};               // size of the local variables
+	std::optional<t_int> num_args{}; // known after a return has been reached
+	t_verstack rets{};               // return values
+	std::set<t_addr> callsites{};    // calls to this function
+};
+
+
+/**
+ * external function signature: number of arguments and return values
+ */
+struct VerExtFunc
+{
+	t_int num_args{};
+	std::optional<VerKind> ret{};
+	std::optional<t_int> ref_arg{};  // argument passed as variable address
+	std::vector<VerKind> more_rets{}; // further return values below the first one
+};
+
+
+/**
+ * get the signatures of the functions known to VM::CallExternal()
+ */
+static std::optional<VerExtFunc> get_ext_func(const t_str& name)
+{
+	static const std::map<t_str, VerExtFunc> funcs
+	{
+		{ "abs", { 1, VerKind::DATA } },
+		{ "fabs", { 1, VerKind::DATA } },
+		{ "norm", { 1, VerKind::DATA } },
+		{ "determinant", { 1, VerKind::DATA } },
+		{ "transpose", { 1, VerKind::DATA } },
+
+		{ "sqrt", { 1, VerKind::DATA } },
+		{ "pow", { 2, VerKind::DATA } },
+		{ "exp", { 1, VerKind::DATA } },
+		{ "sin", { 1, VerKind::DATA } },
+		{ "cos", { 1, VerKind::DATA } },
+		{ "tan", { 1, VerKind::DATA } },
+
+		{ "sum", { 1, VerKind::REAL } },
+		{ "prod", { 1, VerKind::REAL } },
+		{ "min", { 1, VerKind::REAL } },
+		{ "max", { 1, VerKind::REAL } },
+		{ "mean", { 1, VerKind::REAL } },
+		{ "argmin", { 1, VerKind::INT } },
+		{ "argmax", { 1, VerKind::INT } },
+		{ "sum_axis", { 3, VerKind::INT, 2 } },
+		{ "prod_axis", { 3, VerKind::INT, 2 } },
+		{ "min_axis", { 3, VerKind::INT, 2 } },
+		{ "max_axis", { 3, VerKind::INT, 2 } },
+		{ "mean_axis", { 3, VerKind::INT, 2 } },
+		{ "argmin_axis", { 3, VerKind::INT, 2 } },
+		{ "argmax_axis", { 3, VerKind::INT, 2 } },
+
+		{ "set_eps", { 1, std::nullopt } },
+		{ "set_prec", { 1, std::nullopt } },
+		{ "get_eps", { 0, VerKind::REAL } },
+
+		{ "to_str", { 1, VerKind::STR } },
+		{ "flt_to_str", { 1, VerKind::STR } },
+		{ "int_to_str", { 1, VerKind::STR } },
+
+		{ "putstr", { 1, std::nullopt } },
+		{ "putflt", { 1, std::nullopt } },
+		{ "putint", { 1, std::nullopt } },
+		{ "flush", { 0, std::nullopt } },
+		{ "getflt", { 1, VerKind::REAL } },
+		{ "getint", { 1, VerKind::INT } },
+
+		{ "load_vec", { 2, VerKind::INT, 1 } },
+		{ "load_mat", { 2, VerKind::INT, 1 } },
+		{ "save_vec", { 2, VerKind::INT, 1 } },
+		{ "save_mat", { 2, VerKind::INT, 1 } },
+
+		{ "csv_open", { 1, VerKind::INT } },
+		{ "csv_next_rows", { 2, VerKind::INT, 1 } },
+		{ "csv_close", { 1, VerKind::INT } },
+
+		{ "solve", { 2, VerKind::DATA } },
+		{ "inv_mult", { 2, VerKind::DATA } },
+		{ "factor", { 1, VerKind::INT } },
+		{ "factor_free", { 1, VerKind::INT } },
+		{ "qr", { 1, VerKind::MAT, std::nullopt, { VerKind::MAT } } },
+		{ "chol", { 1, VerKind::MAT, std::nullopt, { VerKind::INT } } },
+		{ "eig_sym", { 1, VerKind::VEC, std::nullopt, { VerKind::MAT } } },
+
+		{ "sleep", { 1, std::nullopt } },
+		{ "set_timer", { 1, std::nullopt } },
+		{ "set_debug", { 1, std::nullopt } },
+		{ "snapshot", { 1, VerKind::INT } },
+
+		// "set_isr" is not allowed, as the interrupt
+		// service routine addresses are only known at runtime
+	};
+
+	if(auto iter = funcs.find(name); iter != funcs.end())
+		return iter->second;
+	return std::nullopt;
+}
+
+
+static bool is_typed(VerKind kind)
+{
+	return kind != VerKind::BOOL && kind != VerKind::ADDR;
+}
+
+
+static const char* get_kind_name(VerKind kind)
+{
+	switch(kind)
+	{
+		case VerKind::BOOL: return "boolean";
+		case VerKind::REAL: return "real";
+		case VerKind::INT: return "integer";
+		case VerKind::STR: return "string";
+		case VerKind::VEC: return "vector";
+		case VerKind::MAT: return "matrix";
+		case VerKind::DATA: return "data";
+		case VerKind::ADDR: return "address";
+	}
+
+	return "unknown";
+}
+
+
+/**
+ * get the result type of an arithmetic operation, see VM::OpArithmetic()
+ */
+static std::optional<VerKind> get_arith_kind(OpCode op, VerKind kind1, VerKind kind2)
+{
+	if(kind1 == VerKind::DATA || kind2 == VerKind::DATA)
+		return VerKind::DATA;
+
+	if(kind1 == VerKind::MAT && kind2 == VerKind::VEC && op == OpCode::MUL)
+		return VerKind::VEC;
+	if(kind1 == VerKind::MAT && kind2 == VerKind::REAL && op == OpCode::POW)
+		return VerKind::MAT;
+	if(kind1 == VerKind::VEC && kind2 == VerKind::VEC && op == OpCode::MUL)
+		return VerKind::REAL;
+	if(kind1 == VerKind::VEC && kind2 == VerKind::REAL && (op == OpCode::MUL || op == OpCode::DIV))
+		return VerKind::VEC;
+	if(kind1 == VerKind::REAL && kind2 == VerKind::VEC && op == OpCode::MUL)
+		return VerKind::VEC;
+	if(kind1 == VerKind::MAT && kind2 == VerKind::REAL && (op == OpCode::MUL || op == OpCode::DIV))
+		return VerKind::MAT;
+	if(kind1 == VerKind::REAL && kind2 == VerKind::MAT && op == OpCode::MUL)
+		return VerKind::MAT;
+
+	// element-wise operations, scalars are combined with all array elements
+	const bool elementwise = (op == OpCode::ADD || op == OpCode::SUB ||
+		op == OpCode::EMUL || op == OpCode::EDIV);
+	const bool is_scalar1 = (kind1 == VerKind::REAL || kind1 == VerKind::INT);
+	const bool is_scalar2 = (kind2 == VerKind::REAL || kind2 == VerKind::INT);
+	if(elementwise && (kind1 == VerKind::VEC || kind1 == VerKind::MAT) && is_scalar2)
+		return kind1;
+	if(elementwise && (kind2 == VerKind::VEC || kind2 == VerKind::MAT) && is_scalar1)
+		return kind2;
+
+	if(kind1 == kind2)
+		return kind1;
+
+	return std::nullopt;
+}
+
+
+/**
+ * get the type of a value in a type descriptor
+ */
+static std::optional<VerKind> get_kind(VMType ty)
+{
+	switch(ty)
+	{
+		case VMType::REAL: return VerKind::REAL;
+		case VMType::INT: return VerKind::INT;
+		case VMType::STR: return VerKind::STR;
+		case VMType::VEC: return VerKind::VEC;
+		case VMType::MAT: return VerKind::MAT;
+		case VMType::ADDR_MEM:
+		case VMType::ADDR_IP:
+		case VMType::ADDR_SP:
+		case VMType::ADDR_BP: return VerKind::ADDR;
+		default: return std::nullopt;
+	}
+}
+
+
+
+class Verifier
+{
+public:
+	Verifier(const VM::t_byte* mem, t_addr memsize,
+		t_addr code_begin, t_addr code_end,
+		t_addr prog_begin, t_addr prog_end)
+		: m_mem{mem}, m_memsize{memsize},
+			m_code_begin{code_begin}, m_code_end{code_end},
+			m_prog_begin{prog_begin}, m_prog_end{prog_end},
+			m_marks(code_end - code_begin, 0)
+	{}
+
+
+	void Verify(t_addr entry)
+	{
+		VerFunc& func = m_funcs[entry];
+		func.toplevel = true;
+		Propagate(entry, VerState{ .func = entry, .stack = {} });
+
+		while(m_worklist.size())
+		{
+			t_addr addr = m_worklist.front();
+			m_worklist.pop_front();
+			m_queued.erase(addr);
+
+			Step(addr);
+		}
+	}
+
+
+private:
+	[[noreturn]] void Fail(t_addr addr, const std::string& msg) const
+	{
+		std::ostringstream ostr;
+		ostr << "Verification failed at address " << addr << ": " << msg;
+		throw std::runtime_error(ostr.str());
+	}
+
+
+	void Enqueue(t_addr addr)
+	{
+		if(m_queued.insert(addr).second)
+			m_worklist.push_back(addr);
+	}
+
+
+	/**
+	 * merge two stack values at a join point
+	 */
+	bool Merge(VerValue& val, const VerValue& other, t_addr addr) const
+	{
+		if(val == other)
+			return false;
+
+		VerValue merged = val;
+
+		if(val.kind != other.kind)
+		{
+			if(!is_typed(val.kind) || !is_typed(other.kind))
+			{
+				Fail(addr, std::string("Stack type mismatch between ") +
+					get_kind_name(val.kind) + " and " +
+					get_kind_name(other.kind) + ".");
+			}
+
+			merged.kind = VerKind::DATA;
+		}
+
+		if(val.reg != other.reg)
+			Fail(addr, "Stack address register mismatch.");
+		if(val.val != other.val)
+			merged.val = std::nullopt;
+		if(val.str != other.str)
+			merged.str = std::nullopt;
+
+		bool changed = !(merged == val);
+		val = merged;
+		return changed;
+	}
+
+
+	/**
+	 * pass the state on to a following instruction
+	 */
+	void Propagate(t_addr addr, const VerState& state)
+	{
+		if(addr < m_code_begin || addr >= m_code_end)
+			Fail(addr, "Address is outside the code range.");
+		if(m_marks[addr - m_code_begin] == m_mark_inside)
+			Fail(addr, "Address is not at an instruction boundary.");
+
+		auto iter = m_states.find(addr);
+		if(iter == m_states.end())
+		{
+			m_states.emplace(addr, state);
+			Enqueue(addr);
+			return;
+		}
+
+		VerState& known = iter->second;
+		if(known.func != state.func)
+			Fail(addr, "Code is shared between functions.");
+		if(known.stack.size() != state.stack.size())
+		{
+			std::ostringstream msg;
+			msg << "Stack depth mismatch (" << known.stack.size()
+				<< " vs. " << state.stack.size() << ").";
+			Fail(addr, msg.str());
+		}
+
+		bool changed = false;
+		for(std::size_t i=0; i<known.stack.size(); ++i)
+			changed = Merge(known.stack[i], state.stack[i], addr) || changed;
+
+		if(changed)
+			Enqueue(addr);
+	}
+
+
+	/**
+	 * decode a type-prefixed value in memory, see VM::ReadMemData()
+	 */
+	std::tuple<VerValue, t_addr> DecodeValue(t_addr addr, t_addr end) const
+	{
+		auto read_addr = [this, addr, end](t_addr pos) -> t_addr
+		{
+			if(pos < 0 || pos + VM::m_addrsize > end)
+				Fail(addr, "Value exceeds the program range.");
+
+			t_addr val{};
+			std::memcpy(&val, m_mem + pos, VM::m_addrsize);
+			return val;
+		};
+
+		if(addr < 0 || addr >= end)
+			Fail(addr, "Value exceeds the program range.");
+
+		VMType ty = static_cast<VMType>(m_mem[addr]);
+		std::optional<VerKind> kind = get_kind(ty);
+		if(!kind)
+			Fail(addr, std::string("Invalid data type ") + get_vm_type_name(ty) + ".");
+
+		VerValue val{ .kind = *kind };
+		t_addr data = addr + VM::m_bytesize;
+		t_addr size = 0;
+
+		switch(ty)
+		{
+			case VMType::REAL:
+			{
+				size = VM::m_realsize;
+				break;
+			}
+
+			case VMType::INT:
+			{
+				size = VM::m_intsize;
+				if(data + size <= end)
+				{
+					t_int intval{};
+					std::memcpy(&intval, m_mem + data, VM::m_intsize);
+					val.val = intval;
+				}
+				break;
+			}
+
+			case VMType::STR:
+			{
+				t_addr len = read_addr(data);
+				if(len < 0 || len > m_memsize)
+					Fail(addr, "Invalid string length.");
+				size = VM::m_addrsize + len*VM::m_charsize;
+				if(data + size <= end)
+				{
+					val.str = t_str(reinterpret_cast<const VM::t_char*>(
+						m_mem + data + VM::m_addrsize), len);
+				}
+				break;
+			}
+
+			case VMType::VEC:
+			{
+				t_addr len = read_addr(data);
+				if(len < 0 || len > m_memsize)
+					Fail(addr, "Invalid vector size.");
+				size = VM::m_addrsize + len*VM::m_realsize;
+				break;
+			}
+
+			case VMType::MAT:
+			{
+				t_addr len1 = read_addr(data);
+				t_addr len2 = read_addr(data + VM::m_addrsize);
+				if(len1 < 0 || len2 < 0 || len1 > m_memsize || len2 > m_memsize)
+					Fail(addr, "Invalid matrix size.");
+				size = 2*VM::m_addrsize + len1*len2*VM::m_realsize;
+				break;
+			}
+
+			default:
+			{
+				// addresses
+				val.reg = ty;
+				val.val = read_addr(data);
+				size = VM::m_addrsize;
+				break;
+			}
+		}
+
+		if(data + size > end)
+			Fail(addr, "Value exceeds the program range.");
+
+		return std::make_tuple(val, VM::m_bytesize + size);
+	}
+
+
+	/**
+	 * get an absolute code address
+	 */
+	t_addr GetTarget(const VerValue& val, t_addr next, t_addr addr) const
+	{
+		if(val.kind != VerKind::ADDR || !val.val)
+			Fail(addr, "Jump target is not a constant address.");
+
+		if(val.reg == VMType::ADDR_IP)
+			return next + static_cast<t_addr>(*val.val);
+		else if(val.reg == VMType::ADDR_MEM)
+			return static_cast<t_addr>(*val.val);
+
+		Fail(addr, "Invalid base register for jump target.");
+	}
+
+
+	/**
+	 * check a memory access and get the accessed value if it is a constant
+	 */
+	std::optional<VerValue> CheckAccess(const VerValue& val, t_addr next,
+		t_addr addr, const VerFunc& func, bool write) const
+	{
+		if(val.kind != VerKind::ADDR || !val.val)
+			Fail(addr, "Memory access to a non-constant address.");
+
+		switch(val.reg)
+		{
+			// local variables or function arguments
+			case VMType::ADDR_BP:
+			{
+				if(func.toplevel)
+					Fail(addr, "Frame access outside of a function.");
+
+				t_int offs = *val.val;
+				bool is_local = (offs >= -func.framesize && offs < 0);
+				bool is_arg = (offs >= 2*vm_type_size<VMType::ADDR_MEM, true>);
+
+				if(!is_local && !is_arg)
+				{
+					std::ostringstream msg;
+					msg << "Frame access at offset " << offs
+						<< " is outside the frame of size "
+						<< func.framesize << ".";
+					Fail(addr, msg.str());
+				}
+				return std::nullopt;
+			}
+
+			// constants
+			case VMType::ADDR_MEM:
+			case VMType::ADDR_IP:
+			{
+				if(write)
+					Fail(addr, "Write access to a constant address.");
+
+				t_addr absaddr = static_cast<t_addr>(*val.val);
+				if(val.reg == VMType::ADDR_IP)
+					absaddr += next;
+				if(absaddr < m_prog_begin || absaddr >= m_prog_end)
+					Fail(addr, "Read access outside the program range.");
+
+				return std::get<0>(DecodeValue(absaddr, m_prog_end));
+			}
+
+			default:
+			{
+				Fail(addr, "Invalid base register for memory access.");
+			}
+		}
+	}
+
+
+	/**
+	 * decode and check the instruction at the given address
+	 */
+	std::tuple<OpCode, t_addr, std::optional<VerValue>> Decode(t_addr addr)
+	{
+		OpCode op = static_cast<OpCode>(m_mem[addr]);
+		t_addr size = 1;
+		std::optional<VerValue> inline_val{};
+
+		switch(op)
+		{
+			case OpCode::HALT: case OpCode::NOP:
+			case OpCode::WRMEM: case OpCode::RDMEM:
+			case OpCode::ADDMEM: case OpCode::SUBMEM:
+			case OpCode::MULMEM: case OpCode::DIVMEM: case OpCode::FUSEDMEM:
+			case OpCode::POP:
+			case OpCode::USUB: case OpCode::ADD: case OpCode::SUB:
+			case OpCode::MUL: case OpCode::DIV: case OpCode::MOD: case OpCode::POW:
+			case OpCode::EMUL: case OpCode::EDIV: case OpCode::FUSED:
+			case OpCode::TOI: case OpCode::TOF: case OpCode::TOS:
+			case OpCode::TOV: case OpCode::TOM:
+			case OpCode::JMP: case OpCode::JMPCND: case OpCode::PARLOOP:
+			case OpCode::AND: case OpCode::OR: case OpCode::XOR: case OpCode::NOT:
+			case OpCode::GT: case OpCode::LT: case OpCode::GEQU:
+			case OpCode::LEQU: case OpCode::EQU: case OpCode::NEQU:
+			case OpCode::CALL: case OpCode::RET: case OpCode::EXTCALL:
+			case OpCode::MAP:
+			case OpCode::BINAND: case OpCode::BINOR: case OpCode::BINXOR:
+			case OpCode::BINNOT: case OpCode::SHL: case OpCode::SHR:
+			case OpCode::ROTL: case OpCode::ROTR:
+			case OpCode::MAKEVEC: case OpCode::MAKEMAT:
+			case OpCode::RDARR1D: case OpCode::RDARR1DR:
+			case OpCode::RDARR2D: case OpCode::RDARR2DR:
+			case OpCode::WRARR1D: case OpCode::WRARR1DR:
+			case OpCode::WRARR2D: case OpCode::WRARR2DR:
+			{
+				break;
+			}
+
+			case OpCode::PUSH:
+			{
+				auto [val, valsize] = DecodeValue(addr + 1, m_code_end);
+				inline_val = val;
+				size += valsize;
+				break;
+			}
+
+			default:
+			{
+				std::ostringstream msg;
+				msg << "Invalid instruction 0x" << std::hex
+					<< static_cast<unsigned>(op) << ".";
+				Fail(addr, msg.str());
+			}
+		}
+
+		// mark the instruction's bytes
+		if(m_marks[addr - m_code_begin] == m_mark_inside)
+			Fail(addr, "Instructions overlap.");
+		m_marks[addr - m_code_begin] = m_mark_start;
+		for(t_addr i=addr+1; i<addr+size; ++i)
+		{
+			if(m_marks[i - m_code_begin] == m_mark_start)
+				Fail(addr, "Instructions overlap.");
+			m_marks[i - m_code_begin] = m_mark_inside;
+		}
+
+		return std::make_tuple(op, addr + size, inline_val);
+	}
+
+
+	/**
+	 * abstract interpretation of one instruction
+	 */
+	void Step(t_addr addr)
+	{
+		auto [op, next, inline_val] = Decode(addr);
+		VerState state = m_states[addr];
+		t_verstack& stack = state.stack;
+		VerFunc& func = m_funcs[state.func];
+
+		auto pop = [&stack, addr, this]() -> VerValue
+		{
+			if(stack.empty())
+				Fail(addr, "Stack underflow.");
+			VerValue val = stack.back();
+			stack.pop_back();
+			return val;
+		};
+
+		auto pop_kind = [&pop, addr, this](VerKind kind) -> VerValue
+		{
+			VerValue val = pop();
+			if(val.kind == kind || (is_typed(kind) && val.kind == VerKind::DATA))
+				return val;
+
+			Fail(addr, std::string("Expected ") + get_kind_name(kind) +
+				" but found " + get_kind_name(val.kind) + " on the stack.");
+		};
+
+		auto pop_typed = [&pop, addr, this]() -> VerValue
+		{
+			VerValue val = pop();
+			if(!is_typed(val.kind))
+			{
+				Fail(addr, std::string("Expected typed data but found ") +
+					get_kind_name(val.kind) + " on the stack.");
+			}
+			return val;
+		};
+
+		auto push = [&stack](VerKind kind)
+		{
+			stack.emplace_back(VerValue{ .kind = kind });
+		};
+
+		switch(op)
+		{
+			case OpCode::HALT:
+			{
+				return;
+			}
+
+			case OpCode::NOP:
+			{
+				break;
+			}
+
+			case OpCode::PUSH:
+			{
+				stack.push_back(*inline_val);
+				break;
+			}
+
+			case OpCode::POP:
+			{
+				pop_typed();
+				break;
+			}
+
+			case OpCode::WRMEM:
+			{
+				VerValue memaddr = pop_kind(VerKind::ADDR);
+				CheckAccess(memaddr, next, addr, func, true);
+				pop_typed();
+				break;
+			}
+
+			case OpCode::ADDMEM: case OpCode::SUBMEM:
+			case OpCode::MULMEM: case OpCode::DIVMEM:
+			{
+				VerValue memaddr = pop_kind(VerKind::ADDR);
+				CheckAccess(memaddr, next, addr, func, true);
+				VerValue val = pop_typed();
+				if(val.kind == VerKind::STR && op != OpCode::ADDMEM)
+					Fail(addr, "Invalid in-place operation on a string.");
+				break;
+			}
+
+			case OpCode::RDMEM:
+			{
+				VerValue memaddr = pop_kind(VerKind::ADDR);
+				if(auto val = CheckAccess(memaddr, next, addr, func, false); val)
+					stack.push_back(*val);
+				else
+					push(VerKind::DATA);
+				break;
+			}
+
+			case OpCode::USUB:
+			{
+				VerValue val = pop_typed();
+				if(val.kind == VerKind::STR)
+					Fail(addr, "Invalid type for unary minus.");
+				push(val.kind);
+				break;
+			}
+
+			case OpCode::ADD: case OpCode::SUB:
+			case OpCode::MUL: case OpCode::DIV:
+			case OpCode::MOD: case OpCode::POW:
+			case OpCode::EMUL: case OpCode::EDIV:
+			{
+				VerValue val2 = pop_typed();
+				VerValue val1 = pop_typed();
+				std::optional<VerKind> kind = get_arith_kind(op, val1.kind, val2.kind);
+				if(!kind)
+				{
+					Fail(addr, std::string("Invalid arithmetic operation between ") +
+						get_kind_name(val1.kind) + " and " +
+						get_kind_name(val2.kind) + ".");
+				}
+				push(*kind);
+				break;
+			}
+
+			case OpCode::FUSED: case OpCode::FUSEDMEM:
+			{
+				VerValue prog = pop_kind(VerKind::STR);
+				if(!prog.str)
+					Fail(addr, "Fused expression is not a constant.");
+				auto sizes = check_fused_prog(*prog.str);
+				if(!sizes)
+					Fail(addr, "Invalid fused expression \"" + *prog.str + "\".");
+
+				// variable receiving the result
+				if(op == OpCode::FUSEDMEM)
+				{
+					VerValue memaddr = pop_kind(VerKind::ADDR);
+					CheckAccess(memaddr, next, addr, func, true);
+				}
+
+				if(sizes->first > stack.size())
+					Fail(addr, "Stack underflow.");
+
+				// the result has the type of the array operands
+				std::optional<VerKind> kind{};
+				for(std::size_t i=0; i<sizes->first; ++i)
+				{
+					VerValue val = pop();
+
+					// array variable read in place
+					if(val.kind == VerKind::ADDR)
+					{
+						if(auto memval = CheckAccess(val, next, addr, func, false); memval)
+							val = *memval;
+						else
+							val = VerValue{ .kind = VerKind::DATA };
+					}
+
+					if(!is_typed(val.kind))
+					{
+						Fail(addr, std::string("Expected typed data but found ") +
+							get_kind_name(val.kind) + " on the stack.");
+					}
+					if(val.kind == VerKind::STR)
+						Fail(addr, "Invalid string operand in fused expression.");
+					if(val.kind == VerKind::REAL || val.kind == VerKind::INT)
+						continue;
+
+					if(!kind)
+					{
+						kind = val.kind;
+					}
+					else if(*kind != val.kind)
+					{
+						if(*kind != VerKind::DATA && val.kind != VerKind::DATA)
+							Fail(addr, "Array type mismatch in fused expression.");
+						kind = VerKind::DATA;
+					}
+				}
+
+				if(!kind)
+					Fail(addr, "Fused expression needs an array operand.");
+				if(op == OpCode::FUSED)
+					push(*kind);
+				break;
+			}
+
+			case OpCode::TOI: case OpCode::TOF:
+			{
+				VerValue val = pop_typed();
+				if(val.kind == VerKind::VEC || val.kind == VerKind::MAT)
+					Fail(addr, "Invalid cast of an array to a scalar.");
+				push(op == OpCode::TOI ? VerKind::INT : VerKind::REAL);
+				break;
+			}
+
+			case OpCode::TOS:
+			{
+				pop_typed();
+				push(VerKind::STR);
+				break;
+			}
+
+			case OpCode::TOV:
+			{
+				pop_kind(VerKind::ADDR);
+				VerValue val = pop_typed();
+				if(val.kind == VerKind::STR)
+					Fail(addr, "Invalid cast of a string to a vector.");
+				push(VerKind::VEC);
+				break;
+			}
+
+			case OpCode::TOM:
+			{
+				pop_kind(VerKind::ADDR);
+				pop_kind(VerKind::ADDR);
+				VerValue val = pop_typed();
+				if(val.kind == VerKind::STR)
+					Fail(addr, "Invalid cast of a string to a matrix.");
+				push(VerKind::MAT);
+				break;
+			}
+
+			case OpCode::JMP:
+			{
+				t_addr target = GetTarget(pop_kind(VerKind::ADDR), next, addr);
+				Propagate(target, state);
+				return;
+			}
+
+			case OpCode::JMPCND:
+			{
+				t_addr target = GetTarget(pop_kind(VerKind::ADDR), next, addr);
+				pop_kind(VerKind::BOOL);
+				Propagate(target, state);
+				break;
+			}
+
+			case OpCode::PARLOOP:
+			{
+				// the loop body follows, the loop continues after its end
+				t_addr target = GetTarget(pop_kind(VerKind::ADDR), next, addr);
+
+				VerValue loopvar = pop_kind(VerKind::ADDR);
+				if(loopvar.reg != VMType::ADDR_BP)
+					Fail(addr, "Loop variable is not a local variable.");
+				CheckAccess(loopvar, next, addr, func, true);
+
+				VerValue num_accs = pop_kind(VerKind::INT);
+				if(!num_accs.val || *num_accs.val < 0 || *num_accs.val > static_cast<t_int>(stack.size()))
+					Fail(addr, "Number of accumulators is not a valid constant.");
+				for(t_int acc=0; acc<*num_accs.val; ++acc)
+				{
+					VerValue accaddr = pop_kind(VerKind::ADDR);
+					if(accaddr.reg != VMType::ADDR_BP)
+						Fail(addr, "Accumulator is not a local variable.");
+					CheckAccess(accaddr, next, addr, func, true);
+				}
+
+				// variables declared in the loop body
+				VerValue block_size = pop_kind(VerKind::INT);
+				VerValue block = pop_kind(VerKind::ADDR);
+				if(!block_size.val || *block_size.val < 0)
+					Fail(addr, "Size of the loop variables is not a valid constant.");
+				if(*block_size.val > 0)
+				{
+					if(block.reg != VMType::ADDR_BP)
+						Fail(addr, "Loop variables are not local variables.");
+					CheckAccess(block, next, addr, func, true);
+					if(*block.val + *block_size.val > 0)
+						Fail(addr, "Loop variables exceed the stack frame.");
+				}
+
+				// iteration range
+				pop_kind(VerKind::INT);
+				pop_kind(VerKind::INT);
+
+				Propagate(target, state);
+				break;
+			}
+
+			case OpCode::AND: case OpCode::OR: case OpCode::XOR:
+			{
+				pop_kind(VerKind::BOOL);
+				pop_kind(VerKind::BOOL);
+				push(VerKind::BOOL);
+				break;
+			}
+
+			case OpCode::NOT:
+			{
+				pop_kind(VerKind::BOOL);
+				push(VerKind::BOOL);
+				break;
+			}
+
+			case OpCode::GT: case OpCode::LT:
+			case OpCode::GEQU: case OpCode::LEQU:
+			case OpCode::EQU: case OpCode::NEQU:
+			{
+				VerValue val2 = pop_typed();
+				VerValue val1 = pop_typed();
+				if(val1.kind != val2.kind && val1.kind != VerKind::DATA
+					&& val2.kind != VerKind::DATA)
+				{
+					Fail(addr, std::string("Comparison between ") +
+						get_kind_name(val1.kind) + " and " +
+						get_kind_name(val2.kind) + ".");
+				}
+				push(VerKind::BOOL);
+				break;
+			}
+
+			case OpCode::BINAND: case OpCode::BINOR: case OpCode::BINXOR:
+			case OpCode::SHL: case OpCode::SHR:
+			case OpCode::ROTL: case OpCode::ROTR:
+			{
+				pop_kind(VerKind::INT);
+				pop_kind(VerKind::INT);
+				push(VerKind::INT);
+				break;
+			}
+
+			case OpCode::BINNOT:
+			{
+				pop_kind(VerKind::INT);
+				push(VerKind::INT);
+				break;
+			}
+
+			case OpCode::MAKEVEC:
+			case OpCode::MAKEMAT:
+			{
+				t_int num_elems = 1;
+				for(int i=0; i<(op == OpCode::MAKEVEC ? 1 : 2); ++i)
+				{
+					VerValue size = pop_kind(VerKind::ADDR);
+					if(!size.val || *size.val < 0)
+						Fail(addr, "Array size is not a valid constant.");
+					num_elems *= *size.val;
+				}
+
+				if(num_elems > static_cast<t_int>(stack.size()))
+					Fail(addr, "Stack underflow.");
+				for(t_int i=0; i<num_elems; ++i)
+					pop_kind(VerKind::REAL);
+
+				push(op == OpCode::MAKEVEC ? VerKind::VEC : VerKind::MAT);
+				break;
+			}
+
+			case OpCode::RDARR1D:
+			case OpCode::RDARR1DR:
+			case OpCode::RDARR2D:
+			case OpCode::RDARR2DR:
+			{
+				int num_idx = 1;
+				if(op == OpCode::RDARR1DR || op == OpCode::RDARR2D)
+					num_idx = 2;
+				else if(op == OpCode::RDARR2DR)
+					num_idx = 4;
+
+				for(int i=0; i<num_idx; ++i)
+					pop_kind(VerKind::INT);
+				VerValue arr = pop_typed();
+
+				VerKind kind = VerKind::DATA;
+				if(arr.kind != VerKind::DATA)
+				{
+					bool is_2d = (op == OpCode::RDARR2D || op == OpCode::RDARR2DR);
+					if(is_2d && arr.kind != VerKind::MAT)
+						Fail(addr, "Two-dimensional access to a non-matrix type.");
+					if(arr.kind != VerKind::VEC && arr.kind != VerKind::MAT
+						&& arr.kind != VerKind::STR)
+						Fail(addr, "Cannot index non-array type.");
+
+					if(op == OpCode::RDARR1D)
+					{
+						if(arr.kind == VerKind::VEC)
+							kind = VerKind::REAL;
+						else if(arr.kind == VerKind::MAT)
+							kind = VerKind::VEC;
+						else
+							kind = VerKind::STR;
+					}
+					else if(op == OpCode::RDARR2D)
+					{
+						kind = VerKind::REAL;
+					}
+					else
+					{
+						kind = arr.kind;
+					}
+				}
+
+				push(kind);
+				break;
+			}
+
+			case OpCode::WRARR1D:
+			case OpCode::WRARR1DR:
+			case OpCode::WRARR2D:
+			case OpCode::WRARR2DR:
+			{
+				int num_idx = 1;
+				if(op == OpCode::WRARR1DR || op == OpCode::WRARR2D)
+					num_idx = 2;
+				else if(op == OpCode::WRARR2DR)
+					num_idx = 4;
+
+				for(int i=0; i<num_idx; ++i)
+					pop_kind(VerKind::INT);
+				pop_typed();
+				VerValue memaddr = pop_kind(VerKind::ADDR);
+				CheckAccess(memaddr, next, addr, func, true);
+				break;
+			}
+
+			case OpCode::CALL:
+			{
+				t_addr target = GetTarget(pop_kind(VerKind::ADDR), next, addr);
+				VerValue framesize = pop_kind(VerKind::INT);
+				if(!framesize.val || *framesize.val < 0 || *framesize.val >= m_memsize)
+					Fail(addr, "Frame size is not a valid constant.");
+
+				// new function?
+				auto [iter, inserted] = m_funcs.try_emplace(target);
+				VerFunc& callee = iter->second;
+				if(inserted)
+				{
+					callee.framesize = *framesize.val;
+					Propagate(target, VerState{ .func = target, .stack = {} });
+				}
+				else if(callee.toplevel)
+				{
+					Fail(addr, "Call to the start-up code.");
+				}
+				else if(callee.framesize != *framesize.val)
+				{
+					Fail(addr, "Frame size does not match the other calls.");
+				}
+				callee.callsites.insert(addr);
+
+				// continue when the function's return values are known
+				if(!callee.num_args)
+					return;
+
+				if(*callee.num_args > static_cast<t_int>(stack.size()))
+					Fail(addr, "Stack underflow.");
+				for(t_int arg=0; arg<*callee.num_args; ++arg)
+					pop_typed();
+				for(const VerValue& ret : callee.rets)
+					stack.push_back(ret);
+				break;
+			}
+
+			case OpCode::MAP:
+			{
+				t_addr target = GetTarget(pop_kind(VerKind::ADDR), next, addr);
+				VerValue framesize = pop_kind(VerKind::INT);
+				if(!framesize.val || *framesize.val < 0 || *framesize.val >= m_memsize)
+					Fail(addr, "Frame size is not a valid constant.");
+				VerValue arr = pop_typed();
+				if(arr.kind != VerKind::VEC && arr.kind != VerKind::MAT && arr.kind != VerKind::DATA)
+					Fail(addr, "Map needs a vector or matrix argument.");
+
+				// the function is called with the elements as arguments
+				auto [iter, inserted] = m_funcs.try_emplace(target);
+				VerFunc& callee = iter->second;
+				if(inserted)
+				{
+					callee.framesize = *framesize.val;
+					Propagate(target, VerState{ .func = target, .stack = {} });
+				}
+				else if(callee.toplevel)
+				{
+					Fail(addr, "Call to the start-up code.");
+				}
+				else if(callee.framesize != *framesize.val)
+				{
+					Fail(addr, "Frame size does not match the other calls.");
+				}
+				callee.callsites.insert(addr);
+
+				// continue when the function's return values are known
+				if(!callee.num_args)
+					return;
+
+				if(*callee.num_args != 1 || callee.rets.size() != 1 ||
+					(callee.rets[0].kind != VerKind::REAL && callee.rets[0].kind != VerKind::INT &&
+					callee.rets[0].kind != VerKind::DATA))
+					Fail(addr, "Mapped function has to take and return a scalar.");
+				push(arr.kind);
+				break;
+			}
+
+			case OpCode::RET:
+			{
+				if(func.toplevel)
+					Fail(addr, "Return outside of a function.");
+
+				VerValue num_args = pop_kind(VerKind::INT);
+				VerValue framesize = pop_kind(VerKind::INT);
+				if(!num_args.val || *num_args.val < 0)
+					Fail(addr, "Number of arguments is not a valid constant.");
+				if(!framesize.val || *framesize.val != func.framesize)
+					Fail(addr, "Frame size does not match the function's frame.");
+
+				t_verstack rets;
+				for(const VerValue& val : stack)
+				{
+					if(!is_typed(val.kind))
+						Fail(addr, "Return values have to be typed data.");
+					rets.push_back(VerValue{ .kind = val.kind });
+				}
+
+				bool changed = false;
+				if(!func.num_args)
+				{
+					func.num_args = *num_args.val;
+					func.rets = rets;
+					changed = true;
+				}
+				else
+				{
+					if(*func.num_args != *num_args.val || func.rets.size() != rets.size())
+						Fail(addr, "Inconsistent returns from function.");
+					for(std::size_t i=0; i<rets.size(); ++i)
+						changed = Merge(func.rets[i], rets[i], addr) || changed;
+				}
+
+				// revisit the callers with the new return values
+				if(changed)
+				{
+					for(t_addr callsite : func.callsites)
+						Enqueue(callsite);
+				}
+				return;
+			}
+
+			case OpCode::EXTCALL:
+			{
+				VerValue name = pop_kind(VerKind::STR);
+				if(!name.str)
+					Fail(addr, "External function name is not a constant.");
+
+				std::optional<VerExtFunc> extfunc = get_ext_func(*name.str);
+				if(!extfunc)
+					Fail(addr, "Unknown external function \"" + *name.str + "\".");
+
+				for(t_int arg=0; arg<extfunc->num_args; ++arg)
+				{
+					if(extfunc->ref_arg && *extfunc->ref_arg == arg)
+					{
+						// the function writes to the variable
+						VerValue memaddr = pop_kind(VerKind::ADDR);
+						CheckAccess(memaddr, next, addr, func, true);
+					}
+					else
+					{
+						pop_typed();
+					}
+				}
+				for(auto iter = extfunc->more_rets.rbegin(); iter != extfunc->more_rets.rend(); ++iter)
+					push(*iter);
+				if(extfunc->ret)
+					push(*extfunc->ret);
+				break;
+			}
+
+			default:
+			{
+				Fail(addr, "Unhandled instruction.");
+			}
+		}
+
+		// continue with the next instruction
+		Propagate(next, state);
+	}
+
+
+private:
+	static constexpr const t_vm_byte m_mark_start = 1;
+	static constexpr const t_vm_byte m_mark_inside = 2;
+
+	const VM::t_byte *m_mem{nullptr};
+	t_addr m_memsize{};
+	t_addr m_code_begin{}, m_code_end{};
+	t_addr m_prog_begin{}, m_prog_end{};
+
+	std::vector<t_vm_byte> m_marks{};          // instruction boundaries
+	std::map<t_addr, VerState> m_states{};     // state at each instruction
+	std::map<t_addr, VerFunc> m_funcs{};       // functions by entry address
+
+	std::deque<t_addr> m_worklist{};
+	std::set<t_addr> m_queued{};
+};
+
+} // anonymous namespace
+
+
+
+/**
+ * verify the loaded program, throws on failure
+ */
+void VM::Verify()
+{
+	m_verified = false;
+
+	if(m_code_range[0] < 0 || m_code_range[1] < 0)
+		throw std::runtime_error("Verification failed: No code has been loaded.");
+
+	t_addr prog_begin = m_code_range[0], prog_end = m_code_range[1];
+	if(m_prog_range[0] >= 0 && m_prog_range[1] >= 0)
+	{
+		prog_begin = std::min(prog_begin, m_prog_range[0]);
+		prog_end = std::max(prog_end, m_prog_range[1]);
+	}
+
+	// the stack has to lie above the program
+	if(prog_end > m_sp)
+		throw std::runtime_error("Verification failed: Program overlaps the stack.");
+
+	Verifier verifier(m_mem.get(), m_memsize,
+		m_code_range[0], m_code_range[1],
+		prog_begin, prog_end);
+	// a resumed snapshot is verified from the start of its program
+	verifier.Verify(m_entry);
+
+	m_stack_limit = prog_end;
+	m_verified = true;
+}
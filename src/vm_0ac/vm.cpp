@@ -14,7 +14,7 @@
 
 VM::VM(t_addr memsize) : m_memsize{memsize}
 {
-	m_mem.reset(new t_byte[m_memsize]);
+	AllocMem();
 	Reset();
 }
 
@@ -22,6 +22,7 @@ VM::VM(t_addr memsize) : m_memsize{memsize}
 VM::~VM()
 {
 	StopTimer();
+	StopCheckpoint();
 }
 
 
@@ -109,6 +110,19 @@ VM::t_addr VM::PopAddress()
 		default: throw std::runtime_error("Unknown address base register."); break;
 	}
 
+	// use the private copies of the variables in a parallel loop's body
+	if(!m_par_privs.empty() && thereg == VMType::ADDR_BP && m_bp == m_par_bp)
+	{
+		for(const ParPrivate& priv : m_par_privs)
+		{
+			if(addr >= priv.begin && addr < priv.end)
+			{
+				addr += priv.target - priv.begin;
+				break;
+			}
+		}
+	}
+
 	return addr;
 }
 
@@ -924,16 +938,112 @@ VM::t_addr VM::GetDataSize(const t_data& data) const
 }
 
 
+const VM::t_str& VM::ToString(const t_data& data)
+{
+	// strings need no conversion
+	if(data.index() == m_stridx)
+		return std::get<m_stridx>(data);
+
+	// values close to zero are written as zero
+	auto append_elem = [this](t_real elem)
+	{
+		if(m::equals_0<t_real>(elem, m_eps))
+			elem = t_real(0);
+		append_real(m_convbuf, elem, m_prec);
+	};
+
+	m_convbuf.clear();
+
+	if(data.index() == m_realidx)
+	{
+		append_elem(std::get<m_realidx>(data));
+	}
+	else if(data.index() == m_intidx)
+	{
+		append_int(m_convbuf, std::get<m_intidx>(data));
+	}
+	else if(data.index() == m_addridx)
+	{
+		append_int(m_convbuf, std::get<m_addridx>(data));
+	}
+	else if(data.index() == m_boolidx)
+	{
+		append_int(m_convbuf, std::get<m_boolidx>(data));
+	}
+	else if(data.index() == m_vecidx)
+	{
+		const t_vec& vec = std::get<m_vecidx>(data);
+
+		m_convbuf += "[ ";
+		for(std::size_t i=0; i<vec.size(); ++i)
+		{
+			append_elem(vec[i]);
+			if(i != vec.size()-1)
+				m_convbuf += ", ";
+		}
+		m_convbuf += " ]";
+	}
+	else if(data.index() == m_matidx)
+	{
+		const t_mat& mat = std::get<m_matidx>(data);
+
+		m_convbuf += "[ ";
+		for(std::size_t i=0; i<mat.size1(); ++i)
+		{
+			for(std::size_t j=0; j<mat.size2(); ++j)
+			{
+				append_elem(mat(i, j));
+				if(j != mat.size2()-1)
+					m_convbuf += ", ";
+			}
+			if(i != mat.size1()-1)
+				m_convbuf += "; ";
+		}
+		m_convbuf += " ]";
+	}
+	else
+	{
+		throw std::runtime_error("ToString: Data type not yet implemented.");
+	}
+
+	return m_convbuf;
+}
+
+
 void VM::Reset()
 {
-	m_ip = 0;
-	m_sp = m_memsize;
+	m_ip = m_entry = 0;
+	m_sp = GetStackBase();
 	m_bp = m_memsize;
-	// padding of max. data type size to avoid writing beyond memory size
-	m_sp -= sizeof(t_data) + 1;
+
+	// remove any mapped program file
+	UnmapMem();
+	m_funcnames.clear();
+	m_lines.clear();
 
 	std::memset(m_mem.get(), static_cast<t_byte>(OpCode::HALT), m_memsize*m_bytesize);
 	m_code_range[0] = m_code_range[1] = -1;
+	m_prog_range[0] = m_prog_range[1] = -1;
+	m_verified = false;
+
+	m_ir.clear();
+	m_ir_consts.clear();
+	m_ir_index.clear();
+	m_jit_funcs.clear();
+	m_jit_func_index.clear();
+	m_memo_funcs.clear();
+	m_memo_calls.clear();
+	m_memo_active = false;
+}
+
+
+/**
+ * initial stack pointer
+ */
+VM::t_addr VM::GetStackBase() const
+{
+	// padding of max. data type size to avoid writing beyond memory size
+	return m_memsize - static_cast<t_addr>(sizeof(t_data) + 1);
 }
 
 
@@ -959,7 +1069,7 @@ void VM::UpdateCodeRange(t_addr begin, t_addr end)
 
 void VM::SetMem(t_addr addr, VM::t_byte data)
 {
-	CheckMemoryBounds(addr, m_bytesize);
+	CheckMemoryBounds(addr, m_bytesize, true);
 
 	m_mem[addr % m_memsize] = data;
 }
@@ -1009,7 +1119,7 @@ const char* VM::GetDataTypeName(const t_data& dat)
 }
 
 
-void VM::CheckMemoryBounds(t_addr addr, t_addr size) const
+void VM::CheckMemoryBounds(t_addr addr, t_addr size, bool write) const
 {
 	if(!m_checks)
 		return;
@@ -1017,6 +1127,11 @@ void VM::CheckMemoryBounds(t_addr addr, t_addr size) const
 	t_addr new_addr = addr + size;
 	if(new_addr > m_memsize || new_addr < 0 || addr < 0)
 		throw std::runtime_error("Tried to access out of memory bounds.");
+
+	// the memory mapped from the program file is read-only
+	if(write && m_rom_range[0] >= 0 && m_rom_range[1] >= 0 &&
+		addr < m_rom_range[1] && new_addr > m_rom_range[0])
+		throw std::runtime_error("Tried to write to read-only memory.");
 }
 
 
@@ -1034,7 +1149,8 @@ void VM::CheckPointerBounds() const
 		msg << "Instruction pointer " << t_int(m_ip) << " is out of memory bounds.";
 		throw std::runtime_error(msg.str());
 	}
-	if(m_sp > m_memsize || m_sp < 0 || (chk_c && m_sp >= m_code_range[0] && m_sp < m_code_range[1]))
+	if(m_sp > m_memsize || m_sp < 0 || (chk_c && m_sp >= m_code_range[0] && m_sp < m_code_range[1])
+		|| (m_rom_range[0] >= 0 && m_sp >= m_rom_range[0] && m_sp < m_rom_range[1]))
 	{
 		std::ostringstream msg;
 		msg << "Stack pointer " << t_int(m_sp) << " is out of memory bounds.";
@@ -1047,3 +1163,21 @@ void VM::CheckPointerBounds() const
 		throw std::runtime_error(msg.str());
 	}
 }
+
+
+/**
+ * for verified programs only the stack pointer needs to be checked
+ */
+void VM::CheckStackBounds() const
+{
+	if(!m_checks)
+		return;
+
+	if(m_sp < m_stack_limit)
+	{
+		std::ostringstream msg;
+		msg << "Stack overflow, stack pointer " << t_int(m_sp)
+			<< " runs into the program.";
+		throw std::runtime_error(msg.str());
+	}
+}
@@ -13,7 +13,10 @@
 #include <memory>
 #include <array>
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <optional>
+#include <exception>
 #include <variant>
 #include <iostream>
 #include <sstream>
@@ -21,13 +24,27 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <limits>
 #include <string>
 #include <cstring>
 #include <cmath>
 
 #include "opcodes.h"
+#include "regir.h"
+#include "jit.h"
+#include "memo.h"
+#include "pool.h"
+#include "output.h"
+#include "conv.h"
 #include "helpers.h"
+#include "linalg.h"
+#include "gemm.h"
+#include "vecmath.h"
+
+
+class CsvReader;
 
 
 class VM
@@ -72,6 +89,7 @@ public:
 
 	static constexpr const t_addr m_num_interrupts = 16;
 	static constexpr const t_addr m_timer_interrupt = 0;
+	static constexpr const t_addr m_checkpoint_interrupt = m_num_interrupts - 1;
 
 
 public:
@@ -82,6 +100,35 @@ public:
 	void SetDrawMemImages(bool b) { m_drawmemimages = b; }
 	void SetChecks(bool b) { m_checks = b; }
 	void SetZeroPoppedVals(bool b) { m_zeropoppedvals = b; }
+	void SetUseIR(bool b) { m_use_ir = b; }
+	void SetUseJIT(bool b) { m_use_jit = b; }
+	void SetHotThreshold(std::uint64_t num) { m_hot_threshold = num; }
+
+	// cache the results of all or of the given pure functions
+	void SetMemoise(bool b) { m_memo_all = b; }
+	void SetMemoiseFunction(const t_str& name) { m_memo_names.push_back(name); }
+	void SetMemoSize(std::size_t num) { m_memo_size = num; }
+
+	// number of threads running parallel loops and large array operations, 0: number of cores
+	void SetNumThreads(std::size_t num) { m_num_threads = num; }
+
+	// thread pool, started on first use, null in the workers of a parallel loop
+	ThreadPool* GetPool(std::size_t work = 1, std::size_t min_work = 0)
+	{
+		if(m_par_worker || work < min_work)
+			return nullptr;
+		if(!m_pool)
+			m_pool = std::make_unique<ThreadPool>(m_num_threads);
+		return m_pool.get();
+	}
+
+	// output buffer size, 0: unbuffered, and background writing of the output
+	void SetOutputBuffer(std::size_t size) { m_output->SetSize(size); }
+	void SetAsyncOutput(bool b) { m_output->SetAsync(b); }
+	void FlushOutput() { m_output->Flush(); }
+
+	// print the usage counters and execution tiers of the functions
+	void PrintStats(std::ostream& ostr) const;
 
 	static const char* GetDataTypeName(std::size_t type_idx);
 	static const char* GetDataTypeName(const t_data& dat);
@@ -93,10 +140,30 @@ public:
 	void SetMem(t_addr addr, const t_byte* data, std::size_t size, bool is_code = false);
 	void SetMem(t_addr addr, const std::string& data, bool is_code = false);
 
+	// load a compiled program or resume a snapshot
+	bool Load(const std::string& filename);
+
+	// save the vm state to a file from which it can be resumed using Load()
+	void SaveSnapshot(const std::string& filename);
+
+	// periodically save the vm state, the snapshots are taken between instructions
+	void SetCheckpoint(const std::string& filename, std::chrono::milliseconds interval);
+
+	// verify the loaded program
+	void Verify();
+	bool IsVerified() const { return m_verified; }
+
+	// get the function name and source line belonging to a code address
+	std::optional<t_str> GetFunctionName(t_addr addr) const;
+	std::optional<t_addr> GetSourceLine(t_addr addr) const;
+
 	t_addr GetSP() const { return m_sp; }
 	t_addr GetBP() const { return m_bp; }
 	t_addr GetIP() const { return m_ip; }
 
+	// initial stack pointer
+	t_addr GetStackBase() const;
+
 	void SetSP(t_addr sp) { m_sp = sp; }
 	void SetBP(t_addr bp) { m_bp = bp; }
 	void SetIP(t_addr ip) { m_ip = ip; }
@@ -115,12 +182,55 @@ public:
 
 
 protected:
+	// run a single instruction
+	bool Exec(OpCode op, bool& running);
+
+	// function call and return, returns false if the call was skipped
+	bool OpCall(t_addr funcaddr, t_int framesize);
+	void OpRet(t_int num_args, t_int framesize);
+
+	// call a function for each element of the array on the stack
+	void OpMap(t_addr funcaddr, t_int framesize);
+	t_real MapElement(t_real elem, t_addr funcaddr, t_int framesize);
+
+	// parallel loop over the code up to body_end
+	void OpParLoop(t_addr body_end);
+
+	// evaluate a fused element-wise expression of the operands on the stack,
+	// pushing the result or writing it into a variable
+	void OpFused(bool to_mem);
+
 	//return the size of the held data
 	t_addr GetDataSize(const t_data& data) const;
 
 	//call external function
 	t_data CallExternal(const t_str& func_name);
 
+	// load or save the vector or matrix variable at the given address
+	t_int LoadArray(const t_str& filename, t_addr addr);
+	t_int SaveArray(const t_str& filename, t_addr addr);
+
+	// reductions of all elements or along a matrix axis
+	t_data Reduce(const t_str& func_name, const t_data& arr);
+	t_int ReduceAxis(const t_str& func_name, const t_data& arr, t_int axis, t_addr addr);
+
+	// streaming csv files
+	t_int CsvOpen(const t_str& filename);
+	t_int CsvNextRows(t_int handle, t_addr addr);
+	t_int CsvClose(t_int handle);
+
+	// linear systems for matrices or lu decomposition handles
+	t_data Solve(const t_data& lhs, const t_data& rhs);
+	t_int Factor(const t_data& mat);
+	t_int FactorFree(t_int handle);
+
+	// element-wise math functions of scalars, vectors and matrices
+	t_data ElementwiseMath(const t_str& func_name, const t_data& arg);
+	t_data ElementwisePow(const t_data& base, const t_data& exp);
+
+	// qr, cholesky and symmetric eigen decompositions returning several values
+	std::vector<t_data> MatrixDecomposition(const t_str& func_name, const t_data& mat);
+
 	//pop an address from the stack
 	t_addr PopAddress();
 
@@ -235,7 +345,7 @@ protected:
 		if constexpr(std::is_same_v<std::decay_t<t_val>, t_str>)
 		{
 			t_addr len = static_cast<t_addr>(val.length());
-			CheckMemoryBounds(addr, m_addrsize + len*m_charsize);
+			CheckMemoryBounds(addr, m_addrsize + len*m_charsize, true);
 
 			// write string length
 			WriteMemRaw<t_addr>(addr, len);
@@ -250,7 +360,7 @@ protected:
 		else if constexpr(std::is_same_v<std::decay_t<t_val>, t_vec>)
 		{
 			t_addr num_elems = static_cast<t_addr>(val.size());
-			CheckMemoryBounds(addr, m_addrsize + num_elems*m_realsize);
+			CheckMemoryBounds(addr, m_addrsize + num_elems*m_realsize, true);
 
 			// write vector length
 			WriteMemRaw<t_addr>(addr, num_elems);
@@ -266,7 +376,7 @@ protected:
 		{
 			t_addr num_elems_1 = static_cast<t_addr>(val.size1());
 			t_addr num_elems_2 = static_cast<t_addr>(val.size2());
-			CheckMemoryBounds(addr, m_addrsize + num_elems_1*num_elems_2*m_realsize);
+			CheckMemoryBounds(addr, m_addrsize + num_elems_1*num_elems_2*m_realsize, true);
 
 			// write matrix lengths
 			WriteMemRaw<t_addr>(addr, num_elems_1);
@@ -282,7 +392,7 @@ protected:
 		// primitive types
 		else
 		{
-			CheckMemoryBounds(addr, sizeof(t_val));
+			CheckMemoryBounds(addr, sizeof(t_val), true);
 			*reinterpret_cast<t_val*>(&m_mem[addr]) = val;
 		}
 	}
@@ -295,7 +405,8 @@ protected:
 	t_val TopRaw(t_addr sp_offs = 0) const
 	{
 		t_addr addr = m_sp + sp_offs;
-		CheckMemoryBounds(addr, valsize);
+		if(!m_verified)
+			CheckMemoryBounds(addr, valsize);
 
 		return *reinterpret_cast<t_val*>(m_mem.get() + addr);
 	}
@@ -307,7 +418,9 @@ protected:
 	template<class t_val, t_addr valsize = sizeof(t_val)>
 	t_val PopRaw()
 	{
-		CheckMemoryBounds(m_sp, valsize);
+		// the verifier makes sure that the stack does not underflow
+		if(!m_verified)
+			CheckMemoryBounds(m_sp, valsize);
 
 		t_val *valptr = reinterpret_cast<t_val*>(m_mem.get() + m_sp);
 		t_val val = *valptr;
@@ -338,38 +451,29 @@ protected:
 	 * cast from one variable type to the other
 	 */
 	template<std::size_t toidx>
-	void OpCast()
+	t_data OpCast(const t_data& data)
 	{
 		using t_to = std::variant_alternative_t<toidx, t_data>;
-		t_data data = TopData();
 
 		// casting from real
 		if(data.index() == m_realidx)
 		{
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_real>)
-				return;  // don't need to cast to the same type
+				return data;  // don't need to cast to the same type
 
 			t_real val = std::get<m_realidx>(data);
 
 			// convert to string
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_str>)
 			{
-				if(m::equals_0<t_real>(val, m_eps))
-					val = t_real(0);
-
-				std::ostringstream ostr;
-				ostr.precision(m_prec);
-				ostr << val;
-				PopData();
-				PushData(t_data{std::in_place_index<m_stridx>, ostr.str()});
+				return t_data{std::in_place_index<m_stridx>, ToString(data)};
 			}
 
 			// convert to primitive type
 			else
 			{
-				PopData();
-				PushData(t_data{std::in_place_index<toidx>,
-					static_cast<t_to>(val)});
+				return t_data{std::in_place_index<toidx>,
+					static_cast<t_to>(val)};
 			}
 		}
 
@@ -377,26 +481,21 @@ protected:
 		else if(data.index() == m_intidx)
 		{
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_int>)
-				return;  // don't need to cast to the same type
+				return data;  // don't need to cast to the same type
 
 			t_int val = std::get<m_intidx>(data);
 
 			// convert to string
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_str>)
 			{
-				std::ostringstream ostr;
-				ostr.precision(m_prec);
-				ostr << val;
-				PopData();
-				PushData(t_data{std::in_place_index<m_stridx>, ostr.str()});
+				return t_data{std::in_place_index<m_stridx>, ToString(data)};
 			}
 
 			// convert to primitive type
 			else
 			{
-				PopData();
-				PushData(t_data{std::in_place_index<toidx>,
-					static_cast<t_to>(val)});
+				return t_data{std::in_place_index<toidx>,
+					static_cast<t_to>(val)};
 			}
 		}
 
@@ -404,44 +503,24 @@ protected:
 		else if(data.index() == m_stridx)
 		{
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_str>)
-				return;  // don't need to cast to the same type
-
-			const t_str& val = std::get<m_stridx>(data);
-
-			t_to conv_val{};
-			std::istringstream{val} >> conv_val;
-			PopData();
-			PushData(t_data{std::in_place_index<toidx>, conv_val});
+				return data;  // don't need to cast to the same type
+			else
+			{
+				const t_str& val = std::get<m_stridx>(data);
+				return t_data{std::in_place_index<toidx>, parse_number<t_to>(val)};
+			}
 		}
 
 		// casting from vector
 		else if(data.index() == m_vecidx)
 		{
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_vec>)
-				return;  // don't need to cast to the same type
-
-			const t_vec& val = std::get<m_vecidx>(data);
+				return data;  // don't need to cast to the same type
 
 			// convert to string
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_str>)
 			{
-				std::ostringstream ostr;
-				ostr.precision(m_prec);
-				ostr << "[ ";
-				for(std::size_t i=0; i<val.size(); ++i)
-				{
-					t_real elem = val[i];
-					if(m::equals_0<t_real>(elem, m_eps))
-						elem = t_real(0);
-
-					ostr << elem;
-					if(i != val.size()-1)
-						ostr << ", ";
-				}
-				ostr << " ]";
-
-				PopData();
-				PushData(t_data{std::in_place_index<m_stridx>, ostr.str()});
+				return t_data{std::in_place_index<m_stridx>, ToString(data)};
 			}
 			else
 			{
@@ -456,35 +535,12 @@ protected:
 		else if(data.index() == m_matidx)
 		{
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_mat>)
-				return;  // don't need to cast to the same type
-
-			const t_mat& val = std::get<m_matidx>(data);
+				return data;  // don't need to cast to the same type
 
 			// convert to string
 			if constexpr(std::is_same_v<std::decay_t<t_to>, t_str>)
 			{
-				std::ostringstream ostr;
-				ostr.precision(m_prec);
-				ostr << "[ ";
-				for(std::size_t i=0; i<val.size1(); ++i)
-				{
-					for(std::size_t j=0; j<val.size2(); ++j)
-					{
-						t_real elem = val(i, j);
-						if(m::equals_0<t_real>(elem, m_eps))
-							elem = t_real(0);
-
-						ostr << elem;
-						if(j != val.size2()-1)
-							ostr << ", ";
-					}
-						if(i != val.size1()-1)
-							ostr << "; ";
-				}
-				ostr << " ]";
-
-				PopData();
-				PushData(t_data{std::in_place_index<m_stridx>, ostr.str()});
+				return t_data{std::in_place_index<m_stridx>, ToString(data)};
 			}
 			else
 			{
@@ -494,6 +550,32 @@ protected:
 				throw std::runtime_error(msg.str());
 			}
 		}
+
+		// nothing to convert for other types
+		return data;
+	}
+
+
+	/**
+	 * get the string representation of a value, the returned reference
+	 * stays valid until the next conversion
+	 */
+	const t_str& ToString(const t_data& data);
+
+
+	/**
+	 * cast the value on top of the stack
+	 */
+	template<std::size_t toidx>
+	void OpCast()
+	{
+		t_data data = TopData();
+		if(data.index() == toidx || data.index() == m_addridx)
+			return;  // don't need to cast to the same type
+
+		t_data result = OpCast<toidx>(data);
+		PopData();
+		PushData(result);
 	}
 
 
@@ -604,6 +686,18 @@ protected:
 	}
 
 
+	/**
+	 * runs func(begin, end) over the elements of an array,
+	 * large arrays are split across the threads
+	 */
+	template<class t_func>
+	void ParallelElems(std::size_t num_elems, t_func&& func)
+	{
+		par_for(GetPool(num_elems, g_par_min_elems), num_elems, g_par_min_elems,
+			0, static_cast<t_int>(num_elems), std::forward<t_func>(func));
+	}
+
+
 	/**
 	 * arithmetic operation
 	 */
@@ -619,23 +713,11 @@ protected:
 				result = val1 + val2;
 		}
 
-		// vector operators
-		else if constexpr(std::is_same_v<std::decay_t<t_val>, t_vec>)
-		{
-			if constexpr(op == '+')
-				result = val1 + val2;
-			else if constexpr(op == '-')
-				result = val1 - val2;
-		}
-
-		// matrix operators
+		// matrix operators,
+		// element-wise vector and matrix operations are handled by OpElementwise()
 		else if constexpr(std::is_same_v<std::decay_t<t_val>, t_mat>)
 		{
-			if constexpr(op == '+')
-				result = val1 + val2;
-			else if constexpr(op == '-')
-				result = val1 - val2;
-			else if constexpr(op == '*')
+			if constexpr(op == '*')
 				result = val1 * val2;
 		}
 
@@ -667,19 +749,37 @@ protected:
 	 * arithmetic operation
 	 */
 	template<char op>
-	void OpArithmetic()
+	t_data OpArithmetic(const t_data& val1, const t_data& val2)
 	{
-		t_data val2 = PopData();
-		t_data val1 = PopData();
 		t_data result;
 
 		// matrix-vector product
 		if(val1.index() == m_matidx && val2.index() == m_vecidx && op == '*')
 		{
-			using namespace m_ops;
 			const t_mat& mat = std::get<m_matidx>(val1);
 			const t_vec& vec = std::get<m_vecidx>(val2);
-			result = t_data{std::in_place_index<m_vecidx>, mat*vec};
+			if(mat.size2() != vec.size())
+				throw std::runtime_error("Matrix-vector product dimension mismatch.");
+
+			t_vec res = m::create<t_vec>(mat.size1());
+			gemv(mat.data(), vec.data(), res.data(), mat.size1(), mat.size2(),
+				GetPool(mat.size1()*mat.size2(), g_par_min_flops));
+			result = t_data{std::in_place_index<m_vecidx>, res};
+		}
+
+		// matrix-matrix product
+		else if(val1.index() == m_matidx && val2.index() == m_matidx && op == '*')
+		{
+			const t_mat& mat1 = std::get<m_matidx>(val1);
+			const t_mat& mat2 = std::get<m_matidx>(val2);
+			if(mat1.size2() != mat2.size1())
+				throw std::runtime_error("Matrix-matrix product dimension mismatch.");
+
+			t_mat res = m::create<t_mat>(mat1.size1(), mat2.size2());
+			gemm(mat1.data(), mat2.data(), res.data(),
+				mat1.size1(), mat2.size2(), mat1.size2(),
+				GetPool(mat1.size1()*mat2.size2()*mat1.size2(), g_par_min_flops));
+			result = t_data{std::in_place_index<m_matidx>, res};
 		}
 
 		// matrix power
@@ -687,7 +787,10 @@ protected:
 		{
 			const t_mat& mat = std::get<m_matidx>(val1);
 			t_int pow = static_cast<t_int>(std::get<m_realidx>(val2));
-			auto [matpow, ok] = m::pow<t_mat, t_vec, t_int>(mat, pow);
+
+			const std::size_t N = mat.size1();
+			auto [matpow, ok] = mat_pow<t_mat, t_int, t_real>(mat, pow, m_eps,
+				GetPool(N*N*N, g_par_min_flops));
 			if(!ok)
 				throw std::runtime_error("Matrix power could not be calculated.");
 			result = t_data{std::in_place_index<m_matidx>, matpow};
@@ -756,6 +859,14 @@ protected:
 			result = t_data{std::in_place_index<m_matidx>, s * mat};
 		}
 
+		// element-wise addition or subtraction of arrays, scalars are added to all elements
+		else if((op == '+' || op == '-') &&
+			(val1.index() == m_vecidx || val1.index() == m_matidx ||
+			val2.index() == m_vecidx || val2.index() == m_matidx))
+		{
+			result = OpElementwise<op>(val1, val2);
+		}
+
 		// same-type operations
 		else if(val1.index() == val2.index())
 		{
@@ -794,7 +905,217 @@ protected:
 			throw std::runtime_error(err.str());
 		}
 
-		PushData(result);
+		return result;
+	}
+
+
+	/**
+	 * element-wise operation between arrays of the same shape, or between
+	 * an array and a scalar which is combined with all elements
+	 */
+	template<char op>
+	t_data OpElementwise(const t_data& val1, const t_data& val2)
+	{
+		const bool is_arr1 = (val1.index() == m_vecidx || val1.index() == m_matidx);
+		const bool is_arr2 = (val2.index() == m_vecidx || val2.index() == m_matidx);
+
+		// scalar operations
+		if(!is_arr1 && !is_arr2)
+			return OpArithmetic<op>(val1, val2);
+
+		constexpr VecArithOp arith_op =
+			op == '+' ? VecArithOp::ADD :
+			op == '-' ? VecArithOp::SUB :
+			op == '*' ? VecArithOp::MUL : VecArithOp::DIV;
+
+		// array elements and their number
+		auto get_elems = [](auto& arr)
+		{
+			if(arr.index() == m_vecidx)
+			{
+				auto& vec = std::get<m_vecidx>(arr);
+				return std::make_pair(vec.data(), vec.size());
+			}
+
+			auto& mat = std::get<m_matidx>(arr);
+			return std::make_pair(mat.data(), mat.size1() * mat.size2());
+		};
+
+		// scalar operand
+		auto get_scalar = [](const t_data& val) -> t_real
+		{
+			if(val.index() == m_realidx)
+				return std::get<m_realidx>(val);
+			else if(val.index() == m_intidx)
+				return static_cast<t_real>(std::get<m_intidx>(val));
+
+			throw std::runtime_error("Type mismatch in element-wise operation.");
+		};
+
+		// the result has the shape of the array operand
+		t_data result = is_arr1 ? val1 : val2;
+		auto [elems, num_elems] = get_elems(result);
+		ThreadPool* pool = GetPool(num_elems, g_par_min_elems);
+
+		if(is_arr1 && is_arr2)
+		{
+			bool same_shape = (val1.index() == val2.index());
+			if(same_shape && val1.index() == m_vecidx)
+			{
+				same_shape = std::get<m_vecidx>(val1).size() == std::get<m_vecidx>(val2).size();
+			}
+			else if(same_shape)
+			{
+				const t_mat& mat1 = std::get<m_matidx>(val1);
+				const t_mat& mat2 = std::get<m_matidx>(val2);
+				same_shape = mat1.size1() == mat2.size1() && mat1.size2() == mat2.size2();
+			}
+			if(!same_shape)
+				throw std::runtime_error("Array dimension mismatch in element-wise operation.");
+
+			const t_real* elems2 = get_elems(val2).first;
+			vec_arith(arith_op, elems, 1, elems2, 1, elems, num_elems, pool);
+		}
+		else if(is_arr1)
+		{
+			const t_real scalar = get_scalar(val2);
+			vec_arith(arith_op, elems, 1, &scalar, 0, elems, num_elems, pool);
+		}
+		else
+		{
+			const t_real scalar = get_scalar(val1);
+			vec_arith(arith_op, &scalar, 0, elems, 1, elems, num_elems, pool);
+		}
+
+		return result;
+	}
+
+
+	/**
+	 * element-wise operation on the values on top of the stack
+	 */
+	template<char op>
+	void OpElementwise()
+	{
+		t_data val2 = PopData();
+		t_data val1 = PopData();
+		PushData(OpElementwise<op>(val1, val2));
+	}
+
+
+	/**
+	 * arithmetic operation on the values on top of the stack
+	 */
+	template<char op>
+	void OpArithmetic()
+	{
+		t_data val2 = PopData();
+		t_data val1 = PopData();
+		PushData(OpArithmetic<op>(val1, val2));
+	}
+
+
+	/**
+	 * arithmetic operation on a variable and the value on top of the stack,
+	 * arrays are updated in place without copying them
+	 */
+	template<char op>
+	void OpArithmeticMem()
+	{
+		t_addr addr = PopAddress();
+		const VMType memty = ReadMemType(addr);
+		const VMType valty = static_cast<VMType>(TopRaw<t_byte, m_bytesize>());
+
+		if(memty == VMType::VEC || memty == VMType::MAT)
+		{
+			// array shape and elements in memory
+			const t_addr num_dims = (memty == VMType::MAT ? 2 : 1);
+			const t_addr dims_addr = addr + m_bytesize;
+			const t_addr elems_addr = dims_addr + num_dims*m_addrsize;
+
+			t_addr num_elems = 1;
+			for(t_addr dim=0; dim<num_dims; ++dim)
+				num_elems *= ReadMemRaw<t_addr>(dims_addr + dim*m_addrsize);
+
+			CheckMemoryBounds(elems_addr, num_elems*m_realsize, true);
+			t_real* elems = reinterpret_cast<t_real*>(m_mem.get() + elems_addr);
+
+			// element-wise operation with a scalar, which is combined with all elements
+			if(valty == VMType::REAL || valty == VMType::INT)
+			{
+				t_data val = PopData();
+				const t_real s = (val.index() == m_realidx
+					? std::get<m_realidx>(val)
+					: static_cast<t_real>(std::get<m_intidx>(val)));
+
+				ParallelElems(num_elems, [elems, s](t_int begin, t_int end)
+				{
+					for(t_int idx=begin; idx<end; ++idx)
+					{
+						if constexpr(op == '+')
+							elems[idx] += s;
+						else if constexpr(op == '-')
+							elems[idx] -= s;
+						else if constexpr(op == '*')
+							elems[idx] *= s;
+						else
+							elems[idx] /= s;
+					}
+				});
+				return;
+			}
+
+			// element-wise operation with an array of the same shape
+			if constexpr(op == '+' || op == '-')
+			{
+				if(valty == memty)
+				{
+					for(t_addr dim=0; dim<num_dims; ++dim)
+					{
+						if(TopRaw<t_addr, m_addrsize>(m_bytesize + dim*m_addrsize) !=
+							ReadMemRaw<t_addr>(dims_addr + dim*m_addrsize))
+							throw std::runtime_error("Array dimension mismatch in in-place operation.");
+					}
+
+					const t_addr valsize = m_bytesize + num_dims*m_addrsize + num_elems*m_realsize;
+					CheckMemoryBounds(m_sp, valsize);
+					const t_real* vals = reinterpret_cast<const t_real*>(
+						m_mem.get() + m_sp + m_bytesize + num_dims*m_addrsize);
+
+					ParallelElems(num_elems, [elems, vals](t_int begin, t_int end)
+					{
+						for(t_int idx=begin; idx<end; ++idx)
+						{
+							if constexpr(op == '+')
+								elems[idx] += vals[idx];
+							else
+								elems[idx] -= vals[idx];
+						}
+					});
+
+					// pop the array operand
+					if(m_zeropoppedvals)
+						std::memset(m_mem.get() + m_sp, 0, valsize);
+					m_sp += valsize;
+					return;
+				}
+			}
+		}
+
+		// other types: operate on copies and write the result back
+		t_data val2 = PopData();
+		t_data val1 = std::get<1>(ReadMemData(addr));
+
+		if(val1.index() == m_realidx && val2.index() == m_intidx)
+			val2 = OpCast<m_realidx>(val2);
+
+		t_data result;
+		if(val1.index() == m_intidx && val2.index() == m_realidx)
+			result = OpCast<m_intidx>(OpArithmetic<op>(OpCast<m_realidx>(val1), val2));
+		else
+			result = OpArithmetic<op>(val1, val2);
+
+		WriteMemData(addr, result);
 	}
 
 
@@ -949,11 +1270,8 @@ protected:
 	 * comparison operation
 	 */
 	template<OpCode op>
-	void OpComparison()
+	t_bool OpComparison(const t_data& val1, const t_data& val2)
 	{
-		t_data val2 = PopData();
-		t_data val1 = PopData();
-
 		if(val1.index() != val2.index())
 		{
 			std::ostringstream err;
@@ -995,7 +1313,19 @@ protected:
 			throw std::runtime_error("Invalid type in comparison operation.");
 		}
 
-		PushRaw<t_bool, m_boolsize>(result);
+		return result;
+	}
+
+
+	/**
+	 * comparison operation on the values on top of the stack
+	 */
+	template<OpCode op>
+	void OpComparison()
+	{
+		t_data val2 = PopData();
+		t_data val1 = PopData();
+		PushRaw<t_bool, m_boolsize>(OpComparison<op>(val1, val2));
 	}
 
 
@@ -1007,23 +1337,157 @@ protected:
 
 
 private:
-	void CheckMemoryBounds(t_addr addr, t_addr size = 1) const;
+	void CheckMemoryBounds(t_addr addr, t_addr size = 1, bool write = false) const;
 	void CheckPointerBounds() const;
+	void CheckStackBounds() const;
 	void UpdateCodeRange(t_addr begin, t_addr end);
 
+	// memory allocation and mapping of program files
+	void AllocMem();
+	void MapMem(t_addr addr, int fd, std::size_t offs, std::size_t size, bool writable = false);
+	void UnmapMem();
+
+	// result of running an ir instruction
+	enum class IRStatus
+	{
+		OK,          // continue with the next instruction
+		HALT,        // program has finished
+		ERROR,       // invalid instruction
+		FALLBACK,    // continue in the bytecode interpreter
+	};
+
+	// bytecode and register-based ir interpreters
+	bool RunTiers();
+	bool RunBytecode();
+	bool RunIR();
+	IRStatus StepIR(std::size_t& pc);
+
+	// functions of the ir code and their counters
+	void InitFunctions();
+	void CountCall(std::size_t target);
+	void CountLoop(std::size_t pc, std::size_t target);
+
+	// native code
+	bool RunJIT();
+	JitFunction* GetJITFunction(std::size_t pc);
+	bool CompileJIT(JitFunction& func);
+	static std::size_t JitStep(VM* vm, std::size_t pc);
+
+	// result caches of pure functions
+	void InitMemo();
+	void ClearMemo();
+	bool MemoLookup(t_addr funcaddr, MemoCall& call);
+	void MemoStore(const MemoCall& call);
+	t_addr GetMemDataSize(t_addr addr);
+	void PrintMemoStats(std::ostream& ostr) const;
+
+	// translation into the register-based ir
+	bool TranslateIR();
+	std::optional<std::size_t> GetIRIndex(t_addr addr) const;
+
+	// access ir operands and run ir operations
+	std::tuple<VMType, t_data> GetIROperand(const IROperand& opd);
+	void SetIROperand(const IROperand& opd, const t_data& data, VMType ty);
+	t_data IRCast(OpCode op, const t_data& data);
+	t_data IRArithmetic(OpCode op, const t_data& val1, const t_data& val2);
+	t_bool IRComparison(OpCode op, const t_data& val1, const t_data& val2);
+
+	// frees the vm memory
+	struct MemDeleter
+	{
+		std::size_t size;
+		bool shared;                   // memory of another vm, e.g. for parallel loops
+		void operator()(t_byte* mem) const;
+	};
+
+	// worker of a parallel loop sharing the memory of its parent
+	VM(const VM& parent, t_addr sp, t_addr stack_limit);
+
+	// run one iteration of a parallel loop's body
+	void RunParBody(t_addr begin, t_addr end);
+
+	// address range of a variable and its private copy in a worker
+	struct ParPrivate
+	{
+		t_addr begin{}, end{};
+		t_addr target{};
+	};
+
+	// is the address in one of the worker's private variables?
+	bool IsParPrivate(t_addr addr) const;
+
 	void TimerFunc();
+	void CheckpointFunc();
+	void StopCheckpoint();
 
 
 private:
 	bool m_debug{false};               // write debug messages
 	bool m_checks{true};               // do memory boundary checks
+	bool m_verified{false};            // the program has passed the verifier
 	bool m_drawmemimages{false};       // write memory dump images
 	bool m_zeropoppedvals{false};      // zero memory of popped values
 	t_real m_eps{std::numeric_limits<t_real>::epsilon()};
 	t_int m_prec{6};
+	t_str m_convbuf{};                 // reusable buffer for string conversions
+	std::shared_ptr<OutputBuffer> m_output{std::make_shared<OutputBuffer>()};
+
+	// open csv files
+	std::unordered_map<t_int, std::shared_ptr<CsvReader>> m_csv_files{};
+	t_int m_csv_next_handle{0};
+
+	// lu decompositions, reused for several right-hand sides
+	struct LUFactor
+	{
+		t_mat lu{};
+		std::vector<std::size_t> perm{};
+	};
+	std::unordered_map<t_int, std::shared_ptr<const LUFactor>> m_factors{};
+	t_int m_factor_next_handle{0};
+
+	std::shared_ptr<const LUFactor> Decompose(const t_mat& mat);
 
-	std::unique_ptr<t_byte[]> m_mem{}; // ram
+	std::unique_ptr<t_byte[], MemDeleter> m_mem{}; // ram
 	t_addr m_code_range[2]{-1, -1};    // address range where the code resides
+	t_addr m_rom_range[2]{-1, -1};     // address range mapped read-only from the program file
+	t_addr m_prog_range[2]{-1, -1};    // address range of the loaded code and constants
+	t_addr m_stack_limit{0};           // lowest stack address of a verified program
+	t_addr m_entry{0};                 // start address of the program
+
+	// register-based ir translation of the code
+	bool m_use_ir{true};               // translate the code at load time
+	std::vector<IRInstr> m_ir{};
+	std::vector<std::tuple<VMType, t_data>> m_ir_consts{};
+	std::vector<std::size_t> m_ir_index{};  // code address -> ir index
+	t_addr m_ir_base{0};               // code address of the first m_ir_index entry
+
+	// functions, their counters and native code
+	bool m_use_jit{false};             // compile hot functions
+	std::uint64_t m_hot_threshold{1000}; // calls and backward branches to compile a function
+	std::vector<JitFunction> m_jit_funcs{};
+	std::vector<std::size_t> m_jit_func_index{};  // ir index -> function
+	IRStatus m_jit_status{IRStatus::OK};
+	std::exception_ptr m_jit_exception{};
+
+	// result caches of pure functions
+	bool m_memo_all{false};            // cache all pure functions
+	std::vector<t_str> m_memo_names{}; // cache the given pure functions
+	std::size_t m_memo_size{1024};     // maximum number of results per function
+	std::unordered_map<t_addr, MemoFunction> m_memo_funcs{};
+	std::vector<MemoCall> m_memo_calls{};
+	bool m_memo_active{false};         // any function is cached
+
+	// parallel loops
+	std::size_t m_num_threads{0};      // number of threads, 0: number of cores
+	std::unique_ptr<ThreadPool> m_pool{};
+	bool m_par_worker{false};          // this is a worker running a loop body
+	t_addr m_par_bp{};                 // frame of the function containing the loop
+	std::vector<ParPrivate> m_par_privs{};  // private variables of a worker
+	static constexpr const t_addr m_par_stack_size = 0x400;  // minimum stack per worker
+
+	// function names and source lines from the program file
+	std::map<t_addr, t_str> m_funcnames{};
+	std::map<t_addr, t_addr> m_lines{};
 
 	// registers
 	t_addr m_ip{};                     // instruction pointer
@@ -1041,6 +1505,14 @@ private:
 	std::thread m_timer_thread{};
 	bool m_timer_running{false};
 	std::chrono::milliseconds m_timer_ticks{250};
+
+	// periodic snapshots
+	std::string m_checkpoint_file{};
+	std::chrono::milliseconds m_checkpoint_interval{60000};
+	std::thread m_checkpoint_thread{};
+	std::mutex m_checkpoint_mtx{};
+	std::condition_variable m_checkpoint_cv{};
+	bool m_checkpoint_running{false};
 };
 
 